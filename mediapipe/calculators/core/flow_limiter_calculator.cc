@@ -13,11 +13,15 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "mediapipe/calculators/core/flow_limiter_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/header_util.h"
 
@@ -27,6 +31,7 @@ constexpr char kFinishedTag[] = "FINISHED";
 constexpr char kAllowTag[] = "ALLOW";
 constexpr char kMaxInFlightTag[] = "MAX_IN_FLIGHT";
 constexpr char kOptionsTag[] = "OPTIONS";
+constexpr char kClockTag[] = "CLOCK";
 
 // FlowLimiterCalculator is used to limit the number of frames in flight
 // by dropping input frames when necessary.
@@ -64,6 +69,20 @@ constexpr char kOptionsTag[] = "OPTIONS";
 // including the current timestamp, and "ALLOW = false" indicates the start of
 // dropping frames including the current timestamp.
 //
+// If `target_latency_usec` is set, the limit on frames in flight adapts to the
+// measured latency, from releasing each frame to its "FINISHED" signal.  The
+// limit grows by one frame for each round of frames that finish within the
+// target, and shrinks by `latency_decrease_factor` when a frame finishes late
+// or is abandoned, at most once per round.  This keeps latency near the target
+// while the graph shares the machine with a varying load.  The limit stays
+// between `min_in_flight` and `max_in_flight`.  The optional "CLOCK" side
+// packet, a std::shared_ptr<mediapipe::Clock>, provides the time.
+//
+// Example options:
+//   max_in_flight: 8
+//   max_in_queue: 0
+//   target_latency_usec: 50000
+//
 // FlowLimiterCalculator provides limited support for multiple input streams.
 // The first input stream is treated as the main input stream and successive
 // input streams are treated as auxiliary input streams.  The auxiliary input
@@ -85,6 +104,10 @@ class FlowLimiterCalculator : public CalculatorBase {
     }
     cc->Inputs().Get("FINISHED", 0).SetAny();
     cc->InputSidePackets().Tag(kMaxInFlightTag).Set<int>().Optional();
+    cc->InputSidePackets()
+        .Tag(kClockTag)
+        .Set<std::shared_ptr<mediapipe::Clock>>()
+        .Optional();
     cc->Outputs().Tag(kAllowTag).Set<bool>().Optional();
     cc->SetInputStreamHandler("ImmediateInputStreamHandler");
     cc->SetProcessTimestampBounds(true);
@@ -98,6 +121,21 @@ class FlowLimiterCalculator : public CalculatorBase {
       options_.set_max_in_flight(
           cc->InputSidePackets().Tag(kMaxInFlightTag).Get<int>());
     }
+    if (Adaptive()) {
+      RET_CHECK_GE(options_.min_in_flight(), 1);
+      RET_CHECK_GE(options_.max_in_flight(), options_.min_in_flight());
+      RET_CHECK(options_.latency_decrease_factor() > 0 &&
+                options_.latency_decrease_factor() < 1);
+    }
+    if (cc->InputSidePackets().HasTag(kClockTag)) {
+      clock_ = cc->InputSidePackets()
+                   .Tag(kClockTag)
+                   .Get<std::shared_ptr<mediapipe::Clock>>();
+    } else {
+      clock_ = std::shared_ptr<mediapipe::Clock>(
+          mediapipe::MonotonicClock::CreateSynchronizedMonotonicClock());
+    }
+    in_flight_limit_ = options_.min_in_flight();
     input_queues_.resize(cc->Inputs().NumEntries(""));
     allowed_[Timestamp::Unset()] = true;
     RET_CHECK_OK(CopyInputHeadersToOutputs(cc->Inputs(), &(cc->Outputs())));
@@ -107,12 +145,16 @@ class FlowLimiterCalculator : public CalculatorBase {
   // Releases input packets allowed by the max_in_flight constraint.
   absl::Status Process(CalculatorContext* cc) final {
     options_ = tool::RetrieveOptions(options_, cc->Inputs());
+    // The clock is read only to adapt the limit on frames in flight.
+    absl::Time now = Adaptive() ? clock_->TimeNow() : absl::InfinitePast();
 
     // Process the FINISHED input stream.
     Packet finished_packet = cc->Inputs().Tag(kFinishedTag).Value();
     if (finished_packet.Timestamp() == cc->InputTimestamp()) {
       while (!frames_in_flight_.empty() &&
-             frames_in_flight_.front() <= finished_packet.Timestamp()) {
+             frames_in_flight_.front().timestamp <=
+                 finished_packet.Timestamp()) {
+        UpdateInFlightLimit(frames_in_flight_.front(), now, /*abandoned=*/false);
         frames_in_flight_.pop_front();
       }
     }
@@ -132,7 +174,8 @@ class FlowLimiterCalculator : public CalculatorBase {
     if (timeout > 0 && latest_ts == cc->InputTimestamp() &&
         latest_ts < Timestamp::Max()) {
       while (!frames_in_flight_.empty() &&
-             (latest_ts - frames_in_flight_.front()) > timeout) {
+             (latest_ts - frames_in_flight_.front().timestamp) > timeout) {
+        UpdateInFlightLimit(frames_in_flight_.front(), now, /*abandoned=*/true);
         frames_in_flight_.pop_front();
       }
     }
@@ -144,7 +187,7 @@ class FlowLimiterCalculator : public CalculatorBase {
       input_queue.pop_front();
       cc->Outputs().Get("", 0).AddPacket(packet);
       SendAllow(true, packet.Timestamp(), cc);
-      frames_in_flight_.push_back(packet.Timestamp());
+      frames_in_flight_.push_back({packet.Timestamp(), now});
     }
 
     // Limit the number of queued frames.
@@ -187,10 +230,42 @@ class FlowLimiterCalculator : public CalculatorBase {
   }
 
  private:
+  // A frame released for processing and awaiting its "FINISHED" signal.
+  struct FrameInFlight {
+    Timestamp timestamp;
+    absl::Time release_time;
+  };
+
+  // Returns true if the limit on frames in flight adapts to latency.
+  bool Adaptive() { return options_.target_latency_usec() > 0; }
+
   // Returns true if an additional frame can be released for processing.
   // The "ALLOW" output stream indicates this condition at each input frame.
   bool ProcessingAllowed() {
-    return frames_in_flight_.size() < options_.max_in_flight();
+    int max_in_flight = Adaptive() ? static_cast<int>(in_flight_limit_)
+                                   : options_.max_in_flight();
+    return frames_in_flight_.size() < max_in_flight;
+  }
+
+  // Adjusts the adaptive limit on frames in flight, when a frame finishes or
+  // is abandoned.  The limit increases additively and decreases
+  // multiplicatively.  Late frames released before the last decrease are
+  // ignored, because the decrease has already accounted for them.
+  void UpdateInFlightLimit(const FrameInFlight& frame, absl::Time now,
+                           bool abandoned) {
+    if (!Adaptive()) {
+      return;
+    }
+    absl::Duration latency = now - frame.release_time;
+    if (!abandoned &&
+        latency <= absl::Microseconds(options_.target_latency_usec())) {
+      in_flight_limit_ += 1.0 / in_flight_limit_;
+    } else if (frame.release_time >= last_decrease_time_) {
+      in_flight_limit_ *= options_.latency_decrease_factor();
+      last_decrease_time_ = now;
+    }
+    in_flight_limit_ = std::clamp<double>(
+        in_flight_limit_, options_.min_in_flight(), options_.max_in_flight());
   }
 
   // Outputs a packet indicating whether a frame was sent or dropped.
@@ -259,8 +334,13 @@ class FlowLimiterCalculator : public CalculatorBase {
  private:
   FlowLimiterCalculatorOptions options_;
   std::vector<std::deque<Packet>> input_queues_;
-  std::deque<Timestamp> frames_in_flight_;
+  std::deque<FrameInFlight> frames_in_flight_;
   std::map<Timestamp, bool> allowed_;
+  std::shared_ptr<mediapipe::Clock> clock_;
+  // The adaptive limit on frames in flight, if target_latency_usec is set.
+  double in_flight_limit_ = 1;
+  // The time of the last decrease of in_flight_limit_.
+  absl::Time last_decrease_time_ = absl::InfinitePast();
 };
 REGISTER_CALCULATOR(FlowLimiterCalculator);
 
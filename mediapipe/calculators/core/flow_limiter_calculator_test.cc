@@ -13,11 +13,13 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "mediapipe/calculators/core/flow_limiter_calculator.pb.h"
@@ -44,6 +46,7 @@ constexpr char kClockTag[] = "CLOCK";
 constexpr char kWarmupTimeTag[] = "WARMUP_TIME";
 constexpr char kSleepTimeTag[] = "SLEEP_TIME";
 constexpr char kPacketTag[] = "PACKET";
+constexpr char kMachineTag[] = "MACHINE";
 
 // A simple Semaphore for synchronizing test threads.
 class AtomicSemaphore {
@@ -287,6 +290,59 @@ class DropCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(DropCalculator);
 
+// The processor cores shared by the frames processed in a simulated graph.
+struct SharedMachine {
+  absl::Mutex mutex;
+  int num_cores ABSL_GUARDED_BY(mutex) = 1;
+  int num_active ABSL_GUARDED_BY(mutex) = 0;
+};
+
+// A calculator that simulates 10 ms of work per frame on a SharedMachine.
+// When more frames are active than there are cores, each frame takes
+// proportionally longer.
+class SharedMachineCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Tag(kPacketTag).SetAny();
+    cc->Outputs().Tag(kPacketTag).SetSameAs(&cc->Inputs().Tag(kPacketTag));
+    cc->InputSidePackets().Tag(kMachineTag).Set<SharedMachine*>();
+    cc->InputSidePackets().Tag(kClockTag).Set<mediapipe::Clock*>();
+    cc->SetTimestampOffset(0);
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) final {
+    machine_ = cc->InputSidePackets().Tag(kMachineTag).Get<SharedMachine*>();
+    clock_ = cc->InputSidePackets().Tag(kClockTag).Get<mediapipe::Clock*>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    absl::Duration work_time;
+    {
+      absl::MutexLock lock(&machine_->mutex);
+      ++machine_->num_active;
+      work_time = absl::Milliseconds(10) *
+                  std::max(1.0, static_cast<double>(machine_->num_active) /
+                                    machine_->num_cores);
+    }
+    clock_->Sleep(work_time);
+    {
+      absl::MutexLock lock(&machine_->mutex);
+      --machine_->num_active;
+    }
+    cc->Outputs()
+        .Tag(kPacketTag)
+        .AddPacket(cc->Inputs().Tag(kPacketTag).Value());
+    return absl::OkStatus();
+  }
+
+ private:
+  SharedMachine* machine_ = nullptr;
+  ::mediapipe::Clock* clock_ = nullptr;
+};
+REGISTER_CALCULATOR(SharedMachineCalculator);
+
 // Tests demonstrating an FlowLimiterCalculator processing FINISHED timestamps.
 class FlowLimiterCalculatorTest : public testing::Test {
  protected:
@@ -330,8 +386,8 @@ class FlowLimiterCalculatorTest : public testing::Test {
   absl::Time StartTime() { return ParseTime("2020-11-03T20:00:00Z"); }
 
   // Initialize the test clock to follow simulated time.
-  void SetUpSimulationClock() {
-    auto executor = std::make_shared<SimulationClockExecutor>(8);
+  void SetUpSimulationClock(int num_threads = 8) {
+    auto executor = std::make_shared<SimulationClockExecutor>(num_threads);
     simulation_clock_ = executor->GetClock();
     clock_ = simulation_clock_.get();
     simulation_clock_->ThreadStart();
@@ -980,5 +1036,97 @@ TEST_F(FlowLimiterCalculatorTest, AuxiliaryInputs) {
               ElementsAreArray(PacketMatchers<bool>(expected_allow)));
 }
 
+// Shows how the adaptive limit on frames in flight keeps latency near
+// target_latency_usec, while keeping a shared machine busy.  Frames arrive
+// every 1 ms, faster than the machine can process them.  The machine has 4
+// cores, and then only 2 cores as another workload starts.
+TEST_F(FlowLimiterCalculatorTest, AdaptiveInFlight) {
+  constexpr int kNumFrames = 2000;
+  constexpr int kFrameInterval = 1000;
+  SetUpSimulationClock(/*num_threads=*/24);
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in_1'
+        node {
+          calculator: 'FlowLimiterCalculator'
+          options {
+            [mediapipe.FlowLimiterCalculatorOptions.ext] {
+              max_in_flight: 16
+              max_in_queue: 0
+              target_latency_usec: 20000
+            }
+          }
+          input_side_packet: 'CLOCK:limiter_clock'
+          input_stream: 'in_1'
+          input_stream: 'FINISHED:out_1'
+          input_stream_info: { tag_index: 'FINISHED' back_edge: true }
+          output_stream: 'in_1_sampled'
+        }
+        node {
+          calculator: 'SharedMachineCalculator'
+          input_side_packet: 'MACHINE:machine'
+          input_side_packet: 'CLOCK:clock'
+          input_stream: 'PACKET:in_1_sampled'
+          output_stream: 'PACKET:out_1'
+          max_in_flight: 16
+        }
+      )pb");
+  SharedMachine machine;
+  {
+    absl::MutexLock lock(&machine.mutex);
+    machine.num_cores = 4;
+  }
+  std::map<std::string, Packet> side_packets = {
+      {"limiter_clock",
+       MakePacket<std::shared_ptr<mediapipe::Clock>>(simulation_clock_)},
+      {"clock", MakePacket<mediapipe::Clock*>(clock_)},
+      {"machine", MakePacket<SharedMachine*>(&machine)},
+  };
+
+  // Record the latency of each frame from input to output.
+  std::vector<absl::Time> input_times(kNumFrames);
+  std::map<int, absl::Duration> latencies;
+  MP_ASSERT_OK(graph_.Initialize(graph_config));
+  MP_EXPECT_OK(graph_.ObserveOutputStream("out_1", [&](Packet p) {
+    int frame = p.Timestamp().Value() / kFrameInterval;
+    latencies[frame] = clock_->TimeNow() - input_times[frame];
+    return absl::OkStatus();
+  }));
+  simulation_clock_->ThreadStart();
+  MP_ASSERT_OK(graph_.StartRun(side_packets));
+  for (int i = 0; i < kNumFrames; ++i) {
+    if (i == kNumFrames / 2) {
+      absl::MutexLock lock(&machine.mutex);
+      machine.num_cores = 2;
+    }
+    input_times[i] = clock_->TimeNow();
+    MP_EXPECT_OK(graph_.AddPacketToInputStream(
+        "in_1", MakePacket<int>(i).At(Timestamp(i * kFrameInterval))));
+    clock_->Sleep(absl::Microseconds(kFrameInterval));
+  }
+  MP_EXPECT_OK(graph_.CloseAllPacketSources());
+  clock_->Sleep(absl::Milliseconds(200));
+  MP_EXPECT_OK(graph_.WaitUntilDone());
+  simulation_clock_->ThreadFinish();
+
+  // Validate the output in the second half of each phase, after the limit
+  // has adapted.  The machine processes 400 frames per second with 4 cores,
+  // and 200 frames per second with 2 cores.  A fixed limit of 16 frames would
+  // yield latencies of 40 ms and 80 ms.
+  auto check_phase = [&](int begin, int end, int expected_frames) {
+    int num_frames = 0;
+    absl::Duration max_latency;
+    for (auto it = latencies.lower_bound(begin);
+         it != latencies.end() && it->first < end; ++it) {
+      ++num_frames;
+      max_latency = std::max(max_latency, it->second);
+    }
+    EXPECT_GE(num_frames, expected_frames * 8 / 10);
+    EXPECT_LE(max_latency, absl::Milliseconds(40));
+  };
+  check_phase(500, 1000, 200);
+  check_phase(1500, 2000, 100);
+}
+
 }  // anonymous namespace
 }  // namespace mediapipe
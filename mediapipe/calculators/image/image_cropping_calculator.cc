@@ -244,6 +244,28 @@ absl::Status ImageCroppingCalculator::RenderCpu(CalculatorContext* cc) {
   output_width *= scale;
   output_height *= scale;
 
+  // An upright, unscaled crop on whole pixels that lies within the image is a
+  // view into the input pixels, which the output shares instead of copying.
+  const float left = rect_center_x - target_width / 2.0f;
+  const float top = rect_center_y - target_height / 2.0f;
+  if (rotation == 0.0f && scale == 1.0f && target_width > 0 &&
+      target_height > 0 && left == std::floor(left) && top == std::floor(top) &&
+      left >= 0 && top >= 0 && left + target_width <= input_img.Width() &&
+      top + target_height <= input_img.Height()) {
+    const int pixel_size = input_img.NumberOfChannels() * input_img.ByteDepth();
+    uint8* pixel_data = const_cast<uint8*>(input_img.PixelData()) +
+                        static_cast<int>(top) * input_img.WidthStep() +
+                        static_cast<int>(left) * pixel_size;
+    // The deleter keeps the input frame alive as long as the view.
+    Packet input_packet = cc->Inputs().Tag(kImageTag).Value();
+    std::unique_ptr<ImageFrame> output_frame(new ImageFrame(
+        input_img.Format(), target_width, target_height, input_img.WidthStep(),
+        pixel_data, [input_packet](uint8*) {}));
+    cc->Outputs().Tag(kImageTag).Add(output_frame.release(),
+                                     cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+
   float dst_corners[8] = {
       0, output_height, 0, 0, output_width, 0, output_width, output_height};
   const cv::Mat dst_points = cv::Mat(4, 2, CV_32F, dst_corners);
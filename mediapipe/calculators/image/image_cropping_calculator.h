@@ -32,7 +32,9 @@
 //
 // Output:
 //   One of the following two tags:
-//   IMAGE - Cropped ImageFrame
+//   IMAGE - Cropped ImageFrame. An upright crop that is not scaled, lies within
+//           the image and is aligned on pixels shares the input pixels
+//           instead of copying them, so its WidthStep() is the input's.
 //   IMAGE_GPU - Cropped GpuBuffer.
 //
 // Note: input_stream values take precedence over options defined in the graph.
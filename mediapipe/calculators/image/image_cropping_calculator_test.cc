@@ -143,6 +143,49 @@ TEST(ImageCroppingCalculatorTest, IdentityFunctionCropWithOddSize) {
   EXPECT_EQ(max_diff, 0);
 }  // TEST
 
+// Test that an upright crop within the image shares the input pixels.
+TEST(ImageCroppingCalculatorTest, CropWithinImageSharesInputPixels) {
+  auto calculator_node =
+      ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig::Node>(
+          R"pb(
+            calculator: "ImageCroppingCalculator"
+            input_stream: "IMAGE:input_frames"
+            output_stream: "IMAGE:cropped_output_frames"
+            options: {
+              [mediapipe.ImageCroppingCalculatorOptions.ext] {
+                width: 40
+                height: 20
+              }
+            }
+          )pb");
+  mediapipe::CalculatorRunner runner(calculator_node);
+
+  auto input_frame_packet = mediapipe::MakePacket<mediapipe::ImageFrame>(
+      std::move(*GetInputFrame(input_width, input_height, 3)));
+  runner.MutableInputs()->Tag("IMAGE").packets.push_back(
+      input_frame_packet.At(mediapipe::Timestamp(1)));
+
+  MP_ASSERT_OK(runner.Run());
+
+  const auto& input_image = input_frame_packet.Get<mediapipe::ImageFrame>();
+  const auto& output_image = runner.Outputs()
+                                 .Tag("IMAGE")
+                                 .packets[0]
+                                 .Get<mediapipe::ImageFrame>();
+  EXPECT_EQ(output_image.Width(), 40);
+  EXPECT_EQ(output_image.Height(), 20);
+  // The crop is centered, so its top left corner is at (30, 40).
+  EXPECT_EQ(output_image.PixelData(),
+            input_image.PixelData() + 40 * input_image.WidthStep() + 30 * 3);
+  EXPECT_EQ(output_image.WidthStep(), input_image.WidthStep());
+
+  cv::Mat output_mat = formats::MatView(&output_image);
+  cv::Mat expected_mat =
+      formats::MatView(&input_image)(cv::Rect(30, 40, 40, 20));
+  double max_diff = cv::norm(expected_mat, output_mat, cv::NORM_INF);
+  EXPECT_EQ(max_diff, 0);
+}  // TEST
+
 // Test identity function on GPU, where cropping size is same as input size.
 TEST(ImageCroppingCalculatorTest, IdentityFunctionCropWithOriginalSizeGPU) {
   mediapipe::CalculatorGraphConfig config =
@@ -135,7 +135,8 @@ mediapipe::ScaleMode_Mode ParseScaleMode(
 //
 // Output:
 //   One of the following tags:
-//   IMAGE - ImageFrame representing the output image.
+//   IMAGE - ImageFrame representing the output image. If the image needs no
+//   transformation, this is the input packet itself.
 //   IMAGE_GPU - GpuBuffer representing the output image.
 //
 //   LETTERBOX_PADDING (optional): An std::array<float, 4> representing the
@@ -457,7 +458,8 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
   ComputeOutputDimensions(input_width, input_height, &output_width,
                           &output_height);
 
-  if (output_width_ > 0 && output_height_ > 0) {
+  if (output_width_ > 0 && output_height_ > 0 &&
+      (output_width_ != input_width || output_height_ != input_height)) {
     cv::Mat scaled_mat;
     if (scale_mode_ == mediapipe::ScaleMode_Mode_STRETCH) {
       int scale_flag =
@@ -507,8 +509,8 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
 
   cv::Mat rotated_mat;
   cv::Size rotated_size(output_width, output_height);
-  if (input_mat.size() == rotated_size) {
-    const int angle = RotationModeToDegrees(rotation_);
+  const int angle = RotationModeToDegrees(rotation_);
+  if (input_mat.size() == rotated_size && angle != 0) {
     cv::Point2f src_center(input_mat.cols / 2.0, input_mat.rows / 2.0);
     cv::Mat rotation_mat = cv::getRotationMatrix2D(src_center, angle, 1.0);
     cv::warpAffine(input_mat, rotated_mat, rotation_mat, rotated_size);
@@ -539,10 +541,16 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
     flipped_mat = rotated_mat;
   }
 
-  std::unique_ptr<ImageFrame> output_frame(
-      new ImageFrame(format, output_width, output_height));
-  cv::Mat output_mat = formats::MatView(output_frame.get());
-  flipped_mat.copyTo(output_mat);
+  // If the image is left as is, the input packet is passed on. Otherwise the
+  // output frame takes over the pixels of the last OpenCV result.
+  if (flipped_mat.data == input.PixelData()) {
+    cc->Outputs()
+        .Tag(kImageFrameTag)
+        .AddPacket(cc->Inputs().Tag(kImageFrameTag).Value());
+    return absl::OkStatus();
+  }
+  std::unique_ptr<ImageFrame> output_frame =
+      formats::AdoptMat(format, flipped_mat);
   cc->Outputs()
       .Tag(kImageFrameTag)
       .Add(output_frame.release(), cc->InputTimestamp());
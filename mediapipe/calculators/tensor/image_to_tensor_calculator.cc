@@ -77,6 +77,12 @@ namespace api2 {
 //     Describes region of image to extract.
 //     @Optional: rect covering the whole image is used if not specified.
 //
+//   NORM_RECTS - std::vector<NormalizedRect> @Optional
+//     Describes several regions of the image to extract into one batched
+//     tensor, e.g. for batched inference. Cannot be used with NORM_RECT.
+//     On GPU, more than one rect requires OpenGL ES 3.1 or later: the Metal
+//     and OpenGL texture converters fail on a vector of several rects.
+//
 // Outputs:
 //   TENSORS - std::vector<Tensor>
 //     Vector containing a single Tensor populated with an extrated RGB image.
@@ -97,6 +103,16 @@ namespace api2 {
 //     padding of 10 pixels at the top and the bottom. The resulting array is
 //     therefore [0.f, 0.25f, 0.f, 0.25f] (10/40 = 0.25f).
 //
+//   When NORM_RECTS is specified, the single Tensor has a batch dimension
+//   equal to the number of rects, and holds the image extracted for rect i at
+//   batch index i. Instead of MATRIX and LETTERBOX_PADDING, the calculator
+//   outputs:
+//   MATRICES - std::vector<std::array<float, 16>> @Optional
+//     The MATRIX of each rect.
+//   LETTERBOX_PADDINGS - std::vector<std::array<float, 4>> @Optional
+//     The LETTERBOX_PADDING of each rect.
+//   An empty vector of rects produces no outputs.
+//
 // Example:
 // node {
 //   calculator: "ImageToTensorCalculator"
@@ -128,9 +144,16 @@ class ImageToTensorCalculator : public Node {
   static constexpr Output<std::array<float, 4>>::Optional kOutLetterboxPadding{
       "LETTERBOX_PADDING"};
   static constexpr Output<std::array<float, 16>>::Optional kOutMatrix{"MATRIX"};
+  static constexpr Input<std::vector<mediapipe::NormalizedRect>>::Optional
+      kInNormRects{"NORM_RECTS"};
+  static constexpr Output<std::vector<std::array<float, 4>>>::Optional
+      kOutLetterboxPaddings{"LETTERBOX_PADDINGS"};
+  static constexpr Output<std::vector<std::array<float, 16>>>::Optional
+      kOutMatrices{"MATRICES"};
 
-  MEDIAPIPE_NODE_CONTRACT(kIn, kInGpu, kInNormRect, kOutTensors,
-                          kOutLetterboxPadding, kOutMatrix);
+  MEDIAPIPE_NODE_CONTRACT(kIn, kInGpu, kInNormRect, kInNormRects, kOutTensors,
+                          kOutLetterboxPadding, kOutMatrix,
+                          kOutLetterboxPaddings, kOutMatrices);
 
   static absl::Status UpdateContract(CalculatorContract* cc) {
     const auto& options =
@@ -139,6 +162,19 @@ class ImageToTensorCalculator : public Node {
     RET_CHECK_OK(ValidateOptionOutputDims(options));
     RET_CHECK(kIn(cc).IsConnected() ^ kInGpu(cc).IsConnected())
         << "One and only one of IMAGE and IMAGE_GPU input is expected.";
+    if (kInNormRects(cc).IsConnected()) {
+      RET_CHECK(!kInNormRect(cc).IsConnected())
+          << "At most one of NORM_RECT and NORM_RECTS input is expected.";
+      RET_CHECK(!kOutLetterboxPadding(cc).IsConnected() &&
+                !kOutMatrix(cc).IsConnected())
+          << "NORM_RECTS input requires the LETTERBOX_PADDINGS and MATRICES "
+             "outputs instead of LETTERBOX_PADDING and MATRIX.";
+    } else {
+      RET_CHECK(!kOutLetterboxPaddings(cc).IsConnected() &&
+                !kOutMatrices(cc).IsConnected())
+          << "LETTERBOX_PADDINGS and MATRICES outputs require NORM_RECTS "
+             "input.";
+    }
 
 #if MEDIAPIPE_DISABLE_GPU
     if (kInGpu(cc).IsConnected()) {
@@ -169,6 +205,15 @@ class ImageToTensorCalculator : public Node {
       return absl::OkStatus();
     }
 
+    if (kInNormRects(cc).IsConnected()) {
+      if (kInNormRects(cc).IsEmpty() || kInNormRects(cc)->empty()) {
+        // Timestamp bound update happens automatically.
+        return absl::OkStatus();
+      }
+      ASSIGN_OR_RETURN(auto image, GetImage(cc));
+      return ProcessBatch(cc, *image, *kInNormRects(cc));
+    }
+
     absl::optional<mediapipe::NormalizedRect> norm_rect;
     if (kInNormRect(cc).IsConnected()) {
       if (kInNormRect(cc).IsEmpty()) {
@@ -188,13 +233,7 @@ class ImageToTensorCalculator : public Node {
       }
     }
 
-#if MEDIAPIPE_DISABLE_GPU
-    ASSIGN_OR_RETURN(auto image, GetInputImage(kIn(cc)));
-#else
-    const bool is_input_gpu = kInGpu(cc).IsConnected();
-    ASSIGN_OR_RETURN(auto image, is_input_gpu ? GetInputImage(kInGpu(cc))
-                                              : GetInputImage(kIn(cc)));
-#endif  // MEDIAPIPE_DISABLE_GPU
+    ASSIGN_OR_RETURN(auto image, GetImage(cc));
 
     RotatedRect roi = GetRoi(image->width(), image->height(), norm_rect);
     const int tensor_width = params_.output_width.value_or(image->width());
@@ -232,6 +271,81 @@ class ImageToTensorCalculator : public Node {
   }
 
  private:
+  absl::StatusOr<std::shared_ptr<const mediapipe::Image>> GetImage(
+      CalculatorContext* cc) {
+#if MEDIAPIPE_DISABLE_GPU
+    return GetInputImage(kIn(cc));
+#else
+    const bool is_input_gpu = kInGpu(cc).IsConnected();
+    return is_input_gpu ? GetInputImage(kInGpu(cc)) : GetInputImage(kIn(cc));
+#endif  // MEDIAPIPE_DISABLE_GPU
+  }
+
+  // Extracts every rect of @norm_rects into one batched tensor, with a single
+  // call to the converter.
+  absl::Status ProcessBatch(
+      CalculatorContext* cc, const mediapipe::Image& image,
+      const std::vector<mediapipe::NormalizedRect>& norm_rects) {
+    const int tensor_width = params_.output_width.value_or(image.width());
+    const int tensor_height = params_.output_height.value_or(image.height());
+    std::vector<RotatedRect> rois;
+    rois.reserve(norm_rects.size());
+    std::vector<std::array<float, 4>> paddings;
+    paddings.reserve(norm_rects.size());
+    std::vector<std::array<float, 16>> matrices;
+    for (const auto& norm_rect : norm_rects) {
+      RotatedRect roi = GetRoi(image.width(), image.height(), norm_rect);
+      ASSIGN_OR_RETURN(auto padding,
+                       PadRoi(tensor_width, tensor_height,
+                              options_.keep_aspect_ratio(), &roi));
+      paddings.push_back(padding);
+      if (kOutMatrices(cc).IsConnected()) {
+        std::array<float, 16> matrix;
+        GetRotatedSubRectToRectTransformMatrix(
+            roi, image.width(), image.height(),
+            /*flip_horizontaly=*/false, &matrix);
+        matrices.push_back(matrix);
+      }
+      rois.push_back(roi);
+    }
+    if (kOutLetterboxPaddings(cc).IsConnected()) {
+      kOutLetterboxPaddings(cc).Send(std::move(paddings));
+    }
+    if (kOutMatrices(cc).IsConnected()) {
+      kOutMatrices(cc).Send(std::move(matrices));
+    }
+
+#if !MEDIAPIPE_DISABLE_GPU
+#if MEDIAPIPE_METAL_ENABLED || \
+    MEDIAPIPE_OPENGL_ES_VERSION < MEDIAPIPE_OPENGL_ES_31
+    // Only the OpenGL ES 3.1 converter writes a roi at an offset of the tensor.
+    if (image.UsesGpu() && rois.size() > 1) {
+      return absl::UnimplementedError(
+          "ImageToTensorConverter for the input GPU image doesn't support "
+          "NORM_RECTS with more than one rect on this platform.");
+    }
+#endif  // MEDIAPIPE_METAL_ENABLED || MEDIAPIPE_OPENGL_ES_VERSION < 3.1
+#endif  // !MEDIAPIPE_DISABLE_GPU
+
+    // Lazy initialization of the GPU or CPU converter.
+    MP_RETURN_IF_ERROR(InitConverterIfNecessary(cc, image));
+
+    Tensor::ElementType output_tensor_type =
+        GetOutputTensorType(image.UsesGpu(), params_);
+    Tensor tensor(output_tensor_type,
+                  {static_cast<int>(rois.size()), tensor_height, tensor_width,
+                   GetNumOutputChannels(image)});
+    MP_RETURN_IF_ERROR((image.UsesGpu() ? gpu_converter_ : cpu_converter_)
+                           ->ConvertBatch(image, rois, params_.range_min,
+                                          params_.range_max, tensor));
+
+    auto result = std::make_unique<std::vector<Tensor>>();
+    result->push_back(std::move(tensor));
+    kOutTensors(cc).Send(std::move(result));
+
+    return absl::OkStatus();
+  }
+
   absl::Status InitConverterIfNecessary(CalculatorContext* cc,
                                         const Image& image) {
     // Lazy initialization of the GPU or CPU converter.
@@ -272,7 +386,8 @@ class ImageToTensorCalculator : public Node {
         ASSIGN_OR_RETURN(cpu_converter_,
                          CreateOpenCvConverter(
                              cc, GetBorderMode(options_.border_mode()),
-                             GetOutputTensorType(/*uses_gpu=*/false, params_)));
+                             GetOutputTensorType(/*uses_gpu=*/false, params_),
+                             options_.num_batch_threads()));
 #else
         LOG(FATAL) << "Cannot create image to tensor opencv converter since "
                       "MEDIAPIPE_DISABLE_OPENCV is defined.";
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
 #include <cmath>
 #include <optional>
 #include <string>
@@ -215,9 +216,9 @@ Packet MakeImageFramePacket(cv::Mat input) {
 }
 
 Packet MakeImagePacket(cv::Mat input) {
-  mediapipe::Image input_image(std::make_shared<mediapipe::ImageFrame>(
-      GetImageFormat(input.channels()), input.cols, input.rows, input.step,
-      input.data, [](uint8*) {}));
+  mediapipe::Image input_image(GetImageFormat(input.channels()), input.cols,
+                               input.rows, input.step, input.data,
+                               [](uint8*) {});
   return MakePacket<mediapipe::Image>(std::move(input_image)).At(Timestamp(0));
 }
 
@@ -267,6 +268,27 @@ TEST(ImageToTensorCalculatorTest, MediumSubRectKeepAspect) {
           /*border mode*/ {}, roi);
 }
 
+TEST(ImageToTensorCalculatorTest, MediumSubRectKeepAspectPaddedRows) {
+  mediapipe::NormalizedRect roi;
+  roi.set_x_center(0.65f);
+  roi.set_y_center(0.4f);
+  roi.set_width(0.5f);
+  roi.set_height(0.5f);
+  roi.set_rotation(0);
+  // The input image is a view into a larger buffer, so its rows are padded.
+  cv::Mat input = GetRgb(GetFilePath("input.jpg"));
+  cv::Mat buffer(input.rows + 10, input.cols + 16, input.type(),
+                 cv::Scalar(255, 0, 0));
+  cv::Mat padded_input = buffer(cv::Rect(8, 5, input.cols, input.rows));
+  input.copyTo(padded_input);
+  ASSERT_FALSE(padded_input.isContinuous());
+  RunTest(padded_input, GetRgb(GetFilePath("medium_sub_rect_keep_aspect.png")),
+          /*float_ranges=*/{{0.0f, 1.0f}},
+          /*int_ranges=*/{{0, 255}},
+          /*tensor_width=*/256, /*tensor_height=*/256, /*keep_aspect=*/true,
+          /*border mode*/ {}, roi);
+}
+
 TEST(ImageToTensorCalculatorTest, MediumSubRectKeepAspectBorderZero) {
   mediapipe::NormalizedRect roi;
   roi.set_x_center(0.65f);
@@ -542,6 +564,138 @@ TEST(ImageToTensorCalculatorTest, CanBeUsedWithoutGpuServiceSet) {
   MP_ASSERT_OK(graph.WaitUntilDone());
 }
 
+struct TensorCalculatorOutputs {
+  std::vector<uint8> tensor_bytes;
+  std::vector<int> tensor_dims;
+  std::vector<std::array<float, 4>> paddings;
+  std::vector<std::array<float, 16>> matrices;
+};
+
+// Runs ImageToTensorCalculator on @image, either once for each of @rois with
+// NORM_RECT, or once for all of them with NORM_RECTS on @num_batch_threads
+// threads, and concatenates the outputs.
+TensorCalculatorOutputs RunWithRois(
+    const cv::Mat& image, const std::vector<mediapipe::NormalizedRect>& rois,
+    bool batched, int num_batch_threads = 0) {
+  auto graph_config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(absl::Substitute(
+          R"(
+        input_stream: "input_image"
+        input_stream: "roi"
+        node {
+          calculator: "ImageToTensorCalculator"
+          input_stream: "IMAGE:input_image"
+          input_stream: "$0:roi"
+          output_stream: "TENSORS:tensor"
+          output_stream: "$1:padding"
+          output_stream: "$2:matrix"
+          options {
+            [mediapipe.ImageToTensorCalculatorOptions.ext] {
+              output_tensor_width: 64
+              output_tensor_height: 32
+              keep_aspect_ratio: true
+              output_tensor_uint_range { min: 0 max: 255 }
+              num_batch_threads: $3
+            }
+          }
+        }
+        )",
+          batched ? "NORM_RECTS" : "NORM_RECT",
+          batched ? "LETTERBOX_PADDINGS" : "LETTERBOX_PADDING",
+          batched ? "MATRICES" : "MATRIX", num_batch_threads));
+  std::vector<Packet> tensor_packets;
+  std::vector<Packet> padding_packets;
+  std::vector<Packet> matrix_packets;
+  tool::AddVectorSink("tensor", &graph_config, &tensor_packets);
+  tool::AddVectorSink("padding", &graph_config, &padding_packets);
+  tool::AddVectorSink("matrix", &graph_config, &matrix_packets);
+
+  CalculatorGraph graph;
+  MP_EXPECT_OK(graph.Initialize(graph_config));
+  MP_EXPECT_OK(graph.StartRun({}));
+  if (batched) {
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "input_image", MakeImagePacket(image).At(Timestamp(0))));
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "roi", MakePacket<std::vector<mediapipe::NormalizedRect>>(rois).At(
+                   Timestamp(0))));
+  } else {
+    for (int i = 0; i < rois.size(); ++i) {
+      MP_EXPECT_OK(graph.AddPacketToInputStream(
+          "input_image", MakeImagePacket(image).At(Timestamp(i))));
+      MP_EXPECT_OK(graph.AddPacketToInputStream(
+          "roi", MakePacket<mediapipe::NormalizedRect>(rois[i]).At(
+                     Timestamp(i))));
+    }
+  }
+  MP_EXPECT_OK(graph.CloseAllPacketSources());
+  MP_EXPECT_OK(graph.WaitUntilDone());
+
+  TensorCalculatorOutputs outputs;
+  for (const Packet& packet : tensor_packets) {
+    const Tensor& tensor = packet.Get<std::vector<Tensor>>()[0];
+    outputs.tensor_dims = tensor.shape().dims;
+    auto view = tensor.GetCpuReadView();
+    const uint8* data = view.buffer<uint8>();
+    outputs.tensor_bytes.insert(outputs.tensor_bytes.end(), data,
+                                data + tensor.bytes());
+  }
+  for (int i = 0; i < padding_packets.size(); ++i) {
+    if (batched) {
+      outputs.paddings =
+          padding_packets[i].Get<std::vector<std::array<float, 4>>>();
+      outputs.matrices =
+          matrix_packets[i].Get<std::vector<std::array<float, 16>>>();
+    } else {
+      outputs.paddings.push_back(
+          padding_packets[i].Get<std::array<float, 4>>());
+      outputs.matrices.push_back(
+          matrix_packets[i].Get<std::array<float, 16>>());
+    }
+  }
+  return outputs;
+}
+
+TEST(ImageToTensorCalculatorTest, NormRectsMatchSingleNormRects) {
+  const cv::Mat input = GetRgb(GetFilePath("input.jpg"));
+  std::vector<mediapipe::NormalizedRect> rois(3);
+  rois[0].set_x_center(0.5f);
+  rois[0].set_y_center(0.5f);
+  rois[0].set_width(1.0f);
+  rois[0].set_height(1.0f);
+  rois[1].set_x_center(0.65f);
+  rois[1].set_y_center(0.4f);
+  rois[1].set_width(0.5f);
+  rois[1].set_height(0.5f);
+  rois[1].set_rotation(M_PI * 90.0f / 180.0f);
+  rois[2].set_x_center(0.1f);
+  rois[2].set_y_center(0.9f);
+  rois[2].set_width(0.3f);
+  rois[2].set_height(0.6f);
+  rois[2].set_rotation(0.3f);
+
+  const TensorCalculatorOutputs single =
+      RunWithRois(input, rois, /*batched=*/false);
+  const TensorCalculatorOutputs batched =
+      RunWithRois(input, rois, /*batched=*/true);
+  EXPECT_THAT(batched.tensor_dims, testing::ElementsAre(3, 32, 64, 3));
+  EXPECT_EQ(batched.tensor_bytes, single.tensor_bytes);
+  EXPECT_EQ(batched.paddings, single.paddings);
+  EXPECT_EQ(batched.matrices, single.matrices);
+
+  const TensorCalculatorOutputs batched_in_parallel =
+      RunWithRois(input, rois, /*batched=*/true, /*num_batch_threads=*/2);
+  EXPECT_EQ(batched_in_parallel.tensor_bytes, single.tensor_bytes);
+}
+
+TEST(ImageToTensorCalculatorTest, EmptyNormRectsOutputNothing) {
+  const cv::Mat input = GetRgb(GetFilePath("input.jpg"));
+  const TensorCalculatorOutputs outputs =
+      RunWithRois(input, /*rois=*/{}, /*batched=*/true);
+  EXPECT_TRUE(outputs.tensor_bytes.empty());
+  EXPECT_TRUE(outputs.paddings.empty());
+}
+
 #if !MEDIAPIPE_DISABLE_GPU && !MEDIAPIPE_METAL_ENABLED
 
 TEST(ImageToTensorCalculatorTest,
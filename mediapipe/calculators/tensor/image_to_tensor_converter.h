@@ -15,9 +15,13 @@
 #ifndef MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CONVERTER_H_
 #define MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CONVERTER_H_
 
+#include <vector>
+
 #include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
 #include "mediapipe/framework/formats/image.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/port/statusor.h"
 
 namespace mediapipe {
@@ -46,6 +50,26 @@ class ImageToTensorConverter {
                                const RotatedRect& roi, float range_min,
                                float range_max, int tensor_buffer_offset,
                                Tensor& output_tensor) = 0;
+
+  // Converts several regions of interest of an image into one batched tensor.
+  // @rois describes the regions of interest (absolute values); region i is
+  // written to the i-th image of @output_tensor, whose batch dimension has to
+  // be equal to the number of regions.
+  // The default implementation calls "Convert" for each region in turn.
+  virtual absl::Status ConvertBatch(const mediapipe::Image& input,
+                                    const std::vector<RotatedRect>& rois,
+                                    float range_min, float range_max,
+                                    Tensor& output_tensor) {
+    RET_CHECK_EQ(output_tensor.shape().dims[0], static_cast<int>(rois.size()))
+        << "The batch dimension needs to be equal to the number of rois.";
+    const int image_bytes = output_tensor.bytes() / rois.size();
+    for (int i = 0; i < static_cast<int>(rois.size()); ++i) {
+      MP_RETURN_IF_ERROR(Convert(input, rois[i], range_min, range_max,
+                                 /*tensor_buffer_offset=*/i * image_bytes,
+                                 output_tensor));
+    }
+    return absl::OkStatus();
+  }
 };
 
 }  // namespace mediapipe
@@ -16,8 +16,13 @@
 
 #include <cmath>
 #include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/blocking_counter.h"
 
 #include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_cpu_kernel.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image.h"
@@ -28,6 +33,7 @@
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/port/threadpool.h"
 
 namespace mediapipe {
 
@@ -35,14 +41,17 @@ namespace {
 
 class OpenCvProcessor : public ImageToTensorConverter {
  public:
-  OpenCvProcessor(BorderMode border_mode, Tensor::ElementType tensor_type)
-      : tensor_type_(tensor_type) {
+  OpenCvProcessor(BorderMode border_mode, Tensor::ElementType tensor_type,
+                  int num_batch_threads)
+      : border_mode_(border_mode),
+        tensor_type_(tensor_type),
+        num_batch_threads_(num_batch_threads) {
     switch (border_mode) {
       case BorderMode::kReplicate:
-        border_mode_ = cv::BORDER_REPLICATE;
+        cv_border_mode_ = cv::BORDER_REPLICATE;
         break;
       case BorderMode::kZero:
-        border_mode_ = cv::BORDER_CONSTANT;
+        cv_border_mode_ = cv::BORDER_CONSTANT;
         break;
     }
     switch (tensor_type_) {
@@ -68,63 +77,120 @@ class OpenCvProcessor : public ImageToTensorConverter {
                        float range_min, float range_max,
                        int tensor_buffer_offset,
                        Tensor& output_tensor) override {
-    const bool is_supported_format =
-        input.image_format() == mediapipe::ImageFormat::SRGB ||
-        input.image_format() == mediapipe::ImageFormat::SRGBA ||
-        input.image_format() == mediapipe::ImageFormat::GRAY8;
-    if (!is_supported_format) {
-      return InvalidArgumentError(absl::StrCat(
-          "Unsupported format: ", static_cast<uint32_t>(input.image_format())));
-    }
-
+    MP_RETURN_IF_ERROR(ValidateImageFormat(input));
     RET_CHECK_GE(tensor_buffer_offset, 0)
         << "The input tensor_buffer_offset needs to be non-negative.";
     const auto& output_shape = output_tensor.shape();
     MP_RETURN_IF_ERROR(ValidateTensorShape(output_shape));
+    const int image_bytes = output_tensor.bytes() / output_shape.dims[0];
+    RET_CHECK_GE(static_cast<int>(output_tensor.bytes()),
+                 tensor_buffer_offset + image_bytes)
+        << "The buffer offset + the input image size is larger than the "
+           "allocated tensor buffer.";
+    ASSIGN_OR_RETURN(auto transform,
+                     GetValueRangeTransformation(kInputImageRangeMin,
+                                                 kInputImageRangeMax,
+                                                 range_min, range_max));
+
+    auto buffer_view = output_tensor.GetCpuWriteView();
+    auto src = mediapipe::formats::MatView(&input);
+    ConvertRoi(*src, roi, transform, output_shape,
+               buffer_view.buffer<uint8>() + tensor_buffer_offset);
+    return absl::OkStatus();
+  }
+
+  absl::Status ConvertBatch(const mediapipe::Image& input,
+                            const std::vector<RotatedRect>& rois,
+                            float range_min, float range_max,
+                            Tensor& output_tensor) override {
+    MP_RETURN_IF_ERROR(ValidateImageFormat(input));
+    const auto& output_shape = output_tensor.shape();
+    MP_RETURN_IF_ERROR(ValidateTensorShape(output_shape));
+    RET_CHECK_EQ(output_shape.dims[0], static_cast<int>(rois.size()))
+        << "The batch dimension needs to be equal to the number of rois.";
+    ASSIGN_OR_RETURN(auto transform,
+                     GetValueRangeTransformation(kInputImageRangeMin,
+                                                 kInputImageRangeMax,
+                                                 range_min, range_max));
+
+    // A single write view for the whole batch: each view holds the tensor's
+    // lock, so views taken by the workers would run one after another.
+    auto buffer_view = output_tensor.GetCpuWriteView();
+    uint8* buffer = buffer_view.buffer<uint8>();
+    const int image_bytes = output_tensor.bytes() / rois.size();
+    auto src = mediapipe::formats::MatView(&input);
+    if (rois.size() == 1 || num_batch_threads_ <= 0) {
+      for (int i = 0; i < static_cast<int>(rois.size()); ++i) {
+        ConvertRoi(*src, rois[i], transform, output_shape,
+                   buffer + i * image_bytes);
+      }
+      return absl::OkStatus();
+    }
+
+    if (!pool_) {
+      pool_ = absl::make_unique<mediapipe::ThreadPool>("ImageToTensor",
+                                                       num_batch_threads_);
+      pool_->StartWorkers();
+    }
+    // The rois are written to disjoint slices of the tensor, and the calling
+    // thread converts the first one while the workers convert the rest.
+    absl::BlockingCounter counter(rois.size() - 1);
+    for (int i = 1; i < static_cast<int>(rois.size()); ++i) {
+      pool_->Schedule([this, &src, &rois, &transform, &output_shape, buffer,
+                       image_bytes, &counter, i]() {
+        ConvertRoi(*src, rois[i], transform, output_shape,
+                   buffer + i * image_bytes);
+        counter.DecrementCount();
+      });
+    }
+    ConvertRoi(*src, rois[0], transform, output_shape, buffer);
+    counter.Wait();
+    return absl::OkStatus();
+  }
+
+ private:
+  static constexpr float kInputImageRangeMin = 0.0f;
+  static constexpr float kInputImageRangeMax = 255.0f;
 
+  // Converts @roi of @src into one image of a tensor with @output_shape, which
+  // starts at @output.
+  void ConvertRoi(const cv::Mat& src, const RotatedRect& roi,
+                  const ValueTransformation& transform,
+                  const Tensor::Shape& output_shape, uint8* output) {
     const int output_height = output_shape.dims[1];
     const int output_width = output_shape.dims[2];
     const int output_channels = output_shape.dims[3];
-    const int num_elements_per_img =
-        output_height * output_width * output_channels;
-    auto buffer_view = output_tensor.GetCpuWriteView();
-    cv::Mat dst;
-    const int dst_data_type = output_channels == 1 ? mat_gray_type_ : mat_type_;
-    switch (tensor_type_) {
-      case Tensor::ElementType::kInt8:
-        RET_CHECK_GE(output_shape.num_elements(),
-                     tensor_buffer_offset / sizeof(int8) + num_elements_per_img)
-            << "The buffer offset + the input image size is larger than the "
-               "allocated tensor buffer.";
-        dst = cv::Mat(
-            output_height, output_width, dst_data_type,
-            buffer_view.buffer<int8>() + tensor_buffer_offset / sizeof(int8));
-        break;
-      case Tensor::ElementType::kFloat32:
-        RET_CHECK_GE(
-            output_shape.num_elements(),
-            tensor_buffer_offset / sizeof(float) + num_elements_per_img)
-            << "The buffer offset + the input image size is larger than the "
-               "allocated tensor buffer.";
-        dst = cv::Mat(
-            output_height, output_width, dst_data_type,
-            buffer_view.buffer<float>() + tensor_buffer_offset / sizeof(float));
-        break;
-      case Tensor::ElementType::kUInt8:
-        RET_CHECK_GE(
-            output_shape.num_elements(),
-            tensor_buffer_offset / sizeof(uint8) + num_elements_per_img)
-            << "The buffer offset + the input image size is larger than the "
-               "allocated tensor buffer.";
-        dst = cv::Mat(
-            output_height, output_width, dst_data_type,
-            buffer_view.buffer<uint8>() + tensor_buffer_offset / sizeof(uint8));
-        break;
-      default:
-        return InvalidArgumentError(
-            absl::StrCat("Unsupported tensor type: ", tensor_type_));
+    if (IsSupportedByImageToTensorCpuKernel(src.channels(), output_channels)) {
+      // Sample, normalize and store each value in a single pass, without an
+      // intermediate image.
+      const CpuImageView image = {src.data, src.cols, src.rows, src.channels(),
+                                  static_cast<int>(src.step)};
+      const SamplingTransform sampling =
+          GetSamplingTransform(roi, output_width, output_height);
+      switch (tensor_type_) {
+        case Tensor::ElementType::kInt8:
+          SampleImageToTensor(image, sampling, border_mode_, transform.scale,
+                              transform.offset, output_width, output_height,
+                              output_channels, TensorLayout::kNhwc,
+                              reinterpret_cast<int8*>(output));
+          break;
+        case Tensor::ElementType::kFloat32:
+          SampleImageToTensor(image, sampling, border_mode_, transform.scale,
+                              transform.offset, output_width, output_height,
+                              output_channels, TensorLayout::kNhwc,
+                              reinterpret_cast<float*>(output));
+          break;
+        default:
+          SampleImageToTensor(image, sampling, border_mode_, transform.scale,
+                              transform.offset, output_width, output_height,
+                              output_channels, TensorLayout::kNhwc, output);
+          break;
+      }
+      return;
     }
 
+    const int dst_data_type = output_channels == 1 ? mat_gray_type_ : mat_type_;
+    cv::Mat dst(output_height, output_width, dst_data_type, output);
     const cv::RotatedRect rotated_rect(cv::Point2f(roi.center_x, roi.center_y),
                                        cv::Size2f(roi.width, roi.height),
                                        roi.rotation * 180.f / M_PI);
@@ -140,15 +206,14 @@ class OpenCvProcessor : public ImageToTensorConverter {
                             dst_width, dst_height};
     /* clang-format on */
 
-    auto src = mediapipe::formats::MatView(&input);
     cv::Mat dst_points = cv::Mat(4, 2, CV_32F, dst_corners);
     cv::Mat projection_matrix =
         cv::getPerspectiveTransform(src_points, dst_points);
     cv::Mat transformed;
-    cv::warpPerspective(*src, transformed, projection_matrix,
+    cv::warpPerspective(src, transformed, projection_matrix,
                         cv::Size(dst_width, dst_height),
                         /*flags=*/cv::INTER_LINEAR,
-                        /*borderMode=*/border_mode_);
+                        /*borderMode=*/cv_border_mode_);
 
     if (transformed.channels() > output_channels) {
       cv::Mat proper_channels_mat;
@@ -156,18 +221,22 @@ class OpenCvProcessor : public ImageToTensorConverter {
       transformed = proper_channels_mat;
     }
 
-    constexpr float kInputImageRangeMin = 0.0f;
-    constexpr float kInputImageRangeMax = 255.0f;
-    ASSIGN_OR_RETURN(
-        auto transform,
-        GetValueRangeTransformation(kInputImageRangeMin, kInputImageRangeMax,
-                                    range_min, range_max));
     transformed.convertTo(dst, dst_data_type, transform.scale,
                           transform.offset);
+  }
+
+  absl::Status ValidateImageFormat(const mediapipe::Image& input) {
+    const bool is_supported_format =
+        input.image_format() == mediapipe::ImageFormat::SRGB ||
+        input.image_format() == mediapipe::ImageFormat::SRGBA ||
+        input.image_format() == mediapipe::ImageFormat::GRAY8;
+    if (!is_supported_format) {
+      return InvalidArgumentError(absl::StrCat(
+          "Unsupported format: ", static_cast<uint32_t>(input.image_format())));
+    }
     return absl::OkStatus();
   }
 
- private:
   absl::Status ValidateTensorShape(const Tensor::Shape& output_shape) {
     RET_CHECK_EQ(output_shape.dims.size(), 4)
         << "Wrong output dims size: " << output_shape.dims.size();
@@ -178,17 +247,23 @@ class OpenCvProcessor : public ImageToTensorConverter {
     return absl::OkStatus();
   }
 
-  enum cv::BorderTypes border_mode_;
+  BorderMode border_mode_;
+  enum cv::BorderTypes cv_border_mode_;
   Tensor::ElementType tensor_type_;
   int mat_type_;
   int mat_gray_type_;
+  // The number of threads, besides the calling one, that convert the rois of
+  // a batch.
+  int num_batch_threads_;
+  // Converts the rois of a batch in parallel. Created on the first batch.
+  std::unique_ptr<mediapipe::ThreadPool> pool_;
 };
 
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> CreateOpenCvConverter(
     CalculatorContext* cc, BorderMode border_mode,
-    Tensor::ElementType tensor_type) {
+    Tensor::ElementType tensor_type, int num_batch_threads) {
   if (tensor_type != Tensor::ElementType::kInt8 &&
       tensor_type != Tensor::ElementType::kFloat32 &&
       tensor_type != Tensor::ElementType::kUInt8) {
@@ -196,7 +271,9 @@ absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> CreateOpenCvConverter(
         "Tensor type is currently not supported by OpenCvProcessor, type: ",
         tensor_type));
   }
-  return absl::make_unique<OpenCvProcessor>(border_mode, tensor_type);
+  RET_CHECK_GE(num_batch_threads, 0);
+  return absl::make_unique<OpenCvProcessor>(border_mode, tensor_type,
+                                            num_batch_threads);
 }
 
 }  // namespace mediapipe
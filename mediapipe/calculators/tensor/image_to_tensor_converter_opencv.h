@@ -23,10 +23,11 @@
 
 namespace mediapipe {
 
-// Creates OpenCV image-to-tensor converter.
+// Creates OpenCV image-to-tensor converter. ConvertBatch extracts the rois on
+// @num_batch_threads threads besides the calling one, or serially if 0.
 absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> CreateOpenCvConverter(
     CalculatorContext* cc, BorderMode border_mode,
-    Tensor::ElementType tensor_type);
+    Tensor::ElementType tensor_type, int num_batch_threads = 0);
 
 }  // namespace mediapipe
 
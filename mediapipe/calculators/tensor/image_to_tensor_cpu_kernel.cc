@@ -0,0 +1,232 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/image_to_tensor_cpu_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The arguments of SampleImageToTensor, shared by every output row.
+struct SamplingArgs {
+  CpuImageView image;
+  SamplingTransform transform;
+  BorderMode border_mode;
+  float scale;
+  float offset;
+  int output_width;
+  int output_height;
+};
+
+// Converts a normalized value to the output type, like cv::saturate_cast.
+template <typename T>
+inline T ToOutput(float value);
+
+template <>
+inline float ToOutput<float>(float value) {
+  return value;
+}
+
+template <>
+inline uint8 ToOutput<uint8>(float value) {
+  return static_cast<uint8>(
+      std::min(std::max(std::nearbyint(value), 0.0f), 255.0f));
+}
+
+template <>
+inline int8 ToOutput<int8>(float value) {
+  return static_cast<int8>(
+      std::min(std::max(std::nearbyint(value), -128.0f), 127.0f));
+}
+
+// Returns the input pixel at (x, y), or null if it lies outside the image and
+// the border is zero.
+inline const uint8* BorderPixel(const SamplingArgs& args, int x, int y) {
+  const CpuImageView& image = args.image;
+  if (args.border_mode == BorderMode::kReplicate) {
+    x = std::min(std::max(x, 0), image.width - 1);
+    y = std::min(std::max(y, 0), image.height - 1);
+  } else if (x < 0 || y < 0 || x >= image.width || y >= image.height) {
+    return nullptr;
+  }
+  return image.data + y * image.row_stride + x * image.channels;
+}
+
+// Returns channel c of a pixel that may be outside the image.
+inline float BorderValue(const uint8* pixel, int c) {
+  return pixel ? pixel[c] : 0.0f;
+}
+
+// Samples output row y. The channel counts and the layout are compile-time
+// constants, so that the per-channel loops are unrolled and the interior
+// pixels, which need no bounds checks, are computed without branches.
+template <typename T, int kInputChannels, int kOutputChannels,
+          TensorLayout kLayout>
+void SampleRow(const SamplingArgs& args, int y, T* output) {
+  const CpuImageView& image = args.image;
+  const SamplingTransform& transform = args.transform;
+  const int width = args.output_width;
+  const int plane_size = args.output_width * args.output_height;
+  T* row_output = kLayout == TensorLayout::kNhwc
+                      ? output + y * width * kOutputChannels
+                      : output + y * width;
+  // Positions outside [-2, size] all sample the border alone, and clamping
+  // to them keeps the conversion to int defined.
+  const float max_x = image.width;
+  const float max_y = image.height;
+  for (int x = 0; x < width; ++x) {
+    const float sx = transform.origin_x + x * transform.x_step_x +
+                     y * transform.y_step_x;
+    const float sy = transform.origin_y + x * transform.x_step_y +
+                     y * transform.y_step_y;
+    const float floor_x = std::min(std::max(std::floor(sx), -2.0f), max_x);
+    const float floor_y = std::min(std::max(std::floor(sy), -2.0f), max_y);
+    const int x0 = static_cast<int>(floor_x);
+    const int y0 = static_cast<int>(floor_y);
+    const float wx = sx - std::floor(sx);
+    const float wy = sy - std::floor(sy);
+
+    float values[kOutputChannels];
+    if (x0 >= 0 && y0 >= 0 && x0 + 1 < image.width && y0 + 1 < image.height) {
+      const uint8* p00 =
+          image.data + y0 * image.row_stride + x0 * kInputChannels;
+      const uint8* p01 = p00 + kInputChannels;
+      const uint8* p10 = p00 + image.row_stride;
+      const uint8* p11 = p10 + kInputChannels;
+      for (int c = 0; c < kOutputChannels; ++c) {
+        const int ic = kInputChannels == 1 ? 0 : c;
+        const float top = p00[ic] + wx * (p01[ic] - p00[ic]);
+        const float bottom = p10[ic] + wx * (p11[ic] - p10[ic]);
+        values[c] = top + wy * (bottom - top);
+      }
+    } else {
+      const uint8* p00 = BorderPixel(args, x0, y0);
+      const uint8* p01 = BorderPixel(args, x0 + 1, y0);
+      const uint8* p10 = BorderPixel(args, x0, y0 + 1);
+      const uint8* p11 = BorderPixel(args, x0 + 1, y0 + 1);
+      for (int c = 0; c < kOutputChannels; ++c) {
+        const int ic = kInputChannels == 1 ? 0 : c;
+        const float top = BorderValue(p00, ic) +
+                          wx * (BorderValue(p01, ic) - BorderValue(p00, ic));
+        const float bottom = BorderValue(p10, ic) +
+                             wx * (BorderValue(p11, ic) - BorderValue(p10, ic));
+        values[c] = top + wy * (bottom - top);
+      }
+    }
+
+    for (int c = 0; c < kOutputChannels; ++c) {
+      const T value = ToOutput<T>(args.scale * values[c] + args.offset);
+      if (kLayout == TensorLayout::kNhwc) {
+        row_output[x * kOutputChannels + c] = value;
+      } else {
+        row_output[c * plane_size + x] = value;
+      }
+    }
+  }
+}
+
+template <typename T, int kInputChannels, int kOutputChannels>
+void SampleRows(const SamplingArgs& args, TensorLayout layout, T* output) {
+  for (int y = 0; y < args.output_height; ++y) {
+    if (layout == TensorLayout::kNhwc) {
+      SampleRow<T, kInputChannels, kOutputChannels, TensorLayout::kNhwc>(
+          args, y, output);
+    } else {
+      SampleRow<T, kInputChannels, kOutputChannels, TensorLayout::kNchw>(
+          args, y, output);
+    }
+  }
+}
+
+}  // namespace
+
+SamplingTransform GetSamplingTransform(const RotatedRect& roi, int output_width,
+                                       int output_height) {
+  // The corners of the roi, as computed by cv::RotatedRect::points(), map to
+  // the corners of the output image: its top-left corner maps to (0, 0), and
+  // the output's x and y axes follow the roi's rotated width and height.
+  const float cos_r = std::cos(roi.rotation);
+  const float sin_r = std::sin(roi.rotation);
+  SamplingTransform transform;
+  transform.x_step_x = cos_r * roi.width / output_width;
+  transform.x_step_y = sin_r * roi.width / output_width;
+  transform.y_step_x = -sin_r * roi.height / output_height;
+  transform.y_step_y = cos_r * roi.height / output_height;
+  transform.origin_x =
+      roi.center_x - 0.5f * (cos_r * roi.width - sin_r * roi.height);
+  transform.origin_y =
+      roi.center_y - 0.5f * (sin_r * roi.width + cos_r * roi.height);
+  return transform;
+}
+
+bool IsSupportedByImageToTensorCpuKernel(int input_channels,
+                                         int output_channels) {
+  switch (input_channels) {
+    case 1:
+      return output_channels == 1 || output_channels == 3;
+    case 3:
+    case 4:
+      return output_channels == 3;
+    default:
+      return false;
+  }
+}
+
+template <typename T>
+void SampleImageToTensor(const CpuImageView& image,
+                         const SamplingTransform& transform,
+                         BorderMode border_mode, float scale, float offset,
+                         int output_width, int output_height,
+                         int output_channels, TensorLayout layout, T* output) {
+  CHECK(IsSupportedByImageToTensorCpuKernel(image.channels, output_channels))
+      << "Unsupported conversion from " << image.channels << " to "
+      << output_channels << " channels.";
+  const SamplingArgs args = {image,  transform,    border_mode,  scale,
+                             offset, output_width, output_height};
+  if (image.channels == 1 && output_channels == 1) {
+    SampleRows<T, 1, 1>(args, layout, output);
+  } else if (image.channels == 1) {
+    SampleRows<T, 1, 3>(args, layout, output);
+  } else if (image.channels == 3) {
+    SampleRows<T, 3, 3>(args, layout, output);
+  } else {
+    SampleRows<T, 4, 3>(args, layout, output);
+  }
+}
+
+template void SampleImageToTensor<float>(const CpuImageView& image,
+                                         const SamplingTransform& transform,
+                                         BorderMode border_mode, float scale,
+                                         float offset, int output_width,
+                                         int output_height, int output_channels,
+                                         TensorLayout layout, float* output);
+template void SampleImageToTensor<uint8>(const CpuImageView& image,
+                                         const SamplingTransform& transform,
+                                         BorderMode border_mode, float scale,
+                                         float offset, int output_width,
+                                         int output_height, int output_channels,
+                                         TensorLayout layout, uint8* output);
+template void SampleImageToTensor<int8>(const CpuImageView& image,
+                                        const SamplingTransform& transform,
+                                        BorderMode border_mode, float scale,
+                                        float offset, int output_width,
+                                        int output_height, int output_channels,
+                                        TensorLayout layout, int8* output);
+
+}  // namespace mediapipe
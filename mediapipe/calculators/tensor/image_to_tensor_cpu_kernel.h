@@ -0,0 +1,81 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CPU_KERNEL_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CPU_KERNEL_H_
+
+#include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// An image in CPU memory with interleaved 8-bit channels.
+struct CpuImageView {
+  const uint8* data;
+  int width;
+  int height;
+  // 1 (gray), 3 (RGB) or 4 (RGBA).
+  int channels;
+  // The distance between the starts of two rows, in bytes.
+  int row_stride;
+};
+
+// The order of the dimensions of an output tensor image.
+enum class TensorLayout { kNhwc, kNchw };
+
+// Maps output pixel (x, y) to the input image position
+// (origin_x + x * x_step_x + y * y_step_x,
+//  origin_y + x * x_step_y + y * y_step_y).
+struct SamplingTransform {
+  float origin_x;
+  float origin_y;
+  float x_step_x;
+  float x_step_y;
+  float y_step_x;
+  float y_step_y;
+};
+
+// Returns the transform which samples @roi of an image into an output image
+// of @output_width x @output_height. This is the same mapping as
+// cv::warpPerspective from the corners of the cv::RotatedRect for @roi to the
+// corners of the output image.
+SamplingTransform GetSamplingTransform(const RotatedRect& roi, int output_width,
+                                       int output_height);
+
+// Returns true if SampleImageToTensor supports converting an image with
+// @input_channels into a tensor image with @output_channels. Gray images can
+// be converted into 1 or 3 channels, RGB and RGBA images into 3 channels.
+bool IsSupportedByImageToTensorCpuKernel(int input_channels,
+                                         int output_channels);
+
+// Crops, rotates and resizes an image into a tensor image, and converts each
+// value v into scale * v + offset, in a single pass over the output.
+//
+// Each output value is interpolated bilinearly from the input image at the
+// position given by @transform, and pixels outside the input image are
+// extrapolated according to @border_mode. Integer outputs are rounded to the
+// nearest value and saturated, as by cv::Mat::convertTo.
+//
+// @output holds @output_height * @output_width * @output_channels values in
+// @layout. T is float, uint8 or int8.
+template <typename T>
+void SampleImageToTensor(const CpuImageView& image,
+                         const SamplingTransform& transform,
+                         BorderMode border_mode, float scale, float offset,
+                         int output_width, int output_height,
+                         int output_channels, TensorLayout layout, T* output);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CPU_KERNEL_H_
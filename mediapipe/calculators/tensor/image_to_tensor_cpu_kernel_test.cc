@@ -0,0 +1,234 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/image_to_tensor_cpu_kernel.h"
+
+#include <cmath>
+#include <vector>
+
+#include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+
+namespace mediapipe {
+namespace {
+
+// Returns a smooth image, so that both implementations interpolate it almost
+// exactly.
+cv::Mat MakeImage(int width, int height, int channels) {
+  cv::Mat image(height, width, CV_8UC(channels));
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      for (int c = 0; c < channels; ++c) {
+        image.ptr<uint8>(y)[x * channels + c] = static_cast<uint8>(
+            128 + 100 * std::sin((x + 10 * c) / 9.0) * std::cos(y / 7.0));
+      }
+    }
+  }
+  return image;
+}
+
+// Converts an image into a tensor image the way ImageToTensorConverterOpenCv
+// did before it used the kernel.
+cv::Mat ConvertWithOpenCv(const cv::Mat& image, const RotatedRect& roi,
+                          BorderMode border_mode, float scale, float offset,
+                          int output_width, int output_height,
+                          int output_type) {
+  const cv::RotatedRect rotated_rect(cv::Point2f(roi.center_x, roi.center_y),
+                                     cv::Size2f(roi.width, roi.height),
+                                     roi.rotation * 180.f / M_PI);
+  cv::Mat src_points;
+  cv::boxPoints(rotated_rect, src_points);
+  const float dst_width = output_width;
+  const float dst_height = output_height;
+  /* clang-format off */
+  float dst_corners[8] = {0.0f,      dst_height,
+                          0.0f,      0.0f,
+                          dst_width, 0.0f,
+                          dst_width, dst_height};
+  /* clang-format on */
+  cv::Mat dst_points = cv::Mat(4, 2, CV_32F, dst_corners);
+  cv::Mat projection_matrix =
+      cv::getPerspectiveTransform(src_points, dst_points);
+  cv::Mat transformed;
+  cv::warpPerspective(image, transformed, projection_matrix,
+                      cv::Size(output_width, output_height),
+                      /*flags=*/cv::INTER_LINEAR,
+                      /*borderMode=*/border_mode == BorderMode::kZero
+                          ? cv::BORDER_CONSTANT
+                          : cv::BORDER_REPLICATE);
+  if (transformed.channels() == 4) {
+    cv::cvtColor(transformed, transformed, cv::COLOR_RGBA2RGB);
+  }
+  cv::Mat result;
+  transformed.convertTo(result, output_type, scale, offset);
+  return result;
+}
+
+CpuImageView ViewOf(const cv::Mat& image) {
+  return {image.data, image.cols, image.rows, image.channels(),
+          static_cast<int>(image.step)};
+}
+
+struct KernelTestCase {
+  int channels;
+  RotatedRect roi;
+  BorderMode border_mode;
+};
+
+class ImageToTensorCpuKernelOpenCvTest
+    : public testing::TestWithParam<KernelTestCase> {};
+
+TEST_P(ImageToTensorCpuKernelOpenCvTest, MatchesOpenCv) {
+  const KernelTestCase& test_case = GetParam();
+  const cv::Mat image = MakeImage(64, 48, test_case.channels);
+  constexpr int kOutputWidth = 40;
+  constexpr int kOutputHeight = 30;
+  constexpr float kScale = 2.0f / 255.0f;
+  constexpr float kOffset = -1.0f;
+  const int channels = test_case.channels == 1 ? 1 : 3;
+  const int row_size = kOutputWidth * channels;
+
+  const SamplingTransform transform =
+      GetSamplingTransform(test_case.roi, kOutputWidth, kOutputHeight);
+  std::vector<float> output(row_size * kOutputHeight);
+  SampleImageToTensor(ViewOf(image), transform, test_case.border_mode, kScale,
+                      kOffset, kOutputWidth, kOutputHeight, channels,
+                      TensorLayout::kNhwc, output.data());
+  const cv::Mat expected = ConvertWithOpenCv(
+      image, test_case.roi, test_case.border_mode, kScale, kOffset,
+      kOutputWidth, kOutputHeight, CV_32FC(channels));
+  // OpenCV interpolates with weights in steps of 1/32, and rounds to uint8
+  // before the value range conversion, which makes values differ by a few
+  // levels where a sample next to the border mixes in zeros.
+  constexpr float kMaxLevelDiff = 4;
+  for (int y = 0; y < kOutputHeight; ++y) {
+    for (int x = 0; x < row_size; ++x) {
+      ASSERT_NEAR(expected.ptr<float>(y)[x], output[y * row_size + x],
+                  kMaxLevelDiff * kScale)
+          << "at (" << x / channels << ", " << y << ")";
+    }
+  }
+
+  std::vector<uint8> uint8_output(row_size * kOutputHeight);
+  SampleImageToTensor(ViewOf(image), transform, test_case.border_mode, 1.0f,
+                      0.0f, kOutputWidth, kOutputHeight, channels,
+                      TensorLayout::kNhwc, uint8_output.data());
+  const cv::Mat expected_uint8 =
+      ConvertWithOpenCv(image, test_case.roi, test_case.border_mode, 1.0f,
+                        0.0f, kOutputWidth, kOutputHeight, CV_8UC(channels));
+  for (int y = 0; y < kOutputHeight; ++y) {
+    for (int x = 0; x < row_size; ++x) {
+      ASSERT_NEAR(expected_uint8.ptr<uint8>(y)[x],
+                  uint8_output[y * row_size + x], kMaxLevelDiff)
+          << "at (" << x / channels << ", " << y << ")";
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ImageToTensorCpuKernelOpenCvTests, ImageToTensorCpuKernelOpenCvTest,
+    testing::Values(
+        // Gray, RGB and RGBA images, inside the image.
+        KernelTestCase{1, {32, 24, 40, 30, 0}, BorderMode::kZero},
+        KernelTestCase{3, {30, 20, 25, 20, 0}, BorderMode::kZero},
+        KernelTestCase{4, {30, 20, 25, 20, 0}, BorderMode::kReplicate},
+        // Rotated and partly outside the image.
+        KernelTestCase{3, {10, 40, 50, 30, 0.7f}, BorderMode::kZero},
+        KernelTestCase{3, {10, 40, 50, 30, 0.7f}, BorderMode::kReplicate},
+        KernelTestCase{4, {60, 5, 30, 40, -2.5f}, BorderMode::kReplicate}));
+
+TEST(ImageToTensorCpuKernelTest, NchwIsTransposedNhwc) {
+  const cv::Mat image = MakeImage(32, 32, 3);
+  constexpr int kSize = 16;
+  const SamplingTransform transform =
+      GetSamplingTransform({16, 16, 20, 20, 0.3f}, kSize, kSize);
+  std::vector<int8> nhwc(kSize * kSize * 3);
+  std::vector<int8> nchw(kSize * kSize * 3);
+  SampleImageToTensor(ViewOf(image), transform, BorderMode::kZero, 1.0f,
+                      -128.0f, kSize, kSize, 3, TensorLayout::kNhwc,
+                      nhwc.data());
+  SampleImageToTensor(ViewOf(image), transform, BorderMode::kZero, 1.0f,
+                      -128.0f, kSize, kSize, 3, TensorLayout::kNchw,
+                      nchw.data());
+  for (int i = 0; i < kSize * kSize; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      ASSERT_EQ(nhwc[i * 3 + c], nchw[c * kSize * kSize + i]);
+    }
+  }
+}
+
+TEST(ImageToTensorCpuKernelTest, ReplicatesGrayChannels) {
+  const cv::Mat image = MakeImage(20, 10, 1);
+  constexpr int kWidth = 8;
+  constexpr int kHeight = 4;
+  const SamplingTransform transform =
+      GetSamplingTransform({10, 5, 20, 10, 0}, kWidth, kHeight);
+  std::vector<float> gray(kWidth * kHeight);
+  std::vector<float> rgb(kWidth * kHeight * 3);
+  SampleImageToTensor(ViewOf(image), transform, BorderMode::kReplicate, 1.0f,
+                      0.0f, kWidth, kHeight, 1, TensorLayout::kNhwc,
+                      gray.data());
+  SampleImageToTensor(ViewOf(image), transform, BorderMode::kReplicate, 1.0f,
+                      0.0f, kWidth, kHeight, 3, TensorLayout::kNhwc,
+                      rgb.data());
+  for (int i = 0; i < kWidth * kHeight; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      ASSERT_EQ(gray[i], rgb[i * 3 + c]);
+    }
+  }
+  EXPECT_FALSE(IsSupportedByImageToTensorCpuKernel(3, 1));
+  EXPECT_FALSE(IsSupportedByImageToTensorCpuKernel(2, 3));
+}
+
+// Converts a rotated crop of a camera frame into a face detection input.
+constexpr int kFrameWidth = 1280;
+constexpr int kFrameHeight = 720;
+constexpr int kTensorSize = 128;
+const RotatedRect kBenchmarkRoi = {640, 360, 600, 600, 0.2f};
+
+void BM_ImageToTensorOpenCv(benchmark::State& state) {
+  const cv::Mat image = MakeImage(kFrameWidth, kFrameHeight, 3);
+  for (auto _ : state) {
+    cv::Mat result =
+        ConvertWithOpenCv(image, kBenchmarkRoi, BorderMode::kZero,
+                          2.0f / 255.0f, -1.0f, kTensorSize, kTensorSize,
+                          CV_32FC3);
+    benchmark::DoNotOptimize(result.data);
+  }
+}
+BENCHMARK(BM_ImageToTensorOpenCv);
+
+void BM_ImageToTensorCpuKernel(benchmark::State& state) {
+  const cv::Mat image = MakeImage(kFrameWidth, kFrameHeight, 3);
+  const TensorLayout layout =
+      state.range(0) ? TensorLayout::kNchw : TensorLayout::kNhwc;
+  std::vector<float> output(kTensorSize * kTensorSize * 3);
+  for (auto _ : state) {
+    const SamplingTransform transform =
+        GetSamplingTransform(kBenchmarkRoi, kTensorSize, kTensorSize);
+    SampleImageToTensor(ViewOf(image), transform, BorderMode::kZero,
+                        2.0f / 255.0f, -1.0f, kTensorSize, kTensorSize, 3,
+                        layout, output.data());
+    benchmark::DoNotOptimize(output.data());
+  }
+}
+// Arg is 0 for NHWC and 1 for NCHW.
+BENCHMARK(BM_ImageToTensorCpuKernel)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,110 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/inference_batcher.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "mediapipe/calculators/tensor/inference_calculator.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+namespace api2 {
+
+InferenceBatcher::InferenceBatcher(
+    const mediapipe::InferenceCalculatorOptions::Batching& options)
+    : max_batch_size_(std::max(options.max_batch_size(), 1)),
+      max_batch_delay_(absl::Microseconds(options.max_batch_delay_us())) {
+  pending_.reserve(max_batch_size_);
+}
+
+namespace {
+
+bool BatchingEnabled(const mediapipe::InferenceCalculatorOptions& options,
+                     bool batch_end_connected) {
+  return options.batching().max_batch_size() > 1 || batch_end_connected;
+}
+
+}  // namespace
+
+// static
+bool InferenceBatcher::IsEnabled(CalculatorContext* cc) {
+  return BatchingEnabled(
+      cc->Options<mediapipe::InferenceCalculatorOptions>(),
+      InferenceCalculator::kInBatchEnd(cc).IsConnected());
+}
+
+// static
+absl::Status InferenceBatcher::UpdateContract(CalculatorContract* cc) {
+  if (!BatchingEnabled(cc->Options<mediapipe::InferenceCalculatorOptions>(),
+                       InferenceCalculator::kInBatchEnd(cc).IsConnected())) {
+    return absl::OkStatus();
+  }
+  // Held-back inputs are sent later, below the bound that offset 0 would set.
+  cc->SetTimestampOffset(TimestampDiff::Unset());
+  // Lets bound updates advance the output bound and check the batch delay.
+  cc->SetProcessTimestampBounds(true);
+  return absl::OkStatus();
+}
+
+absl::Status InferenceBatcher::Process(CalculatorContext* cc,
+                                       InferenceRunner* runner) {
+  const absl::Time now = absl::Now();
+  if (!InferenceCalculator::kInTensors(cc).IsEmpty()) {
+    RET_CHECK(!InferenceCalculator::kInTensors(cc)->empty());
+    if (pending_.empty()) {
+      oldest_arrival_time_ = now;
+    }
+    pending_.push_back(InferenceCalculator::kInTensors(cc));
+  }
+  const bool batch_ended = !InferenceCalculator::kInBatchEnd(cc).IsEmpty();
+  const bool deadline_passed = !pending_.empty() &&
+                               max_batch_delay_ > absl::ZeroDuration() &&
+                               now - oldest_arrival_time_ >= max_batch_delay_;
+  if (static_cast<int>(pending_.size()) >= max_batch_size_ || batch_ended ||
+      deadline_passed) {
+    MP_RETURN_IF_ERROR(Flush(cc, runner));
+  }
+  InferenceCalculator::kOutTensors(cc).SetNextTimestampBound(
+      pending_.empty() ? cc->InputTimestamp().NextAllowedInStream()
+                       : pending_.front().timestamp());
+  return absl::OkStatus();
+}
+
+absl::Status InferenceBatcher::Flush(CalculatorContext* cc,
+                                     InferenceRunner* runner) {
+  if (pending_.empty()) {
+    return absl::OkStatus();
+  }
+  std::vector<const std::vector<Tensor>*> batch;
+  batch.reserve(pending_.size());
+  for (const auto& packet : pending_) {
+    batch.push_back(&packet.Get());
+  }
+  ASSIGN_OR_RETURN(std::vector<std::vector<Tensor>> outputs,
+                   runner->RunBatch(cc, batch));
+  RET_CHECK_EQ(outputs.size(), pending_.size());
+  for (int i = 0; i < outputs.size(); ++i) {
+    InferenceCalculator::kOutTensors(cc).Send(std::move(outputs[i]),
+                                              pending_[i].timestamp());
+  }
+  pending_.clear();
+  return absl::OkStatus();
+}
+
+}  // namespace api2
+}  // namespace mediapipe
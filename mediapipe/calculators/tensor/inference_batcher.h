@@ -0,0 +1,74 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_BATCHER_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_BATCHER_H_
+
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "mediapipe/calculators/tensor/inference_calculator.pb.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/framework/api2/packet.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/tensor.h"
+
+namespace mediapipe {
+namespace api2 {
+
+// Implements the dynamic batching mode of the CPU InferenceCalculators.
+//
+// Input packets of the TENSORS stream are held back until a batch is
+// complete, as configured by InferenceCalculatorOptions.batching, and are then
+// run as a single batch by the InferenceRunner. The outputs are sent to the
+// TENSORS output stream with the timestamps of the corresponding inputs.
+//
+// Since outputs are sent after later inputs have arrived, the calculator has
+// no timestamp offset while batching. Instead, the output timestamp bound is
+// kept just below the oldest held-back input. There is no timer: the batch
+// delay is checked whenever packets or timestamp bounds arrive.
+class InferenceBatcher {
+ public:
+  explicit InferenceBatcher(
+      const mediapipe::InferenceCalculatorOptions::Batching& options);
+
+  // Returns true if the calculator with the given options should use dynamic
+  // batching.
+  static bool IsEnabled(CalculatorContext* cc);
+
+  // Adjusts the contract of a calculator that uses dynamic batching. Must be
+  // called from UpdateContract().
+  static absl::Status UpdateContract(CalculatorContract* cc);
+
+  // Holds back the TENSORS input of `cc`, if any, and runs the held-back
+  // inputs if the batch is complete, a BATCH_END packet arrived, or the batch
+  // delay has passed. Advances the TENSORS output bound.
+  absl::Status Process(CalculatorContext* cc, InferenceRunner* runner);
+
+  // Runs the held-back inputs, if any. Must be called from Close().
+  absl::Status Flush(CalculatorContext* cc, InferenceRunner* runner);
+
+ private:
+  const int max_batch_size_;
+  const absl::Duration max_batch_delay_;
+  std::vector<Packet<std::vector<Tensor>>> pending_;
+  // Arrival time of the oldest held-back input.
+  absl::Time oldest_arrival_time_;
+};
+
+}  // namespace api2
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_BATCHER_H_
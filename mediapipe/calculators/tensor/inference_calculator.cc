@@ -19,10 +19,13 @@
 #include <string>
 #include <vector>
 
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
 #include "mediapipe/framework/api2/packet.h"
+#include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/tool/subgraph_expansion.h"
 #include "tensorflow/lite/core/api/op_resolver.h"
 
@@ -98,5 +101,30 @@ InferenceCalculator::GetOpResolverAsPacket(CalculatorContext* cc) {
                            BuiltinOpResolverWithoutDefaultDelegates>());
 }
 
+absl::StatusOr<std::unique_ptr<InferenceRunner>>
+InferenceCalculator::GetSharedInferenceRunner(
+    CalculatorContext* cc, const Packet<TfLiteModelPtr>& model_packet,
+    InferenceServer::RunnerFactory create_runner) {
+  auto server = cc->Service(kInferenceServerService);
+  RET_CHECK(server.IsAvailable()) << "InferenceServer is not available.";
+  // The engine is keyed by the model contents rather than by the path, since
+  // models can be passed as side packets, and by everything that affects the
+  // interpreter and delegate configuration.
+  const auto* allocation = model_packet.Get()->allocation();
+  RET_CHECK(allocation) << "Cannot share a model without an allocation.";
+  const absl::string_view model_bytes(
+      static_cast<const char*>(allocation->base()), allocation->bytes());
+  std::string options =
+      cc->Options<mediapipe::InferenceCalculatorOptions>().SerializeAsString();
+  if (!kDelegate(cc).IsEmpty()) {
+    absl::StrAppend(&options, kDelegate(cc).Get().SerializeAsString());
+  }
+  const std::string model_key =
+      absl::StrCat(cc->CalculatorType(), ":",
+                   absl::Hash<absl::string_view>()(model_bytes), ":",
+                   model_bytes.size(), ":", absl::Hash<std::string>()(options));
+  return server.GetObject().GetRunner(model_key, create_runner);
+}
+
 }  // namespace api2
 }  // namespace mediapipe
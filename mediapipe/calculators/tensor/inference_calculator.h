@@ -21,6 +21,8 @@
 #include <vector>
 
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/inference_server.h"
 #include "mediapipe/framework/api2/node.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/tensor.h"
@@ -46,6 +48,9 @@ namespace api2 {
 //
 // Input:
 //  TENSORS - Vector of Tensors
+//  BATCH_END (optional) - Timestamp. Runs inference on the inputs held back by
+//                         dynamic batching, see
+//                         InferenceCalculatorOptions.batching.
 //
 // Output:
 //  TENSORS - Vector of Tensors
@@ -94,6 +99,7 @@ namespace api2 {
 class InferenceCalculator : public NodeIntf {
  public:
   static constexpr Input<std::vector<Tensor>> kInTensors{"TENSORS"};
+  static constexpr Input<Timestamp>::Optional kInBatchEnd{"BATCH_END"};
   // Deprecated. Prefers to use "OP_RESOLVER" input side packet instead.
   // TODO: Removes the "CUSTOM_OP_RESOLVER" side input after the
   // migration.
@@ -106,7 +112,7 @@ class InferenceCalculator : public NodeIntf {
   static constexpr SideInput<
       mediapipe::InferenceCalculatorOptions::Delegate>::Optional kDelegate{
       "DELEGATE"};
-  MEDIAPIPE_NODE_CONTRACT(kInTensors, kSideInCustomOpResolver,
+  MEDIAPIPE_NODE_CONTRACT(kInTensors, kInBatchEnd, kSideInCustomOpResolver,
                           kSideInOpResolver, kSideInModel, kOutTensors,
                           kDelegate);
 
@@ -120,6 +126,14 @@ class InferenceCalculator : public NodeIntf {
 
   static absl::StatusOr<Packet<tflite::OpResolver>> GetOpResolverAsPacket(
       CalculatorContext* cc);
+
+  // Returns a runner that shares the runners created by `create_runner`
+  // between all calculators that use the same model and options, through the
+  // InferenceServer graph service. Used if `use_inference_server` is set.
+  static absl::StatusOr<std::unique_ptr<InferenceRunner>>
+  GetSharedInferenceRunner(CalculatorContext* cc,
+                           const Packet<TfLiteModelPtr>& model_packet,
+                           InferenceServer::RunnerFactory create_runner);
 };
 
 struct InferenceCalculatorSelector : public InferenceCalculator {
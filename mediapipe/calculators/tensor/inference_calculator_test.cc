@@ -180,6 +180,45 @@ TEST(InferenceCalculatorTest, ModelAsInputSidePacketSmokeTest) {
   DoSmokeTest(kGraphWithModelAsInputSidePacket);
 }
 
+// Tests that held-back inputs are run as batches and sent with their original
+// timestamps, including the incomplete last batch that is flushed on close.
+TEST(InferenceCalculatorTest, DynamicBatchingSmokeTest) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+          kGraphWithModelPathInOption,
+          {{"$delegate",
+            "delegate { tflite {} } batching { max_batch_size: 2 }"}}));
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+  constexpr int kNumPackets = 5;
+  for (int i = 0; i < kNumPackets; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in",
+        MakePacket<std::vector<Tensor>>(CreateInputs()).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(kNumPackets, output_packets.size());
+  for (int i = 0; i < kNumPackets; ++i) {
+    EXPECT_EQ(Timestamp(i), output_packets[i].Timestamp());
+    const std::vector<Tensor>& result_vec =
+        output_packets[i].Get<std::vector<Tensor>>();
+    ASSERT_EQ(1, result_vec.size());
+    const Tensor& result = result_vec[0];
+    EXPECT_EQ(result.shape().dims,
+              std::vector<int>({1, kTensorHeight, kTensorWidth,
+                                kTensorChannels}));
+    auto view = result.GetCpuReadView();
+    auto result_buffer = view.buffer<float>();
+    for (int j = 0; j < result.shape().num_elements(); j++) {
+      ASSERT_EQ(3, result_buffer[j]);
+    }
+  }
+}
+
 void BM_InitializeCalculator(benchmark::State& state) {
   mediapipe::InferenceCalculatorOptions::Delegate delegate;
   delegate.mutable_tflite();
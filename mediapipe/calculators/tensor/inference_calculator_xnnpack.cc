@@ -20,6 +20,7 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "mediapipe/calculators/tensor/inference_batcher.h"
 #include "mediapipe/calculators/tensor/inference_calculator.h"
 #include "mediapipe/calculators/tensor/inference_calculator_utils.h"
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
@@ -46,6 +47,8 @@ class InferenceCalculatorXnnpackImpl
   absl::StatusOr<TfLiteDelegatePtr> CreateDelegate(CalculatorContext* cc);
 
   std::unique_ptr<InferenceRunner> inference_runner_;
+  // Set if dynamic batching is enabled.
+  std::unique_ptr<InferenceBatcher> batcher_;
 };
 
 absl::Status InferenceCalculatorXnnpackImpl::UpdateContract(
@@ -53,16 +56,27 @@ absl::Status InferenceCalculatorXnnpackImpl::UpdateContract(
   const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
   RET_CHECK(!options.model_path().empty() ^ kSideInModel(cc).IsConnected())
       << "Either model as side packet or model path in options is required.";
+  if (options.use_inference_server()) {
+    cc->UseService(kInferenceServerService);
+  }
+  MP_RETURN_IF_ERROR(InferenceBatcher::UpdateContract(cc));
 
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorXnnpackImpl::Open(CalculatorContext* cc) {
   ASSIGN_OR_RETURN(inference_runner_, CreateInferenceRunner(cc));
+  if (InferenceBatcher::IsEnabled(cc)) {
+    batcher_ = std::make_unique<InferenceBatcher>(
+        cc->Options<mediapipe::InferenceCalculatorOptions>().batching());
+  }
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorXnnpackImpl::Process(CalculatorContext* cc) {
+  if (batcher_) {
+    return batcher_->Process(cc, inference_runner_.get());
+  }
   if (kInTensors(cc).IsEmpty()) {
     return absl::OkStatus();
   }
@@ -76,6 +90,9 @@ absl::Status InferenceCalculatorXnnpackImpl::Process(CalculatorContext* cc) {
 }
 
 absl::Status InferenceCalculatorXnnpackImpl::Close(CalculatorContext* cc) {
+  if (batcher_) {
+    MP_RETURN_IF_ERROR(batcher_->Flush(cc, inference_runner_.get()));
+  }
   inference_runner_ = nullptr;
   return absl::OkStatus();
 }
@@ -86,10 +103,18 @@ InferenceCalculatorXnnpackImpl::CreateInferenceRunner(CalculatorContext* cc) {
   ASSIGN_OR_RETURN(auto op_resolver_packet, GetOpResolverAsPacket(cc));
   const int interpreter_num_threads =
       cc->Options<mediapipe::InferenceCalculatorOptions>().cpu_num_thread();
-  ASSIGN_OR_RETURN(TfLiteDelegatePtr delegate, CreateDelegate(cc));
-  return CreateInferenceInterpreterDelegateRunner(
-      std::move(model_packet), std::move(op_resolver_packet),
-      std::move(delegate), interpreter_num_threads);
+  auto create_runner =
+      [&]() -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+    ASSIGN_OR_RETURN(TfLiteDelegatePtr delegate, CreateDelegate(cc));
+    return CreateInferenceInterpreterDelegateRunner(
+        model_packet, op_resolver_packet, std::move(delegate),
+        interpreter_num_threads);
+  };
+  if (cc->Options<mediapipe::InferenceCalculatorOptions>()
+          .use_inference_server()) {
+    return GetSharedInferenceRunner(cc, model_packet, create_runner);
+  }
+  return create_runner();
 }
 
 absl::StatusOr<TfLiteDelegatePtr>
@@ -19,9 +19,11 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "tensorflow/lite/core/shims/c/c_api_types.h"
 #include "tensorflow/lite/core/shims/cc/interpreter.h"
 #include "tensorflow/lite/core/shims/cc/interpreter_builder.h"
@@ -36,21 +38,25 @@ namespace {
 using Interpreter = ::tflite_shims::Interpreter;
 using InterpreterBuilder = ::tflite_shims::InterpreterBuilder;
 
+// Copies `input_tensor` into slot `batch_index` of the interpreter input, i.e.
+// at an offset of `batch_index` times the size of `input_tensor`.
 template <typename T>
 void CopyTensorBufferToInterpreter(const Tensor& input_tensor,
                                    Interpreter* interpreter,
-                                   int input_tensor_index) {
+                                   int input_tensor_index, int batch_index) {
   auto input_tensor_view = input_tensor.GetCpuReadView();
   auto input_tensor_buffer = input_tensor_view.buffer<T>();
   T* local_tensor_buffer =
-      interpreter->typed_input_tensor<T>(input_tensor_index);
+      interpreter->typed_input_tensor<T>(input_tensor_index) +
+      batch_index * input_tensor.shape().num_elements();
   std::memcpy(local_tensor_buffer, input_tensor_buffer, input_tensor.bytes());
 }
 
 template <>
 void CopyTensorBufferToInterpreter<char>(const Tensor& input_tensor,
                                          Interpreter* interpreter,
-                                         int input_tensor_index) {
+                                         int input_tensor_index,
+                                         int batch_index) {
   const char* input_tensor_buffer =
       input_tensor.GetCpuReadView().buffer<char>();
   tflite::DynamicBuffer dynamic_buffer;
@@ -60,18 +66,119 @@ void CopyTensorBufferToInterpreter<char>(const Tensor& input_tensor,
       interpreter->tensor(interpreter->inputs()[input_tensor_index]));
 }
 
+// Copies slot `batch_index` of the interpreter output into `output_tensor`.
 template <typename T>
 void CopyTensorBufferFromInterpreter(Interpreter* interpreter,
-                                     int output_tensor_index,
+                                     int output_tensor_index, int batch_index,
                                      Tensor* output_tensor) {
   auto output_tensor_view = output_tensor->GetCpuWriteView();
   auto output_tensor_buffer = output_tensor_view.buffer<T>();
   T* local_tensor_buffer =
-      interpreter->typed_output_tensor<T>(output_tensor_index);
+      interpreter->typed_output_tensor<T>(output_tensor_index) +
+      batch_index * output_tensor->shape().num_elements();
   std::memcpy(output_tensor_buffer, local_tensor_buffer,
               output_tensor->bytes());
 }
 
+absl::Status CopyInputToInterpreter(const Tensor& input_tensor,
+                                    Interpreter* interpreter,
+                                    int input_tensor_index, int batch_index) {
+  const TfLiteType input_tensor_type =
+      interpreter->tensor(interpreter->inputs()[input_tensor_index])->type;
+  switch (input_tensor_type) {
+    case TfLiteType::kTfLiteFloat16:
+    case TfLiteType::kTfLiteFloat32: {
+      CopyTensorBufferToInterpreter<float>(input_tensor, interpreter,
+                                           input_tensor_index, batch_index);
+      break;
+    }
+    case TfLiteType::kTfLiteUInt8: {
+      CopyTensorBufferToInterpreter<uint8_t>(input_tensor, interpreter,
+                                             input_tensor_index, batch_index);
+      break;
+    }
+    case TfLiteType::kTfLiteInt8: {
+      CopyTensorBufferToInterpreter<int8_t>(input_tensor, interpreter,
+                                            input_tensor_index, batch_index);
+      break;
+    }
+    case TfLiteType::kTfLiteInt32: {
+      CopyTensorBufferToInterpreter<int32_t>(input_tensor, interpreter,
+                                             input_tensor_index, batch_index);
+      break;
+    }
+    case TfLiteType::kTfLiteString: {
+      // String tensors are variable-length and cannot be batched.
+      RET_CHECK_EQ(batch_index, 0);
+      CopyTensorBufferToInterpreter<char>(input_tensor, interpreter,
+                                          input_tensor_index, batch_index);
+      break;
+    }
+    case TfLiteType::kTfLiteBool:
+      // No current use-case for copying MediaPipe Tensors with bool type to
+      // TfLiteTensors.
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported input tensor type:", input_tensor_type));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Tensor> CopyOutputFromInterpreter(Interpreter* interpreter,
+                                                 int output_tensor_index,
+                                                 const Tensor::Shape& shape,
+                                                 int batch_index) {
+  TfLiteTensor* tensor =
+      interpreter->tensor(interpreter->outputs()[output_tensor_index]);
+  switch (tensor->type) {
+    case TfLiteType::kTfLiteFloat16:
+    case TfLiteType::kTfLiteFloat32: {
+      Tensor output_tensor(Tensor::ElementType::kFloat32, shape);
+      CopyTensorBufferFromInterpreter<float>(interpreter, output_tensor_index,
+                                             batch_index, &output_tensor);
+      return output_tensor;
+    }
+    case TfLiteType::kTfLiteUInt8: {
+      Tensor output_tensor(
+          Tensor::ElementType::kUInt8, shape,
+          Tensor::QuantizationParameters{tensor->params.scale,
+                                         tensor->params.zero_point});
+      CopyTensorBufferFromInterpreter<uint8>(interpreter, output_tensor_index,
+                                             batch_index, &output_tensor);
+      return output_tensor;
+    }
+    case TfLiteType::kTfLiteInt8: {
+      Tensor output_tensor(
+          Tensor::ElementType::kInt8, shape,
+          Tensor::QuantizationParameters{tensor->params.scale,
+                                         tensor->params.zero_point});
+      CopyTensorBufferFromInterpreter<int8>(interpreter, output_tensor_index,
+                                            batch_index, &output_tensor);
+      return output_tensor;
+    }
+    case TfLiteType::kTfLiteInt32: {
+      Tensor output_tensor(Tensor::ElementType::kInt32, shape);
+      CopyTensorBufferFromInterpreter<int32_t>(interpreter, output_tensor_index,
+                                               batch_index, &output_tensor);
+      return output_tensor;
+    }
+    case TfLiteType::kTfLiteBool: {
+      Tensor output_tensor(Tensor::ElementType::kBool, shape,
+                           Tensor::QuantizationParameters{1.0f, 0});
+      CopyTensorBufferFromInterpreter<bool>(interpreter, output_tensor_index,
+                                            batch_index, &output_tensor);
+      return output_tensor;
+    }
+    case TfLiteType::kTfLiteString:
+      // No current use-case for copying TfLiteTensors with string type to
+      // MediaPipe Tensors.
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported output tensor type:",
+                       TfLiteTypeGetName(tensor->type)));
+  }
+}
+
 }  // namespace
 
 class InferenceInterpreterDelegateRunner : public InferenceRunner {
@@ -86,53 +193,53 @@ class InferenceInterpreterDelegateRunner : public InferenceRunner {
   absl::StatusOr<std::vector<Tensor>> Run(
       CalculatorContext* cc, const std::vector<Tensor>& input_tensors) override;
 
+  // Stacks the inputs along the first dimension of the interpreter inputs,
+  // runs a single inference and splits the outputs along their first
+  // dimension. The interpreter is only resized when the batch size changes.
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc,
+      const std::vector<const std::vector<Tensor>*>& batch) override;
+
  private:
+  // Resizes the first dimension of all interpreter inputs to hold
+  // `batch_size` inputs and reallocates the interpreter tensors.
+  absl::Status ResizeInputsToBatchSize(int batch_size);
+
   api2::Packet<TfLiteModelPtr> model_;
   std::unique_ptr<Interpreter> interpreter_;
   TfLiteDelegatePtr delegate_;
+  // The number of inputs the interpreter inputs are currently sized for.
+  int batch_size_ = 1;
 };
 
+absl::Status InferenceInterpreterDelegateRunner::ResizeInputsToBatchSize(
+    int batch_size) {
+  if (batch_size == batch_size_) {
+    return absl::OkStatus();
+  }
+  for (int input_index : interpreter_->inputs()) {
+    const TfLiteTensor* tensor = interpreter_->tensor(input_index);
+    std::vector<int> dims(tensor->dims->data,
+                          tensor->dims->data + tensor->dims->size);
+    RET_CHECK(!dims.empty()) << "Cannot batch scalar model inputs.";
+    dims[0] = dims[0] / batch_size_ * batch_size;
+    RET_CHECK_EQ(interpreter_->ResizeInputTensor(input_index, dims),
+                 kTfLiteOk);
+  }
+  RET_CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  batch_size_ = batch_size;
+  return absl::OkStatus();
+}
+
 absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
     CalculatorContext* cc, const std::vector<Tensor>& input_tensors) {
+  MP_RETURN_IF_ERROR(ResizeInputsToBatchSize(1));
   // Read CPU input into tensors.
   RET_CHECK_EQ(interpreter_->inputs().size(), input_tensors.size());
   for (int i = 0; i < input_tensors.size(); ++i) {
-    const TfLiteType input_tensor_type =
-        interpreter_->tensor(interpreter_->inputs()[i])->type;
-    switch (input_tensor_type) {
-      case TfLiteType::kTfLiteFloat16:
-      case TfLiteType::kTfLiteFloat32: {
-        CopyTensorBufferToInterpreter<float>(input_tensors[i],
-                                             interpreter_.get(), i);
-        break;
-      }
-      case TfLiteType::kTfLiteUInt8: {
-        CopyTensorBufferToInterpreter<uint8_t>(input_tensors[i],
-                                               interpreter_.get(), i);
-        break;
-      }
-      case TfLiteType::kTfLiteInt8: {
-        CopyTensorBufferToInterpreter<int8_t>(input_tensors[i],
-                                              interpreter_.get(), i);
-        break;
-      }
-      case TfLiteType::kTfLiteInt32: {
-        CopyTensorBufferToInterpreter<int32_t>(input_tensors[i],
-                                               interpreter_.get(), i);
-        break;
-      }
-      case TfLiteType::kTfLiteString: {
-        CopyTensorBufferToInterpreter<char>(input_tensors[i],
-                                            interpreter_.get(), i);
-        break;
-      }
-      case TfLiteType::kTfLiteBool:
-        // No current use-case for copying MediaPipe Tensors with bool type to
-        // TfLiteTensors.
-      default:
-        return absl::InvalidArgumentError(
-            absl::StrCat("Unsupported input tensor type:", input_tensor_type));
-    }
+    MP_RETURN_IF_ERROR(CopyInputToInterpreter(input_tensors[i],
+                                              interpreter_.get(), i,
+                                              /*batch_index=*/0));
   }
 
   // Run inference.
@@ -148,52 +255,66 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
     TfLiteTensor* tensor = interpreter_->tensor(tensor_indexes[i]);
     Tensor::Shape shape{std::vector<int>{
         tensor->dims->data, tensor->dims->data + tensor->dims->size}};
-    switch (tensor->type) {
-      case TfLiteType::kTfLiteFloat16:
-      case TfLiteType::kTfLiteFloat32:
-        output_tensors.emplace_back(Tensor::ElementType::kFloat32, shape);
-        CopyTensorBufferFromInterpreter<float>(interpreter_.get(), i,
-                                               &output_tensors.back());
-        break;
-      case TfLiteType::kTfLiteUInt8:
-        output_tensors.emplace_back(
-            Tensor::ElementType::kUInt8, shape,
-            Tensor::QuantizationParameters{tensor->params.scale,
-                                           tensor->params.zero_point});
-        CopyTensorBufferFromInterpreter<uint8>(interpreter_.get(), i,
-                                               &output_tensors.back());
-        break;
-      case TfLiteType::kTfLiteInt8:
-        output_tensors.emplace_back(
-            Tensor::ElementType::kInt8, shape,
-            Tensor::QuantizationParameters{tensor->params.scale,
-                                           tensor->params.zero_point});
-        CopyTensorBufferFromInterpreter<int8>(interpreter_.get(), i,
-                                              &output_tensors.back());
-        break;
-      case TfLiteType::kTfLiteInt32:
-        output_tensors.emplace_back(Tensor::ElementType::kInt32, shape);
-        CopyTensorBufferFromInterpreter<int32_t>(interpreter_.get(), i,
-                                                 &output_tensors.back());
-        break;
-      case TfLiteType::kTfLiteBool:
-        output_tensors.emplace_back(Tensor::ElementType::kBool, shape,
-                                    Tensor::QuantizationParameters{1.0f, 0});
-        CopyTensorBufferFromInterpreter<bool>(interpreter_.get(), i,
-                                              &output_tensors.back());
-        break;
-      case TfLiteType::kTfLiteString:
-        // No current use-case for copying TfLiteTensors with string type to
-        // MediaPipe Tensors.
-      default:
-        return absl::InvalidArgumentError(
-            absl::StrCat("Unsupported output tensor type:",
-                         TfLiteTypeGetName(tensor->type)));
-    }
+    ASSIGN_OR_RETURN(Tensor output_tensor,
+                     CopyOutputFromInterpreter(interpreter_.get(), i, shape,
+                                               /*batch_index=*/0));
+    output_tensors.push_back(std::move(output_tensor));
   }
   return output_tensors;
 }
 
+absl::StatusOr<std::vector<std::vector<Tensor>>>
+InferenceInterpreterDelegateRunner::RunBatch(
+    CalculatorContext* cc,
+    const std::vector<const std::vector<Tensor>*>& batch) {
+  const int batch_size = batch.size();
+  RET_CHECK_GT(batch_size, 0);
+  MP_RETURN_IF_ERROR(ResizeInputsToBatchSize(batch_size));
+  // Stack the CPU inputs into the interpreter input tensors.
+  for (int b = 0; b < batch_size; ++b) {
+    const std::vector<Tensor>& input_tensors = *batch[b];
+    RET_CHECK_EQ(interpreter_->inputs().size(), input_tensors.size());
+    for (int i = 0; i < input_tensors.size(); ++i) {
+      const TfLiteTensor* tensor =
+          interpreter_->tensor(interpreter_->inputs()[i]);
+      RET_CHECK_EQ(input_tensors[i].bytes() * batch_size, tensor->bytes)
+          << "Input tensor " << i << " of batch item " << b
+          << " does not match the model input size.";
+      MP_RETURN_IF_ERROR(
+          CopyInputToInterpreter(input_tensors[i], interpreter_.get(), i, b));
+    }
+  }
+
+  // Run inference.
+  {
+    MEDIAPIPE_PROFILING(CPU_TASK_INVOKE, cc);
+    RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
+  }
+  // Split the output result tensors (CPU).
+  const auto& tensor_indexes = interpreter_->outputs();
+  std::vector<std::vector<Tensor>> outputs(batch_size);
+  for (auto& output_tensors : outputs) {
+    output_tensors.reserve(tensor_indexes.size());
+  }
+  for (int i = 0; i < tensor_indexes.size(); ++i) {
+    TfLiteTensor* tensor = interpreter_->tensor(tensor_indexes[i]);
+    std::vector<int> dims(tensor->dims->data,
+                          tensor->dims->data + tensor->dims->size);
+    RET_CHECK(!dims.empty() && dims[0] % batch_size == 0)
+        << "Output tensor " << i << " is not batched along its first "
+        << "dimension.";
+    dims[0] /= batch_size;
+    const Tensor::Shape shape{dims};
+    for (int b = 0; b < batch_size; ++b) {
+      ASSIGN_OR_RETURN(Tensor output_tensor,
+                       CopyOutputFromInterpreter(interpreter_.get(), i, shape,
+                                                 b));
+      outputs[b].push_back(std::move(output_tensor));
+    }
+  }
+  return outputs;
+}
+
 absl::StatusOr<std::unique_ptr<InferenceRunner>>
 CreateInferenceInterpreterDelegateRunner(
     api2::Packet<TfLiteModelPtr> model,
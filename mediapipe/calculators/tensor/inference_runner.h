@@ -1,6 +1,9 @@
 #ifndef MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_RUNNER_H_
 #define MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_RUNNER_H_
 
+#include <utility>
+#include <vector>
+
 #include "absl/status/statusor.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/formats/tensor.h"
@@ -13,6 +16,23 @@ class InferenceRunner {
   virtual ~InferenceRunner() = default;
   virtual absl::StatusOr<std::vector<Tensor>> Run(
       CalculatorContext* cc, const std::vector<Tensor>& inputs) = 0;
+
+  // Runs inference on a batch of independent inputs and returns the outputs
+  // of each of them, in the same order. Runners that can stack the inputs
+  // along the first dimension override this to run a single inference; the
+  // default implementation calls Run() once per input.
+  virtual absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc,
+      const std::vector<const std::vector<Tensor>*>& batch) {
+    std::vector<std::vector<Tensor>> outputs;
+    outputs.reserve(batch.size());
+    for (const std::vector<Tensor>* inputs : batch) {
+      auto output_or = Run(cc, *inputs);
+      if (!output_or.ok()) return output_or.status();
+      outputs.push_back(std::move(output_or).value());
+    }
+    return outputs;
+  }
 };
 
 }  // namespace mediapipe
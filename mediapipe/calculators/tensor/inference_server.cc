@@ -0,0 +1,248 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/inference_server.h"
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+
+namespace mediapipe {
+
+const GraphService<InferenceServer> kInferenceServerService(
+    "kInferenceServerService", GraphServiceBase::kAllowDefaultInitialization);
+
+// A pool of runners for one model, and the queue of requests to run on them.
+class InferenceServer::Engine {
+ public:
+  explicit Engine(const Options& options)
+      : max_runners_(options.max_runners_per_model),
+        max_batch_size_(std::max(options.max_batch_size, 1)) {}
+
+  // Registers a new caller, and reserves a slot for a new runner unless the
+  // pool is full. Returns whether a slot was reserved.
+  bool AddCaller() {
+    absl::MutexLock lock(&mutex_);
+    ++num_callers_;
+    if (static_cast<int>(runners_.size()) + num_reserved_runners_ >=
+        MaxRunners()) {
+      return false;
+    }
+    ++num_reserved_runners_;
+    return true;
+  }
+
+  // Unregisters a caller, and destroys the idle runners it leaves in excess.
+  void RemoveCaller() {
+    absl::MutexLock lock(&mutex_);
+    --num_callers_;
+    ShrinkPool();
+  }
+
+  // Adds a runner to a reserved slot, or cancels the reservation if `runner`
+  // is null.
+  void AddRunner(std::unique_ptr<InferenceRunner> runner) {
+    absl::MutexLock lock(&mutex_);
+    --num_reserved_runners_;
+    if (runner) {
+      idle_runners_.push_back(runner.get());
+      runners_.push_back(std::move(runner));
+    }
+    condition_.SignalAll();
+  }
+
+  // Queues the inputs and returns when all of them have been run, possibly
+  // by other threads. While waiting, the calling thread runs batches of
+  // queued requests whenever a runner is idle.
+  absl::StatusOr<std::vector<std::vector<Tensor>>> Run(
+      CalculatorContext* cc,
+      const std::vector<const std::vector<Tensor>*>& inputs) {
+    std::vector<Request> requests(inputs.size());
+    mutex_.Lock();
+    for (int i = 0; i < inputs.size(); ++i) {
+      requests[i].inputs = inputs[i];
+      queue_.push_back(&requests[i]);
+    }
+    auto all_done = [&requests]() {
+      return std::all_of(requests.begin(), requests.end(),
+                         [](const Request& r) { return r.done; });
+    };
+    while (!all_done()) {
+      if (runners_.empty() && num_reserved_runners_ == 0) {
+        // Only possible if creating the first runner failed. No other thread
+        // can take the requests, so they are all still queued.
+        for (Request& request : requests) {
+          queue_.erase(std::find(queue_.begin(), queue_.end(), &request));
+        }
+        mutex_.Unlock();
+        return absl::FailedPreconditionError(
+            "The inference engine has no runners.");
+      }
+      if (queue_.empty() || idle_runners_.empty()) {
+        condition_.Wait(&mutex_);
+        continue;
+      }
+      InferenceRunner* runner = idle_runners_.back();
+      idle_runners_.pop_back();
+      std::vector<Request*> batch;
+      std::vector<const std::vector<Tensor>*> batch_inputs;
+      while (!queue_.empty() && batch.size() < max_batch_size_) {
+        batch.push_back(queue_.front());
+        batch_inputs.push_back(queue_.front()->inputs);
+        queue_.pop_front();
+      }
+      mutex_.Unlock();
+      auto outputs_or = runner->RunBatch(cc, batch_inputs);
+      if (outputs_or.ok() && outputs_or->size() != batch.size()) {
+        outputs_or = absl::InternalError(
+            "The inference runner returned the wrong number of outputs.");
+      }
+      mutex_.Lock();
+      for (int i = 0; i < batch.size(); ++i) {
+        if (outputs_or.ok()) {
+          batch[i]->outputs = std::move((*outputs_or)[i]);
+        } else {
+          batch[i]->outputs = outputs_or.status();
+        }
+        batch[i]->done = true;
+      }
+      idle_runners_.push_back(runner);
+      ShrinkPool();
+      condition_.SignalAll();
+    }
+    mutex_.Unlock();
+
+    std::vector<std::vector<Tensor>> outputs;
+    outputs.reserve(requests.size());
+    for (Request& request : requests) {
+      if (!request.outputs.ok()) return request.outputs.status();
+      outputs.push_back(std::move(request.outputs).value());
+    }
+    return outputs;
+  }
+
+ private:
+  struct Request {
+    const std::vector<Tensor>* inputs = nullptr;
+    absl::StatusOr<std::vector<Tensor>> outputs;
+    bool done = false;
+  };
+
+  // Returns the size of the pool: max_runners_, or one runner per caller if
+  // it is not positive.
+  int MaxRunners() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return max_runners_ > 0 ? max_runners_ : std::max(num_callers_, 1);
+  }
+
+  // Destroys idle runners while the pool is larger than MaxRunners().
+  void ShrinkPool() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    while (static_cast<int>(runners_.size()) > MaxRunners() &&
+           !idle_runners_.empty()) {
+      InferenceRunner* runner = idle_runners_.back();
+      idle_runners_.pop_back();
+      runners_.erase(std::find_if(
+          runners_.begin(), runners_.end(),
+          [runner](const std::unique_ptr<InferenceRunner>& r) {
+            return r.get() == runner;
+          }));
+    }
+  }
+
+  const int max_runners_;
+  const int max_batch_size_;
+
+  absl::Mutex mutex_;
+  absl::CondVar condition_;
+  std::vector<std::unique_ptr<InferenceRunner>> runners_
+      ABSL_GUARDED_BY(mutex_);
+  std::vector<InferenceRunner*> idle_runners_ ABSL_GUARDED_BY(mutex_);
+  int num_reserved_runners_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The number of SharedRunners of this engine.
+  int num_callers_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Requests that have not been taken by a runner yet, in arrival order.
+  std::deque<Request*> queue_ ABSL_GUARDED_BY(mutex_);
+};
+
+// The runner handed out to each calculator. Keeps the engine alive.
+class InferenceServer::SharedRunner : public InferenceRunner {
+ public:
+  // The caller must have been registered with Engine::AddCaller.
+  explicit SharedRunner(std::shared_ptr<Engine> engine)
+      : engine_(std::move(engine)) {}
+  ~SharedRunner() override { engine_->RemoveCaller(); }
+
+  absl::StatusOr<std::vector<Tensor>> Run(
+      CalculatorContext* cc, const std::vector<Tensor>& inputs) override {
+    auto outputs_or = engine_->Run(cc, {&inputs});
+    if (!outputs_or.ok()) return outputs_or.status();
+    return std::move(outputs_or->front());
+  }
+
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc,
+      const std::vector<const std::vector<Tensor>*>& batch) override {
+    return engine_->Run(cc, batch);
+  }
+
+ private:
+  std::shared_ptr<Engine> engine_;
+};
+
+InferenceServer::InferenceServer(const Options& options) : options_(options) {}
+
+// static
+absl::StatusOr<std::shared_ptr<InferenceServer>> InferenceServer::Create() {
+  static auto* server = new std::shared_ptr<InferenceServer>(
+      std::make_shared<InferenceServer>());
+  return *server;
+}
+
+absl::StatusOr<std::unique_ptr<InferenceRunner>> InferenceServer::GetRunner(
+    const std::string& model_key, RunnerFactory create_runner) {
+  std::shared_ptr<Engine> engine;
+  {
+    absl::MutexLock lock(&mutex_);
+    // Drops the entries of the engines whose last caller is gone.
+    for (auto it = engines_.begin(); it != engines_.end();) {
+      if (it->second.expired() && it->first != model_key) {
+        engines_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    std::weak_ptr<Engine>& weak_engine = engines_[model_key];
+    engine = weak_engine.lock();
+    if (!engine) {
+      engine = std::make_shared<Engine>(options_);
+      weak_engine = engine;
+    }
+  }
+  if (engine->AddCaller()) {
+    // Runners are created outside of any lock, since building an interpreter
+    // can take a while.
+    auto runner_or = create_runner();
+    if (!runner_or.ok()) {
+      engine->AddRunner(nullptr);
+      engine->RemoveCaller();
+      return runner_or.status();
+    }
+    engine->AddRunner(std::move(runner_or).value());
+  }
+  return std::make_unique<SharedRunner>(std::move(engine));
+}
+
+}  // namespace mediapipe
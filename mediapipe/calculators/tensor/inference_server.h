@@ -0,0 +1,103 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_SERVER_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_SERVER_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/framework/graph_service.h"
+
+namespace mediapipe {
+
+// Shares inference engines between InferenceCalculators, including
+// calculators in different CalculatorGraphs.
+//
+// Calculators that run the same model with the same configuration share one
+// engine, which owns a pool of InferenceRunners (interpreters and
+// delegates). Inference requests are queued in the engine. A calling thread
+// that finds an idle runner takes up to `max_batch_size` queued requests,
+// possibly from several graphs, and runs them as one batch on behalf of
+// their callers, so the engine needs no threads of its own.
+//
+// By default, the pool has one runner per calculator, as without the server.
+// Setting `max_runners_per_model` bounds the pool, so that memory stays flat
+// as the number of graphs grows, at the cost of calculators waiting for each
+// other.
+//
+// The engine of a model is destroyed when the last calculator using it is
+// closed.
+//
+// Usage: set `use_inference_server: true` in InferenceCalculatorOptions. By
+// default the calculators of all graphs share a process-wide server. To
+// configure the server, or to share it between a subset of the graphs only,
+// create it explicitly and set it on every graph:
+//
+//   auto server = std::make_shared<InferenceServer>(options);
+//   MP_RETURN_IF_ERROR(graph.SetServiceObject(kInferenceServerService,
+//                                             server));
+class InferenceServer {
+ public:
+  struct Options {
+    // Maximum number of runners, i.e. interpreters, per model. If not
+    // positive, the engine of a model has one runner per calculator using it.
+    int max_runners_per_model = 0;
+    // Maximum number of requests run in a single batch. Batches larger than
+    // one require a model whose inputs and outputs can be resized along their
+    // first dimension, see InferenceRunner::RunBatch.
+    int max_batch_size = 1;
+  };
+
+  // Function that creates a new runner for a model.
+  using RunnerFactory =
+      absl::FunctionRef<absl::StatusOr<std::unique_ptr<InferenceRunner>>()>;
+
+  InferenceServer() : InferenceServer(Options()) {}
+  explicit InferenceServer(const Options& options);
+  InferenceServer(const InferenceServer&) = delete;
+  InferenceServer& operator=(const InferenceServer&) = delete;
+
+  // Returns the process-wide server. Used by the graph service when no server
+  // is set on the graph.
+  static absl::StatusOr<std::shared_ptr<InferenceServer>> Create();
+
+  // Returns a runner that runs inference on the engine for `model_key`.
+  // `model_key` must identify both the model and the runner configuration.
+  // `create_runner` is called synchronously if the engine has fewer than
+  // `max_runners_per_model` runners, or always if that is not positive, and
+  // the new runner is added to the pool.
+  absl::StatusOr<std::unique_ptr<InferenceRunner>> GetRunner(
+      const std::string& model_key, RunnerFactory create_runner);
+
+ private:
+  class Engine;
+  class SharedRunner;
+
+  const Options options_;
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::weak_ptr<Engine>> engines_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+extern const GraphService<InferenceServer> kInferenceServerService;
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_SERVER_H_
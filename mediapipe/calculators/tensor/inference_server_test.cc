@@ -0,0 +1,230 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/inference_server.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/threadpool.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+Tensor MakeScalarTensor(float value) {
+  Tensor tensor(Tensor::ElementType::kFloat32, Tensor::Shape{1});
+  tensor.GetCpuWriteView().buffer<float>()[0] = value;
+  return tensor;
+}
+
+float GetScalar(const Tensor& tensor) {
+  return tensor.GetCpuReadView().buffer<float>()[0];
+}
+
+// Doubles its scalar input, and records the sizes of the batches it runs.
+class DoublingRunner : public InferenceRunner {
+ public:
+  explicit DoublingRunner(std::atomic<int>* max_concurrency)
+      : max_concurrency_(max_concurrency) {}
+
+  absl::StatusOr<std::vector<Tensor>> Run(
+      CalculatorContext* cc, const std::vector<Tensor>& inputs) override {
+    std::vector<Tensor> outputs;
+    outputs.push_back(MakeScalarTensor(2 * GetScalar(inputs[0])));
+    return outputs;
+  }
+
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc,
+      const std::vector<const std::vector<Tensor>*>& batch) override {
+    const int concurrency = ++concurrency_;
+    int max = max_concurrency_->load();
+    while (concurrency > max &&
+           !max_concurrency_->compare_exchange_weak(max, concurrency)) {
+    }
+    {
+      absl::MutexLock lock(&mutex_);
+      batch_sizes_.push_back(batch.size());
+    }
+    std::vector<std::vector<Tensor>> outputs;
+    for (const std::vector<Tensor>* inputs : batch) {
+      auto output_or = Run(cc, *inputs);
+      if (!output_or.ok()) return output_or.status();
+      outputs.push_back(std::move(output_or).value());
+    }
+    --concurrency_;
+    return outputs;
+  }
+
+  std::vector<int> batch_sizes() {
+    absl::MutexLock lock(&mutex_);
+    return batch_sizes_;
+  }
+
+ private:
+  std::atomic<int> concurrency_{0};
+  std::atomic<int>* max_concurrency_;
+  absl::Mutex mutex_;
+  std::vector<int> batch_sizes_ ABSL_GUARDED_BY(mutex_);
+};
+
+TEST(InferenceServerTest, SharesRunnersPerModel) {
+  InferenceServer server(
+      InferenceServer::Options{.max_runners_per_model = 2});
+  std::atomic<int> max_concurrency(0);
+  int num_created = 0;
+  auto create_runner =
+      [&]() -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+    ++num_created;
+    return std::make_unique<DoublingRunner>(&max_concurrency);
+  };
+
+  std::vector<std::unique_ptr<InferenceRunner>> runners;
+  for (int i = 0; i < 5; ++i) {
+    MP_ASSERT_OK_AND_ASSIGN(auto runner,
+                            server.GetRunner("model_a", create_runner));
+    runners.push_back(std::move(runner));
+  }
+  EXPECT_EQ(num_created, 2);
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_b,
+                          server.GetRunner("model_b", create_runner));
+  EXPECT_EQ(num_created, 3);
+
+  std::vector<Tensor> inputs;
+  inputs.push_back(MakeScalarTensor(21));
+  for (auto& runner : runners) {
+    MP_ASSERT_OK_AND_ASSIGN(auto outputs, runner->Run(nullptr, inputs));
+    ASSERT_EQ(outputs.size(), 1);
+    EXPECT_EQ(GetScalar(outputs[0]), 42);
+  }
+}
+
+TEST(InferenceServerTest, DefaultsToOneRunnerPerCaller) {
+  InferenceServer server;
+  std::atomic<int> max_concurrency(0);
+  int num_created = 0;
+  auto create_runner =
+      [&]() -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+    ++num_created;
+    return std::make_unique<DoublingRunner>(&max_concurrency);
+  };
+
+  std::vector<std::unique_ptr<InferenceRunner>> runners;
+  for (int i = 0; i < 3; ++i) {
+    MP_ASSERT_OK_AND_ASSIGN(auto runner,
+                            server.GetRunner("model", create_runner));
+    runners.push_back(std::move(runner));
+  }
+  EXPECT_EQ(num_created, 3);
+
+  // The runners of the callers which are gone are destroyed, so a new caller
+  // gets a new runner.
+  runners.resize(1);
+  MP_ASSERT_OK_AND_ASSIGN(auto runner,
+                          server.GetRunner("model", create_runner));
+  EXPECT_EQ(num_created, 4);
+
+  std::vector<Tensor> inputs;
+  inputs.push_back(MakeScalarTensor(21));
+  MP_ASSERT_OK_AND_ASSIGN(auto outputs, runner->Run(nullptr, inputs));
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_EQ(GetScalar(outputs[0]), 42);
+}
+
+TEST(InferenceServerTest, EngineIsReleasedWithLastRunner) {
+  InferenceServer server;
+  std::atomic<int> max_concurrency(0);
+  int num_created = 0;
+  auto create_runner =
+      [&]() -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+    ++num_created;
+    return std::make_unique<DoublingRunner>(&max_concurrency);
+  };
+  {
+    MP_ASSERT_OK_AND_ASSIGN(auto runner,
+                            server.GetRunner("model", create_runner));
+  }
+  MP_ASSERT_OK_AND_ASSIGN(auto runner,
+                          server.GetRunner("model", create_runner));
+  EXPECT_EQ(num_created, 2);
+}
+
+TEST(InferenceServerTest, RunnerCreationErrorIsReturned) {
+  InferenceServer server;
+  auto failing_create_runner =
+      []() -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+    return absl::InternalError("no interpreter");
+  };
+  EXPECT_EQ(server.GetRunner("model", failing_create_runner).status().code(),
+            absl::StatusCode::kInternal);
+}
+
+TEST(InferenceServerTest, BatchesConcurrentRequests) {
+  constexpr int kNumClients = 8;
+  constexpr int kNumRequests = 200;
+  InferenceServer server(InferenceServer::Options{.max_runners_per_model = 1,
+                                                  .max_batch_size = 4});
+  std::atomic<int> max_concurrency(0);
+  DoublingRunner* shared_runner = nullptr;
+  std::vector<std::unique_ptr<InferenceRunner>> clients;
+  for (int i = 0; i < kNumClients; ++i) {
+    MP_ASSERT_OK_AND_ASSIGN(
+        auto client,
+        server.GetRunner(
+            "model", [&]() -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+              auto runner = std::make_unique<DoublingRunner>(&max_concurrency);
+              shared_runner = runner.get();
+              return runner;
+            }));
+    clients.push_back(std::move(client));
+  }
+  ASSERT_NE(shared_runner, nullptr);
+
+  std::atomic<int> num_errors(0);
+  {
+    ThreadPool pool("clients", kNumClients);
+    pool.StartWorkers();
+    for (int c = 0; c < kNumClients; ++c) {
+      pool.Schedule([&, c]() {
+        for (int i = 0; i < kNumRequests; ++i) {
+          std::vector<Tensor> inputs;
+          inputs.push_back(MakeScalarTensor(c * kNumRequests + i));
+          auto outputs_or = clients[c]->Run(nullptr, inputs);
+          if (!outputs_or.ok() ||
+              GetScalar((*outputs_or)[0]) != 2 * (c * kNumRequests + i)) {
+            ++num_errors;
+          }
+        }
+      });
+    }
+  }
+  EXPECT_EQ(num_errors.load(), 0);
+  EXPECT_EQ(max_concurrency.load(), 1);
+  int num_run = 0;
+  for (int size : shared_runner->batch_sizes()) {
+    EXPECT_LE(size, 4);
+    num_run += size;
+  }
+  EXPECT_EQ(num_run, kNumClients * kNumRequests);
+}
+
+}  // namespace
+}  // namespace mediapipe
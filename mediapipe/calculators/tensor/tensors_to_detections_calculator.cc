@@ -18,9 +18,11 @@
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "mediapipe/calculators/tensor/tensors_to_detections_calculator.pb.h"
+#include "mediapipe/calculators/tensor/tensors_to_detections_cpu_kernel.h"
 #include "mediapipe/framework/api2/node.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/formats/compact_detection.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location.h"
 #include "mediapipe/framework/formats/object_detection/anchor.pb.h"
@@ -160,8 +162,12 @@ BoxFormat GetBoxFormat(const TensorsToDetectionsCalculatorOptions& options) {
 //      a vector of integers. It overrides the corresponding field in the
 //      calculator options.
 //
-// Output:
+// Output, one of:
 //  DETECTIONS - Result MediaPipe detections.
+//  COMPACT_DETECTIONS - The same detections, as a
+//      std::vector<CompactDetection>. Avoids allocating a proto per detection
+//      for NonMaxSuppressionCalculator and DetectionsToRectsCalculator, which
+//      accept them. Requires num_keypoints <= CompactDetection::kMaxKeypoints.
 //
 // Usage example:
 // node {
@@ -189,9 +195,12 @@ class TensorsToDetectionsCalculator : public Node {
       "ANCHORS"};
   static constexpr SideInput<std::vector<int>>::Optional kSideInIgnoreClasses{
       "IGNORE_CLASSES"};
-  static constexpr Output<std::vector<Detection>> kOutDetections{"DETECTIONS"};
+  static constexpr Output<std::vector<Detection>>::Optional kOutDetections{
+      "DETECTIONS"};
+  static constexpr Output<std::vector<CompactDetection>>::Optional
+      kOutCompactDetections{"COMPACT_DETECTIONS"};
   MEDIAPIPE_NODE_CONTRACT(kInTensors, kInAnchors, kSideInIgnoreClasses,
-                          kOutDetections);
+                          kOutDetections, kOutCompactDetections);
   static absl::Status UpdateContract(CalculatorContract* cc);
 
   absl::Status Open(CalculatorContext* cc) override;
@@ -199,23 +208,32 @@ class TensorsToDetectionsCalculator : public Node {
   absl::Status Close(CalculatorContext* cc) override;
 
  private:
+  // DetectionT is Detection or CompactDetection.
+  template <typename DetectionT>
+  absl::Status ProcessDetections(CalculatorContext* cc,
+                                 std::vector<DetectionT>* output_detections);
+  template <typename DetectionT>
   absl::Status ProcessCPU(CalculatorContext* cc,
-                          std::vector<Detection>* output_detections);
+                          std::vector<DetectionT>* output_detections);
+  template <typename DetectionT>
   absl::Status ProcessGPU(CalculatorContext* cc,
-                          std::vector<Detection>* output_detections);
+                          std::vector<DetectionT>* output_detections);
 
   absl::Status LoadOptions(CalculatorContext* cc);
   absl::Status GpuInit(CalculatorContext* cc);
-  absl::Status DecodeBoxes(const float* raw_boxes,
-                           const std::vector<Anchor>& anchors,
-                           std::vector<float>* boxes);
+  template <typename DetectionT>
   absl::Status ConvertToDetections(const float* detection_boxes,
                                    const float* detection_scores,
                                    const int* detection_classes,
-                                   std::vector<Detection>* output_detections);
-  Detection ConvertToDetection(float box_ymin, float box_xmin, float box_ymax,
-                               float box_xmax, float score, int class_id,
-                               bool flip_vertically);
+                                   std::vector<DetectionT>* output_detections);
+  // Appends a detection with the given relative box, and the keypoints found
+  // in @box_values, the values decoded for the box.
+  void AddDetection(float xmin, float ymin, float width, float height,
+                    float score, int class_id, const float* box_values,
+                    std::vector<Detection>* output_detections);
+  void AddDetection(float xmin, float ymin, float width, float height,
+                    float score, int class_id, const float* box_values,
+                    std::vector<CompactDetection>* output_detections);
   bool IsClassIndexAllowed(int class_index);
 
   int num_classes_ = 0;
@@ -233,13 +251,15 @@ class TensorsToDetectionsCalculator : public Node {
   // Allowed or ignored class indices based on provided options or side packet.
   // These are used to filter out the output detection results.
   ClassIndexSet class_index_set_;
+  // The class indices in [0, num_classes_) that are allowed, in order.
+  std::vector<int> allowed_classes_;
 
   TensorsToDetectionsCalculatorOptions options_;
   bool scores_tensor_index_is_set_ = false;
   TensorsToDetectionsCalculatorOptions::TensorMapping tensor_mapping_;
   std::vector<int> box_indices_ = {0, 1, 2, 3};
   bool has_custom_box_indices_ = false;
-  std::vector<Anchor> anchors_;
+  AnchorArrays anchors_;
 
 #ifndef MEDIAPIPE_DISABLE_GL_COMPUTE
   mediapipe::GlCalculatorHelper gpu_helper_;
@@ -262,6 +282,15 @@ MEDIAPIPE_REGISTER_NODE(TensorsToDetectionsCalculator);
 
 absl::Status TensorsToDetectionsCalculator::UpdateContract(
     CalculatorContract* cc) {
+  RET_CHECK(kOutDetections(cc).IsConnected() ^
+            kOutCompactDetections(cc).IsConnected())
+      << "Exactly one of DETECTIONS and COMPACT_DETECTIONS must be connected.";
+  if (kOutCompactDetections(cc).IsConnected()) {
+    RET_CHECK_LE(
+        cc->Options<TensorsToDetectionsCalculatorOptions>().num_keypoints(),
+        CompactDetection::kMaxKeypoints)
+        << "Too many keypoints for COMPACT_DETECTIONS.";
+  }
   if (CanUseGpu()) {
 #ifndef MEDIAPIPE_DISABLE_GL_COMPUTE
     MP_RETURN_IF_ERROR(mediapipe::GlCalculatorHelper::UpdateContract(cc));
@@ -289,7 +318,21 @@ absl::Status TensorsToDetectionsCalculator::Open(CalculatorContext* cc) {
 }
 
 absl::Status TensorsToDetectionsCalculator::Process(CalculatorContext* cc) {
-  auto output_detections = absl::make_unique<std::vector<Detection>>();
+  if (kOutCompactDetections(cc).IsConnected()) {
+    auto output_detections = absl::make_unique<std::vector<CompactDetection>>();
+    MP_RETURN_IF_ERROR(ProcessDetections(cc, output_detections.get()));
+    kOutCompactDetections(cc).Send(std::move(output_detections));
+  } else {
+    auto output_detections = absl::make_unique<std::vector<Detection>>();
+    MP_RETURN_IF_ERROR(ProcessDetections(cc, output_detections.get()));
+    kOutDetections(cc).Send(std::move(output_detections));
+  }
+  return absl::OkStatus();
+}
+
+template <typename DetectionT>
+absl::Status TensorsToDetectionsCalculator::ProcessDetections(
+    CalculatorContext* cc, std::vector<DetectionT>* output_detections) {
   bool gpu_processing = false;
   if (CanUseGpu()) {
     // Use GPU processing only if at least one input tensor is already on GPU
@@ -326,17 +369,16 @@ absl::Status TensorsToDetectionsCalculator::Process(CalculatorContext* cc) {
       MP_RETURN_IF_ERROR(GpuInit(cc));
       gpu_inited_ = true;
     }
-    MP_RETURN_IF_ERROR(ProcessGPU(cc, output_detections.get()));
+    MP_RETURN_IF_ERROR(ProcessGPU(cc, output_detections));
   } else {
-    MP_RETURN_IF_ERROR(ProcessCPU(cc, output_detections.get()));
+    MP_RETURN_IF_ERROR(ProcessCPU(cc, output_detections));
   }
-
-  kOutDetections(cc).Send(std::move(output_detections));
   return absl::OkStatus();
 }
 
+template <typename DetectionT>
 absl::Status TensorsToDetectionsCalculator::ProcessCPU(
-    CalculatorContext* cc, std::vector<Detection>* output_detections) {
+    CalculatorContext* cc, std::vector<DetectionT>* output_detections) {
   const auto& input_tensors = *kInTensors(cc);
 
   if (input_tensors.size() == 2 ||
@@ -372,48 +414,27 @@ absl::Status TensorsToDetectionsCalculator::ProcessCPU(
         RET_CHECK_EQ(anchor_tensor->shape().dims[1], kNumCoordsPerBox);
         auto anchor_view = anchor_tensor->GetCpuReadView();
         auto raw_anchors = anchor_view.buffer<float>();
-        ConvertRawValuesToAnchors(raw_anchors, num_boxes_, &anchors_);
+        std::vector<Anchor> anchors;
+        ConvertRawValuesToAnchors(raw_anchors, num_boxes_, &anchors);
+        anchors_ = ToAnchorArrays(anchors);
       } else if (!kInAnchors(cc).IsEmpty()) {
-        anchors_ = *kInAnchors(cc);
+        RET_CHECK_GE(static_cast<int>(kInAnchors(cc)->size()), num_boxes_);
+        anchors_ = ToAnchorArrays(*kInAnchors(cc));
       } else {
         return absl::UnavailableError("No anchor data available.");
       }
       anchors_init_ = true;
     }
     std::vector<float> boxes(num_boxes_ * num_coords_);
-    MP_RETURN_IF_ERROR(DecodeBoxes(raw_boxes, anchors_, &boxes));
+    DecodeDetectionBoxes(raw_boxes, anchors_, options_, box_output_format_,
+                         num_boxes_, boxes.data());
 
+    // Filter classes by scores.
     std::vector<float> detection_scores(num_boxes_);
     std::vector<int> detection_classes(num_boxes_);
-
-    // Filter classes by scores.
-    for (int i = 0; i < num_boxes_; ++i) {
-      int class_id = -1;
-      float max_score = -std::numeric_limits<float>::max();
-      // Find the top score for box i.
-      for (int score_idx = 0; score_idx < num_classes_; ++score_idx) {
-        if (IsClassIndexAllowed(score_idx)) {
-          auto score = raw_scores[i * num_classes_ + score_idx];
-          if (options_.sigmoid_score()) {
-            if (options_.has_score_clipping_thresh()) {
-              score = score < -options_.score_clipping_thresh()
-                          ? -options_.score_clipping_thresh()
-                          : score;
-              score = score > options_.score_clipping_thresh()
-                          ? options_.score_clipping_thresh()
-                          : score;
-            }
-            score = 1.0f / (1.0f + std::exp(-score));
-          }
-          if (max_score < score) {
-            max_score = score;
-            class_id = score_idx;
-          }
-        }
-      }
-      detection_scores[i] = max_score;
-      detection_classes[i] = class_id;
-    }
+    ScoreDetectionBoxes(raw_scores, num_boxes_, num_classes_, allowed_classes_,
+                        options_, detection_scores.data(),
+                        detection_classes.data());
 
     MP_RETURN_IF_ERROR(
         ConvertToDetections(boxes.data(), detection_scores.data(),
@@ -469,8 +490,9 @@ absl::Status TensorsToDetectionsCalculator::ProcessCPU(
   return absl::OkStatus();
 }
 
+template <typename DetectionT>
 absl::Status TensorsToDetectionsCalculator::ProcessGPU(
-    CalculatorContext* cc, std::vector<Detection>* output_detections) {
+    CalculatorContext* cc, std::vector<DetectionT>* output_detections) {
   const auto& input_tensors = *kInTensors(cc);
   RET_CHECK_GE(input_tensors.size(), 2);
   RET_CHECK_GT(num_boxes_, 0) << "Please set num_boxes in calculator options";
@@ -702,6 +724,12 @@ absl::Status TensorsToDetectionsCalculator::LoadOptions(CalculatorContext* cc) {
     }
   }
 
+  for (int i = 0; i < num_classes_; ++i) {
+    if (IsClassIndexAllowed(i)) {
+      allowed_classes_.push_back(i);
+    }
+  }
+
   if (options_.has_tensor_mapping()) {
     RET_CHECK_OK(CheckCustomTensorMapping(options_.tensor_mapping()));
     tensor_mapping_ = options_.tensor_mapping();
@@ -736,96 +764,10 @@ absl::Status TensorsToDetectionsCalculator::LoadOptions(CalculatorContext* cc) {
   return absl::OkStatus();
 }
 
-absl::Status TensorsToDetectionsCalculator::DecodeBoxes(
-    const float* raw_boxes, const std::vector<Anchor>& anchors,
-    std::vector<float>* boxes) {
-  for (int i = 0; i < num_boxes_; ++i) {
-    const int box_offset = i * num_coords_ + options_.box_coord_offset();
-
-    float y_center = 0.0;
-    float x_center = 0.0;
-    float h = 0.0;
-    float w = 0.0;
-    // TODO
-    switch (box_output_format_) {
-      case mediapipe::TensorsToDetectionsCalculatorOptions::UNSPECIFIED:
-      case mediapipe::TensorsToDetectionsCalculatorOptions::YXHW:
-        y_center = raw_boxes[box_offset];
-        x_center = raw_boxes[box_offset + 1];
-        h = raw_boxes[box_offset + 2];
-        w = raw_boxes[box_offset + 3];
-        break;
-      case mediapipe::TensorsToDetectionsCalculatorOptions::XYWH:
-        x_center = raw_boxes[box_offset];
-        y_center = raw_boxes[box_offset + 1];
-        w = raw_boxes[box_offset + 2];
-        h = raw_boxes[box_offset + 3];
-        break;
-      case mediapipe::TensorsToDetectionsCalculatorOptions::XYXY:
-        x_center = (-raw_boxes[box_offset] + raw_boxes[box_offset + 2]) / 2;
-        y_center = (-raw_boxes[box_offset + 1] + raw_boxes[box_offset + 3]) / 2;
-        w = raw_boxes[box_offset + 2] + raw_boxes[box_offset];
-        h = raw_boxes[box_offset + 3] + raw_boxes[box_offset + 1];
-        break;
-    }
-    x_center =
-        x_center / options_.x_scale() * anchors[i].w() + anchors[i].x_center();
-    y_center =
-        y_center / options_.y_scale() * anchors[i].h() + anchors[i].y_center();
-
-    if (options_.apply_exponential_on_box_size()) {
-      h = std::exp(h / options_.h_scale()) * anchors[i].h();
-      w = std::exp(w / options_.w_scale()) * anchors[i].w();
-    } else {
-      h = h / options_.h_scale() * anchors[i].h();
-      w = w / options_.w_scale() * anchors[i].w();
-    }
-
-    const float ymin = y_center - h / 2.f;
-    const float xmin = x_center - w / 2.f;
-    const float ymax = y_center + h / 2.f;
-    const float xmax = x_center + w / 2.f;
-
-    (*boxes)[i * num_coords_ + 0] = ymin;
-    (*boxes)[i * num_coords_ + 1] = xmin;
-    (*boxes)[i * num_coords_ + 2] = ymax;
-    (*boxes)[i * num_coords_ + 3] = xmax;
-
-    if (options_.num_keypoints()) {
-      for (int k = 0; k < options_.num_keypoints(); ++k) {
-        const int offset = i * num_coords_ + options_.keypoint_coord_offset() +
-                           k * options_.num_values_per_keypoint();
-
-        float keypoint_y = 0.0;
-        float keypoint_x = 0.0;
-        switch (box_output_format_) {
-          case mediapipe::TensorsToDetectionsCalculatorOptions::UNSPECIFIED:
-          case mediapipe::TensorsToDetectionsCalculatorOptions::YXHW:
-            keypoint_y = raw_boxes[offset];
-            keypoint_x = raw_boxes[offset + 1];
-            break;
-          case mediapipe::TensorsToDetectionsCalculatorOptions::XYWH:
-          case mediapipe::TensorsToDetectionsCalculatorOptions::XYXY:
-            keypoint_x = raw_boxes[offset];
-            keypoint_y = raw_boxes[offset + 1];
-            break;
-        }
-
-        (*boxes)[offset] = keypoint_x / options_.x_scale() * anchors[i].w() +
-                           anchors[i].x_center();
-        (*boxes)[offset + 1] =
-            keypoint_y / options_.y_scale() * anchors[i].h() +
-            anchors[i].y_center();
-      }
-    }
-  }
-
-  return absl::OkStatus();
-}
-
+template <typename DetectionT>
 absl::Status TensorsToDetectionsCalculator::ConvertToDetections(
     const float* detection_boxes, const float* detection_scores,
-    const int* detection_classes, std::vector<Detection>* output_detections) {
+    const int* detection_classes, std::vector<DetectionT>* output_detections) {
   for (int i = 0; i < num_boxes_; ++i) {
     if (max_results_ > 0 && output_detections->size() == max_results_) {
       break;
@@ -838,44 +780,31 @@ absl::Status TensorsToDetectionsCalculator::ConvertToDetections(
       continue;
     }
     const int box_offset = i * num_coords_;
-    Detection detection = ConvertToDetection(
-        /*box_ymin=*/detection_boxes[box_offset + box_indices_[0]],
-        /*box_xmin=*/detection_boxes[box_offset + box_indices_[1]],
-        /*box_ymax=*/detection_boxes[box_offset + box_indices_[2]],
-        /*box_xmax=*/detection_boxes[box_offset + box_indices_[3]],
-        detection_scores[i], detection_classes[i], options_.flip_vertically());
-    const auto& bbox = detection.location_data().relative_bounding_box();
-    if (bbox.width() < 0 || bbox.height() < 0 || std::isnan(bbox.width()) ||
-        std::isnan(bbox.height())) {
+    const float box_ymin = detection_boxes[box_offset + box_indices_[0]];
+    const float box_xmin = detection_boxes[box_offset + box_indices_[1]];
+    const float box_ymax = detection_boxes[box_offset + box_indices_[2]];
+    const float box_xmax = detection_boxes[box_offset + box_indices_[3]];
+    const float width = box_xmax - box_xmin;
+    const float height = box_ymax - box_ymin;
+    if (width < 0 || height < 0 || std::isnan(width) || std::isnan(height)) {
       // Decoded detection boxes could have negative values for width/height due
       // to model prediction. Filter out those boxes since some downstream
       // calculators may assume non-negative values. (b/171391719)
       continue;
     }
-    // Add keypoints.
-    if (options_.num_keypoints() > 0) {
-      auto* location_data = detection.mutable_location_data();
-      for (int kp_id = 0; kp_id < options_.num_keypoints() *
-                                      options_.num_values_per_keypoint();
-           kp_id += options_.num_values_per_keypoint()) {
-        auto keypoint = location_data->add_relative_keypoints();
-        const int keypoint_index =
-            box_offset + options_.keypoint_coord_offset() + kp_id;
-        keypoint->set_x(detection_boxes[keypoint_index + 0]);
-        keypoint->set_y(options_.flip_vertically()
-                            ? 1.f - detection_boxes[keypoint_index + 1]
-                            : detection_boxes[keypoint_index + 1]);
-      }
-    }
-    output_detections->emplace_back(detection);
+    AddDetection(box_xmin,
+                 options_.flip_vertically() ? 1.f - box_ymax : box_ymin, width,
+                 height, detection_scores[i], detection_classes[i],
+                 detection_boxes + box_offset, output_detections);
   }
   return absl::OkStatus();
 }
 
-Detection TensorsToDetectionsCalculator::ConvertToDetection(
-    float box_ymin, float box_xmin, float box_ymax, float box_xmax, float score,
-    int class_id, bool flip_vertically) {
-  Detection detection;
+void TensorsToDetectionsCalculator::AddDetection(
+    float xmin, float ymin, float width, float height, float score,
+    int class_id, const float* box_values,
+    std::vector<Detection>* output_detections) {
+  Detection& detection = output_detections->emplace_back();
   detection.add_score(score);
   detection.add_label_id(class_id);
 
@@ -885,11 +814,45 @@ Detection TensorsToDetectionsCalculator::ConvertToDetection(
   LocationData::RelativeBoundingBox* relative_bbox =
       location_data->mutable_relative_bounding_box();
 
-  relative_bbox->set_xmin(box_xmin);
-  relative_bbox->set_ymin(flip_vertically ? 1.f - box_ymax : box_ymin);
-  relative_bbox->set_width(box_xmax - box_xmin);
-  relative_bbox->set_height(box_ymax - box_ymin);
-  return detection;
+  relative_bbox->set_xmin(xmin);
+  relative_bbox->set_ymin(ymin);
+  relative_bbox->set_width(width);
+  relative_bbox->set_height(height);
+
+  // Add keypoints.
+  for (int kp_id = 0;
+       kp_id < options_.num_keypoints() * options_.num_values_per_keypoint();
+       kp_id += options_.num_values_per_keypoint()) {
+    auto keypoint = location_data->add_relative_keypoints();
+    const int keypoint_index = options_.keypoint_coord_offset() + kp_id;
+    keypoint->set_x(box_values[keypoint_index + 0]);
+    keypoint->set_y(options_.flip_vertically()
+                        ? 1.f - box_values[keypoint_index + 1]
+                        : box_values[keypoint_index + 1]);
+  }
+}
+
+void TensorsToDetectionsCalculator::AddDetection(
+    float xmin, float ymin, float width, float height, float score,
+    int class_id, const float* box_values,
+    std::vector<CompactDetection>* output_detections) {
+  CompactDetection& detection = output_detections->emplace_back();
+  detection.label_id = class_id;
+  detection.score = score;
+  detection.xmin = xmin;
+  detection.ymin = ymin;
+  detection.width = width;
+  detection.height = height;
+  // UpdateContract checked that the keypoints fit.
+  detection.num_keypoints = options_.num_keypoints();
+  for (int k = 0; k < detection.num_keypoints; ++k) {
+    const int keypoint_index = options_.keypoint_coord_offset() +
+                               k * options_.num_values_per_keypoint();
+    detection.keypoints[k].x = box_values[keypoint_index + 0];
+    detection.keypoints[k].y = options_.flip_vertically()
+                                   ? 1.f - box_values[keypoint_index + 1]
+                                   : box_values[keypoint_index + 1];
+  }
 }
 
 absl::Status TensorsToDetectionsCalculator::GpuInit(CalculatorContext* cc) {
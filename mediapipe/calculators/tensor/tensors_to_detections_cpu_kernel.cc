@@ -0,0 +1,246 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/tensors_to_detections_cpu_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mediapipe {
+
+namespace {
+
+using Options = TensorsToDetectionsCalculatorOptions;
+
+// The number of boxes processed at a time. Their values stay in L1 cache
+// between the loops over them.
+constexpr int kBlockSize = 64;
+
+// Returns the clipped score, if the options clip scores.
+inline float ClipScore(float score, const Options& options) {
+  if (options.has_score_clipping_thresh()) {
+    score = score < -options.score_clipping_thresh()
+                ? -options.score_clipping_thresh()
+                : score;
+    score = score > options.score_clipping_thresh()
+                ? options.score_clipping_thresh()
+                : score;
+  }
+  return score;
+}
+
+// Finds the highest score of a single box among @classes.
+void ScoreBox(const float* raw_scores, const std::vector<int>& classes,
+              const Options& options, float* score, int* score_class) {
+  int class_id = -1;
+  float max_score = -std::numeric_limits<float>::max();
+  for (int c : classes) {
+    float value = raw_scores[c];
+    if (options.sigmoid_score()) {
+      value = 1.0f / (1.0f + std::exp(-ClipScore(value, options)));
+    }
+    if (max_score < value) {
+      max_score = value;
+      class_id = c;
+    }
+  }
+  *score = max_score;
+  *score_class = class_id;
+}
+
+// Returns a raw score such that boxes whose highest raw score is below it
+// certainly have a score below options.min_score_thresh().
+float GetRawScoreCutoff(const Options& options) {
+  constexpr float kNoCutoff = -std::numeric_limits<float>::infinity();
+  if (!options.has_min_score_thresh()) {
+    return kNoCutoff;
+  }
+  const float thresh = options.min_score_thresh();
+  if (!options.sigmoid_score()) {
+    return thresh;
+  }
+  // The sigmoid is rounded, so a score close to the threshold may land on
+  // either side of it. The error of the logit grows as the threshold gets
+  // close to 0 or 1, so the cutoff stays a margin below the logit of a
+  // threshold clamped to [kMinThresh, kMaxThresh], and there is none below
+  // kMinThresh.
+  constexpr double kMinThresh = 1e-6;
+  constexpr double kMaxThresh = 0.99;
+  constexpr double kLogitMargin = 0.01;
+  if (thresh < kMinThresh) {
+    return kNoCutoff;
+  }
+  const double clamped_thresh = std::min<double>(thresh, kMaxThresh);
+  return std::log(clamped_thresh / (1.0 - clamped_thresh)) - kLogitMargin;
+}
+
+}  // namespace
+
+AnchorArrays ToAnchorArrays(const std::vector<Anchor>& anchors) {
+  AnchorArrays arrays;
+  arrays.x_center.reserve(anchors.size());
+  arrays.y_center.reserve(anchors.size());
+  arrays.w.reserve(anchors.size());
+  arrays.h.reserve(anchors.size());
+  for (const Anchor& anchor : anchors) {
+    arrays.x_center.push_back(anchor.x_center());
+    arrays.y_center.push_back(anchor.y_center());
+    arrays.w.push_back(anchor.w());
+    arrays.h.push_back(anchor.h());
+  }
+  return arrays;
+}
+
+void DecodeDetectionBoxes(const float* raw_boxes, const AnchorArrays& anchors,
+                          const Options& options, Options::BoxFormat box_format,
+                          int num_boxes, float* boxes) {
+  const int num_coords = options.num_coords();
+  // Multiplying by the inverse scales, rather than dividing by the scales,
+  // changes the results by at most one ulp, and makes decoding several times
+  // faster.
+  const float inv_x_scale = 1.0f / options.x_scale();
+  const float inv_y_scale = 1.0f / options.y_scale();
+  const float inv_w_scale = 1.0f / options.w_scale();
+  const float inv_h_scale = 1.0f / options.h_scale();
+  const bool is_yx = box_format == Options::UNSPECIFIED ||
+                     box_format == Options::YXHW;
+  float y_center[kBlockSize];
+  float x_center[kBlockSize];
+  float h[kBlockSize];
+  float w[kBlockSize];
+  for (int start = 0; start < num_boxes; start += kBlockSize) {
+    const int n = std::min(kBlockSize, num_boxes - start);
+    const float* block_raw_boxes = raw_boxes + start * num_coords;
+    float* block_boxes = boxes + start * num_coords;
+    const float* anchor_x = anchors.x_center.data() + start;
+    const float* anchor_y = anchors.y_center.data() + start;
+    const float* anchor_w = anchors.w.data() + start;
+    const float* anchor_h = anchors.h.data() + start;
+
+    // Gathers the raw boxes of the block into arrays.
+    const float* raw = block_raw_boxes + options.box_coord_offset();
+    switch (box_format) {
+      case Options::UNSPECIFIED:
+      case Options::YXHW:
+        for (int i = 0; i < n; ++i, raw += num_coords) {
+          y_center[i] = raw[0];
+          x_center[i] = raw[1];
+          h[i] = raw[2];
+          w[i] = raw[3];
+        }
+        break;
+      case Options::XYWH:
+        for (int i = 0; i < n; ++i, raw += num_coords) {
+          x_center[i] = raw[0];
+          y_center[i] = raw[1];
+          w[i] = raw[2];
+          h[i] = raw[3];
+        }
+        break;
+      case Options::XYXY:
+        for (int i = 0; i < n; ++i, raw += num_coords) {
+          x_center[i] = (-raw[0] + raw[2]) / 2;
+          y_center[i] = (-raw[1] + raw[3]) / 2;
+          w[i] = raw[2] + raw[0];
+          h[i] = raw[3] + raw[1];
+        }
+        break;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      x_center[i] = x_center[i] * inv_x_scale * anchor_w[i] + anchor_x[i];
+      y_center[i] = y_center[i] * inv_y_scale * anchor_h[i] + anchor_y[i];
+    }
+    if (options.apply_exponential_on_box_size()) {
+      for (int i = 0; i < n; ++i) {
+        h[i] = std::exp(h[i] * inv_h_scale) * anchor_h[i];
+        w[i] = std::exp(w[i] * inv_w_scale) * anchor_w[i];
+      }
+    } else {
+      for (int i = 0; i < n; ++i) {
+        h[i] = h[i] * inv_h_scale * anchor_h[i];
+        w[i] = w[i] * inv_w_scale * anchor_w[i];
+      }
+    }
+
+    float* box = block_boxes;
+    for (int i = 0; i < n; ++i, box += num_coords) {
+      box[0] = y_center[i] - h[i] / 2.f;
+      box[1] = x_center[i] - w[i] / 2.f;
+      box[2] = y_center[i] + h[i] / 2.f;
+      box[3] = x_center[i] + w[i] / 2.f;
+    }
+
+    for (int k = 0; k < options.num_keypoints(); ++k) {
+      const int offset = options.keypoint_coord_offset() +
+                         k * options.num_values_per_keypoint();
+      const float* raw_keypoint = block_raw_boxes + offset;
+      float* keypoint = block_boxes + offset;
+      for (int i = 0; i < n; ++i) {
+        const float keypoint_x = is_yx ? raw_keypoint[1] : raw_keypoint[0];
+        const float keypoint_y = is_yx ? raw_keypoint[0] : raw_keypoint[1];
+        keypoint[0] = keypoint_x * inv_x_scale * anchor_w[i] + anchor_x[i];
+        keypoint[1] = keypoint_y * inv_y_scale * anchor_h[i] + anchor_y[i];
+        raw_keypoint += num_coords;
+        keypoint += num_coords;
+      }
+    }
+  }
+}
+
+void ScoreDetectionBoxes(const float* raw_scores, int num_boxes,
+                         int num_classes, const std::vector<int>& classes,
+                         const Options& options, float* scores,
+                         int* score_classes) {
+  const float cutoff = GetRawScoreCutoff(options);
+  if (cutoff == -std::numeric_limits<float>::infinity()) {
+    for (int i = 0; i < num_boxes; ++i) {
+      ScoreBox(raw_scores + i * num_classes, classes, options, &scores[i],
+               &score_classes[i]);
+    }
+    return;
+  }
+
+  float max_raw_scores[kBlockSize];
+  for (int start = 0; start < num_boxes; start += kBlockSize) {
+    const int n = std::min(kBlockSize, num_boxes - start);
+    const float* block_raw_scores = raw_scores + start * num_classes;
+    std::fill(max_raw_scores, max_raw_scores + n,
+              -std::numeric_limits<float>::max());
+    // Like the comparison in ScoreBox, this ignores NaN scores.
+    for (int c : classes) {
+      const float* raw = block_raw_scores + c;
+      for (int i = 0; i < n; ++i) {
+        const float value = raw[i * num_classes];
+        max_raw_scores[i] =
+            value > max_raw_scores[i] ? value : max_raw_scores[i];
+      }
+    }
+    for (int i = 0; i < n; ++i) {
+      const float max_raw_score = options.sigmoid_score()
+                                      ? ClipScore(max_raw_scores[i], options)
+                                      : max_raw_scores[i];
+      if (max_raw_score < cutoff) {
+        scores[start + i] = -std::numeric_limits<float>::max();
+        score_classes[start + i] = -1;
+      } else {
+        ScoreBox(block_raw_scores + i * num_classes, classes, options,
+                 &scores[start + i], &score_classes[start + i]);
+      }
+    }
+  }
+}
+
+}  // namespace mediapipe
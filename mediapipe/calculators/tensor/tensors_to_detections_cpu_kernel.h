@@ -0,0 +1,62 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_TENSORS_TO_DETECTIONS_CPU_KERNEL_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_TENSORS_TO_DETECTIONS_CPU_KERNEL_H_
+
+#include <vector>
+
+#include "mediapipe/calculators/tensor/tensors_to_detections_calculator.pb.h"
+#include "mediapipe/framework/formats/object_detection/anchor.pb.h"
+
+namespace mediapipe {
+
+// Anchors in structure-of-arrays form, so that boxes are decoded by loops over
+// contiguous values, which the compiler vectorizes.
+struct AnchorArrays {
+  std::vector<float> x_center;
+  std::vector<float> y_center;
+  std::vector<float> w;
+  std::vector<float> h;
+};
+
+AnchorArrays ToAnchorArrays(const std::vector<Anchor>& anchors);
+
+// Decodes @num_boxes raw boxes and keypoints, each of options.num_coords()
+// values, relative to @anchors. Box i is written to @boxes at
+// i * options.num_coords() as [ymin, xmin, ymax, xmax], and its keypoints at
+// i * options.num_coords() + options.keypoint_coord_offset() as [x, y] pairs.
+// @box_format is the layout of the raw boxes.
+void DecodeDetectionBoxes(
+    const float* raw_boxes, const AnchorArrays& anchors,
+    const TensorsToDetectionsCalculatorOptions& options,
+    TensorsToDetectionsCalculatorOptions::BoxFormat box_format, int num_boxes,
+    float* boxes);
+
+// Writes the highest score of each of @num_boxes boxes among @classes to
+// @scores, and the class with that score to @score_classes. @raw_scores holds
+// @num_classes scores for each box. Scores are clipped and passed through a
+// sigmoid as set in @options.
+//
+// If options.min_score_thresh() is set, the highest raw scores are compared
+// with the logit of the threshold first, and the sigmoid only runs for boxes
+// that may pass it. The other boxes get a score of -FLT_MAX and class -1.
+void ScoreDetectionBoxes(const float* raw_scores, int num_boxes,
+                         int num_classes, const std::vector<int>& classes,
+                         const TensorsToDetectionsCalculatorOptions& options,
+                         float* scores, int* score_classes);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_TENSORS_TO_DETECTIONS_CPU_KERNEL_H_
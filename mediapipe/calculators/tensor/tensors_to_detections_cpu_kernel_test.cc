@@ -0,0 +1,329 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/tensors_to_detections_cpu_kernel.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "mediapipe/calculators/tensor/tensors_to_detections_calculator.pb.h"
+#include "mediapipe/framework/formats/object_detection/anchor.pb.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+using Options = TensorsToDetectionsCalculatorOptions;
+
+// Decodes boxes one at a time from Anchor protos, the way
+// TensorsToDetectionsCalculator did before it used the kernel.
+void DecodeBoxesScalar(const float* raw_boxes,
+                       const std::vector<Anchor>& anchors,
+                       const Options& options, Options::BoxFormat box_format,
+                       int num_boxes, float* boxes) {
+  const int num_coords = options.num_coords();
+  for (int i = 0; i < num_boxes; ++i) {
+    const int box_offset = i * num_coords + options.box_coord_offset();
+    float y_center = 0.0;
+    float x_center = 0.0;
+    float h = 0.0;
+    float w = 0.0;
+    switch (box_format) {
+      case Options::UNSPECIFIED:
+      case Options::YXHW:
+        y_center = raw_boxes[box_offset];
+        x_center = raw_boxes[box_offset + 1];
+        h = raw_boxes[box_offset + 2];
+        w = raw_boxes[box_offset + 3];
+        break;
+      case Options::XYWH:
+        x_center = raw_boxes[box_offset];
+        y_center = raw_boxes[box_offset + 1];
+        w = raw_boxes[box_offset + 2];
+        h = raw_boxes[box_offset + 3];
+        break;
+      case Options::XYXY:
+        x_center = (-raw_boxes[box_offset] + raw_boxes[box_offset + 2]) / 2;
+        y_center = (-raw_boxes[box_offset + 1] + raw_boxes[box_offset + 3]) / 2;
+        w = raw_boxes[box_offset + 2] + raw_boxes[box_offset];
+        h = raw_boxes[box_offset + 3] + raw_boxes[box_offset + 1];
+        break;
+    }
+    x_center =
+        x_center / options.x_scale() * anchors[i].w() + anchors[i].x_center();
+    y_center =
+        y_center / options.y_scale() * anchors[i].h() + anchors[i].y_center();
+    if (options.apply_exponential_on_box_size()) {
+      h = std::exp(h / options.h_scale()) * anchors[i].h();
+      w = std::exp(w / options.w_scale()) * anchors[i].w();
+    } else {
+      h = h / options.h_scale() * anchors[i].h();
+      w = w / options.w_scale() * anchors[i].w();
+    }
+    boxes[i * num_coords + 0] = y_center - h / 2.f;
+    boxes[i * num_coords + 1] = x_center - w / 2.f;
+    boxes[i * num_coords + 2] = y_center + h / 2.f;
+    boxes[i * num_coords + 3] = x_center + w / 2.f;
+
+    for (int k = 0; k < options.num_keypoints(); ++k) {
+      const int offset = i * num_coords + options.keypoint_coord_offset() +
+                         k * options.num_values_per_keypoint();
+      const bool is_yx =
+          box_format == Options::UNSPECIFIED || box_format == Options::YXHW;
+      const float keypoint_y =
+          is_yx ? raw_boxes[offset] : raw_boxes[offset + 1];
+      const float keypoint_x =
+          is_yx ? raw_boxes[offset + 1] : raw_boxes[offset];
+      boxes[offset] = keypoint_x / options.x_scale() * anchors[i].w() +
+                      anchors[i].x_center();
+      boxes[offset + 1] = keypoint_y / options.y_scale() * anchors[i].h() +
+                          anchors[i].y_center();
+    }
+  }
+}
+
+// Scores every box with a sigmoid for every class, the way
+// TensorsToDetectionsCalculator did before it used the kernel.
+void ScoreBoxesScalar(const float* raw_scores, int num_boxes, int num_classes,
+                      const std::vector<int>& classes, const Options& options,
+                      float* scores, int* score_classes) {
+  for (int i = 0; i < num_boxes; ++i) {
+    int class_id = -1;
+    float max_score = -std::numeric_limits<float>::max();
+    for (int c : classes) {
+      float score = raw_scores[i * num_classes + c];
+      if (options.sigmoid_score()) {
+        if (options.has_score_clipping_thresh()) {
+          score = score < -options.score_clipping_thresh()
+                      ? -options.score_clipping_thresh()
+                      : score;
+          score = score > options.score_clipping_thresh()
+                      ? options.score_clipping_thresh()
+                      : score;
+        }
+        score = 1.0f / (1.0f + std::exp(-score));
+      }
+      if (max_score < score) {
+        max_score = score;
+        class_id = c;
+      }
+    }
+    scores[i] = max_score;
+    score_classes[i] = class_id;
+  }
+}
+
+std::vector<float> MakeValues(int size, float min, float max) {
+  std::mt19937 generator(size);
+  std::uniform_real_distribution<float> distribution(min, max);
+  std::vector<float> values(size);
+  for (float& value : values) {
+    value = distribution(generator);
+  }
+  return values;
+}
+
+std::vector<Anchor> MakeAnchors(int num_boxes) {
+  const std::vector<float> values = MakeValues(num_boxes * 4, 0.05f, 1.0f);
+  std::vector<Anchor> anchors(num_boxes);
+  for (int i = 0; i < num_boxes; ++i) {
+    anchors[i].set_x_center(values[i * 4]);
+    anchors[i].set_y_center(values[i * 4 + 1]);
+    anchors[i].set_w(values[i * 4 + 2]);
+    anchors[i].set_h(values[i * 4 + 3]);
+  }
+  return anchors;
+}
+
+// The options of a face detector with 6 keypoints.
+Options MakeOptions() {
+  Options options;
+  options.set_num_classes(1);
+  options.set_num_coords(16);
+  options.set_keypoint_coord_offset(4);
+  options.set_num_keypoints(6);
+  options.set_num_values_per_keypoint(2);
+  options.set_x_scale(128.0f);
+  options.set_y_scale(128.0f);
+  options.set_w_scale(128.0f);
+  options.set_h_scale(128.0f);
+  options.set_sigmoid_score(true);
+  options.set_score_clipping_thresh(100.0f);
+  options.set_min_score_thresh(0.5f);
+  return options;
+}
+
+struct DecodeTestCase {
+  Options::BoxFormat box_format;
+  bool apply_exponential_on_box_size;
+};
+
+class DecodeDetectionBoxesTest
+    : public testing::TestWithParam<DecodeTestCase> {};
+
+TEST_P(DecodeDetectionBoxesTest, MatchesScalarDecoding) {
+  // Not a multiple of the kernel's block size.
+  constexpr int kNumBoxes = 150;
+  Options options = MakeOptions();
+  options.set_box_format(GetParam().box_format);
+  options.set_apply_exponential_on_box_size(
+      GetParam().apply_exponential_on_box_size);
+  const std::vector<Anchor> anchors = MakeAnchors(kNumBoxes);
+  const std::vector<float> raw_boxes =
+      MakeValues(kNumBoxes * options.num_coords(), -60.0f, 60.0f);
+
+  std::vector<float> expected(raw_boxes.size());
+  DecodeBoxesScalar(raw_boxes.data(), anchors, options, options.box_format(),
+                    kNumBoxes, expected.data());
+  std::vector<float> boxes(raw_boxes.size());
+  DecodeDetectionBoxes(raw_boxes.data(), ToAnchorArrays(anchors), options,
+                       options.box_format(), kNumBoxes, boxes.data());
+  for (int i = 0; i < static_cast<int>(boxes.size()); ++i) {
+    ASSERT_FLOAT_EQ(expected[i], boxes[i]) << "at " << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DecodeDetectionBoxesTests, DecodeDetectionBoxesTest,
+    testing::Values(DecodeTestCase{Options::UNSPECIFIED, false},
+                    DecodeTestCase{Options::YXHW, true},
+                    DecodeTestCase{Options::XYWH, false},
+                    DecodeTestCase{Options::XYXY, true}));
+
+// Checks that the kernel finds the same scores and classes as the scalar
+// loop for every box that passes the threshold, and drops the others.
+void ExpectSameSurvivors(const std::vector<float>& raw_scores,
+                         const std::vector<int>& classes,
+                         const Options& options) {
+  const int num_boxes = raw_scores.size() / options.num_classes();
+  std::vector<float> expected_scores(num_boxes);
+  std::vector<int> expected_classes(num_boxes);
+  ScoreBoxesScalar(raw_scores.data(), num_boxes, options.num_classes(),
+                   classes, options, expected_scores.data(),
+                   expected_classes.data());
+  std::vector<float> scores(num_boxes);
+  std::vector<int> score_classes(num_boxes);
+  ScoreDetectionBoxes(raw_scores.data(), num_boxes, options.num_classes(),
+                      classes, options, scores.data(), score_classes.data());
+  for (int i = 0; i < num_boxes; ++i) {
+    if (expected_scores[i] >= options.min_score_thresh()) {
+      ASSERT_EQ(expected_scores[i], scores[i]) << "at " << i;
+      ASSERT_EQ(expected_classes[i], score_classes[i]) << "at " << i;
+    } else {
+      ASSERT_LT(scores[i], options.min_score_thresh()) << "at " << i;
+    }
+  }
+}
+
+TEST(ScoreDetectionBoxesTest, MatchesScalarScoring) {
+  Options options = MakeOptions();
+  options.set_num_classes(3);
+  const std::vector<float> raw_scores = MakeValues(3 * 1000, -8.0f, 4.0f);
+  ExpectSameSurvivors(raw_scores, {0, 1, 2}, options);
+  // Ignores class 1.
+  ExpectSameSurvivors(raw_scores, {0, 2}, options);
+  options.set_score_clipping_thresh(1.0f);
+  ExpectSameSurvivors(raw_scores, {0, 1, 2}, options);
+  options.set_sigmoid_score(false);
+  ExpectSameSurvivors(raw_scores, {0, 1, 2}, options);
+}
+
+TEST(ScoreDetectionBoxesTest, KeepsScoresCloseToThreshold) {
+  Options options = MakeOptions();
+  for (float thresh : {1e-7f, 0.001f, 0.5f, 0.75f, 0.999f, 1.0f}) {
+    options.set_min_score_thresh(thresh);
+    const float logit = std::log(thresh / (1.0f - thresh));
+    std::vector<float> raw_scores;
+    for (int i = -100; i <= 100; ++i) {
+      raw_scores.push_back(std::isinf(logit) ? 10.0f + i : logit + i * 1e-5f);
+    }
+    ExpectSameSurvivors(raw_scores, {0}, options);
+  }
+}
+
+TEST(ScoreDetectionBoxesTest, ScoresEveryBoxWithoutThreshold) {
+  Options options = MakeOptions();
+  options.clear_min_score_thresh();
+  const std::vector<float> raw_scores = MakeValues(100, -8.0f, 4.0f);
+  std::vector<float> expected_scores(100);
+  std::vector<int> expected_classes(100);
+  ScoreBoxesScalar(raw_scores.data(), 100, 1, {0}, options,
+                   expected_scores.data(), expected_classes.data());
+  std::vector<float> scores(100);
+  std::vector<int> score_classes(100);
+  ScoreDetectionBoxes(raw_scores.data(), 100, 1, {0}, options, scores.data(),
+                      score_classes.data());
+  EXPECT_EQ(expected_scores, scores);
+  EXPECT_EQ(expected_classes, score_classes);
+}
+
+// Decodes and scores the outputs of a face detector with 6 keypoints. The
+// arg is the number of anchors: 896 and 2304 for the short and full range
+// face detectors, 2944 for the palm detector, and about 18k for large SSD
+// models. Most anchors score below the threshold, as in real frames.
+struct BenchmarkInputs {
+  explicit BenchmarkInputs(int num_boxes)
+      : options(MakeOptions()),
+        anchors(MakeAnchors(num_boxes)),
+        raw_boxes(MakeValues(num_boxes * options.num_coords(), -60.0f, 60.0f)),
+        raw_scores(MakeValues(num_boxes, -12.0f, 1.0f)),
+        boxes(raw_boxes.size()),
+        scores(num_boxes),
+        score_classes(num_boxes) {}
+
+  Options options;
+  std::vector<Anchor> anchors;
+  std::vector<float> raw_boxes;
+  std::vector<float> raw_scores;
+  std::vector<float> boxes;
+  std::vector<float> scores;
+  std::vector<int> score_classes;
+};
+
+void BM_DecodeAndScoreScalar(benchmark::State& state) {
+  const int num_boxes = state.range(0);
+  BenchmarkInputs inputs(num_boxes);
+  for (auto _ : state) {
+    DecodeBoxesScalar(inputs.raw_boxes.data(), inputs.anchors, inputs.options,
+                      Options::YXHW, num_boxes, inputs.boxes.data());
+    ScoreBoxesScalar(inputs.raw_scores.data(), num_boxes, 1, {0},
+                     inputs.options, inputs.scores.data(),
+                     inputs.score_classes.data());
+    benchmark::DoNotOptimize(inputs.boxes.data());
+    benchmark::DoNotOptimize(inputs.scores.data());
+  }
+}
+BENCHMARK(BM_DecodeAndScoreScalar)->Arg(896)->Arg(2304)->Arg(2944)->Arg(18000);
+
+void BM_DecodeAndScoreKernel(benchmark::State& state) {
+  const int num_boxes = state.range(0);
+  BenchmarkInputs inputs(num_boxes);
+  const AnchorArrays anchors = ToAnchorArrays(inputs.anchors);
+  for (auto _ : state) {
+    DecodeDetectionBoxes(inputs.raw_boxes.data(), anchors, inputs.options,
+                         Options::YXHW, num_boxes, inputs.boxes.data());
+    ScoreDetectionBoxes(inputs.raw_scores.data(), num_boxes, 1, {0},
+                        inputs.options, inputs.scores.data(),
+                        inputs.score_classes.data());
+    benchmark::DoNotOptimize(inputs.boxes.data());
+    benchmark::DoNotOptimize(inputs.scores.data());
+  }
+}
+BENCHMARK(BM_DecodeAndScoreKernel)->Arg(896)->Arg(2304)->Arg(2944)->Arg(18000);
+
+}  // namespace
+}  // namespace mediapipe
@@ -15,6 +15,7 @@
 #include "mediapipe/calculators/tensor/tensors_to_landmarks_calculator.pb.h"
 #include "mediapipe/framework/api2/node.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_landmark.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -67,11 +68,14 @@ float ApplyActivation(
 // Output:
 //  LANDMARKS(optional) - Result MediaPipe landmarks.
 //  NORM_LANDMARKS(optional) - Result MediaPipe normalized landmarks.
+//  COMPACT_NORM_LANDMARKS(optional) - The normalized landmarks as a
+//    CompactNormalizedLandmarkList, which LandmarkProjectionCalculator and
+//    LandmarksSmoothingCalculator accept without a proto per landmark.
 //
 // Notes:
-//   To output normalized landmarks, user must provide the original input image
-//   size to the model using calculator option input_image_width and
-//   input_image_height.
+//   To output normalized landmarks, in either format, user must provide the
+//   original input image size to the model using calculator option
+//   input_image_width and input_image_height.
 // Usage example:
 // node {
 //   calculator: "TensorsToLandmarksCalculator"
@@ -97,8 +101,17 @@ class TensorsToLandmarksCalculator : public Node {
   static constexpr Output<LandmarkList>::Optional kOutLandmarkList{"LANDMARKS"};
   static constexpr Output<NormalizedLandmarkList>::Optional
       kOutNormalizedLandmarkList{"NORM_LANDMARKS"};
+  static constexpr Output<CompactNormalizedLandmarkList>::Optional
+      kOutCompactNormalizedLandmarkList{"COMPACT_NORM_LANDMARKS"};
   MEDIAPIPE_NODE_CONTRACT(kInTensors, kFlipHorizontally, kFlipVertically,
-                          kOutLandmarkList, kOutNormalizedLandmarkList);
+                          kOutLandmarkList, kOutNormalizedLandmarkList,
+                          kOutCompactNormalizedLandmarkList);
+
+  static absl::Status UpdateContract(CalculatorContract* cc) {
+    // Process only reads the options, so timestamps can run in parallel.
+    cc->SetProcessReentrant(true);
+    return absl::OkStatus();
+  }
 
   absl::Status Open(CalculatorContext* cc) override;
   absl::Status Process(CalculatorContext* cc) override;
@@ -113,7 +126,8 @@ MEDIAPIPE_REGISTER_NODE(TensorsToLandmarksCalculator);
 absl::Status TensorsToLandmarksCalculator::Open(CalculatorContext* cc) {
   MP_RETURN_IF_ERROR(LoadOptions(cc));
 
-  if (kOutNormalizedLandmarkList(cc).IsConnected()) {
+  if (kOutNormalizedLandmarkList(cc).IsConnected() ||
+      kOutCompactNormalizedLandmarkList(cc).IsConnected()) {
     RET_CHECK(options_.has_input_image_height() &&
               options_.has_input_image_width())
         << "Must provide input width/height for getting normalized landmarks.";
@@ -147,61 +161,72 @@ absl::Status TensorsToLandmarksCalculator::Process(CalculatorContext* cc) {
   auto view = input_tensors[0].GetCpuReadView();
   auto raw_landmarks = view.buffer<float>();
 
-  LandmarkList output_landmarks;
-
+  std::vector<CompactLandmark> landmarks(num_landmarks_);
   for (int ld = 0; ld < num_landmarks_; ++ld) {
     const int offset = ld * num_dimensions;
-    Landmark* landmark = output_landmarks.add_landmark();
+    CompactLandmark& landmark = landmarks[ld];
 
     if (flip_horizontally) {
-      landmark->set_x(options_.input_image_width() - raw_landmarks[offset]);
+      landmark.x = options_.input_image_width() - raw_landmarks[offset];
     } else {
-      landmark->set_x(raw_landmarks[offset]);
+      landmark.x = raw_landmarks[offset];
     }
     if (num_dimensions > 1) {
       if (flip_vertically) {
-        landmark->set_y(options_.input_image_height() -
-                        raw_landmarks[offset + 1]);
+        landmark.y = options_.input_image_height() - raw_landmarks[offset + 1];
       } else {
-        landmark->set_y(raw_landmarks[offset + 1]);
+        landmark.y = raw_landmarks[offset + 1];
       }
     }
     if (num_dimensions > 2) {
-      landmark->set_z(raw_landmarks[offset + 2]);
+      landmark.z = raw_landmarks[offset + 2];
     }
     if (num_dimensions > 3) {
-      landmark->set_visibility(ApplyActivation(options_.visibility_activation(),
-                                               raw_landmarks[offset + 3]));
+      landmark.visibility = ApplyActivation(options_.visibility_activation(),
+                                            raw_landmarks[offset + 3]);
+      landmark.has_visibility = true;
     }
     if (num_dimensions > 4) {
-      landmark->set_presence(ApplyActivation(options_.presence_activation(),
-                                             raw_landmarks[offset + 4]));
+      landmark.presence = ApplyActivation(options_.presence_activation(),
+                                          raw_landmarks[offset + 4]);
+      landmark.has_presence = true;
     }
   }
 
   // Output normalized landmarks if required.
-  if (kOutNormalizedLandmarkList(cc).IsConnected()) {
-    NormalizedLandmarkList output_norm_landmarks;
-    for (int i = 0; i < output_landmarks.landmark_size(); ++i) {
-      const Landmark& landmark = output_landmarks.landmark(i);
-      NormalizedLandmark* norm_landmark = output_norm_landmarks.add_landmark();
-      norm_landmark->set_x(landmark.x() / options_.input_image_width());
-      norm_landmark->set_y(landmark.y() / options_.input_image_height());
+  if (kOutNormalizedLandmarkList(cc).IsConnected() ||
+      kOutCompactNormalizedLandmarkList(cc).IsConnected()) {
+    CompactNormalizedLandmarkList output_norm_landmarks;
+    output_norm_landmarks.landmark.reserve(landmarks.size());
+    for (const CompactLandmark& landmark : landmarks) {
+      CompactLandmark& norm_landmark =
+          output_norm_landmarks.landmark.emplace_back(landmark);
+      norm_landmark.x = landmark.x / options_.input_image_width();
+      norm_landmark.y = landmark.y / options_.input_image_height();
       // Scale Z coordinate as X + allow additional uniform normalization.
-      norm_landmark->set_z(landmark.z() / options_.input_image_width() /
-                           options_.normalize_z());
-      if (landmark.has_visibility()) {  // Set only if supported in the model.
-        norm_landmark->set_visibility(landmark.visibility());
-      }
-      if (landmark.has_presence()) {  // Set only if supported in the model.
-        norm_landmark->set_presence(landmark.presence());
-      }
+      norm_landmark.z =
+          landmark.z / options_.input_image_width() / options_.normalize_z();
+    }
+    if (kOutNormalizedLandmarkList(cc).IsConnected()) {
+      kOutNormalizedLandmarkList(cc).Send(
+          ToNormalizedLandmarkList(output_norm_landmarks));
+    }
+    if (kOutCompactNormalizedLandmarkList(cc).IsConnected()) {
+      kOutCompactNormalizedLandmarkList(cc).Send(
+          std::move(output_norm_landmarks));
     }
-    kOutNormalizedLandmarkList(cc).Send(std::move(output_norm_landmarks));
   }
 
   // Output absolute landmarks.
   if (kOutLandmarkList(cc).IsConnected()) {
+    LandmarkList output_landmarks;
+    for (const CompactLandmark& landmark : landmarks) {
+      Landmark* landmark_proto = output_landmarks.add_landmark();
+      ToLandmarkProto(landmark, landmark_proto);
+      // Leave unset the coordinates the model doesn't provide.
+      if (num_dimensions < 2) landmark_proto->clear_y();
+      if (num_dimensions < 3) landmark_proto->clear_z();
+    }
     kOutLandmarkList(cc).Send(std::move(output_landmarks));
   }
 
@@ -4,6 +4,7 @@
 #include "mediapipe/calculators/util/detections_to_rects_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_options.pb.h"
+#include "mediapipe/framework/formats/compact_detection.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
@@ -60,6 +61,12 @@ class AlignmentPointsRectsCalculator : public DetectionsToRectsCalculator {
       const ::mediapipe::Detection& detection,
       const DetectionSpec& detection_spec,
       ::mediapipe::NormalizedRect* rect) override;
+  absl::Status DetectionToNormalizedRect(
+      const CompactDetection& detection, const DetectionSpec& detection_spec,
+      ::mediapipe::NormalizedRect* rect) override {
+    return DetectionToNormalizedRect(ToDetection(detection), detection_spec,
+                                     rect);
+  }
 };
 REGISTER_CALCULATOR(AlignmentPointsRectsCalculator);
 
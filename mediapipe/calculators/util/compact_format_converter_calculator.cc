@@ -0,0 +1,145 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_detection.h"
+#include "mediapipe/framework/formats/compact_landmark.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr char kDetectionsTag[] = "DETECTIONS";
+constexpr char kCompactDetectionsTag[] = "COMPACT_DETECTIONS";
+constexpr char kLandmarksTag[] = "NORM_LANDMARKS";
+constexpr char kCompactLandmarksTag[] = "COMPACT_NORM_LANDMARKS";
+
+}  // namespace
+
+// Converts detections or landmarks between their protos and the compact types
+// of framework/formats/compact_detection.h and compact_landmark.h. The
+// calculators which accept both can then pass the compact types along, and the
+// conversion back to protos only happens for the calculators that need them.
+//
+// TensorsToDetectionsCalculator and TensorsToLandmarksCalculator emit the
+// compact types directly, so this calculator is mostly needed to convert them
+// back for the calculators which only accept protos.
+//
+// Inputs, one of:
+//   DETECTIONS - std::vector<Detection>
+//   COMPACT_DETECTIONS - std::vector<CompactDetection>
+//   NORM_LANDMARKS - NormalizedLandmarkList
+//   COMPACT_NORM_LANDMARKS - CompactNormalizedLandmarkList
+//
+// Output: the other type of the input, with the matching tag.
+//
+// The conversion of detections to CompactDetection fails for the detections
+// which don't fit it, see ToCompactDetection.
+//
+// Usage example:
+// node {
+//   calculator: "CompactFormatConverterCalculator"
+//   input_stream: "DETECTIONS:detections"
+//   output_stream: "COMPACT_DETECTIONS:compact_detections"
+// }
+class CompactFormatConverterCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK_EQ(cc->Inputs().NumEntries(), 1)
+        << "Exactly one input stream is required.";
+    if (cc->Inputs().HasTag(kDetectionsTag)) {
+      cc->Inputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
+      cc->Outputs()
+          .Tag(kCompactDetectionsTag)
+          .Set<std::vector<CompactDetection>>();
+    } else if (cc->Inputs().HasTag(kCompactDetectionsTag)) {
+      cc->Inputs()
+          .Tag(kCompactDetectionsTag)
+          .Set<std::vector<CompactDetection>>();
+      cc->Outputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
+    } else if (cc->Inputs().HasTag(kLandmarksTag)) {
+      cc->Inputs().Tag(kLandmarksTag).Set<NormalizedLandmarkList>();
+      cc->Outputs()
+          .Tag(kCompactLandmarksTag)
+          .Set<CompactNormalizedLandmarkList>();
+    } else {
+      RET_CHECK(cc->Inputs().HasTag(kCompactLandmarksTag))
+          << "Unsupported input stream.";
+      cc->Inputs()
+          .Tag(kCompactLandmarksTag)
+          .Set<CompactNormalizedLandmarkList>();
+      cc->Outputs().Tag(kLandmarksTag).Set<NormalizedLandmarkList>();
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    if (cc->Inputs().Index(0).IsEmpty()) {
+      return absl::OkStatus();
+    }
+    if (cc->Inputs().HasTag(kDetectionsTag)) {
+      const auto& detections =
+          cc->Inputs().Tag(kDetectionsTag).Get<std::vector<Detection>>();
+      ASSIGN_OR_RETURN(auto compact_detections,
+                       ToCompactDetections(detections));
+      cc->Outputs()
+          .Tag(kCompactDetectionsTag)
+          .AddPacket(MakePacket<std::vector<CompactDetection>>(
+                         std::move(compact_detections))
+                         .At(cc->InputTimestamp()));
+    } else if (cc->Inputs().HasTag(kCompactDetectionsTag)) {
+      const auto& compact_detections =
+          cc->Inputs()
+              .Tag(kCompactDetectionsTag)
+              .Get<std::vector<CompactDetection>>();
+      cc->Outputs()
+          .Tag(kDetectionsTag)
+          .AddPacket(MakePacket<std::vector<Detection>>(
+                         ToDetections(compact_detections))
+                         .At(cc->InputTimestamp()));
+    } else if (cc->Inputs().HasTag(kLandmarksTag)) {
+      const auto& landmarks =
+          cc->Inputs().Tag(kLandmarksTag).Get<NormalizedLandmarkList>();
+      cc->Outputs()
+          .Tag(kCompactLandmarksTag)
+          .AddPacket(MakePacket<CompactNormalizedLandmarkList>(
+                         ToCompactNormalizedLandmarkList(landmarks))
+                         .At(cc->InputTimestamp()));
+    } else {
+      const auto& compact_landmarks = cc->Inputs()
+                                          .Tag(kCompactLandmarksTag)
+                                          .Get<CompactNormalizedLandmarkList>();
+      cc->Outputs()
+          .Tag(kLandmarksTag)
+          .AddPacket(MakePacket<NormalizedLandmarkList>(
+                         ToNormalizedLandmarkList(compact_landmarks))
+                         .At(cc->InputTimestamp()));
+    }
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(CompactFormatConverterCalculator);
+
+}  // namespace mediapipe
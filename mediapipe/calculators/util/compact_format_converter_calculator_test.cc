@@ -0,0 +1,159 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/compact_detection.h"
+#include "mediapipe/framework/formats/compact_landmark.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::Pointwise;
+
+constexpr char kDetectionsTag[] = "DETECTIONS";
+constexpr char kCompactDetectionsTag[] = "COMPACT_DETECTIONS";
+constexpr char kLandmarksTag[] = "NORM_LANDMARKS";
+constexpr char kCompactLandmarksTag[] = "COMPACT_NORM_LANDMARKS";
+
+CalculatorGraphConfig::Node GetNodeConfig(const std::string& input_tag,
+                                          const std::string& output_tag) {
+  CalculatorGraphConfig::Node node_config;
+  node_config.set_calculator("CompactFormatConverterCalculator");
+  node_config.add_input_stream(input_tag + ":input");
+  node_config.add_output_stream(output_tag + ":output");
+  return node_config;
+}
+
+std::vector<Detection> GetDetections() {
+  return {
+      ParseTextProtoOrDie<Detection>(R"pb(
+        label_id: 2
+        score: 0.9
+        location_data {
+          format: RELATIVE_BOUNDING_BOX
+          relative_bounding_box { xmin: 0.1 ymin: 0.2 width: 0.3 height: 0.4 }
+          relative_keypoints { x: 0.2 y: 0.3 }
+          relative_keypoints { x: 0.25 y: 0.35 }
+        }
+      )pb"),
+      ParseTextProtoOrDie<Detection>(R"pb(
+        label_id: 0
+        score: 0.5
+        location_data {
+          format: RELATIVE_BOUNDING_BOX
+          relative_bounding_box { xmin: 0.5 ymin: 0.6 width: 0.1 height: 0.2 }
+        }
+      )pb"),
+  };
+}
+
+TEST(CompactFormatConverterCalculatorTest, DetectionsRoundTrip) {
+  CalculatorRunner to_compact(
+      GetNodeConfig(kDetectionsTag, kCompactDetectionsTag));
+  to_compact.MutableInputs()
+      ->Tag(kDetectionsTag)
+      .packets.push_back(
+          MakePacket<std::vector<Detection>>(GetDetections()).At(Timestamp(0)));
+  MP_ASSERT_OK(to_compact.Run());
+  const auto& compact_packets =
+      to_compact.Outputs().Tag(kCompactDetectionsTag).packets;
+  ASSERT_EQ(compact_packets.size(), 1);
+  const auto& compact_detections =
+      compact_packets[0].Get<std::vector<CompactDetection>>();
+  ASSERT_EQ(compact_detections.size(), 2);
+  EXPECT_EQ(compact_detections[0].label_id, 2);
+  EXPECT_FLOAT_EQ(compact_detections[0].score, 0.9f);
+  EXPECT_EQ(compact_detections[0].num_keypoints, 2);
+  EXPECT_EQ(compact_detections[1].num_keypoints, 0);
+
+  CalculatorRunner to_proto(
+      GetNodeConfig(kCompactDetectionsTag, kDetectionsTag));
+  to_proto.MutableInputs()
+      ->Tag(kCompactDetectionsTag)
+      .packets.push_back(compact_packets[0]);
+  MP_ASSERT_OK(to_proto.Run());
+  const auto& packets = to_proto.Outputs().Tag(kDetectionsTag).packets;
+  ASSERT_EQ(packets.size(), 1);
+  EXPECT_EQ(packets[0].Timestamp(), Timestamp(0));
+  EXPECT_THAT(packets[0].Get<std::vector<Detection>>(),
+              Pointwise(EqualsProto(), GetDetections()));
+}
+
+TEST(CompactFormatConverterCalculatorTest, FailsOnDetectionWithSeveralScores) {
+  CalculatorRunner runner(GetNodeConfig(kDetectionsTag, kCompactDetectionsTag));
+  runner.MutableInputs()
+      ->Tag(kDetectionsTag)
+      .packets.push_back(
+          MakePacket<std::vector<Detection>>(
+              std::vector<Detection>{ParseTextProtoOrDie<Detection>(R"pb(
+                label_id: 0
+                label_id: 1
+                score: 0.9
+                score: 0.8
+                location_data {
+                  format: RELATIVE_BOUNDING_BOX
+                  relative_bounding_box {}
+                }
+              )pb")})
+              .At(Timestamp(0)));
+  EXPECT_FALSE(runner.Run().ok());
+}
+
+TEST(CompactFormatConverterCalculatorTest, LandmarksRoundTrip) {
+  const auto landmarks = ParseTextProtoOrDie<NormalizedLandmarkList>(R"pb(
+    landmark { x: 0.1 y: 0.2 z: -0.3 visibility: 0.9 presence: 0.8 }
+    landmark { x: 0.4 y: 0.5 z: 0.6 }
+  )pb");
+
+  CalculatorRunner to_compact(
+      GetNodeConfig(kLandmarksTag, kCompactLandmarksTag));
+  to_compact.MutableInputs()
+      ->Tag(kLandmarksTag)
+      .packets.push_back(
+          MakePacket<NormalizedLandmarkList>(landmarks).At(Timestamp(0)));
+  MP_ASSERT_OK(to_compact.Run());
+  const auto& compact_packets =
+      to_compact.Outputs().Tag(kCompactLandmarksTag).packets;
+  ASSERT_EQ(compact_packets.size(), 1);
+  const auto& compact_landmarks =
+      compact_packets[0].Get<CompactNormalizedLandmarkList>();
+  ASSERT_EQ(compact_landmarks.landmark.size(), 2);
+  EXPECT_TRUE(compact_landmarks.landmark[0].has_visibility);
+  EXPECT_FALSE(compact_landmarks.landmark[1].has_presence);
+
+  CalculatorRunner to_proto(
+      GetNodeConfig(kCompactLandmarksTag, kLandmarksTag));
+  to_proto.MutableInputs()
+      ->Tag(kCompactLandmarksTag)
+      .packets.push_back(compact_packets[0]);
+  MP_ASSERT_OK(to_proto.Run());
+  const auto& packets = to_proto.Outputs().Tag(kLandmarksTag).packets;
+  ASSERT_EQ(packets.size(), 1);
+  EXPECT_EQ(packets[0].Timestamp(), Timestamp(0));
+  EXPECT_THAT(packets[0].Get<NormalizedLandmarkList>(),
+              EqualsProto(landmarks));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -15,10 +15,12 @@
 
 #include <cmath>
 #include <limits>
+#include <vector>
 
 #include "mediapipe/calculators/util/detections_to_rects_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_options.pb.h"
+#include "mediapipe/framework/formats/compact_detection.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
@@ -43,20 +45,41 @@ using ::mediapipe::Rect;
 constexpr float kMinFloat = std::numeric_limits<float>::lowest();
 constexpr float kMaxFloat = std::numeric_limits<float>::max();
 
-absl::Status NormRectFromKeyPoints(const LocationData& location_data,
-                                   NormalizedRect* rect) {
-  RET_CHECK_GT(location_data.relative_keypoints_size(), 1)
+// Accessors of the relative keypoints of a LocationData or CompactDetection.
+int NumKeypoints(const LocationData& location_data) {
+  return location_data.relative_keypoints_size();
+}
+int NumKeypoints(const CompactDetection& detection) {
+  return detection.num_keypoints;
+}
+float KeypointX(const LocationData& location_data, int i) {
+  return location_data.relative_keypoints(i).x();
+}
+float KeypointX(const CompactDetection& detection, int i) {
+  return detection.keypoints[i].x;
+}
+float KeypointY(const LocationData& location_data, int i) {
+  return location_data.relative_keypoints(i).y();
+}
+float KeypointY(const CompactDetection& detection, int i) {
+  return detection.keypoints[i].y;
+}
+
+template <class L>
+absl::Status NormRectFromKeyPoints(const L& location, NormalizedRect* rect) {
+  RET_CHECK_GT(NumKeypoints(location), 1)
       << "2 or more key points required to calculate a rect.";
   float xmin = kMaxFloat;
   float ymin = kMaxFloat;
   float xmax = kMinFloat;
   float ymax = kMinFloat;
-  for (int i = 0; i < location_data.relative_keypoints_size(); ++i) {
-    const auto& kp = location_data.relative_keypoints(i);
-    xmin = std::min(xmin, kp.x());
-    ymin = std::min(ymin, kp.y());
-    xmax = std::max(xmax, kp.x());
-    ymax = std::max(ymax, kp.y());
+  for (int i = 0; i < NumKeypoints(location); ++i) {
+    const float x = KeypointX(location, i);
+    const float y = KeypointY(location, i);
+    xmin = std::min(xmin, x);
+    ymin = std::min(ymin, y);
+    xmax = std::max(xmax, x);
+    ymax = std::max(ymax, y);
   }
   rect->set_x_center((xmin + xmax) / 2);
   rect->set_y_center((ymin + ymax) / 2);
@@ -130,6 +153,49 @@ absl::Status DetectionsToRectsCalculator::DetectionToNormalizedRect(
   return absl::OkStatus();
 }
 
+absl::Status DetectionsToRectsCalculator::DetectionToRect(
+    const CompactDetection& detection, const DetectionSpec& detection_spec,
+    Rect* rect) {
+  RET_CHECK(options_.conversion_mode() ==
+            mediapipe::
+                DetectionsToRectsCalculatorOptions_ConversionMode_USE_KEYPOINTS)
+      << "A CompactDetection has a relative bounding box, and can only be "
+         "converted to Rect with keypoints";
+  RET_CHECK(detection_spec.image_size.has_value())
+      << "Rect with absolute coordinates calculation requires image size.";
+  const int width = detection_spec.image_size->first;
+  const int height = detection_spec.image_size->second;
+  NormalizedRect norm_rect;
+  MP_RETURN_IF_ERROR(NormRectFromKeyPoints(detection, &norm_rect));
+  rect->set_x_center(std::round(norm_rect.x_center() * width));
+  rect->set_y_center(std::round(norm_rect.y_center() * height));
+  rect->set_width(std::round(norm_rect.width() * width));
+  rect->set_height(std::round(norm_rect.height() * height));
+  return absl::OkStatus();
+}
+
+absl::Status DetectionsToRectsCalculator::DetectionToNormalizedRect(
+    const CompactDetection& detection, const DetectionSpec& detection_spec,
+    NormalizedRect* rect) {
+  switch (options_.conversion_mode()) {
+    case mediapipe::DetectionsToRectsCalculatorOptions_ConversionMode_DEFAULT:
+    case mediapipe::
+        DetectionsToRectsCalculatorOptions_ConversionMode_USE_BOUNDING_BOX: {
+      rect->set_x_center(detection.xmin + detection.width / 2);
+      rect->set_y_center(detection.ymin + detection.height / 2);
+      rect->set_width(detection.width);
+      rect->set_height(detection.height);
+      break;
+    }
+    case mediapipe::
+        DetectionsToRectsCalculatorOptions_ConversionMode_USE_KEYPOINTS: {
+      MP_RETURN_IF_ERROR(NormRectFromKeyPoints(detection, rect));
+      break;
+    }
+  }
+  return absl::OkStatus();
+}
+
 absl::Status DetectionsToRectsCalculator::GetContract(CalculatorContract* cc) {
   RET_CHECK(cc->Inputs().HasTag(kDetectionTag) ^
             cc->Inputs().HasTag(kDetectionsTag))
@@ -144,10 +210,12 @@ absl::Status DetectionsToRectsCalculator::GetContract(CalculatorContract* cc) {
          "should be provided.";
 
   if (cc->Inputs().HasTag(kDetectionTag)) {
-    cc->Inputs().Tag(kDetectionTag).Set<Detection>();
+    cc->Inputs().Tag(kDetectionTag).SetOneOf<Detection, CompactDetection>();
   }
   if (cc->Inputs().HasTag(kDetectionsTag)) {
-    cc->Inputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
+    cc->Inputs()
+        .Tag(kDetectionsTag)
+        .SetOneOf<std::vector<Detection>, std::vector<CompactDetection>>();
   }
   if (cc->Inputs().HasTag(kImageSizeTag)) {
     cc->Inputs().Tag(kImageSizeTag).Set<std::pair<int, int>>();
@@ -210,33 +278,45 @@ absl::Status DetectionsToRectsCalculator::Process(CalculatorContext* cc) {
     return absl::OkStatus();
   }
 
-  std::vector<Detection> detections;
   if (cc->Inputs().HasTag(kDetectionTag)) {
-    detections.push_back(cc->Inputs().Tag(kDetectionTag).Get<Detection>());
+    const auto& packet = cc->Inputs().Tag(kDetectionTag).Value();
+    if (packet.ValidateAsType<CompactDetection>().ok()) {
+      return ProcessDetections(
+          cc, std::vector<CompactDetection>{packet.Get<CompactDetection>()});
+    }
+    return ProcessDetections(
+        cc, std::vector<Detection>{packet.Get<Detection>()});
   }
-  if (cc->Inputs().HasTag(kDetectionsTag)) {
-    detections = cc->Inputs().Tag(kDetectionsTag).Get<std::vector<Detection>>();
-    if (detections.empty()) {
-      if (output_zero_rect_for_empty_detections_) {
-        if (cc->Outputs().HasTag(kRectTag)) {
-          cc->Outputs().Tag(kRectTag).AddPacket(
-              MakePacket<Rect>().At(cc->InputTimestamp()));
-        }
-        if (cc->Outputs().HasTag(kNormRectTag)) {
-          cc->Outputs()
-              .Tag(kNormRectTag)
-              .AddPacket(MakePacket<NormalizedRect>().At(cc->InputTimestamp()));
-        }
-        if (cc->Outputs().HasTag(kNormRectsTag)) {
-          auto rect_vector = absl::make_unique<std::vector<NormalizedRect>>();
-          rect_vector->emplace_back(NormalizedRect());
-          cc->Outputs()
-              .Tag(kNormRectsTag)
-              .Add(rect_vector.release(), cc->InputTimestamp());
-        }
+  const auto& packet = cc->Inputs().Tag(kDetectionsTag).Value();
+  if (packet.ValidateAsType<std::vector<CompactDetection>>().ok()) {
+    return ProcessDetections(cc, packet.Get<std::vector<CompactDetection>>());
+  }
+  return ProcessDetections(cc, packet.Get<std::vector<Detection>>());
+}
+
+template <typename DetectionT>
+absl::Status DetectionsToRectsCalculator::ProcessDetections(
+    CalculatorContext* cc, const std::vector<DetectionT>& detections) {
+  if (detections.empty()) {
+    if (output_zero_rect_for_empty_detections_) {
+      if (cc->Outputs().HasTag(kRectTag)) {
+        cc->Outputs().Tag(kRectTag).AddPacket(
+            MakePacket<Rect>().At(cc->InputTimestamp()));
+      }
+      if (cc->Outputs().HasTag(kNormRectTag)) {
+        cc->Outputs()
+            .Tag(kNormRectTag)
+            .AddPacket(MakePacket<NormalizedRect>().At(cc->InputTimestamp()));
+      }
+      if (cc->Outputs().HasTag(kNormRectsTag)) {
+        auto rect_vector = absl::make_unique<std::vector<NormalizedRect>>();
+        rect_vector->emplace_back(NormalizedRect());
+        cc->Outputs()
+            .Tag(kNormRectsTag)
+            .Add(rect_vector.release(), cc->InputTimestamp());
       }
-      return absl::OkStatus();
     }
+    return absl::OkStatus();
   }
 
   // Get dynamic calculator options (e.g. `image_size`).
@@ -326,6 +406,28 @@ absl::Status DetectionsToRectsCalculator::ComputeRotation(
   return absl::OkStatus();
 }
 
+absl::Status DetectionsToRectsCalculator::ComputeRotation(
+    const CompactDetection& detection, const DetectionSpec& detection_spec,
+    float* rotation) {
+  const auto& image_size = detection_spec.image_size;
+  RET_CHECK(image_size) << "Image size is required to calculate rotation";
+  RET_CHECK_LT(start_keypoint_index_, detection.num_keypoints);
+  RET_CHECK_LT(end_keypoint_index_, detection.num_keypoints);
+
+  const float x0 =
+      detection.keypoints[start_keypoint_index_].x * image_size->first;
+  const float y0 =
+      detection.keypoints[start_keypoint_index_].y * image_size->second;
+  const float x1 =
+      detection.keypoints[end_keypoint_index_].x * image_size->first;
+  const float y1 =
+      detection.keypoints[end_keypoint_index_].y * image_size->second;
+
+  *rotation = NormalizeRadians(target_angle_ - std::atan2(-(y1 - y0), x1 - x0));
+
+  return absl::OkStatus();
+}
+
 DetectionSpec DetectionsToRectsCalculator::GetDetectionSpec(
     const CalculatorContext* cc) {
   absl::optional<std::pair<int, int>> image_size;
@@ -15,11 +15,13 @@
 #define MEDIAPIPE_CALCULATORS_UTIL_DETECTIONS_TO_RECTS_CALCULATOR_H_
 
 #include <cmath>
+#include <vector>
 
 #include "absl/types/optional.h"
 #include "mediapipe/calculators/util/detections_to_rects_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_options.pb.h"
+#include "mediapipe/framework/formats/compact_detection.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
@@ -38,7 +40,9 @@ struct DetectionSpec {
 // A calculator that converts Detection proto to Rect proto.
 //
 // Detection is the format for encoding one or more detections in an image.
-// The input can be a single Detection or std::vector<Detection>. The output can
+// The input can be a single Detection or std::vector<Detection>, or their
+// CompactDetection counterparts, which have a relative bounding box and can
+// only be converted to Rect with keypoints. The output can
 // be either a single Rect or NormalizedRect, or std::vector<Rect> or
 // std::vector<NormalizedRect>. If Rect is used, the LocationData format is
 // expected to be BOUNDING_BOX, and if NormalizedRect is used it is expected to
@@ -52,8 +56,8 @@ struct DetectionSpec {
 // Inputs:
 //
 // One of the following:
-// DETECTION: A Detection proto.
-// DETECTIONS: An std::vector<Detection>.
+// DETECTION: A Detection proto or a CompactDetection.
+// DETECTIONS: An std::vector<Detection> or std::vector<CompactDetection>.
 //
 // IMAGE_SIZE (optional): A std::pair<int, int> represention image width and
 //   height. This is required only when rotation needs to be computed (see
@@ -100,6 +104,25 @@ class DetectionsToRectsCalculator : public CalculatorBase {
                                        float* rotation);
   virtual DetectionSpec GetDetectionSpec(const CalculatorContext* cc);
 
+  // The same conversions for a CompactDetection. Subclasses which override the
+  // Detection versions should override these too, if only to convert the
+  // detection with ToDetection.
+  virtual absl::Status DetectionToRect(const CompactDetection& detection,
+                                       const DetectionSpec& detection_spec,
+                                       ::mediapipe::Rect* rect);
+  virtual absl::Status DetectionToNormalizedRect(
+      const CompactDetection& detection, const DetectionSpec& detection_spec,
+      ::mediapipe::NormalizedRect* rect);
+  virtual absl::Status ComputeRotation(const CompactDetection& detection,
+                                       const DetectionSpec& detection_spec,
+                                       float* rotation);
+
+  // Outputs the rects of @detections, which are either Detection or
+  // CompactDetection.
+  template <typename DetectionT>
+  absl::Status ProcessDetections(CalculatorContext* cc,
+                                 const std::vector<DetectionT>& detections);
+
   static inline float NormalizeRadians(float angle) {
     return angle - 2 * M_PI * std::floor((angle - (-M_PI)) / (2 * M_PI));
   }
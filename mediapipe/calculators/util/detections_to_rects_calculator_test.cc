@@ -19,6 +19,7 @@
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/compact_detection.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
@@ -295,6 +296,38 @@ TEST(DetectionsToRectsCalculatorTest, DetectionsToNormalizedRect) {
   EXPECT_THAT(rect, NormRectEq(0.25f, 0.4f, 0.3f, 0.4f));
 }
 
+TEST(DetectionsToRectsCalculatorTest, CompactDetectionsToNormalizedRect) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+    calculator: "DetectionsToRectsCalculator"
+    input_stream: "DETECTIONS:detections"
+    output_stream: "NORM_RECT:rect"
+  )pb"));
+
+  auto detections(absl::make_unique<std::vector<CompactDetection>>());
+  for (const Detection& detection :
+       {DetectionWithRelativeLocationData(0.1, 0.2, 0.3, 0.4),
+        DetectionWithRelativeLocationData(0.2, 0.3, 0.4, 0.5)}) {
+    Detection labeled_detection = detection;
+    labeled_detection.add_label_id(0);
+    labeled_detection.add_score(1.0f);
+    MP_ASSERT_OK_AND_ASSIGN(CompactDetection compact_detection,
+                            ToCompactDetection(labeled_detection));
+    detections->push_back(compact_detection);
+  }
+
+  runner.MutableInputs()
+      ->Tag(kDetectionsTag)
+      .packets.push_back(
+          Adopt(detections.release()).At(Timestamp::PostStream()));
+
+  MP_ASSERT_OK(runner.Run()) << "Calculator execution failed.";
+  const std::vector<Packet>& output =
+      runner.Outputs().Tag(kNormRectTag).packets;
+  ASSERT_EQ(1, output.size());
+  const auto& rect = output[0].Get<NormalizedRect>();
+  EXPECT_THAT(rect, NormRectEq(0.25f, 0.4f, 0.3f, 0.4f));
+}
+
 TEST(DetectionsToRectsCalculatorTest, DetectionsToRects) {
   CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
     calculator: "DetectionsToRectsCalculator"
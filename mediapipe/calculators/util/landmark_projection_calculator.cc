@@ -18,6 +18,7 @@
 
 #include "mediapipe/calculators/util/landmark_projection_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_landmark.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -36,7 +37,7 @@ constexpr char kProjectionMatrix[] = "PROJECTION_MATRIX";
 
 // Projects normalized landmarks to its original coordinates.
 // Input:
-//   NORM_LANDMARKS - NormalizedLandmarkList
+//   NORM_LANDMARKS - NormalizedLandmarkList or CompactNormalizedLandmarkList
 //     Represents landmarks in a normalized rectangle if NORM_RECT is specified
 //     or landmarks that should be projected using PROJECTION_MATRIX if
 //     specified. (Prefer using PROJECTION_MATRIX as it eliminates need of
@@ -54,7 +55,8 @@ constexpr char kProjectionMatrix[] = "PROJECTION_MATRIX";
 //     the normalized region of interest used during landmarks detection.
 //
 // Output:
-//   NORM_LANDMARKS - NormalizedLandmarkList
+//   NORM_LANDMARKS - NormalizedLandmarkList or CompactNormalizedLandmarkList,
+//     the same type as the input.
 //     Landmarks with their locations adjusted according to the inputs.
 //
 // Usage example:
@@ -101,7 +103,9 @@ class LandmarkProjectionCalculator : public CalculatorBase {
 
     for (CollectionItemId id = cc->Inputs().BeginId(kLandmarksTag);
          id != cc->Inputs().EndId(kLandmarksTag); ++id) {
-      cc->Inputs().Get(id).Set<NormalizedLandmarkList>();
+      cc->Inputs()
+          .Get(id)
+          .SetOneOf<NormalizedLandmarkList, CompactNormalizedLandmarkList>();
     }
     RET_CHECK(cc->Inputs().HasTag(kRectTag) ^
               cc->Inputs().HasTag(kProjectionMatrix))
@@ -112,9 +116,10 @@ class LandmarkProjectionCalculator : public CalculatorBase {
       cc->Inputs().Tag(kProjectionMatrix).Set<std::array<float, 16>>();
     }
 
+    CollectionItemId input_id = cc->Inputs().BeginId(kLandmarksTag);
     for (CollectionItemId id = cc->Outputs().BeginId(kLandmarksTag);
-         id != cc->Outputs().EndId(kLandmarksTag); ++id) {
-      cc->Outputs().Get(id).Set<NormalizedLandmarkList>();
+         id != cc->Outputs().EndId(kLandmarksTag); ++id, ++input_id) {
+      cc->Outputs().Get(id).SetSameAs(&cc->Inputs().Get(input_id));
     }
 
     return absl::OkStatus();
@@ -126,13 +131,15 @@ class LandmarkProjectionCalculator : public CalculatorBase {
     return absl::OkStatus();
   }
 
-  static void ProjectXY(const NormalizedLandmark& lm,
+  static void ProjectXY(const CompactLandmark& lm,
                         const std::array<float, 16>& matrix,
-                        NormalizedLandmark* out) {
-    out->set_x(lm.x() * matrix[0] + lm.y() * matrix[1] + lm.z() * matrix[2] +
-               matrix[3]);
-    out->set_y(lm.x() * matrix[4] + lm.y() * matrix[5] + lm.z() * matrix[6] +
-               matrix[7]);
+                        CompactLandmark* out) {
+    const float x = lm.x * matrix[0] + lm.y * matrix[1] + lm.z * matrix[2] +
+                    matrix[3];
+    const float y = lm.x * matrix[4] + lm.y * matrix[5] + lm.z * matrix[6] +
+                    matrix[7];
+    out->x = x;
+    out->y = y;
   }
 
   /**
@@ -142,23 +149,23 @@ class LandmarkProjectionCalculator : public CalculatorBase {
    * 2. Calculate length of the projected segment.
    */
   static float CalculateZScale(const std::array<float, 16>& matrix) {
-    NormalizedLandmark a;
-    a.set_x(0.0f);
-    a.set_y(0.0f);
-    NormalizedLandmark b;
-    b.set_x(1.0f);
-    b.set_y(0.0f);
-    NormalizedLandmark a_projected;
+    CompactLandmark a;
+    a.x = 0.0f;
+    a.y = 0.0f;
+    CompactLandmark b;
+    b.x = 1.0f;
+    b.y = 0.0f;
+    CompactLandmark a_projected;
     ProjectXY(a, matrix, &a_projected);
-    NormalizedLandmark b_projected;
+    CompactLandmark b_projected;
     ProjectXY(b, matrix, &b_projected);
-    return std::sqrt(std::pow(b_projected.x() - a_projected.x(), 2) +
-                     std::pow(b_projected.y() - a_projected.y(), 2));
+    return std::sqrt(std::pow(b_projected.x - a_projected.x, 2) +
+                     std::pow(b_projected.y - a_projected.y, 2));
   }
 
   absl::Status Process(CalculatorContext* cc) override {
-    std::function<void(const NormalizedLandmark&, NormalizedLandmark*)>
-        project_fn;
+    // Projects a landmark in place.
+    std::function<void(CompactLandmark*)> project_fn;
     if (cc->Inputs().HasTag(kRectTag)) {
       if (cc->Inputs().Tag(kRectTag).IsEmpty()) {
         return absl::OkStatus();
@@ -166,12 +173,11 @@ class LandmarkProjectionCalculator : public CalculatorBase {
       const auto& input_rect = cc->Inputs().Tag(kRectTag).Get<NormalizedRect>();
       const auto& options =
           cc->Options<mediapipe::LandmarkProjectionCalculatorOptions>();
-      project_fn = [&input_rect, &options](const NormalizedLandmark& landmark,
-                                           NormalizedLandmark* new_landmark) {
+      project_fn = [&input_rect, &options](CompactLandmark* landmark) {
         // TODO: fix projection or deprecate (current projection
         // calculations are incorrect for general case).
-        const float x = landmark.x() - 0.5f;
-        const float y = landmark.y() - 0.5f;
+        const float x = landmark->x - 0.5f;
+        const float y = landmark->y - 0.5f;
         const float angle =
             options.ignore_rotation() ? 0 : input_rect.rotation();
         float new_x = std::cos(angle) * x - std::sin(angle) * y;
@@ -180,12 +186,11 @@ class LandmarkProjectionCalculator : public CalculatorBase {
         new_x = new_x * input_rect.width() + input_rect.x_center();
         new_y = new_y * input_rect.height() + input_rect.y_center();
         const float new_z =
-            landmark.z() * input_rect.width();  // Scale Z coordinate as X.
+            landmark->z * input_rect.width();  // Scale Z coordinate as X.
 
-        *new_landmark = landmark;
-        new_landmark->set_x(new_x);
-        new_landmark->set_y(new_y);
-        new_landmark->set_z(new_z);
+        landmark->x = new_x;
+        landmark->y = new_y;
+        landmark->z = new_z;
       };
     } else if (cc->Inputs().HasTag(kProjectionMatrix)) {
       if (cc->Inputs().Tag(kProjectionMatrix).IsEmpty()) {
@@ -194,11 +199,9 @@ class LandmarkProjectionCalculator : public CalculatorBase {
       const auto& project_mat =
           cc->Inputs().Tag(kProjectionMatrix).Get<std::array<float, 16>>();
       const float z_scale = CalculateZScale(project_mat);
-      project_fn = [&project_mat, z_scale](const NormalizedLandmark& lm,
-                                           NormalizedLandmark* new_landmark) {
-        *new_landmark = lm;
-        ProjectXY(lm, project_mat, new_landmark);
-        new_landmark->set_z(z_scale * lm.z());
+      project_fn = [&project_mat, z_scale](CompactLandmark* landmark) {
+        ProjectXY(*landmark, project_mat, landmark);
+        landmark->z = z_scale * landmark->z;
       };
     } else {
       return absl::InternalError("Either rect or matrix must be specified.");
@@ -214,12 +217,34 @@ class LandmarkProjectionCalculator : public CalculatorBase {
         continue;
       }
 
+      // Compact landmarks are projected in a copy of the list, while protos
+      // are projected one landmark at a time.
+      if (input_packet.ValidateAsType<CompactNormalizedLandmarkList>().ok()) {
+        CompactNormalizedLandmarkList output_landmarks =
+            input_packet.Get<CompactNormalizedLandmarkList>();
+        for (CompactLandmark& landmark : output_landmarks.landmark) {
+          project_fn(&landmark);
+        }
+        cc->Outputs().Get(output_id).AddPacket(
+            MakePacket<CompactNormalizedLandmarkList>(
+                std::move(output_landmarks))
+                .At(cc->InputTimestamp()));
+        continue;
+      }
+
       const auto& input_landmarks = input_packet.Get<NormalizedLandmarkList>();
       NormalizedLandmarkList output_landmarks;
+      output_landmarks.mutable_landmark()->Reserve(
+          input_landmarks.landmark_size());
       for (int i = 0; i < input_landmarks.landmark_size(); ++i) {
         const NormalizedLandmark& landmark = input_landmarks.landmark(i);
         NormalizedLandmark* new_landmark = output_landmarks.add_landmark();
-        project_fn(landmark, new_landmark);
+        CompactLandmark compact_landmark = ToCompactLandmark(landmark);
+        project_fn(&compact_landmark);
+        *new_landmark = landmark;
+        new_landmark->set_x(compact_landmark.x);
+        new_landmark->set_y(compact_landmark.y);
+        new_landmark->set_z(compact_landmark.z);
       }
 
       cc->Outputs().Get(output_id).AddPacket(
@@ -6,6 +6,7 @@
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/compact_landmark.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/port/gmock.h"
@@ -240,5 +241,53 @@ TEST(LandmarkProjectionCalculatorTest, ProjectingWithRotationMatrix) {
       )pb")));
 }
 
+absl::StatusOr<mediapipe::NormalizedLandmarkList> RunCalculatorOnCompact(
+    const mediapipe::NormalizedLandmarkList& input,
+    mediapipe::NormalizedRect rect) {
+  mediapipe::CalculatorRunner runner(
+      ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig::Node>(R"pb(
+        calculator: "LandmarkProjectionCalculator"
+        input_stream: "NORM_LANDMARKS:landmarks"
+        input_stream: "NORM_RECT:rect"
+        output_stream: "NORM_LANDMARKS:projected_landmarks"
+      )pb"));
+  runner.MutableInputs()
+      ->Tag(kNormLandmarksTag)
+      .packets.push_back(MakePacket<mediapipe::CompactNormalizedLandmarkList>(
+                             ToCompactNormalizedLandmarkList(input))
+                             .At(Timestamp(1)));
+  runner.MutableInputs()
+      ->Tag(kNormRectTag)
+      .packets.push_back(MakePacket<mediapipe::NormalizedRect>(std::move(rect))
+                             .At(Timestamp(1)));
+
+  MP_RETURN_IF_ERROR(runner.Run());
+  const auto& output_packets = runner.Outputs().Tag(kNormLandmarksTag).packets;
+  RET_CHECK_EQ(output_packets.size(), 1);
+  return ToNormalizedLandmarkList(
+      output_packets[0].Get<mediapipe::CompactNormalizedLandmarkList>());
+}
+
+TEST(LandmarkProjectionCalculatorTest, CompactLandmarksMatchProtos) {
+  mediapipe::NormalizedLandmarkList landmarks =
+      ParseTextProtoOrDie<mediapipe::NormalizedLandmarkList>(R"pb(
+        landmark { x: 0.2, y: 0.4, z: -0.5, visibility: 0.8 }
+        landmark { x: 1.0, y: 1.0, z: 0.25, presence: 0.6 }
+      )pb");
+  mediapipe::NormalizedRect rect =
+      ParseTextProtoOrDie<mediapipe::NormalizedRect>(
+          R"pb(
+            x_center: 0.4, y_center: 0.6, width: 0.5, height: 0.8, rotation: 0.3
+          )pb");
+
+  auto status_or_result = RunCalculator(landmarks, rect);
+  MP_ASSERT_OK(status_or_result);
+  auto status_or_compact_result = RunCalculatorOnCompact(landmarks, rect);
+  MP_ASSERT_OK(status_or_compact_result);
+
+  EXPECT_THAT(status_or_compact_result.value(),
+              EqualsProto(status_or_result.value()));
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -13,10 +13,12 @@
 // limitations under the License.
 
 #include <memory>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "mediapipe/calculators/util/landmarks_smoothing_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_landmark.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -40,37 +42,32 @@ using mediapipe::OneEuroFilter;
 using ::mediapipe::Rect;
 using mediapipe::RelativeVelocityFilter;
 
-void NormalizedLandmarksToLandmarks(
-    const NormalizedLandmarkList& norm_landmarks, const int image_width,
-    const int image_height, LandmarkList* landmarks) {
-  for (int i = 0; i < norm_landmarks.landmark_size(); ++i) {
-    const auto& norm_landmark = norm_landmarks.landmark(i);
-
-    auto* landmark = landmarks->add_landmark();
-    landmark->set_x(norm_landmark.x() * image_width);
-    landmark->set_y(norm_landmark.y() * image_height);
-    // Scale Z the same way as X (using image width).
-    landmark->set_z(norm_landmark.z() * image_width);
-    landmark->set_visibility(norm_landmark.visibility());
-    landmark->set_presence(norm_landmark.presence());
-  }
+// Scales a normalized landmark to image coordinates. Visibility and presence
+// are always set, and so are those of the output landmarks.
+CompactLandmark NormalizedLandmarkToLandmark(
+    const CompactLandmark& norm_landmark, const int image_width,
+    const int image_height) {
+  CompactLandmark landmark;
+  landmark.x = norm_landmark.x * image_width;
+  landmark.y = norm_landmark.y * image_height;
+  // Scale Z the same way as X (using image width).
+  landmark.z = norm_landmark.z * image_width;
+  landmark.visibility = norm_landmark.visibility;
+  landmark.presence = norm_landmark.presence;
+  landmark.has_visibility = true;
+  landmark.has_presence = true;
+  return landmark;
 }
 
-void LandmarksToNormalizedLandmarks(const LandmarkList& landmarks,
-                                    const int image_width,
-                                    const int image_height,
-                                    NormalizedLandmarkList* norm_landmarks) {
-  for (int i = 0; i < landmarks.landmark_size(); ++i) {
-    const auto& landmark = landmarks.landmark(i);
-
-    auto* norm_landmark = norm_landmarks->add_landmark();
-    norm_landmark->set_x(landmark.x() / image_width);
-    norm_landmark->set_y(landmark.y() / image_height);
-    // Scale Z the same way as X (using image width).
-    norm_landmark->set_z(landmark.z() / image_width);
-    norm_landmark->set_visibility(landmark.visibility());
-    norm_landmark->set_presence(landmark.presence());
-  }
+CompactLandmark LandmarkToNormalizedLandmark(const CompactLandmark& landmark,
+                                             const int image_width,
+                                             const int image_height) {
+  CompactLandmark norm_landmark = landmark;
+  norm_landmark.x = landmark.x / image_width;
+  norm_landmark.y = landmark.y / image_height;
+  // Scale Z the same way as X (using image width).
+  norm_landmark.z = landmark.z / image_width;
+  return norm_landmark;
 }
 
 // Estimate object scale to use its inverse value as velocity scale for
@@ -79,18 +76,16 @@ void LandmarksToNormalizedLandmarks(const LandmarkList& landmarks,
 // landmarks will be returned as is.
 // Object scale is calculated as average between bounding box width and height
 // with sides parallel to axis.
-float GetObjectScale(const LandmarkList& landmarks) {
+float GetObjectScale(const std::vector<CompactLandmark>& landmarks) {
   const auto& lm_minmax_x = absl::c_minmax_element(
-      landmarks.landmark(),
-      [](const auto& a, const auto& b) { return a.x() < b.x(); });
-  const float x_min = lm_minmax_x.first->x();
-  const float x_max = lm_minmax_x.second->x();
+      landmarks, [](const auto& a, const auto& b) { return a.x < b.x; });
+  const float x_min = lm_minmax_x.first->x;
+  const float x_max = lm_minmax_x.second->x;
 
   const auto& lm_minmax_y = absl::c_minmax_element(
-      landmarks.landmark(),
-      [](const auto& a, const auto& b) { return a.y() < b.y(); });
-  const float y_min = lm_minmax_y.first->y();
-  const float y_max = lm_minmax_y.second->y();
+      landmarks, [](const auto& a, const auto& b) { return a.y < b.y; });
+  const float y_min = lm_minmax_y.first->y;
+  const float y_max = lm_minmax_y.second->y;
 
   const float object_width = x_max - x_min;
   const float object_height = y_max - y_min;
@@ -117,19 +112,20 @@ class LandmarksFilter {
 
   virtual absl::Status Reset() { return absl::OkStatus(); }
 
-  virtual absl::Status Apply(const LandmarkList& in_landmarks,
+  // Filters landmarks in image coordinates.
+  virtual absl::Status Apply(const std::vector<CompactLandmark>& in_landmarks,
                              const absl::Duration& timestamp,
                              const absl::optional<float> object_scale_opt,
-                             LandmarkList* out_landmarks) = 0;
+                             std::vector<CompactLandmark>* out_landmarks) = 0;
 };
 
 // Returns landmarks as is without smoothing.
 class NoFilter : public LandmarksFilter {
  public:
-  absl::Status Apply(const LandmarkList& in_landmarks,
+  absl::Status Apply(const std::vector<CompactLandmark>& in_landmarks,
                      const absl::Duration& timestamp,
                      const absl::optional<float> object_scale_opt,
-                     LandmarkList* out_landmarks) override {
+                     std::vector<CompactLandmark>* out_landmarks) override {
     *out_landmarks = in_landmarks;
     return absl::OkStatus();
   }
@@ -152,10 +148,10 @@ class VelocityFilter : public LandmarksFilter {
     return absl::OkStatus();
   }
 
-  absl::Status Apply(const LandmarkList& in_landmarks,
+  absl::Status Apply(const std::vector<CompactLandmark>& in_landmarks,
                      const absl::Duration& timestamp,
                      const absl::optional<float> object_scale_opt,
-                     LandmarkList* out_landmarks) override {
+                     std::vector<CompactLandmark>* out_landmarks) override {
     // Get value scale as inverse value of the object scale.
     // If value is too small smoothing will be disabled and landmarks will be
     // returned as is.
@@ -171,20 +167,20 @@ class VelocityFilter : public LandmarksFilter {
     }
 
     // Initialize filters once.
-    MP_RETURN_IF_ERROR(InitializeFiltersIfEmpty(in_landmarks.landmark_size()));
+    MP_RETURN_IF_ERROR(InitializeFiltersIfEmpty(in_landmarks.size()));
 
     // Filter landmarks. Every axis of every landmark is filtered separately.
-    for (int i = 0; i < in_landmarks.landmark_size(); ++i) {
-      const auto& in_landmark = in_landmarks.landmark(i);
-
-      auto* out_landmark = out_landmarks->add_landmark();
-      *out_landmark = in_landmark;
-      out_landmark->set_x(
-          x_filters_[i].Apply(timestamp, value_scale, in_landmark.x()));
-      out_landmark->set_y(
-          y_filters_[i].Apply(timestamp, value_scale, in_landmark.y()));
-      out_landmark->set_z(
-          z_filters_[i].Apply(timestamp, value_scale, in_landmark.z()));
+    for (int i = 0; i < in_landmarks.size(); ++i) {
+      const auto& in_landmark = in_landmarks[i];
+
+      CompactLandmark out_landmark = in_landmark;
+      out_landmark.x =
+          x_filters_[i].Apply(timestamp, value_scale, in_landmark.x);
+      out_landmark.y =
+          y_filters_[i].Apply(timestamp, value_scale, in_landmark.y);
+      out_landmark.z =
+          z_filters_[i].Apply(timestamp, value_scale, in_landmark.z);
+      out_landmarks->push_back(out_landmark);
     }
 
     return absl::OkStatus();
@@ -241,12 +237,12 @@ class OneEuroFilterImpl : public LandmarksFilter {
     return absl::OkStatus();
   }
 
-  absl::Status Apply(const LandmarkList& in_landmarks,
+  absl::Status Apply(const std::vector<CompactLandmark>& in_landmarks,
                      const absl::Duration& timestamp,
                      const absl::optional<float> object_scale_opt,
-                     LandmarkList* out_landmarks) override {
+                     std::vector<CompactLandmark>* out_landmarks) override {
     // Initialize filters once.
-    MP_RETURN_IF_ERROR(InitializeFiltersIfEmpty(in_landmarks.landmark_size()));
+    MP_RETURN_IF_ERROR(InitializeFiltersIfEmpty(in_landmarks.size()));
 
     // Get value scale as inverse value of the object scale.
     // If value is too small smoothing will be disabled and landmarks will be
@@ -263,17 +259,17 @@ class OneEuroFilterImpl : public LandmarksFilter {
     }
 
     // Filter landmarks. Every axis of every landmark is filtered separately.
-    for (int i = 0; i < in_landmarks.landmark_size(); ++i) {
-      const auto& in_landmark = in_landmarks.landmark(i);
-
-      auto* out_landmark = out_landmarks->add_landmark();
-      *out_landmark = in_landmark;
-      out_landmark->set_x(
-          x_filters_[i].Apply(timestamp, value_scale, in_landmark.x()));
-      out_landmark->set_y(
-          y_filters_[i].Apply(timestamp, value_scale, in_landmark.y()));
-      out_landmark->set_z(
-          z_filters_[i].Apply(timestamp, value_scale, in_landmark.z()));
+    for (int i = 0; i < in_landmarks.size(); ++i) {
+      const auto& in_landmark = in_landmarks[i];
+
+      CompactLandmark out_landmark = in_landmark;
+      out_landmark.x =
+          x_filters_[i].Apply(timestamp, value_scale, in_landmark.x);
+      out_landmark.y =
+          y_filters_[i].Apply(timestamp, value_scale, in_landmark.y);
+      out_landmark.z =
+          z_filters_[i].Apply(timestamp, value_scale, in_landmark.z);
+      out_landmarks->push_back(out_landmark);
     }
 
     return absl::OkStatus();
@@ -319,7 +315,8 @@ class OneEuroFilterImpl : public LandmarksFilter {
 // A calculator to smooth landmarks over time.
 //
 // Inputs:
-//   NORM_LANDMARKS: A NormalizedLandmarkList of landmarks you want to smooth.
+//   NORM_LANDMARKS: A NormalizedLandmarkList or CompactNormalizedLandmarkList
+//     of landmarks you want to smooth.
 //   IMAGE_SIZE: A std::pair<int, int> represention of image width and height.
 //     Required to perform all computations in absolute coordinates to avoid any
 //     influence of normalized values.
@@ -329,7 +326,8 @@ class OneEuroFilterImpl : public LandmarksFilter {
 //     landmarks.
 //
 // Outputs:
-//   NORM_FILTERED_LANDMARKS: A NormalizedLandmarkList of smoothed landmarks.
+//   NORM_FILTERED_LANDMARKS: The smoothed landmarks, of the same type as
+//     NORM_LANDMARKS.
 //
 // Example config:
 //   node {
@@ -361,11 +359,13 @@ REGISTER_CALCULATOR(LandmarksSmoothingCalculator);
 
 absl::Status LandmarksSmoothingCalculator::GetContract(CalculatorContract* cc) {
   if (cc->Inputs().HasTag(kNormalizedLandmarksTag)) {
-    cc->Inputs().Tag(kNormalizedLandmarksTag).Set<NormalizedLandmarkList>();
+    cc->Inputs()
+        .Tag(kNormalizedLandmarksTag)
+        .SetOneOf<NormalizedLandmarkList, CompactNormalizedLandmarkList>();
     cc->Inputs().Tag(kImageSizeTag).Set<std::pair<int, int>>();
     cc->Outputs()
         .Tag(kNormalizedFilteredLandmarksTag)
-        .Set<NormalizedLandmarkList>();
+        .SetSameAs(&cc->Inputs().Tag(kNormalizedLandmarksTag));
 
     if (cc->Inputs().HasTag(kObjectScaleRoiTag)) {
       cc->Inputs().Tag(kObjectScaleRoiTag).Set<NormalizedRect>();
@@ -426,8 +426,12 @@ absl::Status LandmarksSmoothingCalculator::Process(CalculatorContext* cc) {
       absl::Microseconds(cc->InputTimestamp().Microseconds());
 
   if (cc->Inputs().HasTag(kNormalizedLandmarksTag)) {
-    const auto& in_norm_landmarks =
-        cc->Inputs().Tag(kNormalizedLandmarksTag).Get<NormalizedLandmarkList>();
+    const auto& in_norm_landmarks_packet =
+        cc->Inputs().Tag(kNormalizedLandmarksTag).Value();
+    const bool is_compact =
+        in_norm_landmarks_packet
+            .ValidateAsType<CompactNormalizedLandmarkList>()
+            .ok();
 
     int image_width;
     int image_height;
@@ -441,23 +445,55 @@ absl::Status LandmarksSmoothingCalculator::Process(CalculatorContext* cc) {
       object_scale = GetObjectScale(roi, image_width, image_height);
     }
 
-    auto in_landmarks = absl::make_unique<LandmarkList>();
-    NormalizedLandmarksToLandmarks(in_norm_landmarks, image_width, image_height,
-                                   in_landmarks.get());
+    std::vector<CompactLandmark> in_landmarks;
+    if (is_compact) {
+      const auto& in_norm_landmarks =
+          in_norm_landmarks_packet.Get<CompactNormalizedLandmarkList>();
+      in_landmarks.reserve(in_norm_landmarks.landmark.size());
+      for (const auto& norm_landmark : in_norm_landmarks.landmark) {
+        in_landmarks.push_back(
+            NormalizedLandmarkToLandmark(norm_landmark, image_width,
+                                         image_height));
+      }
+    } else {
+      const auto& in_norm_landmarks =
+          in_norm_landmarks_packet.Get<NormalizedLandmarkList>();
+      in_landmarks.reserve(in_norm_landmarks.landmark_size());
+      for (const auto& norm_landmark : in_norm_landmarks.landmark()) {
+        in_landmarks.push_back(NormalizedLandmarkToLandmark(
+            ToCompactLandmark(norm_landmark), image_width, image_height));
+      }
+    }
 
-    auto out_landmarks = absl::make_unique<LandmarkList>();
+    std::vector<CompactLandmark> out_landmarks;
+    out_landmarks.reserve(in_landmarks.size());
     MP_RETURN_IF_ERROR(landmarks_filter_->Apply(
-        *in_landmarks, timestamp, object_scale, out_landmarks.get()));
-
-    auto out_norm_landmarks = absl::make_unique<NormalizedLandmarkList>();
-    LandmarksToNormalizedLandmarks(*out_landmarks, image_width, image_height,
-                                   out_norm_landmarks.get());
-
-    cc->Outputs()
-        .Tag(kNormalizedFilteredLandmarksTag)
-        .Add(out_norm_landmarks.release(), cc->InputTimestamp());
+        in_landmarks, timestamp, object_scale, &out_landmarks));
+
+    if (is_compact) {
+      auto out_norm_landmarks =
+          absl::make_unique<CompactNormalizedLandmarkList>();
+      out_norm_landmarks->landmark.reserve(out_landmarks.size());
+      for (const auto& landmark : out_landmarks) {
+        out_norm_landmarks->landmark.push_back(
+            LandmarkToNormalizedLandmark(landmark, image_width, image_height));
+      }
+      cc->Outputs()
+          .Tag(kNormalizedFilteredLandmarksTag)
+          .Add(out_norm_landmarks.release(), cc->InputTimestamp());
+    } else {
+      auto out_norm_landmarks = absl::make_unique<NormalizedLandmarkList>();
+      for (const auto& landmark : out_landmarks) {
+        ToLandmarkProto(
+            LandmarkToNormalizedLandmark(landmark, image_width, image_height),
+            out_norm_landmarks->add_landmark());
+      }
+      cc->Outputs()
+          .Tag(kNormalizedFilteredLandmarksTag)
+          .Add(out_norm_landmarks.release(), cc->InputTimestamp());
+    }
   } else {
-    const auto& in_landmarks =
+    const auto& in_landmark_list =
         cc->Inputs().Tag(kLandmarksTag).Get<LandmarkList>();
 
     absl::optional<float> object_scale;
@@ -467,13 +503,24 @@ absl::Status LandmarksSmoothingCalculator::Process(CalculatorContext* cc) {
       object_scale = GetObjectScale(roi);
     }
 
-    auto out_landmarks = absl::make_unique<LandmarkList>();
+    std::vector<CompactLandmark> in_landmarks;
+    in_landmarks.reserve(in_landmark_list.landmark_size());
+    for (const auto& landmark : in_landmark_list.landmark()) {
+      in_landmarks.push_back(ToCompactLandmark(landmark));
+    }
+
+    std::vector<CompactLandmark> out_landmarks;
+    out_landmarks.reserve(in_landmarks.size());
     MP_RETURN_IF_ERROR(landmarks_filter_->Apply(
-        in_landmarks, timestamp, object_scale, out_landmarks.get()));
+        in_landmarks, timestamp, object_scale, &out_landmarks));
 
+    auto out_landmark_list = absl::make_unique<LandmarkList>();
+    for (const auto& landmark : out_landmarks) {
+      ToLandmarkProto(landmark, out_landmark_list->add_landmark());
+    }
     cc->Outputs()
         .Tag(kFilteredLandmarksTag)
-        .Add(out_landmarks.release(), cc->InputTimestamp());
+        .Add(out_landmark_list.release(), cc->InputTimestamp());
   }
 
   return absl::OkStatus();
@@ -0,0 +1,119 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_replace.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/compact_landmark.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr char kNormLandmarksTag[] = "NORM_LANDMARKS";
+constexpr char kImageSizeTag[] = "IMAGE_SIZE";
+constexpr char kNormFilteredLandmarksTag[] = "NORM_FILTERED_LANDMARKS";
+
+constexpr int kNumFrames = 5;
+
+constexpr char kNodeConfig[] = R"pb(
+  calculator: "LandmarksSmoothingCalculator"
+  input_stream: "NORM_LANDMARKS:landmarks"
+  input_stream: "IMAGE_SIZE:image_size"
+  output_stream: "NORM_FILTERED_LANDMARKS:filtered_landmarks"
+  options {
+    [mediapipe.LandmarksSmoothingCalculatorOptions.ext] { $filter }
+  }
+)pb";
+
+// Returns two landmarks moving across the image over the frames.
+NormalizedLandmarkList GetLandmarks(int frame) {
+  NormalizedLandmarkList landmarks;
+  for (int i = 0; i < 2; ++i) {
+    NormalizedLandmark* landmark = landmarks.add_landmark();
+    landmark->set_x(0.1f * i + 0.05f * frame);
+    landmark->set_y(0.5f - 0.03f * frame * frame);
+    landmark->set_z(-0.1f * i);
+    landmark->set_visibility(0.9f);
+  }
+  return landmarks;
+}
+
+// Runs the calculator with @filter on kNumFrames frames of GetLandmarks, of
+// type LandmarksT, and returns the filtered landmarks of every frame.
+template <typename LandmarksT>
+std::vector<Packet> RunCalculator(const std::string& filter) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(
+      absl::StrReplaceAll(kNodeConfig, {{"$filter", filter}})));
+  for (int frame = 0; frame < kNumFrames; ++frame) {
+    const Timestamp timestamp(frame * 33333);
+    NormalizedLandmarkList landmarks = GetLandmarks(frame);
+    if constexpr (std::is_same_v<LandmarksT, NormalizedLandmarkList>) {
+      runner.MutableInputs()
+          ->Tag(kNormLandmarksTag)
+          .packets.push_back(
+              MakePacket<NormalizedLandmarkList>(landmarks).At(timestamp));
+    } else {
+      runner.MutableInputs()
+          ->Tag(kNormLandmarksTag)
+          .packets.push_back(MakePacket<CompactNormalizedLandmarkList>(
+                                 ToCompactNormalizedLandmarkList(landmarks))
+                                 .At(timestamp));
+    }
+    runner.MutableInputs()
+        ->Tag(kImageSizeTag)
+        .packets.push_back(
+            MakePacket<std::pair<int, int>>(640, 480).At(timestamp));
+  }
+  MP_EXPECT_OK(runner.Run());
+  return runner.Outputs().Tag(kNormFilteredLandmarksTag).packets;
+}
+
+class LandmarksSmoothingCalculatorTest
+    : public ::testing::TestWithParam<std::string> {};
+
+TEST_P(LandmarksSmoothingCalculatorTest, CompactLandmarksMatchProtos) {
+  const std::vector<Packet> packets =
+      RunCalculator<NormalizedLandmarkList>(GetParam());
+  const std::vector<Packet> compact_packets =
+      RunCalculator<CompactNormalizedLandmarkList>(GetParam());
+
+  ASSERT_EQ(packets.size(), kNumFrames);
+  ASSERT_EQ(compact_packets.size(), kNumFrames);
+  for (int frame = 0; frame < kNumFrames; ++frame) {
+    EXPECT_EQ(compact_packets[frame].Timestamp(), packets[frame].Timestamp());
+    const auto& compact_landmarks =
+        compact_packets[frame].Get<CompactNormalizedLandmarkList>();
+    EXPECT_THAT(ToNormalizedLandmarkList(compact_landmarks),
+                EqualsProto(packets[frame].Get<NormalizedLandmarkList>()));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Filters, LandmarksSmoothingCalculatorTest,
+    ::testing::Values("no_filter {}",
+                      "velocity_filter { window_size: 3 velocity_scale: 10 }",
+                      "one_euro_filter { min_cutoff: 0.1 beta: 1.0 }"));
+
+}  // namespace
+}  // namespace mediapipe
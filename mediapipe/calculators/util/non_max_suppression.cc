@@ -0,0 +1,351 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/util/non_max_suppression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace mediapipe {
+
+namespace {
+
+// The maximum number of grid cells along each axis.
+constexpr int kMaxCellsPerAxis = 64;
+// Boxes which cover more cells are kept in a separate list.
+constexpr int kMaxCellsPerBox = 16;
+
+bool IsEmpty(const NmsBoxes& boxes, int i) {
+  return boxes.xmin[i] > boxes.xmax[i] || boxes.ymin[i] > boxes.ymax[i];
+}
+
+bool IsFinite(const NmsBoxes& boxes, int i) {
+  return std::isfinite(boxes.xmin[i]) && std::isfinite(boxes.ymin[i]) &&
+         std::isfinite(boxes.xmax[i]) && std::isfinite(boxes.ymax[i]);
+}
+
+// Orders boxes by decreasing score, and by index for equal scores.
+struct ByDecreasingScore {
+  bool operator()(int a, int b) const {
+    return (*scores)[a] > (*scores)[b] ||
+           ((*scores)[a] == (*scores)[b] && a < b);
+  }
+  const std::vector<float>* scores;
+};
+
+// Returns the boxes which are not dropped for their score.
+std::vector<int> GetCandidates(const std::vector<float>& scores,
+                               const NmsOptions& options) {
+  std::vector<int> candidates;
+  candidates.reserve(scores.size());
+  for (int i = 0; i < scores.size(); ++i) {
+    if (options.min_score > 0 && scores[i] < options.min_score) {
+      continue;
+    }
+    candidates.push_back(i);
+  }
+  return candidates;
+}
+
+// A uniform grid which finds the inserted boxes that may overlap a box,
+// without testing all of them. Its cells are about the mean size of the boxes,
+// so that most boxes cover a few cells.
+//
+// With a non-negative suppression threshold, only boxes whose intersection
+// has a positive area can suppress each other, and such boxes share a cell.
+// Otherwise, the grid has a single cell.
+class BoxGrid {
+ public:
+  BoxGrid(const NmsBoxes& boxes, const std::vector<int>& candidates,
+          bool is_enabled)
+      : boxes_(boxes), is_enabled_(is_enabled) {
+    if (!is_enabled_) {
+      return;
+    }
+    float min_x = 0.0f, min_y = 0.0f, max_x = 0.0f, max_y = 0.0f;
+    double sum_width = 0.0, sum_height = 0.0;
+    int num_boxes = 0;
+    for (int i : candidates) {
+      if (IsEmpty(boxes, i) || !IsFinite(boxes, i)) {
+        continue;
+      }
+      if (num_boxes == 0) {
+        min_x = boxes.xmin[i];
+        min_y = boxes.ymin[i];
+        max_x = boxes.xmax[i];
+        max_y = boxes.ymax[i];
+      } else {
+        min_x = std::min(min_x, boxes.xmin[i]);
+        min_y = std::min(min_y, boxes.ymin[i]);
+        max_x = std::max(max_x, boxes.xmax[i]);
+        max_y = std::max(max_y, boxes.ymax[i]);
+      }
+      sum_width += boxes.xmax[i] - boxes.xmin[i];
+      sum_height += boxes.ymax[i] - boxes.ymin[i];
+      ++num_boxes;
+    }
+    if (num_boxes == 0) {
+      return;
+    }
+    origin_x_ = min_x;
+    origin_y_ = min_y;
+    SetAxis(max_x - min_x, sum_width / num_boxes, &num_cols_, &inv_cell_width_);
+    SetAxis(max_y - min_y, sum_height / num_boxes, &num_rows_,
+            &inv_cell_height_);
+    cells_.resize(num_cols_ * num_rows_);
+  }
+
+  void Insert(int i) {
+    inserted_.push_back(i);
+    int col0, col1, row0, row1;
+    if (!GetCells(i, &col0, &col1, &row0, &row1)) {
+      if (!is_enabled_ || !IsEmpty(boxes_, i)) {
+        // An empty box never overlaps another box, but the others (with NaN
+        // coordinates, or when the grid is disabled) have to be tested.
+        large_boxes_.push_back(i);
+      }
+      return;
+    }
+    for (int row = row0; row <= row1; ++row) {
+      for (int col = col0; col <= col1; ++col) {
+        cells_[row * num_cols_ + col].push_back(i);
+      }
+    }
+  }
+
+  // Calls @fn for the inserted boxes which may overlap box @i, until it
+  // returns true, and returns whether it did. @fn may be called more than once
+  // for a box that covers several cells.
+  template <typename Fn>
+  bool ForEachNeighbor(int i, const Fn& fn) const {
+    int col0, col1, row0, row1;
+    if (!GetCells(i, &col0, &col1, &row0, &row1)) {
+      if (is_enabled_ && IsEmpty(boxes_, i)) {
+        return false;
+      }
+      for (int j : inserted_) {
+        if (fn(j)) return true;
+      }
+      return false;
+    }
+    for (int j : large_boxes_) {
+      if (fn(j)) return true;
+    }
+    for (int row = row0; row <= row1; ++row) {
+      for (int col = col0; col <= col1; ++col) {
+        for (int j : cells_[row * num_cols_ + col]) {
+          if (fn(j)) return true;
+        }
+      }
+    }
+    return false;
+  }
+
+ private:
+  static void SetAxis(float extent, double mean_size, int* num_cells,
+                      float* inv_cell_size) {
+    const float cell_size =
+        std::max(static_cast<float>(mean_size), extent / kMaxCellsPerAxis);
+    if (cell_size > 0.0f) {
+      *num_cells = std::min(
+          kMaxCellsPerAxis,
+          std::max(1, static_cast<int>(std::ceil(extent / cell_size))));
+      *inv_cell_size = 1.0f / cell_size;
+    } else {
+      *num_cells = 1;
+      *inv_cell_size = 0.0f;
+    }
+  }
+
+  static int GetCell(float value, float origin, float inv_cell_size,
+                     int num_cells) {
+    const float cell = (value - origin) * inv_cell_size;
+    return static_cast<int>(
+        std::min(std::max(cell, 0.0f), static_cast<float>(num_cells - 1)));
+  }
+
+  // Returns false if box @i is not stored in the cells.
+  bool GetCells(int i, int* col0, int* col1, int* row0, int* row1) const {
+    if (!is_enabled_ || cells_.empty() || IsEmpty(boxes_, i) ||
+        !IsFinite(boxes_, i)) {
+      return false;
+    }
+    *col0 = GetCell(boxes_.xmin[i], origin_x_, inv_cell_width_, num_cols_);
+    *col1 = GetCell(boxes_.xmax[i], origin_x_, inv_cell_width_, num_cols_);
+    *row0 = GetCell(boxes_.ymin[i], origin_y_, inv_cell_height_, num_rows_);
+    *row1 = GetCell(boxes_.ymax[i], origin_y_, inv_cell_height_, num_rows_);
+    return (*col1 - *col0 + 1) * (*row1 - *row0 + 1) <= kMaxCellsPerBox;
+  }
+
+  const NmsBoxes& boxes_;
+  const bool is_enabled_;
+  float origin_x_ = 0.0f;
+  float origin_y_ = 0.0f;
+  float inv_cell_width_ = 0.0f;
+  float inv_cell_height_ = 0.0f;
+  int num_cols_ = 0;
+  int num_rows_ = 0;
+  std::vector<std::vector<int>> cells_;
+  // Boxes which are not stored in the cells, and are tested for every box.
+  std::vector<int> large_boxes_;
+  std::vector<int> inserted_;
+};
+
+}  // namespace
+
+void NmsBoxes::Reserve(int size) {
+  xmin.reserve(size);
+  ymin.reserve(size);
+  xmax.reserve(size);
+  ymax.reserve(size);
+}
+
+void NmsBoxes::Add(float box_xmin, float box_ymin, float box_xmax,
+                   float box_ymax) {
+  xmin.push_back(box_xmin);
+  ymin.push_back(box_ymin);
+  xmax.push_back(box_xmax);
+  ymax.push_back(box_ymax);
+}
+
+float NmsOverlap(NmsOverlapType overlap_type, const NmsBoxes& boxes, int i,
+                 int j) {
+  if (IsEmpty(boxes, i) || IsEmpty(boxes, j) ||
+      boxes.xmax[j] < boxes.xmin[i] || boxes.xmax[i] < boxes.xmin[j] ||
+      boxes.ymax[j] < boxes.ymin[i] || boxes.ymax[i] < boxes.ymin[j]) {
+    return 0.0f;
+  }
+  const float intersection_area =
+      (std::min(boxes.xmax[i], boxes.xmax[j]) -
+       std::max(boxes.xmin[i], boxes.xmin[j])) *
+      (std::min(boxes.ymax[i], boxes.ymax[j]) -
+       std::max(boxes.ymin[i], boxes.ymin[j]));
+  const float area_i =
+      (boxes.xmax[i] - boxes.xmin[i]) * (boxes.ymax[i] - boxes.ymin[i]);
+  const float area_j =
+      (boxes.xmax[j] - boxes.xmin[j]) * (boxes.ymax[j] - boxes.ymin[j]);
+  float normalization = 0.0f;
+  switch (overlap_type) {
+    case NmsOverlapType::kJaccard:
+      normalization = (std::max(boxes.xmax[i], boxes.xmax[j]) -
+                       std::min(boxes.xmin[i], boxes.xmin[j])) *
+                      (std::max(boxes.ymax[i], boxes.ymax[j]) -
+                       std::min(boxes.ymin[i], boxes.ymin[j]));
+      break;
+    case NmsOverlapType::kModifiedJaccard:
+      normalization = area_j;
+      break;
+    case NmsOverlapType::kIntersectionOverUnion:
+      normalization = area_i + area_j - intersection_area;
+      break;
+  }
+  return normalization > 0.0f ? intersection_area / normalization : 0.0f;
+}
+
+std::vector<int> NonMaxSuppression(const NmsBoxes& boxes,
+                                   const std::vector<float>& scores,
+                                   const std::vector<int>& classes,
+                                   const NmsOptions& options) {
+  std::vector<int> candidates = GetCandidates(scores, options);
+  BoxGrid grid(boxes, candidates, options.suppression_threshold >= 0.0f);
+  // A max-heap of the candidates which were not examined yet.
+  const ByDecreasingScore by_decreasing_score = {&scores};
+  const auto heap_order = [&by_decreasing_score](int a, int b) {
+    return by_decreasing_score(b, a);
+  };
+  std::make_heap(candidates.begin(), candidates.end(), heap_order);
+
+  std::vector<int> retained;
+  for (auto heap_end = candidates.end(); heap_end != candidates.begin();) {
+    std::pop_heap(candidates.begin(), heap_end, heap_order);
+    --heap_end;
+    const int i = *heap_end;
+    const bool is_suppressed = grid.ForEachNeighbor(i, [&](int r) {
+      return (classes.empty() || classes[r] == classes[i]) &&
+             NmsOverlap(options.overlap_type, boxes, r, i) >
+                 options.suppression_threshold;
+    });
+    if (!is_suppressed) {
+      retained.push_back(i);
+      grid.Insert(i);
+    }
+    if (options.max_num_boxes >= 0 &&
+        retained.size() >= options.max_num_boxes) {
+      break;
+    }
+  }
+  return retained;
+}
+
+std::vector<NmsCluster> WeightedNonMaxSuppression(
+    const NmsBoxes& boxes, const std::vector<float>& scores,
+    const std::vector<int>& classes, const NmsOptions& options) {
+  // Boxes below min_score are not dropped: they don't start a cluster, but
+  // join the cluster of an overlapping box above it.
+  std::vector<int> order(scores.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), ByDecreasingScore{&scores});
+  std::vector<int> rank(boxes.size());
+  BoxGrid grid(boxes, order, options.suppression_threshold >= 0.0f);
+  for (int k = 0; k < order.size(); ++k) {
+    rank[order[k]] = k;
+    grid.Insert(order[k]);
+  }
+
+  std::vector<NmsCluster> clusters;
+  std::vector<bool> is_clustered(boxes.size(), false);
+  // The last search in which each box was visited, as a box that covers
+  // several cells is found several times.
+  std::vector<int> last_visit(boxes.size(), -1);
+  int num_searches = 0;
+  for (int k = 0; k < order.size();) {
+    const int top = order[k];
+    if (is_clustered[top]) {
+      ++k;
+      continue;
+    }
+    if (options.min_score > 0 && scores[top] < options.min_score) {
+      break;
+    }
+    NmsCluster cluster;
+    cluster.top = top;
+    const int search = num_searches++;
+    grid.ForEachNeighbor(top, [&](int j) {
+      if (is_clustered[j] || last_visit[j] == search) {
+        return false;
+      }
+      last_visit[j] = search;
+      if ((classes.empty() || classes[j] == classes[top]) &&
+          NmsOverlap(options.overlap_type, boxes, j, top) >
+              options.suppression_threshold) {
+        cluster.members.push_back(j);
+      }
+      return false;
+    });
+    std::sort(cluster.members.begin(), cluster.members.end(),
+              [&rank](int a, int b) { return rank[a] < rank[b]; });
+    for (int j : cluster.members) {
+      is_clustered[j] = true;
+    }
+    const bool has_members = !cluster.members.empty();
+    clusters.push_back(std::move(cluster));
+    if (!has_members) {
+      break;
+    }
+  }
+  return clusters;
+}
+
+}  // namespace mediapipe
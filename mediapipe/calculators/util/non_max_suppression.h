@@ -0,0 +1,104 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_UTIL_NON_MAX_SUPPRESSION_H_
+#define MEDIAPIPE_CALCULATORS_UTIL_NON_MAX_SUPPRESSION_H_
+
+#include <vector>
+
+namespace mediapipe {
+
+// Boxes in structure-of-arrays form. Box i covers [xmin[i], xmax[i]] x
+// [ymin[i], ymax[i]], and is empty if a min is above the corresponding max.
+struct NmsBoxes {
+  std::vector<float> xmin;
+  std::vector<float> ymin;
+  std::vector<float> xmax;
+  std::vector<float> ymax;
+
+  int size() const { return xmin.size(); }
+  void Reserve(int size);
+  void Add(float box_xmin, float box_ymin, float box_xmax, float box_ymax);
+};
+
+// How NmsOverlap normalizes the intersection area of two boxes.
+enum class NmsOverlapType {
+  // By the area of the smallest box which contains both boxes.
+  kJaccard,
+  // By the area of the second box.
+  kModifiedJaccard,
+  // By the area of the union of the boxes.
+  kIntersectionOverUnion,
+};
+
+// Returns the overlap of box @i with box @j, in the same way as the
+// OverlapSimilarity of two Rectangle_f. The overlap is 0 if the boxes don't
+// intersect, or if the normalization is not positive.
+float NmsOverlap(NmsOverlapType overlap_type, const NmsBoxes& boxes, int i,
+                 int j);
+
+struct NmsOptions {
+  NmsOverlapType overlap_type = NmsOverlapType::kJaccard;
+  // A box is suppressed by a higher scoring box if their overlap is above
+  // this threshold.
+  float suppression_threshold = 1.0f;
+  // If positive, boxes with a lower score are not retained, and don't start a
+  // cluster in WeightedNonMaxSuppression.
+  float min_score = -1.0f;
+  // If not negative, the maximum number of boxes NonMaxSuppression returns.
+  int max_num_boxes = -1;
+};
+
+// Returns the boxes which are not suppressed, by decreasing score. Box c is
+// suppressed if NmsOverlap(r, c) is above the threshold for a box r which is
+// retained and scores higher.
+//
+// @scores holds the score of each box. If @classes is not empty, it holds the
+// class of each box, and a box only suppresses boxes of the same class.
+//
+// Candidates are popped from a heap, so that only the examined ones are
+// sorted, and a box is only compared with the retained boxes in the cells of a
+// uniform grid that it covers.
+std::vector<int> NonMaxSuppression(const NmsBoxes& boxes,
+                                   const std::vector<float>& scores,
+                                   const std::vector<int>& classes,
+                                   const NmsOptions& options);
+
+// A cluster of boxes found by WeightedNonMaxSuppression.
+struct NmsCluster {
+  // The highest scoring box which was not in a previous cluster.
+  int top;
+  // The boxes b, including @top if it overlaps itself, which were not in a
+  // previous cluster and for which NmsOverlap(b, top) is above the threshold.
+  // Sorted by decreasing score.
+  std::vector<int> members;
+};
+
+// Splits the boxes into clusters, by decreasing score of their top box, for
+// weighted non-maximum suppression. options.max_num_boxes is ignored.
+//
+// The clustering stops at a top box below options.min_score, but boxes below
+// it still join the clusters of the boxes above it and contribute to their
+// weighted averages.
+//
+// As in NonMaxSuppressionCalculator, the clustering stops after a cluster
+// without members, and a cluster whose members don't include its top box is
+// followed by another cluster with the same top box.
+std::vector<NmsCluster> WeightedNonMaxSuppression(
+    const NmsBoxes& boxes, const std::vector<float>& scores,
+    const std::vector<int>& classes, const NmsOptions& options);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_UTIL_NON_MAX_SUPPRESSION_H_
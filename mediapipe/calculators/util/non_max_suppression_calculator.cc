@@ -13,24 +13,29 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <array>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "mediapipe/calculators/util/non_max_suppression.h"
 #include "mediapipe/calculators/util/non_max_suppression_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/compact_detection.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/location.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/rectangle.h"
+#include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 
 namespace mediapipe {
 
 typedef std::vector<Detection> Detections;
-typedef std::vector<std::pair<int, float>> IndexedScores;
+typedef std::vector<CompactDetection> CompactDetections;
 
 namespace {
 
@@ -73,51 +78,33 @@ bool RetainMaxScoringLabelOnly(Detection* detection) {
   return true;
 }
 
-// Computes an overlap similarity between two rectangles. Similarity measure is
-// defined by overlap_type parameter.
-float OverlapSimilarity(
-    const NonMaxSuppressionCalculatorOptions::OverlapType overlap_type,
-    const Rectangle_f& rect1, const Rectangle_f& rect2) {
-  if (!rect1.Intersects(rect2)) return 0.0f;
-  const float intersection_area = Rectangle_f(rect1).Intersect(rect2).Area();
-  float normalization;
+// Maps an overlap type of the options to the one of the NMS library. Open
+// rejects UNSPECIFIED_OVERLAP_TYPE.
+NmsOverlapType ToNmsOverlapType(
+    NonMaxSuppressionCalculatorOptions::OverlapType overlap_type) {
   switch (overlap_type) {
-    case NonMaxSuppressionCalculatorOptions::JACCARD:
-      normalization = Rectangle_f(rect1).Union(rect2).Area();
-      break;
     case NonMaxSuppressionCalculatorOptions::MODIFIED_JACCARD:
-      normalization = rect2.Area();
-      break;
+      return NmsOverlapType::kModifiedJaccard;
     case NonMaxSuppressionCalculatorOptions::INTERSECTION_OVER_UNION:
-      normalization = rect1.Area() + rect2.Area() - intersection_area;
-      break;
+      return NmsOverlapType::kIntersectionOverUnion;
     default:
-      LOG(FATAL) << "Unrecognized overlap type: " << overlap_type;
+      return NmsOverlapType::kJaccard;
   }
-  return normalization > 0.0f ? intersection_area / normalization : 0.0f;
 }
 
-// Computes an overlap similarity between two locations by first extracting the
-// relative box (dimension normalized by frame width/height) from the location.
-float OverlapSimilarity(
-    const int frame_width, const int frame_height,
-    const NonMaxSuppressionCalculatorOptions::OverlapType overlap_type,
-    const Location& location1, const Location& location2) {
-  const auto rect1 = location1.ConvertToRelativeBBox(frame_width, frame_height);
-  const auto rect2 = location2.ConvertToRelativeBBox(frame_width, frame_height);
-  return OverlapSimilarity(overlap_type, rect1, rect2);
-}
-
-// Computes an overlap similarity between two locations by first extracting the
-// relative box from the location. It assumes that a relative-box representation
-// is already available in the location, and therefore frame width and height
-// are not needed for further normalization.
-float OverlapSimilarity(
-    const NonMaxSuppressionCalculatorOptions::OverlapType overlap_type,
-    const Location& location1, const Location& location2) {
-  const auto rect1 = location1.GetRelativeBBox();
-  const auto rect2 = location2.GetRelativeBBox();
-  return OverlapSimilarity(overlap_type, rect1, rect2);
+// Returns the class of a detection with a single score, for multiclass_nms:
+// its label id if it has one, or else its label. Label ids and labels are
+// numbered in the order they are found.
+int GetClass(const Detection& detection,
+             absl::flat_hash_map<int, int>* label_id_classes,
+             absl::flat_hash_map<std::string, int>* label_classes) {
+  const int next_class = label_id_classes->size() + label_classes->size();
+  if (detection.label_id_size() > 0) {
+    return label_id_classes->try_emplace(detection.label_id(0), next_class)
+        .first->second;
+  }
+  return label_classes->try_emplace(detection.label(0), next_class)
+      .first->second;
 }
 
 }  // namespace
@@ -127,12 +114,17 @@ float OverlapSimilarity(
 //   1. IMAGE (optional): A stream of ImageFrame used to obtain the frame size.
 //      No image data is used. Not needed if the detection bounding boxes are
 //      already represented in normalized dimensions (0.0~1.0).
-//   2. A variable number of input streams of type std::vector<Detection>. The
-//      exact number of such streams should be set via num_detection_streams
-//      field in the calculator options.
+//   2. A variable number of input streams of type std::vector<Detection> or
+//      std::vector<CompactDetection>, all of the same type. The exact number
+//      of such streams should be set via num_detection_streams field in the
+//      calculator options. CompactDetection boxes are always relative, so the
+//      IMAGE stream is not used for them.
 //
-// Outputs: a single stream of type std::vector<Detection> containing a subset
-//   of the input detections after non-maximum suppression.
+// Outputs: a single stream of the type of the input streams, containing a
+//   subset of the input detections after non-maximum suppression. When none of
+//   the input streams has a packet, the type of the empty output requested by
+//   return_empty_detections is the one of the previous input packets, or
+//   std::vector<Detection> before any.
 //
 // Example config:
 // node {
@@ -161,9 +153,9 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
       cc->Inputs().Tag(kImageTag).Set<ImageFrame>();
     }
     for (int k = 0; k < options.num_detection_streams(); ++k) {
-      cc->Inputs().Index(k).Set<Detections>();
+      cc->Inputs().Index(k).SetOneOf<Detections, CompactDetections>();
     }
-    cc->Outputs().Index(0).Set<Detections>();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
     return absl::OkStatus();
   }
 
@@ -177,10 +169,34 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
         << "max_num_detections=0 is not a valid value. Please choose a "
         << "positive number of you want to limit the number of output "
         << "detections, or set -1 if you do not want any limit.";
+    RET_CHECK_NE(options_.overlap_type(),
+                 NonMaxSuppressionCalculatorOptions::UNSPECIFIED_OVERLAP_TYPE)
+        << "Unrecognized overlap type.";
     return absl::OkStatus();
   }
 
   absl::Status Process(CalculatorContext* cc) override {
+    // Find the type of the input detections, which must be the same on all the
+    // streams.
+    bool type_found = false;
+    for (int i = 0; i < options_.num_detection_streams(); ++i) {
+      const auto& detections_packet = cc->Inputs().Index(i).Value();
+      if (detections_packet.IsEmpty()) {
+        continue;
+      }
+      const bool compact =
+          detections_packet.ValidateAsType<CompactDetections>().ok();
+      if (type_found) {
+        RET_CHECK_EQ(compact, compact_)
+            << "All the detection streams must have the same type.";
+      }
+      compact_ = compact;
+      type_found = true;
+    }
+    if (compact_) {
+      return ProcessCompactDetections(cc);
+    }
+
     // Add all input detections to the same vector.
     Detections input_detections;
     for (int i = 0; i < options_.num_detection_streams(); ++i) {
@@ -214,33 +230,58 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
       }
     }
 
-    // Copy all the scores (there is a single score in each detection after
-    // the above pruning) to an indexed vector for sorting. The first value is
-    // the index of the detection in the original vector from which the score
-    // stems, while the second is the actual score.
-    IndexedScores indexed_scores;
-    indexed_scores.reserve(pruned_detections.size());
-    for (int index = 0; index < pruned_detections.size(); ++index) {
-      indexed_scores.push_back(
-          std::make_pair(index, pruned_detections[index].score(0)));
+    // Copy the boxes, scores (there is a single score in each detection after
+    // the above pruning) and classes to flat arrays, for the NMS library.
+    NmsBoxes boxes;
+    boxes.Reserve(pruned_detections.size());
+    std::vector<float> scores;
+    scores.reserve(pruned_detections.size());
+    // Weighted NMS only supports relative bounding boxes, while plain NMS
+    // normalizes the boxes by the frame size when the frame is available.
+    const ImageFrame* frame = nullptr;
+    if (options_.algorithm() != NonMaxSuppressionCalculatorOptions::WEIGHTED &&
+        cc->Inputs().HasTag(kImageTag) &&
+        !cc->Inputs().Tag(kImageTag).IsEmpty()) {
+      frame = &cc->Inputs().Tag(kImageTag).Get<ImageFrame>();
+    }
+    for (const auto& detection : pruned_detections) {
+      const Location location(detection.location_data());
+      const Rectangle_f rect =
+          frame ? location.ConvertToRelativeBBox(frame->Width(),
+                                                 frame->Height())
+                : location.GetRelativeBBox();
+      boxes.Add(rect.xmin(), rect.ymin(), rect.xmax(), rect.ymax());
+      scores.push_back(detection.score(0));
+    }
+    std::vector<int> classes;
+    if (options_.multiclass_nms()) {
+      classes.reserve(pruned_detections.size());
+      absl::flat_hash_map<int, int> label_id_classes;
+      absl::flat_hash_map<std::string, int> label_classes;
+      for (const auto& detection : pruned_detections) {
+        classes.push_back(
+            GetClass(detection, &label_id_classes, &label_classes));
+      }
     }
-    std::sort(indexed_scores.begin(), indexed_scores.end(), SortBySecond);
-
-    const int max_num_detections =
-        (options_.max_num_detections() > -1)
-            ? options_.max_num_detections()
-            : static_cast<int>(indexed_scores.size());
-    // A set of detections and locations, wrapping the location data from each
-    // detection, which are retained after the non-maximum suppression.
-    auto* retained_detections = new Detections();
-    retained_detections->reserve(max_num_detections);
 
+    const NmsOptions nms_options = GetNmsOptions();
+    auto* retained_detections = new Detections();
     if (options_.algorithm() == NonMaxSuppressionCalculatorOptions::WEIGHTED) {
-      WeightedNonMaxSuppression(indexed_scores, pruned_detections,
-                                max_num_detections, cc, retained_detections);
+      const std::vector<NmsCluster> clusters =
+          mediapipe::WeightedNonMaxSuppression(boxes, scores, classes,
+                                               nms_options);
+      retained_detections->reserve(clusters.size());
+      for (const auto& cluster : clusters) {
+        retained_detections->push_back(
+            WeightedDetection(cluster, pruned_detections));
+      }
     } else {
-      NonMaxSuppression(indexed_scores, pruned_detections, max_num_detections,
-                        cc, retained_detections);
+      const std::vector<int> retained =
+          mediapipe::NonMaxSuppression(boxes, scores, classes, nms_options);
+      retained_detections->reserve(retained.size());
+      for (int i : retained) {
+        retained_detections->push_back(pruned_detections[i]);
+      }
     }
 
     cc->Outputs().Index(0).Add(retained_detections, cc->InputTimestamp());
@@ -249,136 +290,175 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
   }
 
  private:
-  void NonMaxSuppression(const IndexedScores& indexed_scores,
-                         const Detections& detections, int max_num_detections,
-                         CalculatorContext* cc, Detections* output_detections) {
-    std::vector<Location> retained_locations;
-    retained_locations.reserve(max_num_detections);
-    // We traverse the detections by decreasing score.
-    for (const auto& indexed_score : indexed_scores) {
-      const auto& detection = detections[indexed_score.first];
-      if (options_.min_score_threshold() > 0 &&
-          detection.score(0) < options_.min_score_threshold()) {
-        break;
-      }
-      const Location location(detection.location_data());
-      bool suppressed = false;
-      // The current detection is suppressed iff there exists a retained
-      // detection, whose location overlaps more than the specified
-      // threshold with the location of the current detection.
-      for (const auto& retained_location : retained_locations) {
-        float similarity;
-        if (cc->Inputs().HasTag(kImageTag)) {
-          const auto& frame = cc->Inputs().Tag(kImageTag).Get<ImageFrame>();
-          similarity = OverlapSimilarity(frame.Width(), frame.Height(),
-                                         options_.overlap_type(),
-                                         retained_location, location);
-        } else {
-          similarity = OverlapSimilarity(options_.overlap_type(),
-                                         retained_location, location);
-        }
-        if (similarity > options_.min_suppression_threshold()) {
-          suppressed = true;
-          break;
-        }
+  NmsOptions GetNmsOptions() const {
+    NmsOptions nms_options;
+    nms_options.overlap_type = ToNmsOverlapType(options_.overlap_type());
+    nms_options.suppression_threshold = options_.min_suppression_threshold();
+    nms_options.min_score = options_.min_score_threshold();
+    nms_options.max_num_boxes = options_.max_num_detections();
+    return nms_options;
+  }
+
+  // Same as the Detection path of Process, for CompactDetections. A
+  // CompactDetection already has a single label id and score, which is also
+  // its class for multiclass_nms.
+  absl::Status ProcessCompactDetections(CalculatorContext* cc) {
+    CompactDetections input_detections;
+    for (int i = 0; i < options_.num_detection_streams(); ++i) {
+      const auto& detections_packet = cc->Inputs().Index(i).Value();
+      if (detections_packet.IsEmpty()) {
+        continue;
       }
-      if (!suppressed) {
-        output_detections->push_back(detection);
-        retained_locations.push_back(location);
+      const auto& detections = detections_packet.Get<CompactDetections>();
+      input_detections.insert(input_detections.end(), detections.begin(),
+                              detections.end());
+    }
+
+    if (input_detections.empty()) {
+      if (options_.return_empty_detections()) {
+        cc->Outputs().Index(0).Add(new CompactDetections(),
+                                   cc->InputTimestamp());
       }
-      if (output_detections->size() >= max_num_detections) {
-        break;
+      return absl::OkStatus();
+    }
+
+    NmsBoxes boxes;
+    boxes.Reserve(input_detections.size());
+    std::vector<float> scores;
+    scores.reserve(input_detections.size());
+    std::vector<int> classes;
+    if (options_.multiclass_nms()) {
+      classes.reserve(input_detections.size());
+    }
+    for (const auto& detection : input_detections) {
+      boxes.Add(detection.xmin, detection.ymin,
+                detection.xmin + detection.width,
+                detection.ymin + detection.height);
+      scores.push_back(detection.score);
+      if (options_.multiclass_nms()) {
+        classes.push_back(detection.label_id);
       }
     }
-  }
 
-  void WeightedNonMaxSuppression(const IndexedScores& indexed_scores,
-                                 const Detections& detections,
-                                 int max_num_detections, CalculatorContext* cc,
-                                 Detections* output_detections) {
-    IndexedScores remained_indexed_scores;
-    remained_indexed_scores.assign(indexed_scores.begin(),
-                                   indexed_scores.end());
-
-    IndexedScores remained;
-    IndexedScores candidates;
-    output_detections->clear();
-    while (!remained_indexed_scores.empty()) {
-      const int original_indexed_scores_size = remained_indexed_scores.size();
-      const auto& detection = detections[remained_indexed_scores[0].first];
-      if (options_.min_score_threshold() > 0 &&
-          detection.score(0) < options_.min_score_threshold()) {
-        break;
+    const NmsOptions nms_options = GetNmsOptions();
+    auto* retained_detections = new CompactDetections();
+    if (options_.algorithm() == NonMaxSuppressionCalculatorOptions::WEIGHTED) {
+      const std::vector<NmsCluster> clusters =
+          mediapipe::WeightedNonMaxSuppression(boxes, scores, classes,
+                                               nms_options);
+      retained_detections->reserve(clusters.size());
+      for (const auto& cluster : clusters) {
+        retained_detections->push_back(
+            WeightedDetection(cluster, input_detections));
       }
-      remained.clear();
-      candidates.clear();
-      const Location location(detection.location_data());
-      // This includes the first box.
-      for (const auto& indexed_score : remained_indexed_scores) {
-        Location rest_location(detections[indexed_score.first].location_data());
-        float similarity =
-            OverlapSimilarity(options_.overlap_type(), rest_location, location);
-        if (similarity > options_.min_suppression_threshold()) {
-          candidates.push_back(indexed_score);
-        } else {
-          remained.push_back(indexed_score);
-        }
+    } else {
+      const std::vector<int> retained =
+          mediapipe::NonMaxSuppression(boxes, scores, classes, nms_options);
+      retained_detections->reserve(retained.size());
+      for (int i : retained) {
+        retained_detections->push_back(input_detections[i]);
       }
-      auto weighted_detection = detection;
-      if (!candidates.empty()) {
-        const int num_keypoints =
-            detection.location_data().relative_keypoints_size();
-        std::vector<float> keypoints(num_keypoints * 2);
-        float w_xmin = 0.0f;
-        float w_ymin = 0.0f;
-        float w_xmax = 0.0f;
-        float w_ymax = 0.0f;
-        float total_score = 0.0f;
-        for (const auto& candidate : candidates) {
-          total_score += candidate.second;
-          const auto& location_data =
-              detections[candidate.first].location_data();
-          const auto& bbox = location_data.relative_bounding_box();
-          w_xmin += bbox.xmin() * candidate.second;
-          w_ymin += bbox.ymin() * candidate.second;
-          w_xmax += (bbox.xmin() + bbox.width()) * candidate.second;
-          w_ymax += (bbox.ymin() + bbox.height()) * candidate.second;
-
-          for (int i = 0; i < num_keypoints; ++i) {
-            keypoints[i * 2] +=
-                location_data.relative_keypoints(i).x() * candidate.second;
-            keypoints[i * 2 + 1] +=
-                location_data.relative_keypoints(i).y() * candidate.second;
-          }
-        }
-        auto* weighted_location = weighted_detection.mutable_location_data()
-                                      ->mutable_relative_bounding_box();
-        weighted_location->set_xmin(w_xmin / total_score);
-        weighted_location->set_ymin(w_ymin / total_score);
-        weighted_location->set_width((w_xmax / total_score) -
-                                     weighted_location->xmin());
-        weighted_location->set_height((w_ymax / total_score) -
-                                      weighted_location->ymin());
-        for (int i = 0; i < num_keypoints; ++i) {
-          auto* keypoint = weighted_detection.mutable_location_data()
-                               ->mutable_relative_keypoints(i);
-          keypoint->set_x(keypoints[i * 2] / total_score);
-          keypoint->set_y(keypoints[i * 2 + 1] / total_score);
-        }
+    }
+
+    cc->Outputs().Index(0).Add(retained_detections, cc->InputTimestamp());
+
+    return absl::OkStatus();
+  }
+
+  // Returns the top detection of @cluster, with its relative bounding box and
+  // keypoints replaced by the score-weighted average of those of the members.
+  static Detection WeightedDetection(const NmsCluster& cluster,
+                                     const Detections& detections) {
+    const auto& detection = detections[cluster.top];
+    auto weighted_detection = detection;
+    if (cluster.members.empty()) {
+      return weighted_detection;
+    }
+    const int num_keypoints =
+        detection.location_data().relative_keypoints_size();
+    std::vector<float> keypoints(num_keypoints * 2);
+    float w_xmin = 0.0f;
+    float w_ymin = 0.0f;
+    float w_xmax = 0.0f;
+    float w_ymax = 0.0f;
+    float total_score = 0.0f;
+    for (int member : cluster.members) {
+      const float score = detections[member].score(0);
+      total_score += score;
+      const auto& location_data = detections[member].location_data();
+      const auto& bbox = location_data.relative_bounding_box();
+      w_xmin += bbox.xmin() * score;
+      w_ymin += bbox.ymin() * score;
+      w_xmax += (bbox.xmin() + bbox.width()) * score;
+      w_ymax += (bbox.ymin() + bbox.height()) * score;
+
+      for (int i = 0; i < num_keypoints; ++i) {
+        keypoints[i * 2] += location_data.relative_keypoints(i).x() * score;
+        keypoints[i * 2 + 1] +=
+            location_data.relative_keypoints(i).y() * score;
       }
+    }
+    auto* weighted_location = weighted_detection.mutable_location_data()
+                                  ->mutable_relative_bounding_box();
+    weighted_location->set_xmin(w_xmin / total_score);
+    weighted_location->set_ymin(w_ymin / total_score);
+    weighted_location->set_width((w_xmax / total_score) -
+                                 weighted_location->xmin());
+    weighted_location->set_height((w_ymax / total_score) -
+                                  weighted_location->ymin());
+    for (int i = 0; i < num_keypoints; ++i) {
+      auto* keypoint = weighted_detection.mutable_location_data()
+                           ->mutable_relative_keypoints(i);
+      keypoint->set_x(keypoints[i * 2] / total_score);
+      keypoint->set_y(keypoints[i * 2 + 1] / total_score);
+    }
+    return weighted_detection;
+  }
 
-      output_detections->push_back(weighted_detection);
-      // Breaks the loop if the size of indexed scores doesn't change after an
-      // iteration.
-      if (original_indexed_scores_size == remained.size()) {
-        break;
-      } else {
-        remained_indexed_scores = std::move(remained);
+  // Same as above, for CompactDetections.
+  static CompactDetection WeightedDetection(
+      const NmsCluster& cluster, const CompactDetections& detections) {
+    CompactDetection weighted_detection = detections[cluster.top];
+    if (cluster.members.empty()) {
+      return weighted_detection;
+    }
+    std::array<CompactDetection::Keypoint, CompactDetection::kMaxKeypoints>
+        keypoints;
+    float w_xmin = 0.0f;
+    float w_ymin = 0.0f;
+    float w_xmax = 0.0f;
+    float w_ymax = 0.0f;
+    float total_score = 0.0f;
+    for (int member : cluster.members) {
+      const auto& detection = detections[member];
+      const float score = detection.score;
+      total_score += score;
+      w_xmin += detection.xmin * score;
+      w_ymin += detection.ymin * score;
+      w_xmax += (detection.xmin + detection.width) * score;
+      w_ymax += (detection.ymin + detection.height) * score;
+
+      for (int i = 0; i < weighted_detection.num_keypoints; ++i) {
+        keypoints[i].x += detection.keypoints[i].x * score;
+        keypoints[i].y += detection.keypoints[i].y * score;
       }
     }
+    weighted_detection.xmin = w_xmin / total_score;
+    weighted_detection.ymin = w_ymin / total_score;
+    weighted_detection.width = (w_xmax / total_score) - weighted_detection.xmin;
+    weighted_detection.height =
+        (w_ymax / total_score) - weighted_detection.ymin;
+    for (int i = 0; i < weighted_detection.num_keypoints; ++i) {
+      weighted_detection.keypoints[i].x = keypoints[i].x / total_score;
+      weighted_detection.keypoints[i].y = keypoints[i].y / total_score;
+    }
+    return weighted_detection;
   }
 
   NonMaxSuppressionCalculatorOptions options_;
+  // Whether the detection streams carry CompactDetections, as of the last
+  // input packets.
+  bool compact_ = false;
 };
 REGISTER_CALCULATOR(NonMaxSuppressionCalculator);
 
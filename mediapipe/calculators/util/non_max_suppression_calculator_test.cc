@@ -0,0 +1,147 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_replace.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/compact_detection.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::Pointwise;
+
+// Overlapping detections in two clusters, plus one below the min score
+// threshold of kNodeConfig.
+std::vector<Detection> GetDetections() {
+  return {
+      ParseTextProtoOrDie<Detection>(R"pb(
+        label_id: 0
+        score: 0.9
+        location_data {
+          format: RELATIVE_BOUNDING_BOX
+          relative_bounding_box { xmin: 0.1 ymin: 0.1 width: 0.4 height: 0.4 }
+          relative_keypoints { x: 0.2 y: 0.3 }
+        }
+      )pb"),
+      ParseTextProtoOrDie<Detection>(R"pb(
+        label_id: 0
+        score: 0.8
+        location_data {
+          format: RELATIVE_BOUNDING_BOX
+          relative_bounding_box {
+            xmin: 0.15
+            ymin: 0.1
+            width: 0.4
+            height: 0.45
+          }
+          relative_keypoints { x: 0.25 y: 0.35 }
+        }
+      )pb"),
+      ParseTextProtoOrDie<Detection>(R"pb(
+        label_id: 1
+        score: 0.2
+        location_data {
+          format: RELATIVE_BOUNDING_BOX
+          relative_bounding_box { xmin: 0.1 ymin: 0.15 width: 0.4 height: 0.4 }
+          relative_keypoints { x: 0.3 y: 0.2 }
+        }
+      )pb"),
+      ParseTextProtoOrDie<Detection>(R"pb(
+        label_id: 1
+        score: 0.7
+        location_data {
+          format: RELATIVE_BOUNDING_BOX
+          relative_bounding_box { xmin: 0.6 ymin: 0.6 width: 0.3 height: 0.2 }
+          relative_keypoints { x: 0.7 y: 0.7 }
+        }
+      )pb"),
+      ParseTextProtoOrDie<Detection>(R"pb(
+        label_id: 1
+        score: 0.6
+        location_data {
+          format: RELATIVE_BOUNDING_BOX
+          relative_bounding_box {
+            xmin: 0.62
+            ymin: 0.6
+            width: 0.3
+            height: 0.25
+          }
+          relative_keypoints { x: 0.72 y: 0.75 }
+        }
+      )pb"),
+  };
+}
+
+constexpr char kNodeConfig[] = R"pb(
+  calculator: "NonMaxSuppressionCalculator"
+  input_stream: "detections"
+  output_stream: "retained_detections"
+  options {
+    [mediapipe.NonMaxSuppressionCalculatorOptions.ext] {
+      min_suppression_threshold: 0.3
+      min_score_threshold: 0.5
+      overlap_type: INTERSECTION_OVER_UNION
+      algorithm: $algorithm
+    }
+  }
+)pb";
+
+// Runs the calculator on a single packet holding @detections, and returns
+// the retained detections.
+template <typename DetectionT>
+absl::StatusOr<std::vector<DetectionT>> RunCalculator(
+    const std::string& algorithm, std::vector<DetectionT> detections) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(
+      absl::StrReplaceAll(kNodeConfig, {{"$algorithm", algorithm}})));
+  runner.MutableInputs()->Index(0).packets.push_back(
+      MakePacket<std::vector<DetectionT>>(std::move(detections))
+          .At(Timestamp(0)));
+  MP_RETURN_IF_ERROR(runner.Run());
+  const auto& output_packets = runner.Outputs().Index(0).packets;
+  RET_CHECK_EQ(output_packets.size(), 1);
+  return output_packets[0].Get<std::vector<DetectionT>>();
+}
+
+class NonMaxSuppressionCalculatorTest
+    : public ::testing::TestWithParam<std::string> {};
+
+TEST_P(NonMaxSuppressionCalculatorTest, CompactDetectionsMatchProtos) {
+  MP_ASSERT_OK_AND_ASSIGN(const std::vector<Detection> retained,
+                          RunCalculator(GetParam(), GetDetections()));
+  MP_ASSERT_OK_AND_ASSIGN(const std::vector<CompactDetection> compact_input,
+                          ToCompactDetections(GetDetections()));
+  MP_ASSERT_OK_AND_ASSIGN(const std::vector<CompactDetection> compact_retained,
+                          RunCalculator(GetParam(), compact_input));
+
+  // One detection per cluster.
+  EXPECT_EQ(retained.size(), 2);
+  EXPECT_THAT(ToDetections(compact_retained),
+              Pointwise(EqualsProto(), retained));
+}
+
+INSTANTIATE_TEST_SUITE_P(Algorithms, NonMaxSuppressionCalculatorTest,
+                         ::testing::Values("DEFAULT", "WEIGHTED"));
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,387 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/util/non_max_suppression.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+// Computes the overlap of two boxes the way OverlapSimilarity does with
+// Rectangle_f.
+float ReferenceOverlap(NmsOverlapType overlap_type, const NmsBoxes& boxes,
+                       int i, int j) {
+  const auto is_empty = [&boxes](int k) {
+    return boxes.xmin[k] > boxes.xmax[k] || boxes.ymin[k] > boxes.ymax[k];
+  };
+  const auto area = [&boxes](int k) {
+    return (boxes.xmax[k] - boxes.xmin[k]) * (boxes.ymax[k] - boxes.ymin[k]);
+  };
+  if (is_empty(i) || is_empty(j) || boxes.xmin[j] > boxes.xmax[i] ||
+      boxes.xmax[j] < boxes.xmin[i] || boxes.ymin[j] > boxes.ymax[i] ||
+      boxes.ymax[j] < boxes.ymin[i]) {
+    return 0.0f;
+  }
+  const float intersection_xmin = std::max(boxes.xmin[i], boxes.xmin[j]);
+  const float intersection_ymin = std::max(boxes.ymin[i], boxes.ymin[j]);
+  const float intersection_xmax = std::min(boxes.xmax[i], boxes.xmax[j]);
+  const float intersection_ymax = std::min(boxes.ymax[i], boxes.ymax[j]);
+  const float intersection_area = (intersection_xmax - intersection_xmin) *
+                                  (intersection_ymax - intersection_ymin);
+  float normalization = 0.0f;
+  switch (overlap_type) {
+    case NmsOverlapType::kJaccard:
+      normalization = (std::max(boxes.xmax[i], boxes.xmax[j]) -
+                       std::min(boxes.xmin[i], boxes.xmin[j])) *
+                      (std::max(boxes.ymax[i], boxes.ymax[j]) -
+                       std::min(boxes.ymin[i], boxes.ymin[j]));
+      break;
+    case NmsOverlapType::kModifiedJaccard:
+      normalization = area(j);
+      break;
+    case NmsOverlapType::kIntersectionOverUnion:
+      normalization = area(i) + area(j) - intersection_area;
+      break;
+  }
+  return normalization > 0.0f ? intersection_area / normalization : 0.0f;
+}
+
+// Returns all the boxes, by decreasing score.
+std::vector<int> SortedBoxes(const std::vector<float>& scores) {
+  std::vector<int> order(scores.size());
+  for (int i = 0; i < scores.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&scores](int a, int b) { return scores[a] > scores[b]; });
+  return order;
+}
+
+bool IsBelowMinScore(const std::vector<float>& scores, int i,
+                     const NmsOptions& options) {
+  return options.min_score > 0 && scores[i] < options.min_score;
+}
+
+bool SameClass(const std::vector<int>& classes, int i, int j) {
+  return classes.empty() || classes[i] == classes[j];
+}
+
+// Compares each box with all the retained boxes, the way
+// NonMaxSuppressionCalculator did before it used the library.
+std::vector<int> ReferenceNonMaxSuppression(const NmsBoxes& boxes,
+                                            const std::vector<float>& scores,
+                                            const std::vector<int>& classes,
+                                            const NmsOptions& options) {
+  std::vector<int> retained;
+  for (int i : SortedBoxes(scores)) {
+    if (IsBelowMinScore(scores, i, options)) {
+      break;
+    }
+    bool suppressed = false;
+    for (int r : retained) {
+      if (SameClass(classes, r, i) &&
+          ReferenceOverlap(options.overlap_type, boxes, r, i) >
+              options.suppression_threshold) {
+        suppressed = true;
+        break;
+      }
+    }
+    if (!suppressed) {
+      retained.push_back(i);
+    }
+    if (options.max_num_boxes >= 0 &&
+        retained.size() >= options.max_num_boxes) {
+      break;
+    }
+  }
+  return retained;
+}
+
+// Splits the remaining boxes in each iteration, the way
+// NonMaxSuppressionCalculator did before it used the library.
+std::vector<NmsCluster> ReferenceWeightedNonMaxSuppression(
+    const NmsBoxes& boxes, const std::vector<float>& scores,
+    const std::vector<int>& classes, const NmsOptions& options) {
+  std::vector<NmsCluster> clusters;
+  std::vector<int> remained = SortedBoxes(scores);
+  while (!remained.empty()) {
+    // Only the top box is compared with min_score: lower scoring boxes still
+    // join its cluster.
+    if (IsBelowMinScore(scores, remained[0], options)) {
+      break;
+    }
+    NmsCluster cluster;
+    cluster.top = remained[0];
+    std::vector<int> next_remained;
+    for (int j : remained) {
+      if (SameClass(classes, j, cluster.top) &&
+          ReferenceOverlap(options.overlap_type, boxes, j, cluster.top) >
+              options.suppression_threshold) {
+        cluster.members.push_back(j);
+      } else {
+        next_remained.push_back(j);
+      }
+    }
+    const bool has_members = !cluster.members.empty();
+    clusters.push_back(std::move(cluster));
+    if (!has_members) {
+      break;
+    }
+    remained = std::move(next_remained);
+  }
+  return clusters;
+}
+
+// Returns random boxes of sizes in [min_size, max_size] in the unit square,
+// with a few empty boxes. Scores are drawn from a few values, so that some
+// boxes have equal scores.
+void MakeRandomBoxes(int num_boxes, float min_size, float max_size,
+                     int num_classes, unsigned seed, NmsBoxes* boxes,
+                     std::vector<float>* scores, std::vector<int>* classes) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> position(0.0f, 1.0f);
+  std::uniform_real_distribution<float> size(min_size, max_size);
+  std::uniform_int_distribution<int> score(0, 99);
+  std::uniform_int_distribution<int> box_class(0, num_classes - 1);
+  boxes->Reserve(num_boxes);
+  for (int i = 0; i < num_boxes; ++i) {
+    const float xmin = position(rng);
+    const float ymin = position(rng);
+    if (i % 50 == 7) {
+      boxes->Add(xmin, ymin, xmin - size(rng), ymin + size(rng));
+    } else {
+      boxes->Add(xmin, ymin, xmin + size(rng), ymin + size(rng));
+    }
+    scores->push_back(score(rng) / 100.0f);
+    classes->push_back(box_class(rng));
+  }
+}
+
+void ExpectSameClusters(const std::vector<NmsCluster>& clusters,
+                        const std::vector<NmsCluster>& expected_clusters) {
+  ASSERT_EQ(clusters.size(), expected_clusters.size());
+  for (int k = 0; k < clusters.size(); ++k) {
+    EXPECT_EQ(clusters[k].top, expected_clusters[k].top);
+    EXPECT_EQ(clusters[k].members, expected_clusters[k].members);
+  }
+}
+
+constexpr NmsOverlapType kOverlapTypes[] = {
+    NmsOverlapType::kJaccard,
+    NmsOverlapType::kModifiedJaccard,
+    NmsOverlapType::kIntersectionOverUnion,
+};
+
+TEST(NonMaxSuppressionTest, OverlapMatchesRectangles) {
+  NmsBoxes boxes;
+  std::vector<float> scores;
+  std::vector<int> classes;
+  MakeRandomBoxes(200, 0.0f, 0.5f, 1, 1, &boxes, &scores, &classes);
+  // Boxes touching on an edge, and a box with zero width.
+  boxes.Add(0.2f, 0.2f, 0.4f, 0.4f);
+  boxes.Add(0.4f, 0.3f, 0.6f, 0.5f);
+  boxes.Add(0.3f, 0.3f, 0.3f, 0.5f);
+  for (NmsOverlapType overlap_type : kOverlapTypes) {
+    for (int i = 0; i < boxes.size(); ++i) {
+      for (int j = 0; j < boxes.size(); ++j) {
+        ASSERT_EQ(NmsOverlap(overlap_type, boxes, i, j),
+                  ReferenceOverlap(overlap_type, boxes, i, j))
+            << i << " " << j;
+      }
+    }
+  }
+}
+
+TEST(NonMaxSuppressionTest, MatchesReference) {
+  NmsBoxes boxes;
+  std::vector<float> scores;
+  std::vector<int> classes;
+  MakeRandomBoxes(1000, 0.01f, 0.2f, 3, 2, &boxes, &scores, &classes);
+  // A box spanning many grid cells, and one with NaN coordinates.
+  boxes.Add(0.1f, 0.1f, 0.9f, 0.9f);
+  scores.push_back(0.5f);
+  classes.push_back(0);
+  boxes.Add(std::numeric_limits<float>::quiet_NaN(), 0.5f, 0.6f, 0.6f);
+  scores.push_back(0.5f);
+  classes.push_back(1);
+  const std::vector<int> no_classes;
+  for (NmsOverlapType overlap_type : kOverlapTypes) {
+    for (float threshold : {-0.1f, 0.0f, 0.3f, 0.7f, 1.0f}) {
+      for (float min_score : {-1.0f, 0.5f}) {
+        for (int max_num_boxes : {-1, 10}) {
+          NmsOptions options;
+          options.overlap_type = overlap_type;
+          options.suppression_threshold = threshold;
+          options.min_score = min_score;
+          options.max_num_boxes = max_num_boxes;
+          EXPECT_EQ(NonMaxSuppression(boxes, scores, no_classes, options),
+                    ReferenceNonMaxSuppression(boxes, scores, no_classes,
+                                               options));
+          EXPECT_EQ(
+              NonMaxSuppression(boxes, scores, classes, options),
+              ReferenceNonMaxSuppression(boxes, scores, classes, options));
+        }
+      }
+    }
+  }
+}
+
+TEST(NonMaxSuppressionTest, WeightedMatchesReference) {
+  NmsBoxes boxes;
+  std::vector<float> scores;
+  std::vector<int> classes;
+  MakeRandomBoxes(1000, 0.01f, 0.2f, 3, 3, &boxes, &scores, &classes);
+  boxes.Add(0.1f, 0.1f, 0.9f, 0.9f);
+  scores.push_back(0.5f);
+  classes.push_back(0);
+  const std::vector<int> no_classes;
+  for (NmsOverlapType overlap_type : kOverlapTypes) {
+    for (float threshold : {-0.1f, 0.0f, 0.3f, 0.7f}) {
+      for (float min_score : {-1.0f, 0.5f}) {
+        NmsOptions options;
+        options.overlap_type = overlap_type;
+        options.suppression_threshold = threshold;
+        options.min_score = min_score;
+        ExpectSameClusters(
+            WeightedNonMaxSuppression(boxes, scores, no_classes, options),
+            ReferenceWeightedNonMaxSuppression(boxes, scores, no_classes,
+                                               options));
+        ExpectSameClusters(
+            WeightedNonMaxSuppression(boxes, scores, classes, options),
+            ReferenceWeightedNonMaxSuppression(boxes, scores, classes,
+                                               options));
+      }
+    }
+  }
+}
+
+TEST(NonMaxSuppressionTest, WeightedStopsAtEmptyCluster) {
+  NmsBoxes boxes;
+  boxes.Add(0.0f, 0.0f, 0.5f, 0.5f);
+  // An empty box overlaps no box, so its cluster is empty.
+  boxes.Add(0.5f, 0.5f, 0.4f, 0.6f);
+  boxes.Add(0.6f, 0.6f, 0.8f, 0.8f);
+  NmsOptions options;
+  options.suppression_threshold = 0.3f;
+  const std::vector<NmsCluster> clusters =
+      WeightedNonMaxSuppression(boxes, {0.9f, 0.8f, 0.7f}, {}, options);
+  ASSERT_EQ(clusters.size(), 2);
+  EXPECT_EQ(clusters[0].top, 0);
+  EXPECT_EQ(clusters[0].members, std::vector<int>({0}));
+  EXPECT_EQ(clusters[1].top, 1);
+  EXPECT_TRUE(clusters[1].members.empty());
+}
+
+TEST(NonMaxSuppressionTest, WeightedClustersBoxesBelowMinScore) {
+  NmsBoxes boxes;
+  boxes.Add(0.0f, 0.0f, 0.5f, 0.5f);
+  // Overlaps the first box, but scores below min_score.
+  boxes.Add(0.1f, 0.1f, 0.6f, 0.6f);
+  // Scores below min_score, and overlaps no box of a higher score.
+  boxes.Add(0.7f, 0.7f, 0.9f, 0.9f);
+  NmsOptions options;
+  options.suppression_threshold = 0.3f;
+  options.min_score = 0.5f;
+  const std::vector<NmsCluster> clusters =
+      WeightedNonMaxSuppression(boxes, {0.9f, 0.2f, 0.3f}, {}, options);
+  ASSERT_EQ(clusters.size(), 1);
+  EXPECT_EQ(clusters[0].top, 0);
+  EXPECT_EQ(clusters[0].members, std::vector<int>({0, 1}));
+}
+
+struct BenchmarkInputs {
+  explicit BenchmarkInputs(int num_boxes) {
+    MakeRandomBoxes(num_boxes, 0.02f, 0.1f, 1, 4, &boxes, &scores, &classes);
+    options.overlap_type = NmsOverlapType::kIntersectionOverUnion;
+    options.suppression_threshold = 0.3f;
+  }
+
+  NmsBoxes boxes;
+  std::vector<float> scores;
+  std::vector<int> classes;
+  NmsOptions options;
+};
+
+void BM_NonMaxSuppressionReference(benchmark::State& state) {
+  BenchmarkInputs inputs(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ReferenceNonMaxSuppression(
+        inputs.boxes, inputs.scores, {}, inputs.options));
+  }
+}
+BENCHMARK(BM_NonMaxSuppressionReference)->Arg(1000)->Arg(10000)->Arg(50000);
+
+void BM_NonMaxSuppression(benchmark::State& state) {
+  BenchmarkInputs inputs(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        NonMaxSuppression(inputs.boxes, inputs.scores, {}, inputs.options));
+  }
+}
+BENCHMARK(BM_NonMaxSuppression)->Arg(1000)->Arg(10000)->Arg(50000);
+
+void BM_NonMaxSuppressionTop100(benchmark::State& state) {
+  BenchmarkInputs inputs(state.range(0));
+  inputs.options.max_num_boxes = 100;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        NonMaxSuppression(inputs.boxes, inputs.scores, {}, inputs.options));
+  }
+}
+BENCHMARK(BM_NonMaxSuppressionTop100)->Arg(1000)->Arg(10000)->Arg(50000);
+
+void BM_MulticlassNonMaxSuppression(benchmark::State& state) {
+  BenchmarkInputs inputs(state.range(0));
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> box_class(0, 9);
+  for (int& c : inputs.classes) {
+    c = box_class(rng);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(NonMaxSuppression(inputs.boxes, inputs.scores,
+                                               inputs.classes, inputs.options));
+  }
+}
+BENCHMARK(BM_MulticlassNonMaxSuppression)->Arg(1000)->Arg(10000)->Arg(50000);
+
+void BM_WeightedNonMaxSuppressionReference(benchmark::State& state) {
+  BenchmarkInputs inputs(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ReferenceWeightedNonMaxSuppression(
+        inputs.boxes, inputs.scores, {}, inputs.options));
+  }
+}
+BENCHMARK(BM_WeightedNonMaxSuppressionReference)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(50000);
+
+void BM_WeightedNonMaxSuppression(benchmark::State& state) {
+  BenchmarkInputs inputs(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(WeightedNonMaxSuppression(
+        inputs.boxes, inputs.scores, {}, inputs.options));
+  }
+}
+BENCHMARK(BM_WeightedNonMaxSuppression)->Arg(1000)->Arg(10000)->Arg(50000);
+
+}  // namespace
+}  // namespace mediapipe
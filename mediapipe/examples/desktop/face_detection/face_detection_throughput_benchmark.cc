@@ -0,0 +1,146 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the offline throughput of the face detection desktop graph on a
+// synthetic video, with CalculatorGraphConfig.throughput_mode.
+//
+// Example:
+//   bazel run -c opt --define MEDIAPIPE_DISABLE_GPU=1 \
+//     mediapipe/examples/desktop/face_detection:face_detection_throughput_benchmark
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+
+constexpr char kInputStream[] = "input_video";
+constexpr char kOutputStream[] = "output_video";
+
+ABSL_FLAG(std::string, calculator_graph_config_file,
+          "mediapipe/graphs/face_detection/face_detection_desktop_live.pbtxt",
+          "Name of file containing text format CalculatorGraphConfig proto.");
+ABSL_FLAG(int, num_frames, 600, "Number of synthetic video frames to process.");
+ABSL_FLAG(int, frame_width, 640, "Width of the synthetic video frames.");
+ABSL_FLAG(int, frame_height, 480, "Height of the synthetic video frames.");
+ABSL_FLAG(bool, throughput_mode, true,
+          "Whether to run the graph in throughput mode.");
+
+namespace {
+
+// The number of distinct frames in the synthetic video, which repeats.
+constexpr int kNumDistinctFrames = 30;
+
+// Returns an SRGB frame with a diagonal gradient that moves with the frame
+// index, so that consecutive frames differ.
+mediapipe::Packet MakeSyntheticFrame(int index, int width, int height) {
+  auto frame = absl::make_unique<mediapipe::ImageFrame>(
+      mediapipe::ImageFormat::SRGB, width, height,
+      mediapipe::ImageFrame::kDefaultAlignmentBoundary);
+  for (int y = 0; y < height; ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < width; ++x) {
+      row[3 * x] = static_cast<uint8>(x + index * 8);
+      row[3 * x + 1] = static_cast<uint8>(y + index * 4);
+      row[3 * x + 2] = static_cast<uint8>(x + y);
+    }
+  }
+  return mediapipe::Adopt(frame.release());
+}
+
+// Replaces each FlowLimiterCalculator with a PassThroughCalculator, since
+// an offline run must not drop frames.
+void RemoveFlowLimiters(mediapipe::CalculatorGraphConfig* config) {
+  for (auto& node : *config->mutable_node()) {
+    if (node.calculator() != "FlowLimiterCalculator") {
+      continue;
+    }
+    std::string input = node.input_stream(0);
+    std::string output = node.output_stream(0);
+    node.Clear();
+    node.set_calculator("PassThroughCalculator");
+    node.add_input_stream(input);
+    node.add_output_stream(output);
+  }
+}
+
+absl::Status RunBenchmark() {
+  std::string calculator_graph_config_contents;
+  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
+      absl::GetFlag(FLAGS_calculator_graph_config_file),
+      &calculator_graph_config_contents));
+  mediapipe::CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig>(
+          calculator_graph_config_contents);
+  RemoveFlowLimiters(&config);
+  config.set_throughput_mode(absl::GetFlag(FLAGS_throughput_mode));
+
+  LOG(INFO) << "Initialize the calculator graph.";
+  mediapipe::CalculatorGraph graph;
+  MP_RETURN_IF_ERROR(graph.Initialize(config));
+  int64 num_output_frames = 0;
+  MP_RETURN_IF_ERROR(graph.ObserveOutputStream(
+      kOutputStream, [&num_output_frames](const mediapipe::Packet&) {
+        ++num_output_frames;
+        return absl::OkStatus();
+      }));
+
+  const int width = absl::GetFlag(FLAGS_frame_width);
+  const int height = absl::GetFlag(FLAGS_frame_height);
+  std::vector<mediapipe::Packet> frames;
+  for (int i = 0; i < kNumDistinctFrames; ++i) {
+    frames.push_back(MakeSyntheticFrame(i, width, height));
+  }
+
+  LOG(INFO) << "Start running the calculator graph.";
+  MP_RETURN_IF_ERROR(graph.StartRun({}));
+  const int num_frames = absl::GetFlag(FLAGS_num_frames);
+  for (int i = 0; i < num_frames; ++i) {
+    // Frames share their pixels with the synthetic frames, at 30 fps.
+    MP_RETURN_IF_ERROR(graph.AddPacketToInputStream(
+        kInputStream, frames[i % kNumDistinctFrames].At(
+                          mediapipe::Timestamp(int64{i} * 33333))));
+  }
+  MP_RETURN_IF_ERROR(graph.CloseInputStream(kInputStream));
+  MP_RETURN_IF_ERROR(graph.WaitUntilDone());
+  RET_CHECK_EQ(num_output_frames, num_frames);
+
+  mediapipe::CalculatorGraph::ThroughputStats stats =
+      graph.GetThroughputStats();
+  LOG(INFO) << "Processed " << stats.num_frames << " frames of " << width
+            << "x" << height << " in " << stats.run_time << ": "
+            << stats.frames_per_second << " frames/sec, max_queue_size "
+            << graph.GetMaxInputStreamQueueSize() << ".";
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  absl::Status run_status = RunBenchmark();
+  if (!run_status.ok()) {
+    LOG(ERROR) << "Failed to run the benchmark: " << run_status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
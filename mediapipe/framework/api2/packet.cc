@@ -4,12 +4,12 @@ namespace mediapipe {
 namespace api2 {
 
 PacketBase FromOldPacket(const mediapipe::Packet& op) {
-  return PacketBase(packet_internal::GetHolderShared(op)).At(op.Timestamp());
+  return PacketBase(packet_internal::GetHolderPtr(op)).At(op.Timestamp());
 }
 
 PacketBase FromOldPacket(mediapipe::Packet&& op) {
   Timestamp t = op.Timestamp();
-  return PacketBase(packet_internal::GetHolderShared(std::move(op))).At(t);
+  return PacketBase(packet_internal::GetHolderPtr(std::move(op))).At(t);
 }
 
 mediapipe::Packet ToOldPacket(const PacketBase& p) {
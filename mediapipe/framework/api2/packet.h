@@ -66,9 +66,7 @@ class PacketBase {
   operator mediapipe::Packet() const& { return ToOldPacket(*this); }
   operator mediapipe::Packet() && { return ToOldPacket(std::move(*this)); }
 
-  // Note: Consume is included for compatibility with the old Packet; however,
-  // it relies on shared_ptr.unique(), which is deprecated and is not guaranteed
-  // to give exact results.
+  // Note: Consume is included for compatibility with the old Packet.
   template <typename T>
   absl::StatusOr<std::unique_ptr<T>> Consume() {
     // Using the implementation in the old Packet for now.
@@ -76,15 +74,15 @@ class PacketBase {
         packet_internal::Create(std::move(payload_), timestamp_);
     auto result = old.Consume<T>();
     if (!result.ok())
-      payload_ = packet_internal::GetHolderShared(std::move(old));
+      payload_ = packet_internal::GetHolderPtr(std::move(old));
     return result;
   }
 
  protected:
-  explicit PacketBase(std::shared_ptr<HolderBase> payload)
+  explicit PacketBase(packet_internal::HolderPtr payload)
       : payload_(std::move(payload)) {}
 
-  std::shared_ptr<HolderBase> payload_;
+  packet_internal::HolderPtr payload_;
   Timestamp timestamp_;
 
   template <typename T>
@@ -193,7 +191,7 @@ class Packet<internal::Generic> : public PacketBase {
   Packet<internal::Generic> At(Timestamp timestamp) &&;
 
  protected:
-  explicit Packet(std::shared_ptr<HolderBase> payload)
+  explicit Packet(packet_internal::HolderPtr payload)
       : PacketBase(std::move(payload)) {}
 
   friend PacketBase;
@@ -224,15 +222,13 @@ class Packet : public Packet<internal::Generic> {
     return IsEmpty() ? static_cast<T>(absl::forward<U>(v)) : **this;
   }
 
-  // Note: Consume is included for compatibility with the old Packet; however,
-  // it relies on shared_ptr.unique(), which is deprecated and is not guaranteed
-  // to give exact results.
+  // Note: Consume is included for compatibility with the old Packet.
   absl::StatusOr<std::unique_ptr<T>> Consume() {
     return PacketBase::Consume<T>();
   }
 
  private:
-  explicit Packet(std::shared_ptr<HolderBase> payload)
+  explicit Packet(packet_internal::HolderPtr payload)
       : Packet<internal::Generic>(std::move(payload)) {}
 
   friend PacketBase;
@@ -354,9 +350,7 @@ class Packet<OneOf<T...>> : public PacketBase {
     return Invoke<decltype(f), T...>(f);
   }
 
-  // Note: Consume is included for compatibility with the old Packet; however,
-  // it relies on shared_ptr.unique(), which is deprecated and is not guaranteed
-  // to give exact results.
+  // Note: Consume is included for compatibility with the old Packet.
   template <class U, class = AllowedType<U>>
   absl::StatusOr<std::unique_ptr<U>> Consume() {
     return PacketBase::Consume<U>();
@@ -379,7 +373,7 @@ class Packet<OneOf<T...>> : public PacketBase {
   }
 
  protected:
-  explicit Packet(std::shared_ptr<HolderBase> payload)
+  explicit Packet(packet_internal::HolderPtr payload)
       : PacketBase(std::move(payload)) {}
 
   friend PacketBase;
@@ -450,18 +444,20 @@ inline Packet<internal::Generic> Packet<internal::Generic>::At(
 
 template <typename T, typename... Args>
 Packet<T> MakePacket(Args&&... args) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(
-      new T(std::forward<Args>(args)...)));
+  return Packet<T>(packet_internal::HolderPtr(
+      packet_internal::NewPayloadHolder<T>(std::forward<Args>(args)...)));
 }
 
 template <typename T>
 Packet<T> PacketAdopting(const T* ptr) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(ptr));
+  return Packet<T>(packet_internal::HolderPtr(
+      packet_internal::NewHolder<packet_internal::Holder<T>>(ptr)));
 }
 
 template <typename T>
 Packet<T> PacketAdopting(std::unique_ptr<T> ptr) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(ptr.release()));
+  return Packet<T>(packet_internal::HolderPtr(
+      packet_internal::NewHolder<packet_internal::Holder<T>>(ptr.release())));
 }
 
 }  // namespace api2
@@ -138,6 +138,31 @@ class CalculatorContract {
   void SetTimestampOffset(TimestampDiff offset) { timestamp_offset_ = offset; }
   TimestampDiff GetTimestampOffset() const { return timestamp_offset_; }
 
+  // Declares that Process can run for several input timestamps at once,
+  // because the calculator keeps no state between Process calls, so that a
+  // graph may set max_in_flight above 1 for the node.  The framework then
+  // runs each Process call with its own CalculatorContext, and the output
+  // stream handler emits their outputs in timestamp order.  Open and Close
+  // still run alone.  The default max_in_flight stays 1, except in
+  // CalculatorGraphConfig.throughput_mode, where it is one per CPU core.
+  // Ignored for source calculators.
+  void SetProcessReentrant(bool process_reentrant) {
+    process_reentrant_ = process_reentrant;
+  }
+  bool GetProcessReentrant() const { return process_reentrant_; }
+
+  // Declares that Process does nothing for an input set without packets, so
+  // that with SetProcessTimestampBounds(true) a timestamp bound update only
+  // moves the output timestamp bounds by the timestamp offset.  The framework
+  // then skips these Process calls and propagates the bound while scheduling
+  // the node, so a bound crosses a chain of such calculators in one step
+  // instead of one scheduled Process call per node.  Only applies to nodes
+  // that run one Process call at a time.
+  void SetPureOffsetPropagation(bool pure_offset_propagation) {
+    pure_offset_propagation_ = pure_offset_propagation;
+  }
+  bool GetPureOffsetPropagation() const { return pure_offset_propagation_; }
+
   class GraphServiceRequest {
    public:
     // APIs that should be used by calculators.
@@ -210,6 +235,8 @@ class CalculatorContract {
   ServiceReqMap service_requests_;
   bool process_timestamps_ = false;
   TimestampDiff timestamp_offset_ = TimestampDiff::Unset();
+  bool process_reentrant_ = false;
+  bool pure_offset_propagation_ = false;
 
   friend class CalculatorNode;
 };
@@ -33,6 +33,8 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/counter_factory.h"
@@ -40,6 +42,7 @@
 #include "mediapipe/framework/graph_service_manager.h"
 #include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/packet_generator.h"
 #include "mediapipe/framework/packet_generator.pb.h"
 #include "mediapipe/framework/packet_set.h"
@@ -173,7 +176,8 @@ absl::Status CalculatorGraph::InitializeStreams() {
        ++index) {
     const EdgeInfo& edge_info = validated_graph_->InputStreamInfos()[index];
     MP_RETURN_IF_ERROR(input_stream_managers_[index].Initialize(
-        edge_info.name, edge_info.packet_type, edge_info.back_edge));
+        edge_info.name, edge_info.packet_type, edge_info.back_edge,
+        edge_info.single_producer_single_consumer));
   }
 
   // Create and initialize the output streams.
@@ -236,7 +240,16 @@ static void MaybeFixupLegacyGpuNodeContract(CalculatorNode& node) {
 absl::Status CalculatorGraph::InitializeCalculatorNodes() {
   // Check if the user has specified a maximum queue size for an input stream.
   max_queue_size_ = validated_graph_->Config().max_queue_size();
+  const bool size_queues_for_throughput =
+      max_queue_size_ == 0 && validated_graph_->Config().throughput_mode();
   max_queue_size_ = max_queue_size_ ? max_queue_size_ : 100;
+  int total_max_in_flight = 0;
+  if (validated_graph_->Config().use_packet_arena()) {
+    scheduler_.SetPacketArena(PacketArena::Create());
+  }
+  scheduler_.SetOldestTimestampFirst(
+      validated_graph_->Config().scheduling_policy() ==
+      CalculatorGraphConfig::OLDEST_TIMESTAMP_FIRST);
 
   // Use a local variable to avoid needing to lock errors_.
   std::vector<absl::Status> errors;
@@ -257,6 +270,7 @@ absl::Status CalculatorGraph::InitializeCalculatorNodes() {
     if (buffer_size_hint > 0) {
       max_queue_size_ = std::max(max_queue_size_, buffer_size_hint);
     }
+    total_max_in_flight += nodes_.back()->max_in_flight();
     if (!result.ok()) {
       // Collect as many errors as we can before failing.
       errors.push_back(result);
@@ -266,6 +280,10 @@ absl::Status CalculatorGraph::InitializeCalculatorNodes() {
     return tool::CombinedStatus(
         "CalculatorGraph::InitializeCalculatorNodes failed: ", errors);
   }
+  if (size_queues_for_throughput) {
+    // Enough room for every invocation the graph can run at once.
+    max_queue_size_ = std::max(max_queue_size_, total_max_in_flight);
+  }
 
   VLOG(2) << "Maximum input stream queue size based on graph config: "
           << max_queue_size_;
@@ -474,7 +492,8 @@ absl::Status CalculatorGraph::ObserveOutputStream(
 }
 
 absl::StatusOr<OutputStreamPoller> CalculatorGraph::AddOutputStreamPoller(
-    const std::string& stream_name, bool observe_timestamp_bounds) {
+    const std::string& stream_name, bool observe_timestamp_bounds,
+    bool single_consumer) {
   RET_CHECK(initialized_).SetNoLogging()
       << "CalculatorGraph is not initialized.";
   int output_stream_index = validated_graph_->OutputStreamIndex(stream_name);
@@ -483,12 +502,20 @@ absl::StatusOr<OutputStreamPoller> CalculatorGraph::AddOutputStreamPoller(
            << "Unable to attach observer to output stream \"" << stream_name
            << "\" because it doesn't exist.";
   }
+  // Graph input streams are fed from arbitrary threads, and so are the
+  // outputs of calculators with several Process() calls in flight.
+  bool single_producer_single_consumer =
+      single_consumer &&
+      validated_graph_->NodeRunsSerially(
+          validated_graph_->OutputStreamInfos()[output_stream_index]
+              .parent_node);
   auto internal_poller = std::make_shared<internal::OutputStreamPollerImpl>();
   MP_RETURN_IF_ERROR(internal_poller->Initialize(
       stream_name, &any_packet_type_,
       std::bind(&CalculatorGraph::UpdateThrottledNodes, this,
                 std::placeholders::_1, std::placeholders::_2),
-      &output_stream_managers_[output_stream_index], observe_timestamp_bounds));
+      &output_stream_managers_[output_stream_index], observe_timestamp_bounds,
+      single_producer_single_consumer));
   OutputStreamPoller poller(internal_poller);
   graph_output_streams_.push_back(std::move(internal_poller));
   return std::move(poller);
@@ -544,6 +571,11 @@ absl::Status CalculatorGraph::StartRun(
     const std::map<std::string, Packet>& stream_headers) {
   RET_CHECK(initialized_).SetNoLogging()
       << "CalculatorGraph is not initialized.";
+  {
+    absl::MutexLock lock(&run_time_mutex_);
+    run_start_time_ = absl::Now();
+    run_end_time_ = absl::InfiniteFuture();
+  }
   MP_RETURN_IF_ERROR(PrepareForRun(extra_side_packets, stream_headers));
   MP_RETURN_IF_ERROR(profiler_->Start(executors_[""].get()));
   scheduler_.Start();
@@ -1112,6 +1144,28 @@ void CalculatorGraph::CallStatusHandlers(GraphRunState graph_run_state,
 
 int CalculatorGraph::GetMaxInputStreamQueueSize() { return max_queue_size_; }
 
+CalculatorGraph::ThroughputStats CalculatorGraph::GetThroughputStats() const {
+  ThroughputStats stats;
+  for (const auto& item : graph_input_streams_) {
+    stats.num_frames = std::max(stats.num_frames, item.second->NumPackets());
+  }
+  for (const auto& node : nodes_) {
+    stats.num_frames = std::max(stats.num_frames, node->NumSourceFrames());
+  }
+  {
+    absl::MutexLock lock(&run_time_mutex_);
+    if (run_start_time_ == absl::InfinitePast()) {
+      return stats;
+    }
+    stats.run_time = std::min(run_end_time_, absl::Now()) - run_start_time_;
+  }
+  if (stats.run_time > absl::ZeroDuration()) {
+    stats.frames_per_second =
+        stats.num_frames / absl::ToDoubleSeconds(stats.run_time);
+  }
+  return stats;
+}
+
 void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
                                            bool* stream_was_full) {
   // TODO Change the throttling code to use the index directly
@@ -1328,6 +1382,16 @@ void CalculatorGraph::CleanupAfterRun(absl::Status* status) {
   for (auto& item : graph_input_streams_) {
     item.second->Close();
   }
+  {
+    absl::MutexLock lock(&run_time_mutex_);
+    run_end_time_ = absl::Now();
+  }
+  if (Config().throughput_mode() && VLOG_IS_ON(1)) {
+    ThroughputStats stats = GetThroughputStats();
+    VLOG(1) << "Graph run processed " << stats.num_frames << " frames in "
+            << stats.run_time << ": " << stats.frames_per_second
+            << " frames/sec.";
+  }
 
   CallStatusHandlers(GraphRunState::POST_RUN, *status);
   if (has_error_) {
@@ -31,6 +31,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_node.h"
@@ -164,8 +165,13 @@ class CalculatorGraph {
   // polling API for accessing a stream's output. Should only be called before
   // Run() or StartRun(). For asynchronous output, use ObserveOutputStream. See
   // also the helpers in tool/sink.h.
+  //
+  // If single_consumer is true, the caller promises to poll from one thread
+  // at a time. Packets are then handed to the poller through a lock-free queue
+  // when the stream is produced by a calculator that runs serially.
   StatusOrPoller AddOutputStreamPoller(const std::string& stream_name,
-                                       bool observe_timestamp_bounds = false);
+                                       bool observe_timestamp_bounds = false,
+                                       bool single_consumer = false);
 
   // Gets output side packet by name. The output side packet can be successfully
   // retrevied in one of the following situations:
@@ -323,6 +329,23 @@ class CalculatorGraph {
   // Returns the maximum input stream queue size.
   int GetMaxInputStreamQueueSize();
 
+  // The frame rate of a graph run.
+  struct ThroughputStats {
+    // The number of frames that entered the graph, counted on the graph input
+    // stream or source calculator that produced the most packets.
+    int64 num_frames = 0;
+    // The time from StartRun to the end of the run, or until now if the graph
+    // is still running.
+    absl::Duration run_time;
+    // num_frames divided by run_time.
+    double frames_per_second = 0;
+  };
+
+  // Returns the frame rate of the current or last graph run. If
+  // throughput_mode is set, it is also logged at VLOG level 1 at the end of
+  // each run.
+  ThroughputStats GetThroughputStats() const;
+
   // Get the mode for adding packets to an input stream.
   GraphInputStreamAddMode GetGraphInputStreamAddMode() const;
 
@@ -470,6 +493,7 @@ class CalculatorGraph {
 
     void PrepareForRun(std::function<void(absl::Status)> error_callback) {
       manager_->PrepareForRun(std::move(error_callback));
+      num_packets_ = 0;
     }
 
     void SetMaxQueueSize(int max_queue_size) {
@@ -478,9 +502,18 @@ class CalculatorGraph {
 
     void SetHeader(const Packet& header);
 
-    void AddPacket(const Packet& packet) { shard_.AddPacket(packet); }
+    void AddPacket(const Packet& packet) {
+      shard_.AddPacket(packet);
+      num_packets_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void AddPacket(Packet&& packet) {
+      shard_.AddPacket(std::move(packet));
+      num_packets_.fetch_add(1, std::memory_order_relaxed);
+    }
 
-    void AddPacket(Packet&& packet) { shard_.AddPacket(std::move(packet)); }
+    // Returns the number of packets added since PrepareForRun.
+    int64 NumPackets() const { return num_packets_.load(); }
 
     void SetNextTimestampBound(Timestamp timestamp);
 
@@ -495,6 +528,7 @@ class CalculatorGraph {
    private:
     OutputStreamManager* manager_ = nullptr;
     OutputStreamShard shard_;
+    std::atomic<int64> num_packets_{0};
   };
 
   // Initializes the graph from a ValidatedGraphConfig object.
@@ -635,6 +669,13 @@ class CalculatorGraph {
   // restrict memory usage.
   int max_queue_size_ = -1;
 
+  // The start and end of the current or last run, for GetThroughputStats.
+  mutable absl::Mutex run_time_mutex_;
+  absl::Time run_start_time_ ABSL_GUARDED_BY(run_time_mutex_) =
+      absl::InfinitePast();
+  absl::Time run_end_time_ ABSL_GUARDED_BY(run_time_mutex_) =
+      absl::InfinitePast();
+
   // Mode for adding packets to a graph input stream. Set to block until all
   // affected input streams are not full by default.
   GraphInputStreamAddMode graph_input_stream_add_mode_
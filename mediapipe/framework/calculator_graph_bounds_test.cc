@@ -12,8 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
+#include <string>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -1777,5 +1780,109 @@ TEST(CalculatorGraphBoundsTest, TimestampBoundsForInfrequentInput) {
   MP_ASSERT_OK(graph.WaitUntilDone());
 }
 
+// A Calculator that relays packets, and relays timestamp bounds through its
+// timestamp offset.  It counts its Process calls.
+class OffsetPassthroughCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    cc->SetProcessTimestampBounds(true);
+    cc->SetTimestampOffset(TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    ++num_process_calls;
+    if (!cc->Inputs().Index(0).IsEmpty()) {
+      cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    }
+    return absl::OkStatus();
+  }
+
+  static std::atomic<int> num_process_calls;
+};
+std::atomic<int> OffsetPassthroughCalculator::num_process_calls(0);
+REGISTER_CALCULATOR(OffsetPassthroughCalculator);
+
+// An OffsetPassthroughCalculator that declares pure offset propagation.
+class PureOffsetPassthroughCalculator : public OffsetPassthroughCalculator {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    MP_RETURN_IF_ERROR(OffsetPassthroughCalculator::GetContract(cc));
+    cc->SetPureOffsetPropagation(true);
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(PureOffsetPassthroughCalculator);
+
+// Sends packets and timestamp bounds through a chain of calculators, and
+// returns the number of Process calls in the chain.
+int RunOffsetPassthroughChain(const std::string& calculator) {
+  constexpr int kChainLength = 4;
+  constexpr int kNumInputs = 5;
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  std::string stream = "input";
+  for (int i = 0; i < kChainLength; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator(calculator);
+    node->add_input_stream(stream);
+    stream = absl::StrCat("chain_", i);
+    node->add_output_stream(stream);
+  }
+  CalculatorGraphConfig::Node* node = config.add_node();
+  node->set_calculator("ProcessBoundToPacketCalculator");
+  node->add_input_stream(stream);
+  node->add_output_stream("output_ts");
+
+  CalculatorGraph graph;
+  std::vector<Packet> output_packets;
+  std::vector<Packet> output_ts_packets;
+  MP_EXPECT_OK(graph.Initialize(config));
+  MP_EXPECT_OK(graph.ObserveOutputStream(stream, [&](const Packet& p) {
+    output_packets.push_back(p);
+    return absl::OkStatus();
+  }));
+  MP_EXPECT_OK(graph.ObserveOutputStream("output_ts", [&](const Packet& p) {
+    output_ts_packets.push_back(p);
+    return absl::OkStatus();
+  }));
+  MP_EXPECT_OK(graph.StartRun({}));
+  OffsetPassthroughCalculator::num_process_calls = 0;
+
+  // Send a packet at {0, 10, 20, ...} and a timestamp bound after each one.
+  std::vector<Timestamp> expected_ts;
+  for (int i = 0; i < kNumInputs; ++i) {
+    const int ts = i * 10;
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(kIntTestValue).At(Timestamp(ts))));
+    MP_EXPECT_OK(graph.WaitUntilIdle());
+    MP_EXPECT_OK(graph.SetInputStreamTimestampBound("input", Timestamp(ts + 6)));
+    MP_EXPECT_OK(graph.WaitUntilIdle());
+    expected_ts.push_back(Timestamp(ts));
+    expected_ts.push_back(Timestamp(ts + 5));
+  }
+
+  // Every packet and every timestamp bound crosses the chain.
+  EXPECT_EQ(output_packets.size(), kNumInputs);
+  EXPECT_EQ(GetContents<Timestamp>(output_ts_packets), expected_ts);
+  int num_process_calls = OffsetPassthroughCalculator::num_process_calls;
+
+  MP_EXPECT_OK(graph.CloseAllPacketSources());
+  MP_EXPECT_OK(graph.WaitUntilDone());
+  return num_process_calls;
+}
+
+// Shows that with SetPureOffsetPropagation(true), timestamp bounds cross a
+// chain of calculators without Process calls.
+TEST(CalculatorGraphBoundsTest, PureOffsetPropagation) {
+  // Each packet and each bound invoke Process on each calculator.
+  EXPECT_EQ(RunOffsetPassthroughChain("OffsetPassthroughCalculator"), 5 * 8);
+  // Only each packet invokes Process on each calculator.
+  EXPECT_EQ(RunOffsetPassthroughChain("PureOffsetPassthroughCalculator"),
+            5 * 4);
+}
+
 }  // namespace
 }  // namespace mediapipe
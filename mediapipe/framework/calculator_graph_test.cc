@@ -21,6 +21,7 @@
 #include <deque>
 #include <map>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -1573,6 +1574,47 @@ TEST(CalculatorGraph, RunsCorrectlyWithMultipleExecutors) {
   RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
 }
 
+TEST(CalculatorGraph, RunsCorrectlyWithWorkStealingExecutor) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  ExecutorConfig* executor = proto.add_executor();
+  executor->set_type("ThreadPoolExecutor");
+  ThreadPoolExecutorOptions* extension =
+      executor->mutable_options()->MutableExtension(
+          ThreadPoolExecutorOptions::ext);
+  extension->set_num_threads(4);
+  extension->set_task_queue_type(ThreadPoolExecutorOptions::WORK_STEALING);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, RunsCorrectlyWithPinnedExecutor) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  ExecutorConfig* executor = proto.add_executor();
+  executor->set_type("ThreadPoolExecutor");
+  ThreadPoolExecutorOptions* extension =
+      executor->mutable_options()->MutableExtension(
+          ThreadPoolExecutorOptions::ext);
+  extension->set_num_threads(2);
+  extension->add_cpu_id(0);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, NegativeNumaNodeIsRejected) {
+  CalculatorGraphConfig proto = GetConfig();
+  ExecutorConfig* executor = proto.add_executor();
+  executor->set_type("ThreadPoolExecutor");
+  ThreadPoolExecutorOptions* extension =
+      executor->mutable_options()->MutableExtension(
+          ThreadPoolExecutorOptions::ext);
+  extension->set_num_threads(2);
+  extension->set_numa_node(-1);
+  CalculatorGraph graph;
+  absl::Status status = graph.Initialize(proto);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), HasSubstr("numa_node"));
+}
+
 // Packet generator for an arbitrary unit64 packet.
 class Uint64PacketGenerator : public PacketGenerator {
  public:
@@ -4445,6 +4487,95 @@ TEST(CalculatorGraph, TestPollPacket) {
   EXPECT_EQ(kDefaultMaxCount, num_packets);
 }
 
+TEST(CalculatorGraph, TestPollPacketBatches) {
+  CalculatorGraphConfig config;
+  CalculatorGraphConfig::Node* node = config.add_node();
+  node->set_calculator("CountingSourceCalculator");
+  node->add_output_stream("output");
+  node->add_input_side_packet("MAX_COUNT:max_count");
+
+  for (bool single_consumer : {false, true}) {
+    CalculatorGraph graph;
+    MP_ASSERT_OK(graph.Initialize(config));
+    auto status_or_poller = graph.AddOutputStreamPoller(
+        "output", /*observe_timestamp_bounds=*/false, single_consumer);
+    ASSERT_TRUE(status_or_poller.ok());
+    OutputStreamPoller poller = std::move(status_or_poller.value());
+    MP_ASSERT_OK(
+        graph.StartRun({{"max_count", MakePacket<int>(kDefaultMaxCount)}}));
+    std::vector<Packet> packets;
+    packets.reserve(16);
+    int num_packets = 0;
+    while (poller.NextBatch(&packets, 16)) {
+      ASSERT_FALSE(packets.empty());
+      EXPECT_LE(packets.size(), 16);
+      EXPECT_EQ(16, packets.capacity());
+      for (const Packet& packet : packets) {
+        EXPECT_EQ(num_packets, packet.Get<int>());
+        ++num_packets;
+      }
+    }
+    EXPECT_TRUE(packets.empty());
+    MP_ASSERT_OK(graph.CloseAllPacketSources());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+    EXPECT_FALSE(poller.NextBatch(&packets, 16));
+    EXPECT_EQ(kDefaultMaxCount, num_packets);
+  }
+}
+
+// Polls a stream while another thread adds packets to the graph, so that the
+// poller often waits on an empty queue as packets arrive. A lost wakeup hangs
+// the test.
+TEST(CalculatorGraph, PollerStressTest) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "input"
+          output_stream: "output"
+        }
+      )pb");
+  constexpr int kNumPackets = 10000;
+  for (bool use_next_batch : {false, true}) {
+    for (bool single_consumer : {false, true}) {
+      CalculatorGraph graph;
+      MP_ASSERT_OK(graph.Initialize(config));
+      auto status_or_poller = graph.AddOutputStreamPoller(
+          "output", /*observe_timestamp_bounds=*/false, single_consumer);
+      ASSERT_TRUE(status_or_poller.ok());
+      OutputStreamPoller poller = std::move(status_or_poller.value());
+      MP_ASSERT_OK(graph.StartRun({}));
+      std::thread producer([&graph] {
+        for (int i = 0; i < kNumPackets; ++i) {
+          MP_EXPECT_OK(graph.AddPacketToInputStream(
+              "input", MakePacket<int>(i).At(Timestamp(i))));
+        }
+        MP_EXPECT_OK(graph.CloseInputStream("input"));
+      });
+      int num_packets = 0;
+      if (use_next_batch) {
+        std::vector<Packet> packets;
+        while (poller.NextBatch(&packets, 8)) {
+          for (const Packet& packet : packets) {
+            EXPECT_EQ(num_packets, packet.Get<int>());
+            ++num_packets;
+          }
+        }
+      } else {
+        Packet packet;
+        while (poller.Next(&packet)) {
+          EXPECT_EQ(num_packets, packet.Get<int>());
+          ++num_packets;
+        }
+      }
+      producer.join();
+      MP_ASSERT_OK(graph.WaitUntilDone());
+      EXPECT_EQ(kNumPackets, num_packets);
+    }
+  }
+}
+
 TEST(CalculatorGraph, TestOutputStreamPollerDesiredQueueSize) {
   CalculatorGraphConfig config;
   CalculatorGraphConfig::Node* node = config.add_node();
@@ -4589,6 +4720,42 @@ TEST(CalculatorGraph, TestPollPacketsWithTimestampNotification) {
   EXPECT_EQ(101, values[2]);
 }
 
+TEST(CalculatorGraph, TestPollPacketBatchesWithTimestampNotification) {
+  CalculatorGraphConfig graph_config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        node { calculator: "TimestampBoundTestCalculator" output_stream: "foo" }
+      )pb");
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(graph_config));
+  auto status_or_poller = graph.AddOutputStreamPoller(
+      "foo", /*observe_timestamp_bounds=*/true, /*single_consumer=*/true);
+  ASSERT_TRUE(status_or_poller.ok());
+  OutputStreamPoller poller = std::move(status_or_poller.value());
+  std::vector<Packet> packets;
+  std::vector<int> timestamps;
+  std::vector<int> values;
+  MP_ASSERT_OK(graph.StartRun({}));
+  while (poller.NextBatch(&packets, 4)) {
+    for (const Packet& packet : packets) {
+      if (packet.IsEmpty()) {
+        timestamps.push_back(packet.Timestamp().Value());
+      } else {
+        values.push_back(packet.Get<int>());
+      }
+    }
+  }
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_FALSE(poller.NextBatch(&packets, 4));
+  ASSERT_FALSE(timestamps.empty());
+  int prev_t = 0;
+  for (auto t : timestamps) {
+    EXPECT_TRUE(t > prev_t && t < 110);
+    prev_t = t;
+  }
+  EXPECT_THAT(values, testing::ElementsAre(1, 51, 101));
+}
+
 // Ensure that when a custom input stream handler is used to handle packets from
 // input streams, an error message is outputted with the appropriate link to
 // resolve the issue when the calculator doesn't handle inputs in monotonically
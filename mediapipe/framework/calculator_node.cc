@@ -133,6 +133,7 @@ absl::Status CalculatorNode::Initialize(
     node_config = &validated_graph_->Config().node(node_ref.index);
     name_ = tool::CanonicalNodeName(validated_graph_->Config(), node_ref.index);
     node_type_info_ = &validated_graph_->CalculatorInfos()[node_ref.index];
+    fused_producer_id_ = validated_graph_->FusedProducer(node_ref.index);
   } else if (node_ref.type == NodeTypeInfo::NodeType::PACKET_GENERATOR) {
     const PacketGeneratorConfig& pg_config =
         validated_graph_->Config().packet_generator(node_ref.index);
@@ -145,15 +146,15 @@ absl::Status CalculatorNode::Initialize(
         "node_ref is not a calculator or packet generator");
   }
 
-  max_in_flight_ = node_config->max_in_flight();
-  max_in_flight_ = max_in_flight_ ? max_in_flight_ : 1;
+  const CalculatorContract& contract = node_type_info_->Contract();
+
+  max_in_flight_ =
+      validated_graph_->MaxInFlight(*node_config, *node_type_info_);
   if (!node_config->executor().empty()) {
     executor_ = node_config->executor();
   }
   source_layer_ = node_config->source_layer();
 
-  const CalculatorContract& contract = node_type_info_->Contract();
-
   // TODO Propagate types between calculators when SetAny is used.
 
   MP_RETURN_IF_ERROR(InitializeOutputSidePackets(
@@ -208,6 +209,8 @@ absl::Status CalculatorNode::Initialize(
   }
   input_stream_handler_->SetProcessTimestampBounds(
       contract.GetProcessTimestampBounds());
+  input_stream_handler_->SetPureOffsetPropagation(
+      contract.GetPureOffsetPropagation());
 
   return InitializeInputStreams(input_stream_managers, output_stream_managers);
 }
@@ -382,6 +385,7 @@ absl::Status CalculatorNode::PrepareForRun(
   RET_CHECK(schedule_callback) << "schedule_callback is NULL";
   RET_CHECK(error_callback) << "error_callback is NULL";
   calculator_state_->ResetBetweenRuns();
+  num_source_frames_ = 0;
 
   ready_for_open_callback_ = std::move(ready_for_open_callback);
   source_node_opened_callback_ = std::move(source_node_opened_callback);
@@ -818,7 +822,9 @@ absl::Status CalculatorNode::ProcessNode(
     }
 
     bool node_stopped = false;
-    if (!result.ok()) {
+    if (result.ok()) {
+      num_source_frames_.fetch_add(1, std::memory_order_relaxed);
+    } else {
       if (result == tool::StatusStop()) {
         // Needs to call CloseNode().
         node_stopped = true;
@@ -20,6 +20,7 @@
 
 #include <stddef.h>
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -162,6 +163,17 @@ class CalculatorNode {
 
   int source_layer() const { return source_layer_; }
 
+  // Returns the max number of invocations that can be scheduled in parallel.
+  int max_in_flight() const { return max_in_flight_; }
+
+  // Returns the id of the node after which this node runs inline, on the same
+  // thread, or -1 if this node is not fused with its producer.
+  int fused_producer_id() const { return fused_producer_id_; }
+
+  // Returns the number of successful Process calls of a source node in the
+  // current or last run.
+  int64 NumSourceFrames() const { return num_source_frames_.load(); }
+
   // Checks if the node can be scheduled; if so, increases current_in_flight_
   // and returns true; otherwise, returns false.
   // If true is returned, the scheduler must commit to executing the node, and
@@ -310,6 +322,10 @@ class CalculatorNode {
 
   // The max number of invocations that can be scheduled in parallel.
   int max_in_flight_ = 1;
+  // The id of the node after which this node runs inline, or -1.
+  int fused_producer_id_ = -1;
+  // The number of successful Process calls of a source node.
+  std::atomic<int64> num_source_frames_{0};
   // The following two variables are used for the concurrency control of node
   // scheduling.
   //
@@ -19,22 +19,29 @@
 //
 // TODO: Add more tests to verify the correctness of parallel execution.
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
@@ -77,6 +84,103 @@ class SlowPlusOneCalculator : public CalculatorBase {
 
 REGISTER_CALCULATOR(SlowPlusOneCalculator);
 
+// A calculator that does almost no work, so that running a graph of these
+// mostly measures the cost of scheduling.
+class PlusOneCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(mediapipe::TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(cc->Inputs().Index(0).Get<int>() + 1)
+            .At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+
+REGISTER_CALCULATOR(PlusOneCalculator);
+
+// Like PlusOneCalculator, but busy for 20 microseconds in each Process call.
+class BusyPlusOneCalculator : public PlusOneCalculator {
+ public:
+  absl::Status Process(CalculatorContext* cc) override {
+    BusySleep(absl::Microseconds(20));
+    return PlusOneCalculator::Process(cc);
+  }
+};
+
+REGISTER_CALCULATOR(BusyPlusOneCalculator);
+
+// A calculator that declares Process reentrant, and counts how many Process
+// calls overlap. Negative inputs produce no output, only a timestamp bound.
+class ReentrantSlowPlusOneCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->SetTimestampOffset(0);
+    cc->SetProcessReentrant(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    int active = active_.fetch_add(1) + 1;
+    int max_active = max_active_.load();
+    while (active > max_active &&
+           !max_active_.compare_exchange_weak(max_active, active)) {
+    }
+    // Later timestamps finish sooner, to exercise output reordering.
+    BusySleep(absl::Milliseconds(20 - cc->InputTimestamp().Value() % 10));
+    active_.fetch_sub(1);
+    const int input = cc->Inputs().Index(0).Get<int>();
+    if (input >= 0) {
+      cc->Outputs().Index(0).Add(new int(input + 1), cc->InputTimestamp());
+    }
+    return absl::OkStatus();
+  }
+
+  static std::atomic<int> max_active_;
+
+ private:
+  std::atomic<int> active_{0};
+};
+std::atomic<int> ReentrantSlowPlusOneCalculator::max_active_{0};
+
+REGISTER_CALCULATOR(ReentrantSlowPlusOneCalculator);
+
+// Returns a graph in which the input stream fans out to |num_branches| chains
+// of |chain_length| calculators. The output of branch i is "out_i".
+CalculatorGraphConfig ManyCheapNodesConfig(
+    int num_branches, int chain_length, int num_threads,
+    const std::string& calculator = "PlusOneCalculator") {
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  config.set_num_threads(num_threads);
+  for (int b = 0; b < num_branches; ++b) {
+    std::string input = "input";
+    for (int i = 0; i < chain_length; ++i) {
+      std::string output = i + 1 == chain_length
+                               ? absl::StrCat("out_", b)
+                               : absl::StrCat("branch_", b, "_", i);
+      CalculatorGraphConfig::Node* node = config.add_node();
+      node->set_calculator(calculator);
+      node->add_input_stream(input);
+      node->add_output_stream(output);
+      input = output;
+    }
+  }
+  return config;
+}
+
 class ParallelExecutionTest : public testing::Test {
  public:
   void AddThreadSafeVectorSink(const Packet& packet) {
@@ -153,5 +257,410 @@ TEST_F(ParallelExecutionTest, SlowPlusOneCalculatorsTest) {
   }
 }
 
+// A reentrant calculator runs one timestamp at a time by default, and several
+// in parallel when max_in_flight allows it. Its outputs stay in timestamp
+// order either way.
+TEST_F(ParallelExecutionTest, ReentrantCalculatorTest) {
+  for (int max_in_flight : {0, 4}) {
+    CalculatorGraphConfig graph_config =
+        mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+          input_stream: "input"
+          node {
+            calculator: "ReentrantSlowPlusOneCalculator"
+            input_stream: "input"
+            output_stream: "output"
+          }
+          num_threads: 4
+        )pb");
+    graph_config.mutable_node(0)->set_max_in_flight(max_in_flight);
+    ReentrantSlowPlusOneCalculator::max_active_ = 0;
+    CalculatorGraph graph(graph_config);
+    std::vector<Packet> outputs;
+    MP_ASSERT_OK(
+        graph.ObserveOutputStream("output", [&](const Packet& packet) {
+          outputs.push_back(packet);
+          return absl::OkStatus();
+        }));
+    MP_ASSERT_OK(graph.StartRun({}));
+    constexpr int kTotalNums = 40;
+    for (int i = 0; i < kTotalNums; ++i) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MP_ASSERT_OK(graph.CloseAllInputStreams());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+
+    ASSERT_EQ(kTotalNums, outputs.size());
+    for (int i = 0; i < kTotalNums; ++i) {
+      EXPECT_EQ(i + 1, outputs[i].Get<int>());
+      EXPECT_EQ(Timestamp(i), outputs[i].Timestamp());
+    }
+    if (max_in_flight == 0) {
+      EXPECT_EQ(1, ReentrantSlowPlusOneCalculator::max_active_.load());
+    } else {
+      EXPECT_GT(ReentrantSlowPlusOneCalculator::max_active_.load(), 1);
+    }
+  }
+}
+
+// Runs hundreds of cheap nodes on many threads, which stresses concurrent
+// access to the scheduler queue.
+TEST_F(ParallelExecutionTest, ManyCheapNodesTest) {
+  constexpr int kNumBranches = 100;
+  constexpr int kChainLength = 3;
+  constexpr int kTotalNums = 50;
+  CalculatorGraph graph(
+      ManyCheapNodesConfig(kNumBranches, kChainLength, /*num_threads=*/8));
+  std::vector<std::vector<Packet>> outputs(kNumBranches);
+  for (int b = 0; b < kNumBranches; ++b) {
+    MP_ASSERT_OK(graph.ObserveOutputStream(
+        absl::StrCat("out_", b), [&outputs, b](const Packet& packet) {
+          outputs[b].push_back(packet);
+          return absl::OkStatus();
+        }));
+  }
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < kTotalNums; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  for (int b = 0; b < kNumBranches; ++b) {
+    ASSERT_EQ(kTotalNums, outputs[b].size());
+    for (int i = 0; i < kTotalNums; ++i) {
+      EXPECT_EQ(i + kChainLength, outputs[b][i].Get<int>());
+      EXPECT_EQ(Timestamp(i), outputs[b][i].Timestamp());
+    }
+  }
+}
+
+// Runs the same graph with the OLDEST_TIMESTAMP_FIRST scheduling policy.
+TEST_F(ParallelExecutionTest, OldestTimestampFirstTest) {
+  constexpr int kNumBranches = 20;
+  constexpr int kChainLength = 3;
+  constexpr int kTotalNums = 50;
+  CalculatorGraphConfig config =
+      ManyCheapNodesConfig(kNumBranches, kChainLength, /*num_threads=*/4);
+  config.set_scheduling_policy(CalculatorGraphConfig::OLDEST_TIMESTAMP_FIRST);
+  CalculatorGraph graph(config);
+  std::vector<std::vector<Packet>> outputs(kNumBranches);
+  for (int b = 0; b < kNumBranches; ++b) {
+    MP_ASSERT_OK(graph.ObserveOutputStream(
+        absl::StrCat("out_", b), [&outputs, b](const Packet& packet) {
+          outputs[b].push_back(packet);
+          return absl::OkStatus();
+        }));
+  }
+  // Runs the graph twice, to check that the queue is reset between runs.
+  for (int run = 0; run < 2; ++run) {
+    MP_ASSERT_OK(graph.StartRun({}));
+    for (int i = 0; i < kTotalNums; ++i) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MP_ASSERT_OK(graph.CloseAllInputStreams());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+
+    for (int b = 0; b < kNumBranches; ++b) {
+      ASSERT_EQ(kTotalNums, outputs[b].size());
+      for (int i = 0; i < kTotalNums; ++i) {
+        EXPECT_EQ(i + kChainLength, outputs[b][i].Get<int>());
+        EXPECT_EQ(Timestamp(i), outputs[b][i].Timestamp());
+      }
+      outputs[b].clear();
+    }
+  }
+}
+
+// In throughput mode, queues hold as many packets as the graph can process at
+// once, and the graph reports its frame rate.
+TEST_F(ParallelExecutionTest, ThroughputModeTest) {
+  constexpr int kNumBranches = 2;
+  constexpr int kChainLength = 3;
+  constexpr int kTotalNums = 50;
+  CalculatorGraphConfig config =
+      ManyCheapNodesConfig(kNumBranches, kChainLength, /*num_threads=*/4);
+  config.set_throughput_mode(true);
+  config.mutable_node(0)->set_max_in_flight(4);
+  CalculatorGraph graph(config);
+  // The 9 invocations that can run at once fit in the default queue size.
+  EXPECT_EQ(100, graph.GetMaxInputStreamQueueSize());
+  EXPECT_EQ(0, graph.GetThroughputStats().num_frames);
+  // One node runs 200 invocations at once, and the other 5 nodes run one
+  // each.
+  config.mutable_node(0)->set_max_in_flight(200);
+  EXPECT_EQ(205, CalculatorGraph(config).GetMaxInputStreamQueueSize());
+
+  std::vector<std::vector<Packet>> outputs(kNumBranches);
+  for (int b = 0; b < kNumBranches; ++b) {
+    MP_ASSERT_OK(graph.ObserveOutputStream(
+        absl::StrCat("out_", b), [&outputs, b](const Packet& packet) {
+          outputs[b].push_back(packet);
+          return absl::OkStatus();
+        }));
+  }
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < kTotalNums; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  for (int b = 0; b < kNumBranches; ++b) {
+    ASSERT_EQ(kTotalNums, outputs[b].size());
+    for (int i = 0; i < kTotalNums; ++i) {
+      EXPECT_EQ(i + kChainLength, outputs[b][i].Get<int>());
+    }
+  }
+  CalculatorGraph::ThroughputStats stats = graph.GetThroughputStats();
+  EXPECT_EQ(kTotalNums, stats.num_frames);
+  EXPECT_GT(stats.run_time, absl::ZeroDuration());
+  EXPECT_GT(stats.frames_per_second, 0);
+}
+
+// In throughput mode, a reentrant calculator runs several timestamps in
+// parallel without setting max_in_flight. Its outputs and timestamp bounds
+// still advance in timestamp order.
+TEST_F(ParallelExecutionTest, ThroughputModeReentrantCalculatorTest) {
+  CalculatorGraphConfig graph_config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input"
+        node {
+          calculator: "ReentrantSlowPlusOneCalculator"
+          input_stream: "input"
+          output_stream: "output"
+        }
+        num_threads: 4
+        throughput_mode: true
+      )pb");
+  ReentrantSlowPlusOneCalculator::max_active_ = 0;
+  CalculatorGraph graph(graph_config);
+  std::vector<Packet> outputs;
+  MP_ASSERT_OK(graph.ObserveOutputStream(
+      "output",
+      [&](const Packet& packet) {
+        outputs.push_back(packet);
+        return absl::OkStatus();
+      },
+      /*observe_timestamp_bounds=*/true));
+  MP_ASSERT_OK(graph.StartRun({}));
+  constexpr int kTotalNums = 40;
+  for (int i = 0; i < kTotalNums; ++i) {
+    // Every third input only advances the timestamp bound.
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i % 3 == 2 ? -1 : i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  std::vector<int64> packet_timestamps;
+  for (int i = 0; i < outputs.size(); ++i) {
+    if (i > 0) {
+      EXPECT_LT(outputs[i - 1].Timestamp(), outputs[i].Timestamp());
+    }
+    if (!outputs[i].IsEmpty()) {
+      EXPECT_EQ(outputs[i].Timestamp().Value() + 1, outputs[i].Get<int>());
+      packet_timestamps.push_back(outputs[i].Timestamp().Value());
+    }
+  }
+  std::vector<int64> expected_timestamps;
+  for (int i = 0; i < kTotalNums; ++i) {
+    if (i % 3 != 2) expected_timestamps.push_back(i);
+  }
+  EXPECT_EQ(expected_timestamps, packet_timestamps);
+  if (mediapipe::NumCPUCores() > 1) {
+    EXPECT_GT(ReentrantSlowPlusOneCalculator::max_active_.load(), 1);
+  }
+}
+
+// Measures the scheduling overhead of a graph with many cheap nodes.
+// Arguments: number of branches (with 3 nodes each), number of threads.
+void BM_ManyCheapNodes(benchmark::State& state) {
+  constexpr int kChainLength = 3;
+  constexpr int kPacketsPerIteration = 16;
+  const int num_branches = state.range(0);
+  CalculatorGraph graph(
+      ManyCheapNodesConfig(num_branches, kChainLength, state.range(1)));
+  std::atomic<int64> num_outputs(0);
+  for (int b = 0; b < num_branches; ++b) {
+    CHECK_OK(graph.ObserveOutputStream(
+        absl::StrCat("out_", b), [&num_outputs](const Packet& packet) {
+          num_outputs.fetch_add(1, std::memory_order_relaxed);
+          return absl::OkStatus();
+        }));
+  }
+  CHECK_OK(graph.StartRun({}));
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kPacketsPerIteration; ++i) {
+      CHECK_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(timestamp++))));
+    }
+    CHECK_OK(graph.WaitUntilIdle());
+  }
+  CHECK_OK(graph.CloseAllInputStreams());
+  CHECK_OK(graph.WaitUntilDone());
+  CHECK_EQ(num_outputs.load(), timestamp * num_branches);
+  // Each item is one Process call.
+  state.SetItemsProcessed(timestamp * num_branches * kChainLength);
+}
+BENCHMARK(BM_ManyCheapNodes)
+    ->Args({10, 1})
+    ->Args({10, 4})
+    ->Args({100, 1})
+    ->Args({100, 4})
+    ->Args({100, 16})
+    ->Args({300, 16})
+    ->UseRealTime();
+
+// Measures the end-to-end latency of each timestamp, from when it is added to
+// the graph to when every branch has output it, while packets arrive at about
+// 90% of the rate that the graph can sustain. Reports the p50 and p99
+// latencies in microseconds.
+// Argument: CalculatorGraphConfig::SchedulingPolicy.
+void BM_SchedulingPolicyLatency(benchmark::State& state) {
+  constexpr int kNumBranches = 8;
+  constexpr int kChainLength = 4;
+  constexpr int kNumThreads = 2;
+  constexpr int kPacketsPerIteration = 32;
+  // Each timestamp takes 8 * 4 * 20 = 640 usec of work, on 2 threads.
+  const absl::Duration kPacketInterval = absl::Microseconds(355);
+  CalculatorGraphConfig config = ManyCheapNodesConfig(
+      kNumBranches, kChainLength, kNumThreads, "BusyPlusOneCalculator");
+  config.set_scheduling_policy(
+      static_cast<CalculatorGraphConfig::SchedulingPolicy>(state.range(0)));
+  CalculatorGraph graph(config);
+
+  absl::Mutex mutex;
+  std::vector<absl::Time> input_times;
+  std::vector<int> outputs_left;
+  std::vector<int64> latencies_usec;
+  for (int b = 0; b < kNumBranches; ++b) {
+    CHECK_OK(graph.ObserveOutputStream(
+        absl::StrCat("out_", b), [&](const Packet& packet) {
+          absl::Time now = absl::Now();
+          absl::MutexLock lock(&mutex);
+          int64 t = packet.Timestamp().Value();
+          if (--outputs_left[t] == 0) {
+            latencies_usec.push_back(
+                absl::ToInt64Microseconds(now - input_times[t]));
+          }
+          return absl::OkStatus();
+        }));
+  }
+  CHECK_OK(graph.StartRun({}));
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    absl::Time next_input_time = absl::Now();
+    for (int i = 0; i < kPacketsPerIteration; ++i) {
+      while (absl::Now() < next_input_time) {
+      }
+      next_input_time += kPacketInterval;
+      {
+        absl::MutexLock lock(&mutex);
+        input_times.push_back(absl::Now());
+        outputs_left.push_back(kNumBranches);
+      }
+      CHECK_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(timestamp++))));
+    }
+    CHECK_OK(graph.WaitUntilIdle());
+  }
+  CHECK_OK(graph.CloseAllInputStreams());
+  CHECK_OK(graph.WaitUntilDone());
+
+  absl::MutexLock lock(&mutex);
+  CHECK_EQ(latencies_usec.size(), timestamp);
+  std::sort(latencies_usec.begin(), latencies_usec.end());
+  auto percentile = [&latencies_usec](double fraction) {
+    return latencies_usec.empty()
+               ? 0
+               : latencies_usec[static_cast<int>(fraction *
+                                                 (latencies_usec.size() - 1))];
+  };
+  state.counters["p50_usec"] = percentile(0.5);
+  state.counters["p99_usec"] = percentile(0.99);
+  state.SetItemsProcessed(timestamp);
+}
+BENCHMARK(BM_SchedulingPolicyLatency)
+    ->Arg(CalculatorGraphConfig::NODE_ORDER)
+    ->Arg(CalculatorGraphConfig::OLDEST_TIMESTAMP_FIRST)
+    ->UseRealTime();
+
+// The ways in which BM_DrainOutputStream consumes an output stream.
+enum DrainMode {
+  kObserverCallback = 0,
+  kPollerNext = 1,
+  kPollerNextBatch = 2,
+  kPollerNextBatchSingleConsumer = 3,
+};
+
+// Measures the cost of handing the packets of an output stream to the
+// application, through an observer callback or through an OutputStreamPoller
+// drained by a separate consumer thread.
+// Argument: DrainMode.
+void BM_DrainOutputStream(benchmark::State& state) {
+  constexpr int kPacketsPerIteration = 64;
+  constexpr int kMaxBatchSize = 64;
+  const DrainMode mode = static_cast<DrainMode>(state.range(0));
+  CalculatorGraph graph(
+      ManyCheapNodesConfig(/*num_branches=*/1, /*chain_length=*/1,
+                           /*num_threads=*/1));
+  std::atomic<int64> num_outputs(0);
+  absl::optional<OutputStreamPoller> poller;
+  if (mode == kObserverCallback) {
+    CHECK_OK(graph.ObserveOutputStream(
+        "out_0", [&num_outputs](const Packet& packet) {
+          num_outputs.fetch_add(1, std::memory_order_relaxed);
+          return absl::OkStatus();
+        }));
+  } else {
+    auto status_or_poller = graph.AddOutputStreamPoller(
+        "out_0", /*observe_timestamp_bounds=*/false,
+        /*single_consumer=*/mode == kPollerNextBatchSingleConsumer);
+    CHECK_OK(status_or_poller.status());
+    poller.emplace(std::move(status_or_poller.value()));
+  }
+  CHECK_OK(graph.StartRun({}));
+  std::thread consumer([&] {
+    if (mode == kPollerNext) {
+      Packet packet;
+      while (poller->Next(&packet)) {
+        num_outputs.fetch_add(1, std::memory_order_relaxed);
+      }
+    } else if (mode != kObserverCallback) {
+      std::vector<Packet> packets;
+      packets.reserve(kMaxBatchSize);
+      while (poller->NextBatch(&packets, kMaxBatchSize)) {
+        num_outputs.fetch_add(packets.size(), std::memory_order_relaxed);
+      }
+    }
+  });
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kPacketsPerIteration; ++i) {
+      CHECK_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(timestamp++))));
+    }
+    while (num_outputs.load(std::memory_order_relaxed) < timestamp) {
+      std::this_thread::yield();
+    }
+  }
+  CHECK_OK(graph.CloseAllInputStreams());
+  CHECK_OK(graph.WaitUntilDone());
+  consumer.join();
+  CHECK_EQ(num_outputs.load(), timestamp);
+  state.SetItemsProcessed(timestamp);
+}
+BENCHMARK(BM_DrainOutputStream)
+    ->Arg(kObserverCallback)
+    ->Arg(kPollerNext)
+    ->Arg(kPollerNextBatch)
+    ->Arg(kPollerNextBatchSingleConsumer)
+    ->UseRealTime();
+
 }  // namespace
 }  // namespace mediapipe
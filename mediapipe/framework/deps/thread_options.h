@@ -26,7 +26,7 @@ namespace mediapipe {
 // the field descriptions.
 class ThreadOptions {
  public:
-  ThreadOptions() : stack_size_(0), nice_priority_level_(0) {}
+  ThreadOptions() : stack_size_(0), nice_priority_level_(0), numa_node_(-1) {}
 
   // Set the thread stack size (in bytes).  Passing stack_size==0 resets
   // the stack size to the default value for the system. The system default
@@ -46,6 +46,14 @@ class ThreadOptions {
     return *this;
   }
 
+  // Set the NUMA node whose memory the thread should allocate from. Pages
+  // first touched by the thread are preferably placed on this node. Passing
+  // a negative value, the default, keeps the system memory policy.
+  ThreadOptions& set_numa_node(int numa_node) {
+    numa_node_ = numa_node;
+    return *this;
+  }
+
   ThreadOptions& set_name_prefix(const std::string& name_prefix) {
     name_prefix_ = name_prefix;
     return *this;
@@ -57,12 +65,15 @@ class ThreadOptions {
 
   const std::set<int>& cpu_set() const { return cpu_set_; }
 
+  int numa_node() const { return numa_node_; }
+
   std::string name_prefix() const { return name_prefix_; }
 
  private:
   size_t stack_size_;        // Size of thread stack
   int nice_priority_level_;  // Nice priority level of the workers
   std::set<int> cpu_set_;    // CPU set for affinity setting
+  int numa_node_;            // Preferred NUMA node for memory allocation
   std::string name_prefix_;  // Name of the thread
 };
 
@@ -18,6 +18,13 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 
+#include <climits>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#endif  // __linux__
+
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "mediapipe/framework/deps/threadpool.h"
@@ -60,6 +67,7 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
   int nice_priority_level =
       thread->pool_->thread_options().nice_priority_level();
   const std::set<int> selected_cpus = thread->pool_->thread_options().cpu_set();
+  const int numa_node = thread->pool_->thread_options().numa_node();
 #if defined(__linux__)
   const std::string name =
       internal::CreateThreadName(thread->name_prefix_, syscall(SYS_gettid));
@@ -89,6 +97,24 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
                     "affinity setting for now.";
     }
   }
+  if (numa_node >= 0) {
+    // Prefer the given node for the pages first touched by this thread, e.g.
+    // the buffers that calculators running on this thread allocate and fill.
+    constexpr int kBitsPerWord = sizeof(unsigned long) * CHAR_BIT;
+    std::vector<unsigned long> node_mask(numa_node / kBitsPerWord + 1, 0);
+    node_mask[numa_node / kBitsPerWord] = 1UL << (numa_node % kBitsPerWord);
+    // The kernel expects the number of bits in the mask plus one.
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, node_mask.data(),
+                node_mask.size() * kBitsPerWord + 1) != -1) {
+      VLOG(1) << "Set the preferred memory node of the thread pool executor "
+                 "to node "
+              << numa_node << ".";
+    } else {
+      LOG(ERROR) << "Error : " << strerror(errno) << std::endl
+                 << "Failed to set the preferred memory node. Ignore NUMA "
+                    "node setting for now.";
+    }
+  }
   int error = pthread_setname_np(pthread_self(), name.c_str());
   if (error != 0) {
     LOG(ERROR) << "Error : " << strerror(error) << std::endl
@@ -96,9 +122,9 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
   }
 #else
   const std::string name = internal::CreateThreadName(thread->name_prefix_, 0);
-  if (nice_priority_level != 0 || !selected_cpus.empty()) {
-    LOG(ERROR) << "Thread priority and processor affinity feature aren't "
-                  "supported on the current platform.";
+  if (nice_priority_level != 0 || !selected_cpus.empty() || numa_node >= 0) {
+    LOG(ERROR) << "Thread priority, processor affinity and NUMA node features "
+                  "aren't supported on the current platform.";
   }
 #if __APPLE__
   int error = pthread_setname_np(name.c_str());
@@ -66,9 +66,11 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
   int nice_priority_level =
       thread->pool_->thread_options().nice_priority_level();
   const std::set<int> selected_cpus = thread->pool_->thread_options().cpu_set();
-  if (nice_priority_level != 0 || !selected_cpus.empty()) {
-    LOG(ERROR) << "Thread priority and processor affinity feature aren't "
-                  "supported by the std::thread threadpool implementation.";
+  if (nice_priority_level != 0 || !selected_cpus.empty() ||
+      thread->pool_->thread_options().numa_node() >= 0) {
+    LOG(ERROR) << "Thread priority, processor affinity and NUMA node features "
+                  "aren't supported by the std::thread threadpool "
+                  "implementation.";
   }
   thread->pool_->RunWorker();
   return nullptr;
@@ -91,6 +91,14 @@ TEST(ThreadPoolTest, CreateWithCPUAffinity) {
   thread_pool.StartWorkers();
 }
 
+TEST(ThreadPoolTest, CreateWithNumaNode) {
+  ThreadOptions thread_options = ThreadOptions().set_numa_node(0);
+  ThreadPool thread_pool(thread_options, "testpool", 10);
+  ASSERT_EQ(10, thread_pool.num_threads());
+  ASSERT_EQ(0, thread_pool.thread_options().numa_node());
+  thread_pool.StartWorkers();
+}
+
 TEST(ThreadPoolTest, CreateThreadName) {
   ASSERT_EQ("name_prefix/123", internal::CreateThreadName("name_prefix", 1234));
   ASSERT_EQ("name_prefix/123",
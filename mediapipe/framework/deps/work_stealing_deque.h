@@ -0,0 +1,159 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_DEPS_WORK_STEALING_DEQUE_H_
+#define MEDIAPIPE_DEPS_WORK_STEALING_DEQUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mediapipe {
+
+// A lock-free, unbounded, single-owner work-stealing deque of pointers
+// (Chase & Lev, "Dynamic Circular Work-Stealing Deque"). The fences of the
+// C11 formulation by Le et al. are expressed as sequentially consistent
+// accesses, which costs the same on x86 and ARM and is understood by
+// ThreadSanitizer.
+//
+// The owner thread pushes and pops at the bottom (LIFO), any other thread may
+// steal from the top (FIFO). Push() and Pop() must only be called by the
+// owner thread. Steal() may be called concurrently from any thread.
+//
+// The deque does not own the pointed-to objects. Buffers that are replaced
+// when the deque grows are retained until the deque is destroyed, because a
+// concurrent thief may still be reading from them.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  explicit WorkStealingDeque(int64_t initial_capacity = 64)
+      : top_(0), bottom_(0) {
+    int64_t capacity = 1;
+    while (capacity < initial_capacity) capacity <<= 1;
+    auto buffer = std::make_unique<Buffer>(capacity);
+    buffer_.store(buffer.get(), std::memory_order_relaxed);
+    buffers_.push_back(std::move(buffer));
+  }
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  // Pushes an item at the bottom of the deque. Owner thread only.
+  void Push(T* item) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    if (bottom - top > buffer->capacity() - 1) {
+      buffer = Grow(buffer, top, bottom);
+    }
+    buffer->Put(bottom, item);
+    bottom_.store(bottom + 1, std::memory_order_release);
+  }
+
+  // Pops the most recently pushed item, or returns nullptr if the deque is
+  // empty. Owner thread only.
+  T* Pop() {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    // The store to bottom_ must be ordered before the load of top_, see
+    // Steal().
+    bottom_.store(bottom, std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_seq_cst);
+    T* item = nullptr;
+    if (top <= bottom) {
+      item = buffer->Get(bottom);
+      if (top == bottom) {
+        // Last item: race against thieves for it.
+        if (!top_.compare_exchange_strong(top, top + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+          item = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Steals the least recently pushed item. Returns nullptr if the deque is
+  // empty or if another thread won the race for the top item.
+  T* Steal() {
+    int64_t top = top_.load(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+    if (top >= bottom) return nullptr;
+    Buffer* buffer = buffer_.load(std::memory_order_acquire);
+    T* item = buffer->Get(top);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+  // Returns an estimate of the number of items in the deque.
+  int64_t SizeEstimate() const {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    return bottom > top ? bottom - top : 0;
+  }
+
+ private:
+  // A power-of-two circular array of atomic pointers.
+  class Buffer {
+   public:
+    explicit Buffer(int64_t capacity)
+        : capacity_(capacity),
+          mask_(capacity - 1),
+          items_(new std::atomic<T*>[capacity]) {}
+
+    int64_t capacity() const { return capacity_; }
+    T* Get(int64_t i) const {
+      return items_[i & mask_].load(std::memory_order_relaxed);
+    }
+    void Put(int64_t i, T* item) {
+      items_[i & mask_].store(item, std::memory_order_relaxed);
+    }
+
+   private:
+    const int64_t capacity_;
+    const int64_t mask_;
+    std::unique_ptr<std::atomic<T*>[]> items_;
+  };
+
+  // Replaces the buffer with one of twice the capacity. Owner thread only.
+  Buffer* Grow(Buffer* old_buffer, int64_t top, int64_t bottom) {
+    auto buffer = std::make_unique<Buffer>(old_buffer->capacity() * 2);
+    for (int64_t i = top; i < bottom; ++i) {
+      buffer->Put(i, old_buffer->Get(i));
+    }
+    Buffer* result = buffer.get();
+    buffers_.push_back(std::move(buffer));
+    buffer_.store(result, std::memory_order_release);
+    return result;
+  }
+
+  // top_ and bottom_ are written by different threads, so keep them on
+  // separate cache lines.
+  alignas(64) std::atomic<int64_t> top_;
+  alignas(64) std::atomic<int64_t> bottom_;
+  alignas(64) std::atomic<Buffer*> buffer_;
+  // All buffers ever allocated, including the current one. Owner thread only.
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_DEPS_WORK_STEALING_DEQUE_H_
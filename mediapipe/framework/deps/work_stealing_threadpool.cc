@@ -0,0 +1,187 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "absl/time/time.h"
+
+namespace mediapipe {
+
+namespace {
+
+// A worker that fails to find a task, although pending_tasks_ says there is
+// one, retries kSpinRounds times, then yields its core for kYieldRounds more
+// rounds, and then parks until a task is added or kParkTimeout expires. Tasks
+// are pending but not found while they are being handed over, or while
+// thieves race for them, which is usually resolved within a few rounds.
+constexpr int kSpinRounds = 16;
+constexpr int kYieldRounds = 64;
+constexpr absl::Duration kParkTimeout = absl::Milliseconds(1);
+
+// The pool and worker index of the current thread, if it is a worker thread
+// of a WorkStealingThreadPool.
+thread_local WorkStealingThreadPool* current_pool = nullptr;
+thread_local int current_worker = -1;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(const std::string& name_prefix,
+                                               int num_threads)
+    : WorkStealingThreadPool(ThreadOptions(), name_prefix, num_threads) {}
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    const ThreadOptions& thread_options, const std::string& name_prefix,
+    int num_threads)
+    : host_(thread_options, name_prefix, num_threads),
+      num_threads_(host_.num_threads()) {
+  deques_.reserve(num_threads_);
+  for (int i = 0; i < num_threads_; ++i) {
+    deques_.push_back(std::make_unique<WorkStealingDeque<Task>>());
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopped_ = true;
+    condition_.SignalAll();
+    // The worker loops reference the deques and the injection queue, so they
+    // must return before any member is destroyed. host_ joins the threads.
+    while (running_workers_ > 0) {
+      condition_.Wait(&mutex_);
+    }
+  }
+  absl::MutexLock lock(&injection_mutex_);
+  for (Task* task : injection_queue_) {
+    delete task;
+  }
+  injection_queue_.clear();
+}
+
+void WorkStealingThreadPool::StartWorkers() {
+  host_.StartWorkers();
+  {
+    absl::MutexLock lock(&mutex_);
+    running_workers_ = num_threads_;
+  }
+  for (int i = 0; i < num_threads_; ++i) {
+    host_.Schedule([this, i]() { RunWorker(i); });
+  }
+}
+
+void WorkStealingThreadPool::Schedule(std::function<void()> callback) {
+  Task* task = new Task(std::move(callback));
+  if (current_pool == this) {
+    deques_[current_worker]->Push(task);
+  } else {
+    absl::MutexLock lock(&injection_mutex_);
+    injection_queue_.push_back(task);
+  }
+  NotifyTaskAdded();
+}
+
+int WorkStealingThreadPool::num_threads() const { return num_threads_; }
+
+const ThreadOptions& WorkStealingThreadPool::thread_options() const {
+  return host_.thread_options();
+}
+
+void WorkStealingThreadPool::RunWorker(int index) {
+  current_pool = this;
+  current_worker = index;
+  int failed_rounds = 0;
+  while (true) {
+    Task* task = FindTask(index);
+    if (task != nullptr) {
+      failed_rounds = 0;
+      pending_tasks_.fetch_sub(1);
+      (*task)();
+      delete task;
+      continue;
+    }
+    if (pending_tasks_.load() > 0 &&
+        failed_rounds < kSpinRounds + kYieldRounds) {
+      if (++failed_rounds > kSpinRounds) {
+        std::this_thread::yield();
+      }
+      continue;
+    }
+    const bool park = failed_rounds > 0;
+    failed_rounds = 0;
+    if (!WaitForWork(park)) {
+      break;
+    }
+  }
+  current_pool = nullptr;
+  current_worker = -1;
+
+  absl::MutexLock lock(&mutex_);
+  if (--running_workers_ == 0) {
+    condition_.SignalAll();
+  }
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::FindTask(int index) {
+  Task* task = deques_[index]->Pop();
+  if (task != nullptr) return task;
+  {
+    absl::MutexLock lock(&injection_mutex_);
+    if (!injection_queue_.empty()) {
+      task = injection_queue_.front();
+      injection_queue_.pop_front();
+      return task;
+    }
+  }
+  for (int i = 1; i < num_threads_; ++i) {
+    task = deques_[(index + i) % num_threads_]->Steal();
+    if (task != nullptr) return task;
+  }
+  return nullptr;
+}
+
+bool WorkStealingThreadPool::WaitForWork(bool park) {
+  absl::MutexLock lock(&mutex_);
+  // Announcing the sleeper before re-checking pending_tasks_ pairs with
+  // NotifyTaskAdded(), which increments pending_tasks_ before checking for
+  // sleepers, so that a wakeup can never be lost.
+  sleeping_workers_.fetch_add(1);
+  bool has_work = true;
+  if (park && !stopped_ && pending_tasks_.load() > 0) {
+    // The pending tasks could not be found. Rather than spinning until they
+    // can, sleep until another task is added.
+    condition_.WaitWithTimeout(&mutex_, kParkTimeout);
+  }
+  while (pending_tasks_.load() <= 0) {
+    if (stopped_) {
+      has_work = false;
+      break;
+    }
+    condition_.Wait(&mutex_);
+  }
+  sleeping_workers_.fetch_sub(1);
+  return has_work;
+}
+
+void WorkStealingThreadPool::NotifyTaskAdded() {
+  pending_tasks_.fetch_add(1);
+  if (sleeping_workers_.load() > 0) {
+    absl::MutexLock lock(&mutex_);
+    condition_.Signal();
+  }
+}
+
+}  // namespace mediapipe
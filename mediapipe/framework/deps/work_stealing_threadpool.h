@@ -0,0 +1,117 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
+#define MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/deps/threadpool.h"
+#include "mediapipe/framework/deps/work_stealing_deque.h"
+
+namespace mediapipe {
+
+// A thread pool in which every worker owns a lock-free deque of tasks.
+//
+// Callbacks scheduled from a worker thread of this pool are pushed onto that
+// worker's own deque and popped in LIFO order, which keeps recently produced
+// data hot in the worker's cache. Callbacks scheduled from any other thread
+// go to a shared injection queue. An idle worker first drains its own deque,
+// then the injection queue, and then steals the oldest task from the other
+// workers' deques (FIFO).
+//
+// This avoids the single mutex of ThreadPool on the common path where
+// tasks schedule follow-up tasks, e.g. the CalculatorGraph scheduler, at the
+// cost of not preserving any execution order between callbacks.
+//
+// The interface mirrors ThreadPool. The pool is shut down when it is
+// destroyed; all scheduled callbacks are run before the destructor returns.
+class WorkStealingThreadPool {
+ public:
+  WorkStealingThreadPool(const std::string& name_prefix, int num_threads);
+  WorkStealingThreadPool(const ThreadOptions& thread_options,
+                         const std::string& name_prefix, int num_threads);
+  WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+  WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+  // Waits for closures (if any) to complete. May be called without
+  // having called StartWorkers().
+  ~WorkStealingThreadPool();
+
+  // REQUIRES: StartWorkers has not been called
+  // Actually start the worker threads.
+  void StartWorkers();
+
+  // REQUIRES: StartWorkers has been called
+  // Adds the callback to the calling worker's deque, or to the injection
+  // queue if the caller is not a worker of this pool.
+  void Schedule(std::function<void()> callback);
+
+  // Provided for debugging and testing only.
+  int num_threads() const;
+
+  // Standard thread options.  Use this accessor to get them.
+  const ThreadOptions& thread_options() const;
+
+ private:
+  using Task = std::function<void()>;
+
+  // Runs the scheduling loop of worker "index" until the pool is stopped and
+  // no tasks are left.
+  void RunWorker(int index);
+
+  // Returns the next task for worker "index", or nullptr if none was found.
+  Task* FindTask(int index);
+
+  // Blocks the calling worker until a task may be available. Returns false if
+  // the pool is stopped and drained. If "park" is true, also sleeps while
+  // tasks are pending but could not be found, until a task is added or a
+  // short timeout expires.
+  bool WaitForWork(bool park);
+
+  // Records that a task was made available and wakes up a sleeping worker.
+  void NotifyTaskAdded();
+
+  // Worker threads are provided by a plain ThreadPool, which takes care of
+  // thread naming, priority and affinity. Each of its threads runs one
+  // RunWorker() loop for the lifetime of the pool.
+  ThreadPool host_;
+  const int num_threads_;
+  std::vector<std::unique_ptr<WorkStealingDeque<Task>>> deques_;
+
+  // Tasks scheduled from threads outside of this pool.
+  absl::Mutex injection_mutex_;
+  std::deque<Task*> injection_queue_ ABSL_GUARDED_BY(injection_mutex_);
+
+  // Number of tasks that have been added but not yet taken by a worker.
+  std::atomic<int64_t> pending_tasks_{0};
+  // Number of workers that are blocked in WaitForWork().
+  std::atomic<int> sleeping_workers_{0};
+
+  absl::Mutex mutex_;
+  absl::CondVar condition_;
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+  int running_workers_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
@@ -0,0 +1,229 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/threadpool.h"
+#include "mediapipe/framework/deps/work_stealing_deque.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(WorkStealingDequeTest, PushPopIsLifo) {
+  WorkStealingDeque<int> deque(2);
+  std::vector<int> values = {1, 2, 3, 4, 5};
+  for (int& value : values) {
+    deque.Push(&value);
+  }
+  EXPECT_EQ(5, deque.SizeEstimate());
+  for (int i = values.size() - 1; i >= 0; --i) {
+    EXPECT_EQ(&values[i], deque.Pop());
+  }
+  EXPECT_EQ(nullptr, deque.Pop());
+}
+
+TEST(WorkStealingDequeTest, StealIsFifo) {
+  WorkStealingDeque<int> deque(2);
+  std::vector<int> values = {1, 2, 3, 4, 5};
+  for (int& value : values) {
+    deque.Push(&value);
+  }
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(&values[i], deque.Steal());
+  }
+  EXPECT_EQ(nullptr, deque.Steal());
+}
+
+TEST(WorkStealingDequeTest, ConcurrentStealsTakeEachItemOnce) {
+  constexpr int kNumItems = 100000;
+  constexpr int kNumThieves = 4;
+  WorkStealingDeque<int> deque;
+  std::vector<int> values(kNumItems);
+  std::vector<std::atomic<int>> taken(kNumItems);
+  auto take = [&](int* item) { taken[item - values.data()].fetch_add(1); };
+  {
+    ThreadPool thieves("thieves", kNumThieves);
+    thieves.StartWorkers();
+    std::atomic<bool> done(false);
+    for (int t = 0; t < kNumThieves; ++t) {
+      thieves.Schedule([&]() {
+        while (!done.load()) {
+          if (int* item = deque.Steal()) take(item);
+        }
+        while (int* item = deque.Steal()) take(item);
+      });
+    }
+    for (int i = 0; i < kNumItems; ++i) {
+      deque.Push(&values[i]);
+      if (i % 3 == 0) {
+        if (int* item = deque.Pop()) take(item);
+      }
+    }
+    while (int* item = deque.Pop()) take(item);
+    done.store(true);
+  }
+  for (int i = 0; i < kNumItems; ++i) {
+    EXPECT_EQ(1, taken[i].load()) << "item " << i;
+  }
+}
+
+TEST(WorkStealingThreadPoolTest, DestroyWithoutStart) {
+  WorkStealingThreadPool thread_pool("testpool", 10);
+}
+
+TEST(WorkStealingThreadPoolTest, EmptyThread) {
+  WorkStealingThreadPool thread_pool("testpool", 0);
+  ASSERT_EQ(1, thread_pool.num_threads());
+  thread_pool.StartWorkers();
+}
+
+TEST(WorkStealingThreadPoolTest, SingleThread) {
+  absl::Mutex mu;
+  int n = 100;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 1);
+    ASSERT_EQ(1, thread_pool.num_threads());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+TEST(WorkStealingThreadPoolTest, MultiThreads) {
+  absl::Mutex mu;
+  int n = 100;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 10);
+    ASSERT_EQ(10, thread_pool.num_threads());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+// Tasks scheduled from worker threads go to the local deques and must be
+// drained, including by other workers, before the pool is destroyed.
+TEST(WorkStealingThreadPoolTest, NestedSchedule) {
+  std::atomic<int> n(0);
+  std::function<void(int)> spawn;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 4);
+    thread_pool.StartWorkers();
+    spawn = [&](int depth) {
+      n.fetch_add(1);
+      if (depth == 0) return;
+      for (int i = 0; i < 2; ++i) {
+        thread_pool.Schedule([&spawn, depth]() { spawn(depth - 1); });
+      }
+    };
+    thread_pool.Schedule([&spawn]() { spawn(10); });
+  }
+
+  EXPECT_EQ((1 << 11) - 1, n.load());
+}
+
+TEST(WorkStealingThreadPoolTest, CreateWithThreadOptions) {
+  ThreadOptions thread_options = ThreadOptions().set_stack_size(256 * 1024);
+  WorkStealingThreadPool thread_pool(thread_options, "testpool", 10);
+  ASSERT_EQ(10, thread_pool.num_threads());
+  ASSERT_EQ(256 * 1024, thread_pool.thread_options().stack_size());
+  thread_pool.StartWorkers();
+}
+
+// Benchmarks the throughput in tasks/sec of ThreadPool and
+// WorkStealingThreadPool as a function of the number of threads.
+//
+// Each iteration runs a binary tree of tiny tasks in which every task
+// schedules its children from the worker thread, which is the access pattern
+// of the CalculatorGraph scheduler.
+template <typename Pool>
+void BM_NestedSchedule(benchmark::State& state) {
+  constexpr int kDepth = 14;
+  constexpr int kNumTasks = (1 << (kDepth + 1)) - 1;
+  absl::BlockingCounter* counter = nullptr;
+  std::function<void(int)> spawn;
+  Pool pool("bm", state.range(0));
+  pool.StartWorkers();
+  spawn = [&](int depth) {
+    if (depth > 0) {
+      pool.Schedule([&spawn, depth]() { spawn(depth - 1); });
+      pool.Schedule([&spawn, depth]() { spawn(depth - 1); });
+    }
+    counter->DecrementCount();
+  };
+  for (auto _ : state) {
+    absl::BlockingCounter iteration_counter(kNumTasks);
+    counter = &iteration_counter;
+    pool.Schedule([&spawn]() { spawn(kDepth); });
+    iteration_counter.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTasks);
+}
+BENCHMARK_TEMPLATE(BM_NestedSchedule, ThreadPool)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_NestedSchedule, WorkStealingThreadPool)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime();
+
+// Same as above, but all tasks are scheduled from a thread outside the pool.
+template <typename Pool>
+void BM_ExternalSchedule(benchmark::State& state) {
+  constexpr int kNumTasks = 1 << 14;
+  Pool pool("bm", state.range(0));
+  pool.StartWorkers();
+  for (auto _ : state) {
+    absl::BlockingCounter counter(kNumTasks);
+    for (int i = 0; i < kNumTasks; ++i) {
+      pool.Schedule([&counter]() { counter.DecrementCount(); });
+    }
+    counter.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTasks);
+}
+BENCHMARK_TEMPLATE(BM_ExternalSchedule, ThreadPool)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ExternalSchedule, WorkStealingThreadPool)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,98 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/compact_detection.h"
+
+#include "mediapipe/framework/formats/location_data.pb.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/type_map.h"
+
+namespace mediapipe {
+
+absl::StatusOr<CompactDetection> ToCompactDetection(
+    const Detection& detection) {
+  RET_CHECK_EQ(detection.label_id_size(), 1)
+      << "A CompactDetection has a single label id.";
+  RET_CHECK_EQ(detection.score_size(), 1)
+      << "A CompactDetection has a single score.";
+  const LocationData& location_data = detection.location_data();
+  RET_CHECK_EQ(location_data.format(), LocationData::RELATIVE_BOUNDING_BOX)
+      << "A CompactDetection has a relative bounding box.";
+  RET_CHECK_LE(location_data.relative_keypoints_size(),
+               CompactDetection::kMaxKeypoints)
+      << "Too many keypoints for a CompactDetection.";
+
+  CompactDetection compact_detection;
+  compact_detection.label_id = detection.label_id(0);
+  compact_detection.score = detection.score(0);
+  const auto& box = location_data.relative_bounding_box();
+  compact_detection.xmin = box.xmin();
+  compact_detection.ymin = box.ymin();
+  compact_detection.width = box.width();
+  compact_detection.height = box.height();
+  compact_detection.num_keypoints = location_data.relative_keypoints_size();
+  for (int i = 0; i < compact_detection.num_keypoints; ++i) {
+    compact_detection.keypoints[i].x = location_data.relative_keypoints(i).x();
+    compact_detection.keypoints[i].y = location_data.relative_keypoints(i).y();
+  }
+  return compact_detection;
+}
+
+absl::StatusOr<std::vector<CompactDetection>> ToCompactDetections(
+    const std::vector<Detection>& detections) {
+  std::vector<CompactDetection> compact_detections;
+  compact_detections.reserve(detections.size());
+  for (const auto& detection : detections) {
+    ASSIGN_OR_RETURN(CompactDetection compact_detection,
+                     ToCompactDetection(detection));
+    compact_detections.push_back(compact_detection);
+  }
+  return compact_detections;
+}
+
+Detection ToDetection(const CompactDetection& detection) {
+  Detection proto;
+  proto.add_label_id(detection.label_id);
+  proto.add_score(detection.score);
+  LocationData* location_data = proto.mutable_location_data();
+  location_data->set_format(LocationData::RELATIVE_BOUNDING_BOX);
+  auto* box = location_data->mutable_relative_bounding_box();
+  box->set_xmin(detection.xmin);
+  box->set_ymin(detection.ymin);
+  box->set_width(detection.width);
+  box->set_height(detection.height);
+  for (int i = 0; i < detection.num_keypoints; ++i) {
+    auto* keypoint = location_data->add_relative_keypoints();
+    keypoint->set_x(detection.keypoints[i].x);
+    keypoint->set_y(detection.keypoints[i].y);
+  }
+  return proto;
+}
+
+std::vector<Detection> ToDetections(
+    const std::vector<CompactDetection>& detections) {
+  std::vector<Detection> protos;
+  protos.reserve(detections.size());
+  for (const auto& detection : detections) {
+    protos.push_back(ToDetection(detection));
+  }
+  return protos;
+}
+
+MEDIAPIPE_REGISTER_TYPE(std::vector<mediapipe::CompactDetection>,
+                        "::std::vector<::mediapipe::CompactDetection>",
+                        nullptr, nullptr);
+
+}  // namespace mediapipe
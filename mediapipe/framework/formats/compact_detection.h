@@ -0,0 +1,72 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_DETECTION_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_DETECTION_H_
+
+#include <array>
+#include <vector>
+
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// A detection with a single label id and score, a relative bounding box and up
+// to kMaxKeypoints relative keypoints. Unlike the Detection proto, it is a
+// plain struct, so that a std::vector<CompactDetection> holds all the
+// detections of a frame in a single allocation.
+//
+// It covers the detections of the face, hand and pose detectors, which
+// NonMaxSuppressionCalculator and DetectionsToRectsCalculator accept in place
+// of the protos.
+struct CompactDetection {
+  static constexpr int kMaxKeypoints = 8;
+
+  struct Keypoint {
+    float x = 0.0f;
+    float y = 0.0f;
+  };
+
+  int label_id = 0;
+  float score = 0.0f;
+  // The relative bounding box.
+  float xmin = 0.0f;
+  float ymin = 0.0f;
+  float width = 0.0f;
+  float height = 0.0f;
+  // The relative keypoints. Only the first num_keypoints are set.
+  int num_keypoints = 0;
+  std::array<Keypoint, kMaxKeypoints> keypoints;
+};
+
+// Converts a Detection with a relative bounding box. Fails if the detection
+// has labels rather than a label id, does not have exactly one score, or has
+// more than CompactDetection::kMaxKeypoints keypoints. Other fields, such as
+// keypoint labels and the detection id, are dropped.
+absl::StatusOr<CompactDetection> ToCompactDetection(const Detection& detection);
+
+absl::StatusOr<std::vector<CompactDetection>> ToCompactDetections(
+    const std::vector<Detection>& detections);
+
+// Converts a CompactDetection to a Detection with a RELATIVE_BOUNDING_BOX
+// location.
+Detection ToDetection(const CompactDetection& detection);
+
+std::vector<Detection> ToDetections(
+    const std::vector<CompactDetection>& detections);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_DETECTION_H_
@@ -0,0 +1,87 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/compact_detection.h"
+
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(CompactDetectionTest, RoundTrip) {
+  const Detection detection = ParseTextProtoOrDie<Detection>(R"pb(
+    label_id: 3
+    score: 0.75
+    location_data {
+      format: RELATIVE_BOUNDING_BOX
+      relative_bounding_box { xmin: 0.1 ymin: 0.2 width: 0.3 height: 0.4 }
+      relative_keypoints { x: 0.15 y: 0.25 }
+      relative_keypoints { x: 0.35 y: 0.45 }
+    }
+  )pb");
+
+  MP_ASSERT_OK_AND_ASSIGN(const CompactDetection compact_detection,
+                          ToCompactDetection(detection));
+  EXPECT_EQ(compact_detection.label_id, 3);
+  EXPECT_FLOAT_EQ(compact_detection.score, 0.75f);
+  EXPECT_FLOAT_EQ(compact_detection.xmin, 0.1f);
+  EXPECT_FLOAT_EQ(compact_detection.ymin, 0.2f);
+  EXPECT_FLOAT_EQ(compact_detection.width, 0.3f);
+  EXPECT_FLOAT_EQ(compact_detection.height, 0.4f);
+  ASSERT_EQ(compact_detection.num_keypoints, 2);
+  EXPECT_FLOAT_EQ(compact_detection.keypoints[1].x, 0.35f);
+  EXPECT_FLOAT_EQ(compact_detection.keypoints[1].y, 0.45f);
+
+  EXPECT_THAT(ToDetection(compact_detection), EqualsProto(detection));
+}
+
+TEST(CompactDetectionTest, RejectsUnsupportedDetections) {
+  EXPECT_FALSE(ToCompactDetection(ParseTextProtoOrDie<Detection>(R"pb(
+                 label: "face"
+                 score: 0.75
+                 location_data { format: RELATIVE_BOUNDING_BOX }
+               )pb"))
+                   .ok());
+  EXPECT_FALSE(ToCompactDetection(ParseTextProtoOrDie<Detection>(R"pb(
+                 label_id: 0
+                 label_id: 1
+                 score: 0.75
+                 score: 0.5
+                 location_data { format: RELATIVE_BOUNDING_BOX }
+               )pb"))
+                   .ok());
+  EXPECT_FALSE(ToCompactDetection(ParseTextProtoOrDie<Detection>(R"pb(
+                 label_id: 0
+                 score: 0.75
+                 location_data { format: BOUNDING_BOX }
+               )pb"))
+                   .ok());
+
+  Detection detection = ParseTextProtoOrDie<Detection>(R"pb(
+    label_id: 0
+    score: 0.75
+    location_data { format: RELATIVE_BOUNDING_BOX }
+  )pb");
+  for (int i = 0; i <= CompactDetection::kMaxKeypoints; ++i) {
+    detection.mutable_location_data()->add_relative_keypoints();
+  }
+  EXPECT_FALSE(ToCompactDetection(detection).ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
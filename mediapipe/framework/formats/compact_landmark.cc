@@ -0,0 +1,93 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/compact_landmark.h"
+
+#include "mediapipe/framework/type_map.h"
+
+namespace mediapipe {
+
+namespace {
+
+template <typename LandmarkProto>
+CompactLandmark ToCompactLandmarkImpl(const LandmarkProto& landmark) {
+  CompactLandmark compact_landmark;
+  compact_landmark.x = landmark.x();
+  compact_landmark.y = landmark.y();
+  compact_landmark.z = landmark.z();
+  compact_landmark.visibility = landmark.visibility();
+  compact_landmark.presence = landmark.presence();
+  compact_landmark.has_visibility = landmark.has_visibility();
+  compact_landmark.has_presence = landmark.has_presence();
+  return compact_landmark;
+}
+
+template <typename LandmarkProto>
+void ToLandmarkProtoImpl(const CompactLandmark& landmark,
+                         LandmarkProto* proto) {
+  proto->set_x(landmark.x);
+  proto->set_y(landmark.y);
+  proto->set_z(landmark.z);
+  if (landmark.has_visibility) {
+    proto->set_visibility(landmark.visibility);
+  }
+  if (landmark.has_presence) {
+    proto->set_presence(landmark.presence);
+  }
+}
+
+}  // namespace
+
+CompactLandmark ToCompactLandmark(const NormalizedLandmark& landmark) {
+  return ToCompactLandmarkImpl(landmark);
+}
+
+CompactLandmark ToCompactLandmark(const Landmark& landmark) {
+  return ToCompactLandmarkImpl(landmark);
+}
+
+void ToLandmarkProto(const CompactLandmark& landmark,
+                     NormalizedLandmark* proto) {
+  ToLandmarkProtoImpl(landmark, proto);
+}
+
+void ToLandmarkProto(const CompactLandmark& landmark, Landmark* proto) {
+  ToLandmarkProtoImpl(landmark, proto);
+}
+
+CompactNormalizedLandmarkList ToCompactNormalizedLandmarkList(
+    const NormalizedLandmarkList& landmarks) {
+  CompactNormalizedLandmarkList compact_landmarks;
+  compact_landmarks.landmark.reserve(landmarks.landmark_size());
+  for (const auto& landmark : landmarks.landmark()) {
+    compact_landmarks.landmark.push_back(ToCompactLandmark(landmark));
+  }
+  return compact_landmarks;
+}
+
+NormalizedLandmarkList ToNormalizedLandmarkList(
+    const CompactNormalizedLandmarkList& landmarks) {
+  NormalizedLandmarkList proto;
+  proto.mutable_landmark()->Reserve(landmarks.landmark.size());
+  for (const auto& landmark : landmarks.landmark) {
+    ToLandmarkProto(landmark, proto.add_landmark());
+  }
+  return proto;
+}
+
+MEDIAPIPE_REGISTER_TYPE(mediapipe::CompactNormalizedLandmarkList,
+                        "::mediapipe::CompactNormalizedLandmarkList", nullptr,
+                        nullptr);
+
+}  // namespace mediapipe
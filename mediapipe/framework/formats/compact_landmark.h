@@ -0,0 +1,61 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_LANDMARK_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_LANDMARK_H_
+
+#include <vector>
+
+#include "mediapipe/framework/formats/landmark.pb.h"
+
+namespace mediapipe {
+
+// The fields of a Landmark or NormalizedLandmark in a plain struct.
+// Visibility and presence are only meaningful if the has_ flags are set, as
+// with the proto fields.
+struct CompactLandmark {
+  float x = 0.0f;
+  float y = 0.0f;
+  float z = 0.0f;
+  float visibility = 0.0f;
+  float presence = 0.0f;
+  bool has_visibility = false;
+  bool has_presence = false;
+};
+
+// A NormalizedLandmarkList which holds its landmarks in a single allocation,
+// rather than one proto per landmark. LandmarkProjectionCalculator and
+// LandmarksSmoothingCalculator accept it in place of the proto.
+struct CompactNormalizedLandmarkList {
+  std::vector<CompactLandmark> landmark;
+};
+
+CompactLandmark ToCompactLandmark(const NormalizedLandmark& landmark);
+CompactLandmark ToCompactLandmark(const Landmark& landmark);
+
+// Sets all the fields of @proto, except the visibility and presence a
+// CompactLandmark doesn't have.
+void ToLandmarkProto(const CompactLandmark& landmark,
+                     NormalizedLandmark* proto);
+void ToLandmarkProto(const CompactLandmark& landmark, Landmark* proto);
+
+CompactNormalizedLandmarkList ToCompactNormalizedLandmarkList(
+    const NormalizedLandmarkList& landmarks);
+
+NormalizedLandmarkList ToNormalizedLandmarkList(
+    const CompactNormalizedLandmarkList& landmarks);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_COMPACT_LANDMARK_H_
@@ -0,0 +1,66 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/compact_landmark.h"
+
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(CompactLandmarkTest, RoundTrip) {
+  const NormalizedLandmarkList landmarks =
+      ParseTextProtoOrDie<NormalizedLandmarkList>(R"pb(
+        landmark { x: 0.1 y: 0.2 z: 0.3 }
+        landmark { x: 0.4 y: 0.5 z: 0.6 visibility: 0.7 }
+        landmark { x: 0.7 y: 0.8 z: 0.9 visibility: 0.0 presence: 0.25 }
+      )pb");
+
+  const CompactNormalizedLandmarkList compact_landmarks =
+      ToCompactNormalizedLandmarkList(landmarks);
+  ASSERT_EQ(compact_landmarks.landmark.size(), 3);
+  EXPECT_FALSE(compact_landmarks.landmark[0].has_visibility);
+  EXPECT_FALSE(compact_landmarks.landmark[0].has_presence);
+  EXPECT_TRUE(compact_landmarks.landmark[1].has_visibility);
+  EXPECT_FLOAT_EQ(compact_landmarks.landmark[1].visibility, 0.7f);
+  EXPECT_TRUE(compact_landmarks.landmark[2].has_visibility);
+  EXPECT_TRUE(compact_landmarks.landmark[2].has_presence);
+  EXPECT_FLOAT_EQ(compact_landmarks.landmark[2].presence, 0.25f);
+
+  EXPECT_THAT(ToNormalizedLandmarkList(compact_landmarks),
+              EqualsProto(landmarks));
+}
+
+TEST(CompactLandmarkTest, ConvertsLandmark) {
+  const Landmark landmark = ParseTextProtoOrDie<Landmark>(R"pb(
+    x: 10 y: 20 z: 30 presence: 0.5
+  )pb");
+
+  const CompactLandmark compact_landmark = ToCompactLandmark(landmark);
+  EXPECT_FLOAT_EQ(compact_landmark.x, 10.0f);
+  EXPECT_FLOAT_EQ(compact_landmark.y, 20.0f);
+  EXPECT_FLOAT_EQ(compact_landmark.z, 30.0f);
+  EXPECT_FALSE(compact_landmark.has_visibility);
+  EXPECT_TRUE(compact_landmark.has_presence);
+
+  Landmark proto;
+  ToLandmarkProto(compact_landmark, &proto);
+  EXPECT_THAT(proto, EqualsProto(landmark));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -76,6 +76,14 @@ class Image {
     use_gpu_ = false;
   }
 
+  // Creates an Image over pixel data owned by someone else, without copying
+  // it. The arguments are the same as for the ImageFrame constructor: deleter
+  // is called with pixel_data once the Image and all its copies are gone.
+  Image(ImageFormat::Format format, int width, int height, int width_step,
+        uint8* pixel_data, ImageFrame::Deleter deleter)
+      : Image(std::make_shared<ImageFrame>(format, width, height, width_step,
+                                           pixel_data, std::move(deleter))) {}
+
   // CPU getters.
   ImageFrameSharedPtr GetImageFrameSharedPtr() const {
     // Write view currently because the return type does not point to const IF.
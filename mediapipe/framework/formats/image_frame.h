@@ -114,6 +114,11 @@ class ImageFrame {
   // size at least width_step*height and width_step must be at least
   // width*num_channels*depth.  Both width_step and depth are in units
   // of bytes.
+  //
+  // This can also wrap memory owned by someone else, such as a camera
+  // buffer, without copying it: deleter is then a release callback that
+  // hands the memory back to its owner once the ImageFrame is destroyed
+  // (or PixelDataDeleter::kNone if the memory outlives the ImageFrame).
   ImageFrame(ImageFormat::Format format, int width, int height, int width_step,
              uint8* pixel_data,
              Deleter deleter = std::default_delete<uint8[]>());
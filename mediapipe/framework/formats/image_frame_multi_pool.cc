@@ -0,0 +1,173 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/image_frame_multi_pool.h"
+
+#include <deque>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
+
+namespace mediapipe {
+
+struct ImageFrameMultiPool::SizeClass {
+  explicit SizeClass(size_t bytes) : bytes(bytes) {}
+
+  // The size of the buffers, in bytes.
+  const size_t bytes;
+  // The following are guarded by the mutex of the pool.
+  std::deque<uint8*> idle;
+  // Set when the size class is dropped from the pool. Its buffers are then
+  // freed when they are returned.
+  bool evicted = false;
+};
+
+ImageFrameMultiPool::ImageFrameMultiPool(const Options& options)
+    : options_(options) {}
+
+ImageFrameMultiPool::~ImageFrameMultiPool() {
+  // Buffers that are still in use are freed by their deleters.
+  absl::MutexLock lock(&mutex_);
+  size_classes_.ForEachLeastRequestedFirst(
+      [](std::shared_ptr<SizeClass>& size_class) {
+        for (uint8* buffer : size_class->idle) aligned_free(buffer);
+        size_class->idle.clear();
+        return true;
+      });
+}
+
+// static
+size_t ImageFrameMultiPool::SizeClassBytes(size_t bytes) {
+  constexpr size_t kMinBytes = 4096;
+  if (bytes <= kMinBytes) return kMinBytes;
+  // The classes between 2^n and 2^(n+1) bytes are 2^(n-2) bytes apart.
+  size_t step = 1;
+  while ((step << 3) < bytes) step <<= 1;
+  return (bytes + step - 1) / step * step;
+}
+
+ImageFrameSharedPtr ImageFrameMultiPool::GetBuffer(int width, int height,
+                                                   ImageFormat::Format format) {
+  // Fix alignment at 4 for best compatability with OpenGL.
+  const int alignment = ImageFrame::kGlDefaultAlignmentBoundary;
+  const int row_bytes = width * ImageFrame::NumberOfChannelsForFormat(format) *
+                        ImageFrame::ByteDepthForFormat(format);
+  const int width_step = ((row_bytes - 1) | (alignment - 1)) + 1;
+  const size_t bytes =
+      SizeClassBytes(static_cast<size_t>(width_step) * height);
+
+  std::shared_ptr<SizeClass> size_class;
+  uint8* buffer = nullptr;
+  std::vector<uint8*> trimmed;
+  {
+    absl::MutexLock lock(&mutex_);
+    size_class = size_classes_.Lookup(
+        bytes, [](const size_t& bytes, int request_count) {
+          return std::make_shared<SizeClass>(bytes);
+        });
+    // Take the most recently returned buffer of the class, or else of one of
+    // the next larger classes.
+    std::shared_ptr<SizeClass> candidate = size_class;
+    size_t candidate_bytes = bytes;
+    for (int i = 0; i <= options_.max_larger_classes; ++i) {
+      if (candidate && !candidate->idle.empty()) {
+        size_class = candidate;
+        buffer = candidate->idle.back();
+        candidate->idle.pop_back();
+        break;
+      }
+      candidate_bytes = SizeClassBytes(candidate_bytes + 1);
+      candidate = size_classes_.Find(candidate_bytes);
+    }
+    if (buffer) {
+      ++stats_.hits;
+      stats_.bytes_idle -= size_class->bytes;
+    } else {
+      ++stats_.misses;
+    }
+    stats_.bytes_in_use += size_class->bytes;
+
+    for (std::shared_ptr<SizeClass>& evicted : size_classes_.Evict(
+             options_.max_class_count, options_.request_count_scrub_interval)) {
+      evicted->evicted = true;
+      stats_.bytes_idle -= evicted->bytes * evicted->idle.size();
+      stats_.evictions += evicted->idle.size();
+      trimmed.insert(trimmed.end(), evicted->idle.begin(), evicted->idle.end());
+      evicted->idle.clear();
+    }
+  }
+  // Buffers are allocated and freed without holding the lock.
+  for (uint8* trimmed_buffer : trimmed) aligned_free(trimmed_buffer);
+  if (!buffer) {
+    buffer = static_cast<uint8*>(aligned_malloc(
+        size_class->bytes, ImageFrame::kDefaultAlignmentBoundary));
+  }
+
+  // The buffer goes back to the pool when the ImageFrame releases it.
+  std::weak_ptr<ImageFrameMultiPool> weak_pool(shared_from_this());
+  return std::make_shared<ImageFrame>(
+      format, width, height, width_step, buffer,
+      [weak_pool, size_class](uint8* buffer) {
+        auto pool = weak_pool.lock();
+        if (pool) {
+          pool->Return(size_class, buffer);
+        } else {
+          aligned_free(buffer);
+        }
+      });
+}
+
+ImageFrameMultiPool::Stats ImageFrameMultiPool::GetStats() {
+  absl::MutexLock lock(&mutex_);
+  return stats_;
+}
+
+void ImageFrameMultiPool::Return(std::shared_ptr<SizeClass> size_class,
+                                 uint8* buffer) {
+  std::vector<uint8*> trimmed;
+  {
+    absl::MutexLock lock(&mutex_);
+    stats_.bytes_in_use -= size_class->bytes;
+    if (size_class->evicted) {
+      trimmed.push_back(buffer);
+    } else {
+      size_class->idle.push_back(buffer);
+      stats_.bytes_idle += size_class->bytes;
+      Trim(&trimmed);
+    }
+  }
+  // The trimmed buffers will be released without holding the lock.
+  for (uint8* trimmed_buffer : trimmed) aligned_free(trimmed_buffer);
+}
+
+void ImageFrameMultiPool::Trim(std::vector<uint8*>* trimmed) {
+  int64_t bytes_idle = stats_.bytes_idle;
+  int64_t evictions = 0;
+  const int64_t max_idle_bytes = options_.max_idle_bytes;
+  size_classes_.ForEachLeastRequestedFirst(
+      [&](std::shared_ptr<SizeClass>& size_class) {
+        while (bytes_idle > max_idle_bytes && !size_class->idle.empty()) {
+          trimmed->push_back(size_class->idle.front());
+          size_class->idle.pop_front();
+          bytes_idle -= size_class->bytes;
+          ++evictions;
+        }
+        return bytes_idle > max_idle_bytes;
+      });
+  stats_.bytes_idle = bytes_idle;
+  stats_.evictions += evictions;
+}
+
+}  // namespace mediapipe
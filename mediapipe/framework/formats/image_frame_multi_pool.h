@@ -0,0 +1,120 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Consider this file an implementation detail. None of this is part of the
+// public API.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_MULTI_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_MULTI_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/util/resource_cache.h"
+
+namespace mediapipe {
+
+using ImageFrameSharedPtr = std::shared_ptr<ImageFrame>;
+
+// A pool of ImageFrame pixel buffers for frames of any size and format.
+//
+// Unlike ImageFramePool, which keeps buffers for one exact size, buffers are
+// grouped in size classes by their number of bytes, so that frames of
+// different dimensions and formats share them. Size classes are spaced by a
+// quarter of a power of two, which bounds the wasted memory to 25%. When no
+// buffer of the requested class is idle, a buffer of one of the next few
+// larger classes is reused, with the row stride of the requested frame.
+//
+// The total size of idle buffers is bounded by a byte budget. When it is
+// exceeded, idle buffers are freed, the oldest first, starting with the least
+// requested size classes.
+class ImageFrameMultiPool
+    : public std::enable_shared_from_this<ImageFrameMultiPool> {
+ public:
+  struct Options {
+    // The maximum total size of the idle buffers kept for reuse, in bytes.
+    int64_t max_idle_bytes = 128 << 20;
+    // When no buffer of the requested size class is idle, reuse one of up to
+    // this many larger classes.
+    int max_larger_classes = 2;
+    // The maximum number of size classes that are tracked.
+    int max_class_count = 32;
+    // Halve the request counts of the size classes every this many requests,
+    // so that the eviction order adapts when the requested sizes change.
+    int request_count_scrub_interval = 50;
+  };
+
+  struct Stats {
+    // Requests served with an idle buffer.
+    int64_t hits = 0;
+    // Requests for which a new buffer was allocated.
+    int64_t misses = 0;
+    // Idle buffers freed to stay within the budget.
+    int64_t evictions = 0;
+    // The total size of the buffers in use, and of the idle ones, in bytes.
+    int64_t bytes_in_use = 0;
+    int64_t bytes_idle = 0;
+  };
+
+  // We enforce creation as a shared_ptr so that we can use a weak reference in
+  // the buffers' deleters.
+  static std::shared_ptr<ImageFrameMultiPool> Create(const Options& options) {
+    return std::shared_ptr<ImageFrameMultiPool>(
+        new ImageFrameMultiPool(options));
+  }
+  static std::shared_ptr<ImageFrameMultiPool> Create() {
+    return Create(Options());
+  }
+
+  ~ImageFrameMultiPool();
+
+  // Obtains a frame, whose pixel buffer may either be reused or created anew.
+  // Rows are aligned to ImageFrame::kGlDefaultAlignmentBoundary. The buffer
+  // goes back to the pool once the pixel data of the frame is released.
+  ImageFrameSharedPtr GetBuffer(int width, int height,
+                                ImageFormat::Format format);
+
+  Stats GetStats();
+
+  // Returns the size class of a buffer of at least `bytes` bytes.
+  static size_t SizeClassBytes(size_t bytes);
+
+ private:
+  // The idle buffers of one size class, the oldest first.
+  struct SizeClass;
+
+  explicit ImageFrameMultiPool(const Options& options);
+
+  // Returns a buffer to the idle buffers of its size class.
+  void Return(std::shared_ptr<SizeClass> size_class, uint8* buffer);
+
+  // Frees idle buffers until their total size is within the budget.
+  void Trim(std::vector<uint8*>* trimmed)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const Options options_;
+
+  absl::Mutex mutex_;
+  ResourceCache<size_t, std::shared_ptr<SizeClass>> size_classes_
+      ABSL_GUARDED_BY(mutex_);
+  Stats stats_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_MULTI_POOL_H_
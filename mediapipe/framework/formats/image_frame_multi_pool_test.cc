@@ -0,0 +1,134 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/image_frame_multi_pool.h"
+
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+// 100x100 SRGBA frames take 40000 bytes, in the 40960 byte size class.
+constexpr int kSize = 100;
+constexpr ImageFormat::Format kFormat = ImageFormat::SRGBA;
+constexpr int64_t kClassBytes = 40960;
+
+TEST(ImageFrameMultiPoolTest, SizeClassBytes) {
+  EXPECT_EQ(ImageFrameMultiPool::SizeClassBytes(1), 4096);
+  EXPECT_EQ(ImageFrameMultiPool::SizeClassBytes(4096), 4096);
+  EXPECT_EQ(ImageFrameMultiPool::SizeClassBytes(4097), 5120);
+  EXPECT_EQ(ImageFrameMultiPool::SizeClassBytes(8192), 8192);
+  EXPECT_EQ(ImageFrameMultiPool::SizeClassBytes(8193), 10240);
+  EXPECT_EQ(ImageFrameMultiPool::SizeClassBytes(40000), kClassBytes);
+  // 4K RGBA.
+  EXPECT_EQ(ImageFrameMultiPool::SizeClassBytes(3840 * 2160 * 4),
+            32 * 1024 * 1024);
+}
+
+TEST(ImageFrameMultiPoolTest, ReusesBuffers) {
+  auto pool = ImageFrameMultiPool::Create();
+  auto frame = pool->GetBuffer(kSize, kSize, kFormat);
+  EXPECT_EQ(frame->Width(), kSize);
+  EXPECT_EQ(frame->Height(), kSize);
+  EXPECT_EQ(frame->Format(), kFormat);
+  EXPECT_TRUE(frame->IsAligned(ImageFrame::kGlDefaultAlignmentBoundary));
+  const uint8* pixel_data = frame->PixelData();
+  ImageFrameMultiPool::Stats stats = pool->GetStats();
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.bytes_in_use, kClassBytes);
+
+  frame = nullptr;
+  stats = pool->GetStats();
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_EQ(stats.bytes_idle, kClassBytes);
+
+  frame = pool->GetBuffer(kSize, kSize, kFormat);
+  EXPECT_EQ(frame->PixelData(), pixel_data);
+  stats = pool->GetStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.bytes_in_use, kClassBytes);
+  EXPECT_EQ(stats.bytes_idle, 0);
+}
+
+TEST(ImageFrameMultiPoolTest, ReusesLargerBufferWithOwnStride) {
+  auto pool = ImageFrameMultiPool::Create();
+  auto frame = pool->GetBuffer(kSize, kSize, kFormat);
+  const uint8* pixel_data = frame->PixelData();
+  frame = nullptr;
+
+  // 101x99 SRGB takes 304 * 99 bytes, in the next smaller size class.
+  frame = pool->GetBuffer(101, 99, ImageFormat::SRGB);
+  EXPECT_EQ(frame->PixelData(), pixel_data);
+  EXPECT_EQ(frame->WidthStep(), 304);
+  EXPECT_EQ(pool->GetStats().hits, 1);
+  frame = nullptr;
+
+  // Much smaller frames do not take large buffers.
+  frame = pool->GetBuffer(10, 10, ImageFormat::GRAY8);
+  EXPECT_NE(frame->PixelData(), pixel_data);
+  EXPECT_EQ(pool->GetStats().misses, 2);
+}
+
+TEST(ImageFrameMultiPoolTest, EvictsLeastRequestedSizeClassesFirst) {
+  ImageFrameMultiPool::Options options;
+  options.max_idle_bytes = kClassBytes;
+  auto pool = ImageFrameMultiPool::Create(options);
+  auto frame1 = pool->GetBuffer(kSize, kSize, kFormat);
+  auto frame2 = pool->GetBuffer(kSize, kSize, kFormat);
+  auto small_frame = pool->GetBuffer(10, 10, ImageFormat::GRAY8);
+  const uint8* pixel_data2 = frame2->PixelData();
+
+  small_frame = nullptr;
+  EXPECT_EQ(pool->GetStats().evictions, 0);
+  // The small buffer is evicted, since its size class had fewer requests.
+  frame1 = nullptr;
+  ImageFrameMultiPool::Stats stats = pool->GetStats();
+  EXPECT_EQ(stats.evictions, 1);
+  EXPECT_EQ(stats.bytes_idle, kClassBytes);
+  // Then the least recently returned buffer.
+  frame2 = nullptr;
+  stats = pool->GetStats();
+  EXPECT_EQ(stats.evictions, 2);
+  EXPECT_EQ(stats.bytes_idle, kClassBytes);
+
+  frame1 = pool->GetBuffer(kSize, kSize, kFormat);
+  EXPECT_EQ(frame1->PixelData(), pixel_data2);
+}
+
+TEST(ImageFrameMultiPoolTest, ReleasedPixelDataReturnsToPool) {
+  auto pool = ImageFrameMultiPool::Create();
+  auto frame = pool->GetBuffer(kSize, kSize, kFormat);
+  std::unique_ptr<uint8[], ImageFrame::Deleter> pixel_data = frame->Release();
+  frame = nullptr;
+  EXPECT_EQ(pool->GetStats().bytes_in_use, kClassBytes);
+  pixel_data = nullptr;
+  EXPECT_EQ(pool->GetStats().bytes_in_use, 0);
+  EXPECT_EQ(pool->GetStats().bytes_idle, kClassBytes);
+}
+
+TEST(ImageFrameMultiPoolTest, BufferCanOutlivePool) {
+  auto pool = ImageFrameMultiPool::Create();
+  auto frame = pool->GetBuffer(kSize, kSize, kFormat);
+  auto idle_frame = pool->GetBuffer(kSize, kSize, kFormat);
+  idle_frame = nullptr;
+  pool = nullptr;
+  frame = nullptr;
+}
+
+}  // namespace
+}  // namespace mediapipe
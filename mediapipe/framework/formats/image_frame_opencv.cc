@@ -14,7 +14,9 @@
 
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 
+#include "absl/memory/memory.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/port/logging.h"
 
 namespace {
 // Maps ImageFrame format to OpenCV Mat type.
@@ -89,5 +91,19 @@ cv::Mat MatView(const ImageFrame* image) {
                  steps);
 }
 
+std::unique_ptr<ImageFrame> AdoptMat(ImageFormat::Format format, cv::Mat mat) {
+  CHECK(mat.u != nullptr) << "The cv::Mat does not own its pixel data.";
+  CHECK_EQ(mat.dims, 2);
+  CHECK_EQ(mat.type(),
+           CV_MAKETYPE(GetMatType(format),
+                       ImageFrame::NumberOfChannelsForFormat(format)));
+  uint8* pixel_data = mat.data;
+  const int width_step = static_cast<int>(mat.step[0]);
+  // The deleter holds a reference to the pixel data, which is released along
+  // with the ImageFrame.
+  return absl::make_unique<ImageFrame>(format, mat.cols, mat.rows, width_step,
+                                       pixel_data, [mat](uint8*) {});
+}
+
 }  // namespace formats
 }  // namespace mediapipe
@@ -16,6 +16,9 @@
 #ifndef MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_OPENCV_H_
 #define MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_OPENCV_H_
 
+#include <memory>
+
+#include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 
@@ -30,6 +33,12 @@ namespace formats {
 // even though the returned data is mutable.
 cv::Mat MatView(const ImageFrame* image);
 
+// OpenCV to ImageFrame helper conversion function.
+// The returned ImageFrame shares the pixel data of mat (zero copy), and keeps
+// it alive.  mat must own its data, as the results of OpenCV functions do,
+// and its type must match format.
+std::unique_ptr<ImageFrame> AdoptMat(ImageFormat::Format format, cv::Mat mat);
+
 }  // namespace formats
 }  // namespace mediapipe
 
@@ -14,6 +14,9 @@
 
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 
+#include <memory>
+#include <vector>
+
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -131,5 +134,36 @@ TEST(ImageFrameOpencvTest, ImageFormats) {
   EXPECT_EQ(mat_c4.type(), CV_8UC4);
 }
 
+TEST(ImageFrameOpencvTest, AdoptMat) {
+  cv::Mat mat(45, 123, CV_8UC3, cv::Scalar(1, 2, 3));
+  const uint8* data = mat.data;
+  std::unique_ptr<ImageFrame> frame =
+      formats::AdoptMat(ImageFormat::SRGB, mat);
+  // The ImageFrame keeps the pixel data alive after the Mat is gone.
+  mat.release();
+  EXPECT_EQ(frame->PixelData(), data);
+  EXPECT_EQ(frame->Width(), 123);
+  EXPECT_EQ(frame->Height(), 45);
+  EXPECT_EQ(frame->WidthStep(), 123 * 3);
+  EXPECT_EQ(frame->PixelData()[frame->WidthStep() * 44 + 122 * 3 + 2], 3);
+}
+
+TEST(ImageFrameOpencvTest, ViewOfExternalMemory) {
+  // A 4x3 sub-image of a 10x8 GRAY8 buffer, owned by the test, whose release
+  // callback is run when the last reference to the ImageFrame is gone.
+  std::vector<uint8> buffer(10 * 8);
+  for (int i = 0; i < 10 * 8; ++i) buffer[i] = i;
+  int num_releases = 0;
+  auto frame = std::make_shared<ImageFrame>(
+      ImageFormat::GRAY8, 4, 3, /*width_step=*/10, buffer.data() + 10 * 2 + 3,
+      [&num_releases](uint8*) { ++num_releases; });
+  cv::Mat mat = formats::MatView(frame.get());
+  EXPECT_EQ(mat.data, buffer.data() + 23);
+  EXPECT_EQ(mat.step[0], 10u);
+  EXPECT_EQ(mat.at<uint8>(2, 1), 10 * 4 + 4);
+  frame.reset();
+  EXPECT_EQ(num_releases, 1);
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -110,17 +110,6 @@ Image ImageMultiPool::GetBufferFromSimplePool(
 
 #endif  // !MEDIAPIPE_DISABLE_GPU
 
-ImageMultiPool::SimplePoolCpu ImageMultiPool::MakeSimplePoolCpu(
-    IBufferSpec spec) {
-  return ImageFramePool::Create(spec.width, spec.height, spec.format,
-                                kKeepCount);
-}
-
-Image ImageMultiPool::GetBufferFromSimplePool(
-    IBufferSpec spec, const ImageMultiPool::SimplePoolCpu& pool) {
-  return Image(pool->GetBuffer());
-}
-
 Image ImageMultiPool::GetBuffer(int width, int height, bool use_gpu,
                                 ImageFormat::Format format) {
 #if !MEDIAPIPE_DISABLE_GPU
@@ -155,33 +144,7 @@ Image ImageMultiPool::GetBuffer(int width, int height, bool use_gpu,
   } else  // NOLINT(readability/braces)
 #endif    // !MEDIAPIPE_DISABLE_GPU
   {
-    absl::MutexLock lock(&mutex_cpu_);
-    IBufferSpec key(width, height, format);
-    auto pool_it = pools_cpu_.find(key);
-    if (pool_it == pools_cpu_.end()) {
-      // Discard the least recently used pool in LRU cache.
-      if (pools_cpu_.size() >= kMaxPoolCount) {
-        auto old_spec = buffer_specs_cpu_.front();  // Front has LRU.
-        buffer_specs_cpu_.pop_front();
-        pools_cpu_.erase(old_spec);
-      }
-      buffer_specs_cpu_.push_back(key);  // Push new spec to back.
-      std::tie(pool_it, std::ignore) = pools_cpu_.emplace(
-          std::piecewise_construct, std::forward_as_tuple(key),
-          std::forward_as_tuple(MakeSimplePoolCpu(key)));
-    } else {
-      // Find and move current 'key' spec to back, keeping others in same order.
-      auto specs_it = buffer_specs_cpu_.begin();
-      while (specs_it != buffer_specs_cpu_.end()) {
-        if (*specs_it == key) {
-          buffer_specs_cpu_.erase(specs_it);
-          break;
-        }
-        ++specs_it;
-      }
-      buffer_specs_cpu_.push_back(key);
-    }
-    return GetBufferFromSimplePool(pool_it->first, pool_it->second);
+    return Image(pool_cpu_->GetBuffer(width, height, format));
   }
 }
 
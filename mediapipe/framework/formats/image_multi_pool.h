@@ -28,7 +28,7 @@
 
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/formats/image.h"
-#include "mediapipe/framework/formats/image_frame_pool.h"
+#include "mediapipe/framework/formats/image_frame_multi_pool.h"
 
 #if !MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gpu_buffer.h"
@@ -118,16 +118,9 @@ class ImageMultiPool {
   std::deque<IBufferSpec> buffer_specs_gpu_;
 #endif  // !MEDIAPIPE_DISABLE_GPU
 
-  typedef std::shared_ptr<ImageFramePool> SimplePoolCpu;
-  SimplePoolCpu MakeSimplePoolCpu(IBufferSpec spec);
-  Image GetBufferFromSimplePool(IBufferSpec spec, const SimplePoolCpu& pool);
-
-  absl::Mutex mutex_cpu_;
-  std::unordered_map<IBufferSpec, SimplePoolCpu, IBufferSpecHash> pools_cpu_
-      ABSL_GUARDED_BY(mutex_cpu_);
-  // A queue of IBufferSpecs to keep track of the age of each IBufferSpec added
-  // to the pool.
-  std::deque<IBufferSpec> buffer_specs_cpu_;
+  // CPU buffers are shared across dimensions and formats.
+  std::shared_ptr<ImageFrameMultiPool> pool_cpu_ =
+      ImageFrameMultiPool::Create();
 
 #if !MEDIAPIPE_DISABLE_GPU
 #ifdef __APPLE__
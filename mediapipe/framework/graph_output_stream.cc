@@ -14,6 +14,8 @@
 
 #include "mediapipe/framework/graph_output_stream.h"
 
+#include <atomic>
+
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/port/status.h"
 
@@ -23,7 +25,8 @@ namespace internal {
 
 absl::Status GraphOutputStream::Initialize(
     const std::string& stream_name, const PacketType* packet_type,
-    OutputStreamManager* output_stream_manager, bool observe_timestamp_bounds) {
+    OutputStreamManager* output_stream_manager, bool observe_timestamp_bounds,
+    bool single_producer_single_consumer) {
   RET_CHECK(output_stream_manager);
 
   // Initializes input_stream_handler_ with one input stream as the observer.
@@ -37,8 +40,9 @@ absl::Status GraphOutputStream::Initialize(
   input_stream_handler_->SetProcessTimestampBounds(observe_timestamp_bounds);
   const CollectionItemId& id = tag_map->BeginId();
   input_stream_ = absl::make_unique<InputStreamManager>();
-  MP_RETURN_IF_ERROR(
-      input_stream_->Initialize(stream_name, packet_type, /*back_edge=*/false));
+  MP_RETURN_IF_ERROR(input_stream_->Initialize(
+      stream_name, packet_type, /*back_edge=*/false,
+      single_producer_single_consumer));
   MP_RETURN_IF_ERROR(input_stream_handler_->InitializeInputStreamManagers(
       input_stream_.get()));
   output_stream_manager->AddMirror(input_stream_handler_.get(), id);
@@ -125,10 +129,11 @@ absl::Status OutputStreamObserver::Notify() {
 absl::Status OutputStreamPollerImpl::Initialize(
     const std::string& stream_name, const PacketType* packet_type,
     std::function<void(InputStreamManager*, bool*)> queue_size_callback,
-    OutputStreamManager* output_stream_manager, bool observe_timestamp_bounds) {
-  MP_RETURN_IF_ERROR(GraphOutputStream::Initialize(stream_name, packet_type,
-                                                   output_stream_manager,
-                                                   observe_timestamp_bounds));
+    OutputStreamManager* output_stream_manager, bool observe_timestamp_bounds,
+    bool single_producer_single_consumer) {
+  MP_RETURN_IF_ERROR(GraphOutputStream::Initialize(
+      stream_name, packet_type, output_stream_manager, observe_timestamp_bounds,
+      single_producer_single_consumer));
   input_stream_handler_->SetQueueSizeCallbacks(queue_size_callback,
                                                queue_size_callback);
   return absl::OkStatus();
@@ -161,6 +166,15 @@ void OutputStreamPollerImpl::SetMaxQueueSize(int queue_size) {
 int OutputStreamPollerImpl::QueueSize() { return input_stream_->QueueSize(); }
 
 absl::Status OutputStreamPollerImpl::Notify() {
+  // The packet or timestamp bound is queued before Notify() is called, and
+  // a waiter increments num_waiters_ before it checks the queue, so either
+  // the waiter sees the update or it is counted here. The queue update need
+  // not be sequentially consistent, so this fence and the one in
+  // WaitForInput() keep each side's store ordered before its load.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (num_waiters_.load() == 0) {
+    return absl::OkStatus();
+  }
   mutex_.Lock();
   handler_condvar_.Signal();
   mutex_.Unlock();
@@ -174,26 +188,37 @@ void OutputStreamPollerImpl::NotifyError() {
   mutex_.Unlock();
 }
 
-bool OutputStreamPollerImpl::Next(Packet* packet) {
-  CHECK(packet);
-  bool empty_queue = true;
-  bool timestamp_bound_changed = false;
+Timestamp OutputStreamPollerImpl::WaitForInput(bool* empty_queue,
+                                               bool* timestamp_bound_changed) {
   Timestamp min_timestamp = Timestamp::Unset();
-  mutex_.Lock();
   while (true) {
-    min_timestamp = input_stream_->MinTimestampOrBound(&empty_queue);
-    if (empty_queue) {
-      timestamp_bound_changed =
+    num_waiters_.fetch_add(1);
+    // Pairs with the fence in Notify().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    min_timestamp = input_stream_->MinTimestampOrBound(empty_queue);
+    *timestamp_bound_changed = false;
+    if (*empty_queue) {
+      *timestamp_bound_changed =
           input_stream_handler_->ProcessTimestampBounds() &&
           output_timestamp_ < min_timestamp.PreviousAllowedInStream();
     }
-    if (graph_has_error_ || !empty_queue || timestamp_bound_changed ||
+    if (graph_has_error_ || !*empty_queue || *timestamp_bound_changed ||
         min_timestamp == Timestamp::Done()) {
-      break;
-    } else {
-      handler_condvar_.Wait(&mutex_);
+      num_waiters_.fetch_sub(1);
+      return min_timestamp;
     }
+    handler_condvar_.Wait(&mutex_);
+    num_waiters_.fetch_sub(1);
   }
+}
+
+bool OutputStreamPollerImpl::Next(Packet* packet) {
+  CHECK(packet);
+  bool empty_queue = true;
+  bool timestamp_bound_changed = false;
+  mutex_.Lock();
+  Timestamp min_timestamp =
+      WaitForInput(&empty_queue, &timestamp_bound_changed);
   if (graph_has_error_ && empty_queue) {
     mutex_.Unlock();
     return false;
@@ -221,5 +246,46 @@ bool OutputStreamPollerImpl::Next(Packet* packet) {
   return true;
 }
 
+bool OutputStreamPollerImpl::NextBatch(std::vector<Packet>* packets,
+                                       int max_packets) {
+  CHECK(packets);
+  CHECK_GT(max_packets, 0);
+  packets->clear();
+  bool empty_queue = true;
+  bool timestamp_bound_changed = false;
+  mutex_.Lock();
+  Timestamp min_timestamp =
+      WaitForInput(&empty_queue, &timestamp_bound_changed);
+  if ((graph_has_error_ && empty_queue) ||
+      min_timestamp == Timestamp::Done()) {
+    mutex_.Unlock();
+    return false;
+  }
+  if (empty_queue) {
+    output_timestamp_ = min_timestamp.PreviousAllowedInStream();
+    mutex_.Unlock();
+    packets->push_back(Packet().At(output_timestamp_));
+    return true;
+  }
+  mutex_.Unlock();
+  // Drains the packets which are already queued, without waiting for more.
+  Timestamp last_timestamp = min_timestamp;
+  while (!empty_queue && static_cast<int>(packets->size()) < max_packets) {
+    int num_packets_dropped = 0;
+    bool stream_is_done = false;
+    packets->push_back(input_stream_->PopPacketAtTimestamp(
+        min_timestamp, &num_packets_dropped, &stream_is_done));
+    CHECK_EQ(num_packets_dropped, 0)
+        << absl::Substitute("Dropped $0 packet(s) on input stream \"$1\".",
+                            num_packets_dropped, input_stream_->Name());
+    last_timestamp = min_timestamp;
+    min_timestamp = input_stream_->MinTimestampOrBound(&empty_queue);
+  }
+  mutex_.Lock();
+  output_timestamp_ = last_timestamp;
+  mutex_.Unlock();
+  return true;
+}
+
 }  // namespace internal
 }  // namespace mediapipe
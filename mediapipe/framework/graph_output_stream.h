@@ -15,6 +15,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_GRAPH_OUTPUT_STREAM_H_
 #define MEDIAPIPE_FRAMEWORK_GRAPH_OUTPUT_STREAM_H_
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
@@ -49,11 +50,14 @@ class GraphOutputStream {
   // Initializes an input stream handler that only manages one
   // input stream and attaches the input stream to an output stream as
   // the mirror for observation/polling.  Ownership of output_stream_manager
-  // is not transferred to the graph output stream object.
+  // is not transferred to the graph output stream object.  If
+  // single_producer_single_consumer is true, the mirror queues packets without
+  // taking a lock, see InputStreamManager.
   absl::Status Initialize(const std::string& stream_name,
                           const PacketType* packet_type,
                           OutputStreamManager* output_stream_manager,
-                          bool observe_timestamp_bounds = false);
+                          bool observe_timestamp_bounds = false,
+                          bool single_producer_single_consumer = false);
 
   // Installs callbacks into its GraphOutputStreamHandler.
   virtual void PrepareForRun(std::function<void()> notification_callback,
@@ -144,7 +148,8 @@ class OutputStreamPollerImpl : public GraphOutputStream {
       const std::string& stream_name, const PacketType* packet_type,
       std::function<void(InputStreamManager*, bool*)> queue_size_callback,
       OutputStreamManager* output_stream_manager,
-      bool observe_timestamp_bounds = false);
+      bool observe_timestamp_bounds = false,
+      bool single_producer_single_consumer = false);
 
   void PrepareForRun(std::function<void()> notification_callback,
                      std::function<void(absl::Status)> error_callback) override;
@@ -167,9 +172,26 @@ class OutputStreamPollerImpl : public GraphOutputStream {
   // done).  Returns true if successful.
   ABSL_MUST_USE_RESULT bool Next(Packet* packet);
 
+  // Replaces the contents of "packets" with the next packets, at most
+  // max_packets of them (block until at least one is available or the stream
+  // is done).  The capacity of "packets" is reused, so a caller that keeps
+  // the vector across calls does not allocate.  Returns true if successful.
+  ABSL_MUST_USE_RESULT bool NextBatch(std::vector<Packet>* packets,
+                                      int max_packets);
+
  private:
+  // Blocks until the mirror stream has a packet, a new timestamp bound, an
+  // error or is done.  Sets "empty_queue" and "timestamp_bound_changed" and
+  // returns the min timestamp or bound of the mirror stream.
+  Timestamp WaitForInput(bool* empty_queue, bool* timestamp_bound_changed)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   absl::Mutex mutex_;
   absl::CondVar handler_condvar_ ABSL_GUARDED_BY(mutex_);
+  // The number of threads blocked in WaitForInput().  Notify() only takes
+  // mutex_ to wake up a waiting thread, so a producer never contends with a
+  // consumer which is draining the queue.
+  std::atomic<int> num_waiters_{0};
   bool graph_has_error_ ABSL_GUARDED_BY(mutex_);
   Timestamp output_timestamp_ ABSL_GUARDED_BY(mutex_) = Timestamp::Min();
 };
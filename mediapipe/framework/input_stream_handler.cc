@@ -188,15 +188,26 @@ bool InputStreamHandler::ScheduleInvocations(int max_allowance,
           calculator_context, min_stream_timestamp);
       if (!late_preparation_) {
         FillInputSet(min_stream_timestamp, &calculator_context->Inputs());
+        if (IsSkippableInputSet(min_stream_timestamp,
+                                calculator_context->Inputs())) {
+          // Process would only move the output bounds by the timestamp
+          // offset, which the kNotReady branch above does once the input
+          // timestamp is consumed.
+          ClearCurrentInputs(calculator_context);
+          continue;
+        }
       }
       if (calculator_context_manager_->NumberOfContextTimestamps(
               *calculator_context) == batch_size_) {
         schedule_callback_(calculator_context);
         ++invocations_scheduled;
       }
+      // The timestamp is passed as packet_ts, which is only traced for stream
+      // events, so that the trace is unchanged.
       mediapipe::LogEvent(calculator_context->GetProfilingContext(),
                           TraceEvent(TraceEvent::READY_FOR_PROCESS)
-                              .set_node_id(calculator_context->NodeId()));
+                              .set_node_id(calculator_context->NodeId())
+                              .set_packet_ts(min_stream_timestamp));
     } else {
       CHECK(node_readiness == NodeReadiness::kReadyForClose);
       // If any parallel invocations are in progress or a calculator context has
@@ -231,6 +242,25 @@ void InputStreamHandler::FinalizeInputSet(Timestamp timestamp,
   }
 }
 
+bool InputStreamHandler::IsSkippableInputSet(
+    Timestamp input_timestamp, const InputStreamShardSet& input_set) const {
+  // Parallel contexts are recycled in timestamp order, and batches are only
+  // scheduled when full, so neither can drop an input timestamp here.
+  // Special timestamps, such as the one signaling that inputs are done, get
+  // special output bounds and are always processed.
+  if (!pure_offset_propagation_ || !process_timestamps_ ||
+      calculator_run_in_parallel_ || batch_size_ != 1 ||
+      !input_timestamp.IsRangeValue() || input_timestamp >= Timestamp::Max()) {
+    return false;
+  }
+  for (const InputStreamShard& shard : input_set) {
+    if (!shard.IsEmpty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Returns the default CalculatorContext.
 CalculatorContext* GetCalculatorContext(CalculatorContextManager* manager) {
   return (manager && manager->HasDefaultCalculatorContext())
@@ -249,10 +279,13 @@ void LogQueuedPackets(CalculatorContext* context, InputStreamManager* stream,
                            .set_event_data(stream->QueueSize() + 1);
     mediapipe::LogEvent(context->GetProfilingContext(),
                         event.set_packet_ts(queue_tail.Timestamp()));
-    Packet queue_head = stream->QueueHead();
-    if (!queue_head.IsEmpty()) {
+    // Only the timestamp of the queue head is needed, which, unlike the
+    // packet itself, can be read from the producer thread.
+    bool queue_is_empty;
+    Timestamp queue_head_ts = stream->MinTimestampOrBound(&queue_is_empty);
+    if (!queue_is_empty) {
       mediapipe::LogEvent(context->GetProfilingContext(),
-                          event.set_packet_ts(queue_head.Timestamp()));
+                          event.set_packet_ts(queue_head_ts));
     }
   }
 }
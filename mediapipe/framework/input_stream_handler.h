@@ -184,6 +184,13 @@ class InputStreamHandler {
   // When true, Calculator::Process is called for every input timestamp bound.
   bool ProcessTimestampBounds() { return process_timestamps_; }
 
+  // When true, input sets without packets are not scheduled for
+  // Calculator::Process, and only their timestamp bound is propagated.
+  // See CalculatorContract::SetPureOffsetPropagation.
+  void SetPureOffsetPropagation(bool pure_offset_propagation) {
+    pure_offset_propagation_ = pure_offset_propagation;
+  }
+
   // Returns the number of sync-sets populated by this input stream handler.
   virtual int SyncSetCount() { return 1; }
 
@@ -288,6 +295,12 @@ class InputStreamHandler {
   std::function<void(absl::Status)> error_callback_;
 
  private:
+  // Returns true if Calculator::Process can be skipped for the input set
+  // filled at input_timestamp, because it holds no packets and the calculator
+  // declared pure offset propagation.
+  bool IsSkippableInputSet(Timestamp input_timestamp,
+                           const InputStreamShardSet& input_set) const;
+
   // Indicates when to fill the input set. If true, every input set will be
   // prepared in FinalizeInputSet(). Otherwise, the input sets will be filled
   // in ScheduleInvocations() in the scheduling phase.
@@ -303,6 +316,9 @@ class InputStreamHandler {
   // When true, any increase in timestamp bound invokes Calculator::Process.
   bool process_timestamps_ = false;
 
+  // When true, input sets without packets skip Calculator::Process.
+  bool pure_offset_propagation_ = false;
+
   // A callback to notify the observer when all the input stream headers
   // (excluding headers of back edges) become available.
   std::function<void()> headers_ready_callback_;
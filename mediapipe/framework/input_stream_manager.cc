@@ -14,25 +14,234 @@
 
 #include "mediapipe/framework/input_stream_manager.h"
 
+#include <algorithm>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/packet.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/tool/status_util.h"
 
 namespace mediapipe {
 
-absl::Status InputStreamManager::Initialize(const std::string& name,
-                                            const PacketType* packet_type,
-                                            bool back_edge) {
+// The lock-free packet queue and stream state of a single-producer,
+// single-consumer stream.
+//
+// Packets are kept in a chain of ring buffers. The producer pushes to the last
+// ring, and links a new ring of twice the capacity when it is full. The
+// consumer pops from the first ring, and moves on to the next ring once the
+// first one is drained. Rings are only freed by Reset(), so that any thread can
+// read the timestamp of the front packet.
+//
+// The queue size and the next timestamp bound use sequentially consistent
+// operations: the producer updates one and then reads the other to decide
+// whether to notify the consumer, while the consumer does the opposite, and
+// either the producer notifies or the consumer sees the update. Readers load
+// the bound before looking at the queue, since the producer raises the bound
+// only after pushing the packets below it.
+struct InputStreamManager::SpscState {
+  struct Ring {
+    explicit Ring(int64 capacity)
+        : mask(capacity - 1),
+          packets(capacity),
+          timestamps(new std::atomic<int64>[capacity]) {}
+
+    const int64 mask;
+    std::vector<Packet> packets;
+    // The timestamps of |packets|, which can be read by any thread.
+    std::unique_ptr<std::atomic<int64>[]> timestamps;
+    // Slots [head, tail) hold packets. |head| is only written by the consumer
+    // and |tail| only by the producer.
+    std::atomic<int64> head{0};
+    std::atomic<int64> tail{0};
+    // The ring the producer moved on to when this one was full. |tail| does
+    // not change once |next| is set.
+    std::atomic<Ring*> next{nullptr};
+  };
+
+  // The capacity of the first ring. Must be a power of two.
+  static constexpr int64 kInitialCapacity = 16;
+
+  SpscState() { Reset(); }
+
+  // Empties the queue and resets the stream state. Keeps the largest ring for
+  // the next run. Must not be called concurrently with any other method.
+  void Reset() {
+    std::unique_ptr<Ring> ring =
+        rings.empty() ? absl::make_unique<Ring>(kInitialCapacity)
+                      : std::move(rings.back());
+    rings.clear();
+    for (Packet& packet : ring->packets) packet = Packet();
+    ring->head = 0;
+    ring->tail = 0;
+    ring->next = nullptr;
+    producer_ring = ring.get();
+    consumer_ring = ring.get();
+    rings.push_back(std::move(ring));
+    size = 0;
+    num_packets_added = 0;
+    next_timestamp_bound = Timestamp::PreStream().Value();
+    last_select_timestamp = Timestamp::Unstarted().Value();
+    closed = false;
+  }
+
+  // Appends |packet| to the queue. Called by the producer.
+  void Push(Packet packet) {
+    Ring* ring = producer_ring;
+    int64 tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->head.load(std::memory_order_acquire) > ring->mask) {
+      rings.push_back(absl::make_unique<Ring>(2 * (ring->mask + 1)));
+      Ring* next = rings.back().get();
+      ring->next.store(next, std::memory_order_release);
+      producer_ring = ring = next;
+      tail = 0;
+    }
+    const int64 slot = tail & ring->mask;
+    // Released so that a reader that sees this timestamp also sees that the
+    // previous packet in the slot was popped, see FrontTimestamp().
+    ring->timestamps[slot].store(packet.Timestamp().Value(),
+                                 std::memory_order_release);
+    ring->packets[slot] = std::move(packet);
+    ring->tail.store(tail + 1, std::memory_order_release);
+  }
+
+  // Returns the ring that holds the front packet, or nullptr if the queue is
+  // empty. Called by the consumer.
+  Ring* FrontRing() {
+    Ring* ring = consumer_ring.load(std::memory_order_relaxed);
+    while (true) {
+      Ring* next = ring->next.load(std::memory_order_acquire);
+      if (ring->head.load(std::memory_order_relaxed) !=
+          ring->tail.load(std::memory_order_acquire)) {
+        return ring;
+      }
+      if (next == nullptr) return nullptr;
+      consumer_ring.store(next, std::memory_order_release);
+      ring = next;
+    }
+  }
+
+  // Returns the front packet of |ring|, as returned by FrontRing().
+  static Packet& Front(Ring* ring) {
+    return ring->packets[ring->head.load(std::memory_order_relaxed) &
+                         ring->mask];
+  }
+
+  // Removes and returns the front packet of |ring|, as returned by
+  // FrontRing(). Returns the queue size before the pop.
+  int Pop(Ring* ring, Packet* packet) {
+    const int64 head = ring->head.load(std::memory_order_relaxed);
+    *packet = std::move(ring->packets[head & ring->mask]);
+    ring->head.store(head + 1, std::memory_order_release);
+    return size.fetch_sub(1);
+  }
+
+  // Sets |timestamp| to the timestamp of the front packet and returns true,
+  // or returns false if the queue is empty. Can be called from any thread.
+  bool FrontTimestamp(Timestamp* timestamp) const {
+    Ring* ring = consumer_ring.load(std::memory_order_acquire);
+    while (true) {
+      const int64 head = ring->head.load(std::memory_order_acquire);
+      Ring* next = ring->next.load(std::memory_order_acquire);
+      if (head != ring->tail.load(std::memory_order_acquire)) {
+        const int64 value =
+            ring->timestamps[head & ring->mask].load(std::memory_order_acquire);
+        // The slot is not reused until its packet is popped.
+        if (ring->head.load(std::memory_order_acquire) == head) {
+          *timestamp = Timestamp::CreateNoErrorChecking(value);
+          return true;
+        }
+      } else if (next != nullptr) {
+        ring = next;
+      } else {
+        return false;
+      }
+    }
+  }
+
+  // Returns the timestamp of the packet at |index| from the front, which must
+  // be less than the queue size. Called by the consumer.
+  Timestamp TimestampAt(int64 index) {
+    Ring* ring = FrontRing();
+    while (true) {
+      const int64 head = ring->head.load(std::memory_order_relaxed);
+      const int64 count = ring->tail.load(std::memory_order_acquire) - head;
+      if (index < count) {
+        return Timestamp::CreateNoErrorChecking(
+            ring->timestamps[(head + index) & ring->mask].load(
+                std::memory_order_relaxed));
+      }
+      index -= count;
+      ring = ring->next.load(std::memory_order_acquire);
+    }
+  }
+
+  Timestamp NextTimestampBound() const {
+    return Timestamp::CreateNoErrorChecking(next_timestamp_bound.load());
+  }
+
+  // Raises the next timestamp bound to |bound|. Returns false if the bound
+  // was already at least |bound|.
+  bool RaiseNextTimestampBound(Timestamp bound) {
+    int64 current = next_timestamp_bound.load();
+    while (current < bound.Value()) {
+      if (next_timestamp_bound.compare_exchange_weak(current, bound.Value())) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // All the rings, in order. Only accessed by the producer.
+  std::vector<std::unique_ptr<Ring>> rings;
+  Ring* producer_ring = nullptr;
+  // The ring the consumer pops from. Only written by the consumer.
+  std::atomic<Ring*> consumer_ring{nullptr};
+
+  // The number of packets in the queue.
+  std::atomic<int> size{0};
+  std::atomic<int64> num_packets_added{0};
+  std::atomic<int64> next_timestamp_bound{0};
+  std::atomic<int64> last_select_timestamp{0};
+  std::atomic<bool> closed{false};
+};
+
+namespace {
+
+absl::Status DecreasingTimestampBoundError(const std::string& name,
+                                           Timestamp current_bound,
+                                           Timestamp bound) {
+  return mediapipe::UnknownErrorBuilder(MEDIAPIPE_LOC)
+         << "SetNextTimestampBound must be called with a timestamp greater "
+            "than or equal to the current bound. In stream \""
+         << name << "\". Current minimum expected timestamp is "
+         << current_bound.DebugString() << " but received "
+         << bound.DebugString();
+}
+
+}  // namespace
+
+InputStreamManager::InputStreamManager() = default;
+InputStreamManager::~InputStreamManager() = default;
+
+absl::Status InputStreamManager::Initialize(
+    const std::string& name, const PacketType* packet_type, bool back_edge,
+    bool single_producer_single_consumer) {
   name_ = name;
   packet_type_ = packet_type;
   back_edge_ = back_edge;
+  if (single_producer_single_consumer) {
+    spsc_ = absl::make_unique<SpscState>();
+  } else {
+    spsc_ = nullptr;
+  }
   PrepareForRun();
   return absl::OkStatus();
 }
@@ -55,14 +264,24 @@ void InputStreamManager::PrepareForRun() {
   last_select_timestamp_ = Timestamp::Unstarted();
   closed_ = false;
   header_ = Packet();
+  if (spsc_) {
+    spsc_->Reset();
+  }
 }
 
 bool InputStreamManager::IsEmpty() const {
+  if (spsc_) {
+    return spsc_->size.load() == 0;
+  }
   absl::MutexLock stream_lock(&stream_mutex_);
   return queue_.empty();
 }
 
 Packet InputStreamManager::QueueHead() const {
+  if (spsc_) {
+    SpscState::Ring* ring = spsc_->FrontRing();
+    return ring ? SpscState::Front(ring) : Packet();
+  }
   absl::MutexLock stream_lock(&stream_mutex_);
   if (queue_.empty()) {
     return Packet();
@@ -90,9 +309,58 @@ absl::Status InputStreamManager::MovePackets(std::list<Packet>* container,
   return AddOrMovePacketsInternal<std::list<Packet>&>(*container, notify);
 }
 
+absl::Status InputStreamManager::ValidatePacket(
+    const Packet& packet, Timestamp next_timestamp_bound,
+    int64 num_packets_added) const {
+  absl::Status result = packet_type_->Validate(packet);
+  if (!result.ok()) {
+    return tool::AddStatusPrefix(
+        absl::StrCat(
+            "Packet type mismatch on a calculator receiving from stream \"",
+            name_, "\": "),
+        result);
+  }
+
+  const Timestamp timestamp = packet.Timestamp();
+  if (!timestamp.IsAllowedInStream()) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "In stream \"" << name_
+           << "\", timestamp not specified or set to illegal value: "
+           << timestamp.DebugString();
+  }
+  if (enable_timestamps_) {
+    // Check that PostStream(), if used, is the only timestamp used.  This
+    // is also true for PreStream() but doesn't need to be checked because
+    // Timestamp::PreStream().NextAllowedInStream() is
+    // Timestamp::OneOverPostStream().
+    if (timestamp == Timestamp::PostStream() && num_packets_added > 0) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "In stream \"" << name_
+             << "\", a packet at Timestamp::PostStream() must be the only "
+                "Packet in an InputStream.";
+    }
+    if (timestamp < next_timestamp_bound) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "Packet timestamp mismatch on a calculator receiving from "
+                "stream \""
+             << name_ << "\". Current minimum expected timestamp is "
+             << next_timestamp_bound.DebugString() << " but received "
+             << timestamp.DebugString()
+             << ". Are you using a custom InputStreamHandler? Note that "
+                "some InputStreamHandlers allow timestamps that are not "
+                "strictly monotonically increasing. See for example the "
+                "ImmediateInputStreamHandler class comment.";
+    }
+  }
+  return absl::OkStatus();
+}
+
 template <typename Container>
 absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
                                                           bool* notify) {
+  if (spsc_) {
+    return AddOrMovePacketsSpsc<Container>(container, notify);
+  }
   *notify = false;
   bool queue_became_non_empty = false;
   bool queue_became_full = false;
@@ -108,46 +376,9 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
     // Check if the queue becomes non-empty.
     queue_became_non_empty = queue_.empty() && !container.empty();
     for (auto& packet : container) {
-      absl::Status result = packet_type_->Validate(packet);
-      if (!result.ok()) {
-        return tool::AddStatusPrefix(
-            absl::StrCat(
-                "Packet type mismatch on a calculator receiving from stream \"",
-                name_, "\": "),
-            result);
-      }
-
+      MP_RETURN_IF_ERROR(
+          ValidatePacket(packet, next_timestamp_bound_, num_packets_added_));
       const Timestamp timestamp = packet.Timestamp();
-      if (!timestamp.IsAllowedInStream()) {
-        return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
-               << "In stream \"" << name_
-               << "\", timestamp not specified or set to illegal value: "
-               << timestamp.DebugString();
-      }
-      if (enable_timestamps_) {
-        // Check that PostStream(), if used, is the only timestamp used.  This
-        // is also true for PreStream() but doesn't need to be checked because
-        // Timestamp::PreStream().NextAllowedInStream() is
-        // Timestamp::OneOverPostStream().
-        if (timestamp == Timestamp::PostStream() && num_packets_added_ > 0) {
-          return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
-                 << "In stream \"" << name_
-                 << "\", a packet at Timestamp::PostStream() must be the only "
-                    "Packet in an InputStream.";
-        }
-        if (timestamp < next_timestamp_bound_) {
-          return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
-                 << "Packet timestamp mismatch on a calculator receiving from "
-                    "stream \""
-                 << name_ << "\". Current minimum expected timestamp is "
-                 << next_timestamp_bound_.DebugString() << " but received "
-                 << timestamp.DebugString()
-                 << ". Are you using a custom InputStreamHandler? Note that "
-                    "some InputStreamHandlers allow timestamps that are not "
-                    "strictly monotonically increasing. See for example the "
-                    "ImmediateInputStreamHandler class comment.";
-        }
-      }
       next_timestamp_bound_ = timestamp.NextAllowedInStream();
 
       // If the caller is MovePackets(), packet's underlying holder should be
@@ -180,8 +411,59 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
   return absl::OkStatus();
 }
 
+template <typename Container>
+absl::Status InputStreamManager::AddOrMovePacketsSpsc(Container container,
+                                                      bool* notify) {
+  *notify = false;
+  SpscState& spsc = *spsc_;
+  if (spsc.closed.load()) {
+    return absl::OkStatus();
+  }
+  bool queue_became_non_empty = false;
+  bool queue_became_full = false;
+  const int max_queue_size = max_queue_size_;
+  for (auto& packet : container) {
+    absl::Status status =
+        ValidatePacket(packet, spsc.NextTimestampBound(),
+                       spsc.num_packets_added.load(std::memory_order_relaxed));
+    if (!status.ok()) {
+      // A concurrent Close() sets |closed| before it raises the bound to
+      // Timestamp::Done(), so a packet rejected because of that bound belongs
+      // to a closed stream. It is dropped, as on the mutex path.
+      if (spsc.closed.load()) {
+        break;
+      }
+      return status;
+    }
+    const Timestamp timestamp = packet.Timestamp();
+    spsc.num_packets_added.fetch_add(1, std::memory_order_relaxed);
+    VLOG(3) << "Input stream:" << name_
+            << " has added packet at time: " << timestamp;
+    if (std::is_const<
+            typename std::remove_reference<Container>::type>::value) {
+      spsc.Push(packet);
+    } else {
+      spsc.Push(std::move(packet));
+    }
+    const int queue_size = spsc.size.fetch_add(1) + 1;
+    queue_became_non_empty |= (queue_size == 1);
+    queue_became_full |= (max_queue_size != -1 && queue_size == max_queue_size);
+    // Raised after the push, see SpscState.
+    spsc.RaiseNextTimestampBound(timestamp.NextAllowedInStream());
+  }
+  if (queue_became_full) {
+    VLOG(3) << "Queue became full: " << Name();
+    becomes_full_callback_(this, &last_reported_stream_full_);
+  }
+  *notify = queue_became_non_empty;
+  return absl::OkStatus();
+}
+
 absl::Status InputStreamManager::SetNextTimestampBound(const Timestamp bound,
                                                        bool* notify) {
+  if (spsc_) {
+    return SetNextTimestampBoundSpsc(bound, notify);
+  }
   *notify = false;
   {
     // Scope to prevent locking the stream when notification is called.
@@ -191,12 +473,7 @@ absl::Status InputStreamManager::SetNextTimestampBound(const Timestamp bound,
     }
 
     if (enable_timestamps_ && bound < next_timestamp_bound_) {
-      return mediapipe::UnknownErrorBuilder(MEDIAPIPE_LOC)
-             << "SetNextTimestampBound must be called with a timestamp greater "
-                "than or equal to the current bound. In stream \""
-             << name_ << "\". Current minimum expected timestamp is "
-             << next_timestamp_bound_.DebugString() << " but received "
-             << bound.DebugString();
+      return DecreasingTimestampBoundError(name_, next_timestamp_bound_, bound);
     }
 
     // Even if enable_timestamps_ is false, Timestamp::Done() is used to
@@ -216,9 +493,45 @@ absl::Status InputStreamManager::SetNextTimestampBound(const Timestamp bound,
   return absl::OkStatus();
 }
 
-void InputStreamManager::DisableTimestamps() { enable_timestamps_ = false; }
+absl::Status InputStreamManager::SetNextTimestampBoundSpsc(
+    const Timestamp bound, bool* notify) {
+  *notify = false;
+  SpscState& spsc = *spsc_;
+  if (spsc.closed.load()) {
+    return absl::OkStatus();
+  }
+  const Timestamp current_bound = spsc.NextTimestampBound();
+  if (bound < current_bound) {
+    // The bound may have been raised by a concurrent Close(), see
+    // AddOrMovePacketsSpsc.
+    if (spsc.closed.load()) {
+      return absl::OkStatus();
+    }
+    return DecreasingTimestampBoundError(name_, current_bound, bound);
+  }
+  if (spsc.RaiseNextTimestampBound(bound)) {
+    VLOG(3) << "Next timestamp bound for input " << name_ << " is " << bound;
+    // If the queue was not empty then a change to the next timestamp bound is
+    // not detectable by the consumer.
+    *notify = (spsc.size.load() == 0);
+  }
+  return absl::OkStatus();
+}
+
+void InputStreamManager::DisableTimestamps() {
+  enable_timestamps_ = false;
+  spsc_ = nullptr;
+}
 
 void InputStreamManager::Close() {
+  if (spsc_) {
+    if (spsc_->closed.exchange(true)) {
+      return;
+    }
+    spsc_->RaiseNextTimestampBound(Timestamp::Done());
+    spsc_->last_select_timestamp = Timestamp::Done().Value();
+    return;
+  }
   absl::MutexLock stream_lock(&stream_mutex_);
   if (closed_) {
     return;
@@ -229,6 +542,9 @@ void InputStreamManager::Close() {
 }
 
 Timestamp InputStreamManager::MinTimestampOrBound(bool* is_empty) const {
+  if (spsc_) {
+    return MinTimestampOrBoundSpsc(is_empty);
+  }
   absl::MutexLock stream_lock(&stream_mutex_);
   if (is_empty) {
     *is_empty = queue_.empty();
@@ -241,10 +557,25 @@ Timestamp InputStreamManager::MinTimestampOrBoundHelper() const
   return queue_.empty() ? next_timestamp_bound_ : queue_.front().Timestamp();
 }
 
+Timestamp InputStreamManager::MinTimestampOrBoundSpsc(bool* is_empty) const {
+  // The bound is read before the queue, see SpscState.
+  const Timestamp bound = spsc_->NextTimestampBound();
+  Timestamp front_timestamp;
+  const bool empty = !spsc_->FrontTimestamp(&front_timestamp);
+  if (is_empty) {
+    *is_empty = empty;
+  }
+  return empty ? bound : front_timestamp;
+}
+
 Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
                                                 int* num_packets_dropped,
                                                 bool* stream_is_done) {
   CHECK(enable_timestamps_);
+  if (spsc_) {
+    return PopPacketAtTimestampSpsc(timestamp, num_packets_dropped,
+                                    stream_is_done);
+  }
   *num_packets_dropped = -1;
   *stream_is_done = false;
   bool queue_became_non_full = false;
@@ -298,6 +629,60 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
   return packet;
 }
 
+Packet InputStreamManager::PopPacketAtTimestampSpsc(Timestamp timestamp,
+                                                    int* num_packets_dropped,
+                                                    bool* stream_is_done) {
+  SpscState& spsc = *spsc_;
+  *num_packets_dropped = -1;
+  *stream_is_done = false;
+  // Make sure timestamp didn't decrease from last time.
+  CHECK_LE(Timestamp::CreateNoErrorChecking(spsc.last_select_timestamp.load(
+               std::memory_order_relaxed)),
+           timestamp);
+  spsc.last_select_timestamp.store(timestamp.Value(),
+                                   std::memory_order_relaxed);
+
+  // Make sure AddPacket and SetNextTimestampBound are not called with
+  // timestamps we have already passed.
+  spsc.RaiseNextTimestampBound(timestamp.NextAllowedInStream());
+
+  VLOG(3) << "Input stream " << name_
+          << " selecting at timestamp:" << timestamp.Value()
+          << " next timestamp bound: " << spsc.NextTimestampBound();
+
+  // Advances time to timestamp.
+  const int max_queue_size = max_queue_size_;
+  bool queue_became_non_full = false;
+  Timestamp current_timestamp = Timestamp::Unset();
+  Packet packet;
+  SpscState::Ring* ring;
+  while ((ring = spsc.FrontRing()) != nullptr &&
+         SpscState::Front(ring).Timestamp() <= timestamp) {
+    const int queue_size = spsc.Pop(ring, &packet);
+    queue_became_non_full |=
+        (max_queue_size != -1 && queue_size == max_queue_size);
+    current_timestamp = packet.Timestamp();
+    ++(*num_packets_dropped);
+  }
+  // Clear value_ if it doesn't have exactly the right timestamp.
+  if (current_timestamp != timestamp) {
+    // The timestamp bound reported when no packet is sent.
+    Timestamp bound = MinTimestampOrBoundSpsc(nullptr);
+    packet = Packet().At(bound.PreviousAllowedInStream());
+    ++(*num_packets_dropped);
+  }
+
+  VLOG(3) << "Input stream removed packets:" << name_
+          << " Size:" << spsc.size.load();
+  *stream_is_done = spsc.NextTimestampBound() == Timestamp::Done() &&
+                    spsc.FrontRing() == nullptr;
+  if (queue_became_non_full) {
+    VLOG(3) << "Queue became non-full: " << Name();
+    becomes_not_full_callback_(this, &last_reported_stream_full_);
+  }
+  return packet;
+}
+
 Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
   CHECK(!enable_timestamps_);
   *stream_is_done = false;
@@ -332,28 +717,32 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
 }
 
 int InputStreamManager::NumPacketsAdded() const {
+  if (spsc_) {
+    return spsc_->num_packets_added.load(std::memory_order_relaxed);
+  }
   absl::MutexLock lock(&stream_mutex_);
   return num_packets_added_;
 }
 
 int InputStreamManager::QueueSize() const {
+  if (spsc_) {
+    return spsc_->size.load();
+  }
   absl::MutexLock lock(&stream_mutex_);
   return static_cast<int>(queue_.size());
 }
 
-int InputStreamManager::MaxQueueSize() const {
-  absl::MutexLock lock(&stream_mutex_);
-  return max_queue_size_;
-}
+int InputStreamManager::MaxQueueSize() const { return max_queue_size_; }
 
 void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
   bool was_full;
   bool is_full;
   {
     absl::MutexLock lock(&stream_mutex_);
-    was_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    const int queue_size = spsc_ ? spsc_->size.load() : queue_.size();
+    was_full = (max_queue_size_ != -1 && queue_size >= max_queue_size_);
     max_queue_size_ = max_queue_size;
-    is_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    is_full = (max_queue_size_ != -1 && queue_size >= max_queue_size_);
   }
 
   // QueueSizeCallback is called with no mutexes held.
@@ -367,11 +756,22 @@ void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
 }
 
 bool InputStreamManager::IsFull() const {
+  if (spsc_) {
+    const int max_queue_size = max_queue_size_;
+    return max_queue_size != -1 && spsc_->size.load() >= max_queue_size;
+  }
   absl::MutexLock lock(&stream_mutex_);
   return max_queue_size_ != -1 && queue_.size() >= max_queue_size_;
 }
 
 Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
+  if (spsc_) {
+    const int queue_size = spsc_->size.load();
+    if (queue_size == 0) {
+      return Timestamp::Unset();
+    }
+    return spsc_->TimestampAt(queue_size - std::min(n, queue_size));
+  }
   absl::MutexLock lock(&stream_mutex_);
   if (queue_.empty()) {
     return Timestamp::Unset();
@@ -380,6 +780,10 @@ Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
 }
 
 void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
+  if (spsc_) {
+    ErasePacketsEarlierThanSpsc(timestamp);
+    return;
+  }
   bool queue_became_non_full = false;
   {
     absl::MutexLock lock(&stream_mutex_);
@@ -401,6 +805,26 @@ void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
   }
 }
 
+void InputStreamManager::ErasePacketsEarlierThanSpsc(Timestamp timestamp) {
+  SpscState& spsc = *spsc_;
+  const int max_queue_size = max_queue_size_;
+  bool queue_became_non_full = false;
+  Packet packet;
+  SpscState::Ring* ring;
+  while ((ring = spsc.FrontRing()) != nullptr &&
+         SpscState::Front(ring).Timestamp() < timestamp) {
+    const int queue_size = spsc.Pop(ring, &packet);
+    queue_became_non_full |=
+        (max_queue_size != -1 && queue_size == max_queue_size);
+  }
+  VLOG(3) << "Input stream removed packets:" << name_
+          << " Size:" << spsc.size.load();
+  if (queue_became_non_full) {
+    VLOG(3) << "Queue became non-full: " << Name();
+    becomes_not_full_callback_(this, &last_reported_stream_full_);
+  }
+}
+
 bool InputStreamManager::IsDone() const {
   return queue_.empty() && next_timestamp_bound_ == Timestamp::Done();
 }
@@ -15,9 +15,11 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 
+#include <atomic>
 #include <deque>
 #include <functional>
 #include <list>
+#include <memory>
 #include <string>
 
 #include "absl/base/thread_annotations.h"
@@ -43,6 +45,17 @@ namespace mediapipe {
 // An input stream is written to by exactly one output stream and is read by a
 // single node. None of its methods should hold a lock when they invoke a
 // callback in the scheduler.
+//
+// By default, the packet queue and the timestamp bound are guarded by a mutex.
+// When the graph guarantees that the stream is written by only one thread at
+// a time and read by only one thread at a time (see
+// EdgeInfo::single_producer_single_consumer), the stream can instead keep its
+// packets in a lock-free single-producer/single-consumer queue, so that adding
+// and popping packets does not take any lock. In that mode, the producer
+// methods (AddPackets, MovePackets and SetNextTimestampBound) and the consumer
+// methods (PopPacketAtTimestamp, QueueHead, ErasePacketsEarlierThan and
+// GetMinTimestampAmongNLatest) must each be called by one thread at a time.
+// The remaining methods can be called from any thread.
 class InputStreamManager {
  public:
   // Function type for becomes_full_callback and becomes_not_full_callback.
@@ -54,11 +67,14 @@ class InputStreamManager {
   InputStreamManager(const InputStreamManager&) = delete;
   InputStreamManager& operator=(const InputStreamManager&) = delete;
 
-  InputStreamManager() = default;
+  InputStreamManager();
+  ~InputStreamManager();
 
-  // Initializes the InputStreamManager.
+  // Initializes the InputStreamManager. If |single_producer_single_consumer|
+  // is true, packets are queued without taking a lock, see above.
   absl::Status Initialize(const std::string& name,
-                          const PacketType* packet_type, bool back_edge);
+                          const PacketType* packet_type, bool back_edge,
+                          bool single_producer_single_consumer = false);
 
   // Returns the stream name.
   const std::string& Name() const;
@@ -114,9 +130,13 @@ class InputStreamManager {
   Timestamp MinTimestampOrBound(bool* is_empty) const
       ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
-  // Turns off the use of packet timestamps.
+  // Turns off the use of packet timestamps. This also turns off the lock-free
+  // queue, which relies on timestamps.
   void DisableTimestamps();
 
+  // Returns true if packets are queued without taking a lock.
+  bool IsSingleProducerSingleConsumer() const { return spsc_ != nullptr; }
+
   // Returns true iff the queue is empty.
   bool IsEmpty() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
@@ -195,6 +215,27 @@ class InputStreamManager {
   // Returns the smallest timestamp at which this stream might see an input.
   Timestamp MinTimestampOrBoundHelper() const;
 
+  // Returns an error if |packet| cannot be added to the stream, given the
+  // current next timestamp bound and number of packets added.
+  absl::Status ValidatePacket(const Packet& packet,
+                              Timestamp next_timestamp_bound,
+                              int64 num_packets_added) const;
+
+  // The lock-free counterparts of the methods above, used when spsc_ is set.
+  template <typename Container>
+  absl::Status AddOrMovePacketsSpsc(Container container, bool* notify);
+  absl::Status SetNextTimestampBoundSpsc(Timestamp bound, bool* notify);
+  Timestamp MinTimestampOrBoundSpsc(bool* is_empty) const;
+  Packet PopPacketAtTimestampSpsc(Timestamp timestamp, int* num_packets_dropped,
+                                  bool* stream_is_done);
+  void ErasePacketsEarlierThanSpsc(Timestamp timestamp);
+
+  // The state of the lock-free queue. Only set in single-producer,
+  // single-consumer mode, in which case it replaces the members guarded by
+  // stream_mutex_ below.
+  struct SpscState;
+  std::unique_ptr<SpscState> spsc_;
+
   mutable absl::Mutex stream_mutex_;
   std::deque<Packet> queue_ ABSL_GUARDED_BY(stream_mutex_);
   // The number of packets added to queue_.  Used to verify a packet at
@@ -213,8 +254,9 @@ class InputStreamManager {
   // The header packet of the input stream.
   Packet header_;
 
-  // The maximum queue size for this stream if set.
-  int max_queue_size_ ABSL_GUARDED_BY(stream_mutex_) = -1;
+  // The maximum queue size for this stream if set. Atomic since it is read
+  // without holding stream_mutex_ in single-producer/single-consumer mode.
+  std::atomic<int> max_queue_size_{-1};
 
   // Callback to notify the framework that we have hit the maximum queue size.
   QueueSizeCallback becomes_full_callback_;
@@ -15,18 +15,25 @@
 #include "mediapipe/framework/input_stream_manager.h"
 
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/input_stream_shard.h"
 #include "mediapipe/framework/lifetime_tracker.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/status_matchers.h"
 
 namespace mediapipe {
 namespace {
-class InputStreamManagerTest : public ::testing::Test {
+// The test parameter selects the lock-free single-producer/single-consumer
+// queue.
+class InputStreamManagerTest : public ::testing::TestWithParam<bool> {
  protected:
   InputStreamManagerTest() {}
 
@@ -42,8 +49,9 @@ class InputStreamManagerTest : public ::testing::Test {
 
     packet_type_.Set<std::string>();
     input_stream_manager_ = absl::make_unique<InputStreamManager>();
-    MP_ASSERT_OK(input_stream_manager_->Initialize("a_test", &packet_type_,
-                                                   /*back_edge=*/false));
+    MP_ASSERT_OK(input_stream_manager_->Initialize(
+        "a_test", &packet_type_,
+        /*back_edge=*/false, /*single_producer_single_consumer=*/GetParam()));
 
     queue_full_callback_ =
         std::bind(&InputStreamManagerTest::ReportQueueBecomesFull, this,
@@ -89,9 +97,15 @@ class InputStreamManagerTest : public ::testing::Test {
   int queue_becomes_not_full_count_;
 };
 
-TEST_F(InputStreamManagerTest, Init) {}
+INSTANTIATE_TEST_SUITE_P(SingleProducerSingleConsumer, InputStreamManagerTest,
+                         ::testing::Values(false, true));
 
-TEST_F(InputStreamManagerTest, AddPackets) {
+TEST_P(InputStreamManagerTest, Init) {
+  EXPECT_EQ(input_stream_manager_->IsSingleProducerSingleConsumer(),
+            GetParam());
+}
+
+TEST_P(InputStreamManagerTest, AddPackets) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -108,7 +122,7 @@ TEST_F(InputStreamManagerTest, AddPackets) {
   }
 }
 
-TEST_F(InputStreamManagerTest, MovePackets) {
+TEST_P(InputStreamManagerTest, MovePackets) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -128,7 +142,7 @@ TEST_F(InputStreamManagerTest, MovePackets) {
 // InputStreamManager should reject the four timestamps that are not allowed in
 // a stream: Timestamp::Unset(), Timestamp::Unstarted(),
 // Timestamp::OneOverPostStream(), and Timestamp::Done().
-TEST_F(InputStreamManagerTest, AddPacketUnset) {
+TEST_P(InputStreamManagerTest, AddPacketUnset) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp::Unset()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -139,7 +153,7 @@ TEST_F(InputStreamManagerTest, AddPacketUnset) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketUnstarted) {
+TEST_P(InputStreamManagerTest, AddPacketUnstarted) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::Unstarted()));
@@ -151,7 +165,7 @@ TEST_F(InputStreamManagerTest, AddPacketUnstarted) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketOneOverPostStream) {
+TEST_P(InputStreamManagerTest, AddPacketOneOverPostStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::OneOverPostStream()));
@@ -164,7 +178,7 @@ TEST_F(InputStreamManagerTest, AddPacketOneOverPostStream) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketDone) {
+TEST_P(InputStreamManagerTest, AddPacketDone) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp::Done()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -175,7 +189,7 @@ TEST_F(InputStreamManagerTest, AddPacketDone) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketsOnlyPreStream) {
+TEST_P(InputStreamManagerTest, AddPacketsOnlyPreStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PreStream()));
@@ -189,7 +203,7 @@ TEST_F(InputStreamManagerTest, AddPacketsOnlyPreStream) {
 
 // An attempt to add a packet after Timestamp::PreStream() should be rejected
 // because the next timestamp bound is Timestamp::OneOverPostStream().
-TEST_F(InputStreamManagerTest, AddPacketsAfterPreStream) {
+TEST_P(InputStreamManagerTest, AddPacketsAfterPreStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PreStream()));
@@ -203,7 +217,7 @@ TEST_F(InputStreamManagerTest, AddPacketsAfterPreStream) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketsOnlyPostStream) {
+TEST_P(InputStreamManagerTest, AddPacketsOnlyPostStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PostStream()));
@@ -217,7 +231,7 @@ TEST_F(InputStreamManagerTest, AddPacketsOnlyPostStream) {
 
 // A packet at Timestamp::PostStream() must be the only Packet in an input
 // stream.
-TEST_F(InputStreamManagerTest, AddPacketsBeforePostStream) {
+TEST_P(InputStreamManagerTest, AddPacketsBeforePostStream) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(
@@ -230,7 +244,7 @@ TEST_F(InputStreamManagerTest, AddPacketsBeforePostStream) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketsReverseTimestamps) {
+TEST_P(InputStreamManagerTest, AddPacketsReverseTimestamps) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(20)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(10)));
@@ -245,7 +259,7 @@ TEST_F(InputStreamManagerTest, AddPacketsReverseTimestamps) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, PopPacketAtTimestamp) {
+TEST_P(InputStreamManagerTest, PopPacketAtTimestamp) {
   std::string expected_value_at_10("packet 1");
   std::string expected_value_at_20("packet 2");
   std::string expected_value_at_30("packet 3");
@@ -329,7 +343,7 @@ TEST_F(InputStreamManagerTest, PopPacketAtTimestamp) {
   EXPECT_TRUE(stream_is_done_);
 }
 
-TEST_F(InputStreamManagerTest, PopQueueHead) {
+TEST_P(InputStreamManagerTest, PopQueueHead) {
   input_stream_manager_->DisableTimestamps();
   std::string expected_value_at_10("packet 1");
   std::string expected_value_at_20("packet 2");
@@ -393,7 +407,7 @@ TEST_F(InputStreamManagerTest, PopQueueHead) {
   EXPECT_TRUE(stream_is_done_);
 }
 
-TEST_F(InputStreamManagerTest, BadPacketType) {
+TEST_P(InputStreamManagerTest, BadPacketType) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<int>(10).At(Timestamp(10)));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -404,7 +418,7 @@ TEST_F(InputStreamManagerTest, BadPacketType) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, Close) {
+TEST_P(InputStreamManagerTest, Close) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -427,7 +441,7 @@ TEST_F(InputStreamManagerTest, Close) {
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
 }
 
-TEST_F(InputStreamManagerTest, ReuseInputStreamManager) {
+TEST_P(InputStreamManagerTest, ReuseInputStreamManager) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -480,7 +494,7 @@ TEST_F(InputStreamManagerTest, ReuseInputStreamManager) {
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
 }
 
-TEST_F(InputStreamManagerTest, MultipleNotifications) {
+TEST_P(InputStreamManagerTest, MultipleNotifications) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -516,7 +530,7 @@ TEST_F(InputStreamManagerTest, MultipleNotifications) {
   EXPECT_TRUE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, SetHeader) {
+TEST_P(InputStreamManagerTest, SetHeader) {
   Packet header = MakePacket<std::string>("blah");
   MP_ASSERT_OK(input_stream_manager_->SetHeader(header));
 
@@ -525,7 +539,7 @@ TEST_F(InputStreamManagerTest, SetHeader) {
   EXPECT_EQ(header.Timestamp(), input_stream_manager_->Header().Timestamp());
 }
 
-TEST_F(InputStreamManagerTest, BackwardsInTime) {
+TEST_P(InputStreamManagerTest, BackwardsInTime) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -592,7 +606,7 @@ TEST_F(InputStreamManagerTest, BackwardsInTime) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, SelectBackwardsInTime) {
+TEST_P(InputStreamManagerTest, SelectBackwardsInTime) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -636,7 +650,7 @@ TEST_F(InputStreamManagerTest, SelectBackwardsInTime) {
                "");
 }
 
-TEST_F(InputStreamManagerTest, TimestampBound) {
+TEST_P(InputStreamManagerTest, TimestampBound) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -746,7 +760,7 @@ TEST_F(InputStreamManagerTest, TimestampBound) {
             input_stream_manager_->MinTimestampOrBound(&is_empty));
 }
 
-TEST_F(InputStreamManagerTest, QueueSizeTest) {
+TEST_P(InputStreamManagerTest, QueueSizeTest) {
   std::list<Packet> packets;
   int max_queue_size = 2;
   input_stream_manager_->SetMaxQueueSize(max_queue_size);
@@ -783,11 +797,12 @@ TEST_F(InputStreamManagerTest, QueueSizeTest) {
   expected_queue_becomes_not_full_count_ = 1;
 }
 
-TEST_F(InputStreamManagerTest, InputReleaseTest) {
+TEST_P(InputStreamManagerTest, InputReleaseTest) {
   packet_type_.Set<LifetimeTracker::Object>();
   input_stream_manager_ = absl::make_unique<InputStreamManager>();
-  MP_ASSERT_OK(input_stream_manager_->Initialize("a_test", &packet_type_,
-                                                 /*back_edge=*/false));
+  MP_ASSERT_OK(input_stream_manager_->Initialize(
+      "a_test", &packet_type_,
+      /*back_edge=*/false, /*single_producer_single_consumer=*/GetParam()));
   input_stream_manager_->PrepareForRun();
   input_stream_manager_->SetQueueSizeCallbacks(queue_full_callback_,
                                                queue_not_full_callback_);
@@ -833,7 +848,7 @@ TEST_F(InputStreamManagerTest, InputReleaseTest) {
 
 // An attempt to add a packet after Timestamp::PreStream() should be allowed
 // if packet timestamps don't need to be increasing.
-TEST_F(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
+TEST_P(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
   input_stream_manager_->DisableTimestamps();
   std::list<Packet> packets;
   packets.push_back(
@@ -849,7 +864,7 @@ TEST_F(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
 
 // A packet at Timestamp::PostStream() doesn't need to be the only Packet in
 // an input stream if packet timestamps don't need to be increasing.
-TEST_F(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
+TEST_P(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
   input_stream_manager_->DisableTimestamps();
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
@@ -863,7 +878,7 @@ TEST_F(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
   EXPECT_TRUE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, BackwardsInTimeUntimed) {
+TEST_P(InputStreamManagerTest, BackwardsInTimeUntimed) {
   input_stream_manager_->DisableTimestamps();
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
@@ -924,5 +939,163 @@ TEST_F(InputStreamManagerTest, BackwardsInTimeUntimed) {
   EXPECT_TRUE(notify_);
 }
 
+TEST_P(InputStreamManagerTest, QueueGrowsAndShrinks) {
+  // More packets than fit in the initial ring of the lock-free queue.
+  constexpr int kNumPackets = 100;
+  for (int run = 0; run < 2; ++run) {
+    for (int i = 0; i < kNumPackets; ++i) {
+      MP_ASSERT_OK(input_stream_manager_->AddPackets(
+          {MakePacket<std::string>(absl::StrCat(i)).At(Timestamp(i))},
+          &notify_));
+      EXPECT_EQ(notify_, i == 0);
+      // Pops every third packet while the queue grows.
+      if (i % 3 == 2) {
+        popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+            Timestamp(i / 3), &num_packets_dropped_, &stream_is_done_);
+        EXPECT_EQ(popped_packet_.Get<std::string>(), absl::StrCat(i / 3));
+      }
+    }
+    const int num_popped = kNumPackets / 3;
+    EXPECT_EQ(input_stream_manager_->QueueSize(), kNumPackets - num_popped);
+    EXPECT_EQ(input_stream_manager_->GetMinTimestampAmongNLatest(10),
+              Timestamp(kNumPackets - 10));
+    input_stream_manager_->ErasePacketsEarlierThan(Timestamp(50));
+    for (int i = 50; i < kNumPackets; ++i) {
+      bool is_empty;
+      EXPECT_EQ(input_stream_manager_->MinTimestampOrBound(&is_empty),
+                Timestamp(i));
+      EXPECT_FALSE(is_empty);
+      popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+          Timestamp(i), &num_packets_dropped_, &stream_is_done_);
+      EXPECT_EQ(popped_packet_.Get<std::string>(), absl::StrCat(i));
+      EXPECT_EQ(num_packets_dropped_, 0);
+    }
+    EXPECT_TRUE(input_stream_manager_->IsEmpty());
+    input_stream_manager_->PrepareForRun();
+  }
+}
+
+// Adds packets and timestamp bounds on one thread while another thread pops
+// them, and checks that the consumer sees every packet and is notified
+// whenever it may have missed one.
+TEST_P(InputStreamManagerTest, ConcurrentProducerAndConsumer) {
+  constexpr int kNumPackets = 20000;
+  absl::Mutex mutex;
+  struct Notifications {
+    int count = 0;
+    int seen = 0;
+  } notifications;
+  std::thread producer([&]() {
+    for (int i = 0; i < kNumPackets; ++i) {
+      bool notify = false;
+      MP_EXPECT_OK(input_stream_manager_->AddPackets(
+          {MakePacket<std::string>("packet").At(Timestamp(2 * i))}, &notify));
+      if (notify) {
+        absl::MutexLock lock(&mutex);
+        ++notifications.count;
+      }
+      MP_EXPECT_OK(input_stream_manager_->SetNextTimestampBound(
+          Timestamp(2 * i + 2), &notify));
+      if (notify) {
+        absl::MutexLock lock(&mutex);
+        ++notifications.count;
+      }
+    }
+    bool notify = false;
+    MP_EXPECT_OK(input_stream_manager_->SetNextTimestampBound(
+        Timestamp::Done(), &notify));
+    if (notify) {
+      absl::MutexLock lock(&mutex);
+      ++notifications.count;
+    }
+  });
+
+  int num_packets_popped = 0;
+  bool done = false;
+  while (!done) {
+    bool is_empty;
+    Timestamp timestamp = input_stream_manager_->MinTimestampOrBound(&is_empty);
+    if (is_empty) {
+      if (timestamp == Timestamp::Done()) break;
+      // Waits for a notification, as the scheduler would.
+      absl::MutexLock lock(&mutex);
+      if (!mutex.AwaitWithTimeout(
+              absl::Condition(
+                  +[](Notifications* n) { return n->count > n->seen; },
+                  &notifications),
+              absl::Seconds(10))) {
+        ADD_FAILURE() << "The consumer was not notified of a packet or bound.";
+        break;
+      }
+      notifications.seen = notifications.count;
+      continue;
+    }
+    popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+        timestamp, &num_packets_dropped_, &done);
+    EXPECT_EQ(popped_packet_.Timestamp(), Timestamp(2 * num_packets_popped));
+    EXPECT_EQ(num_packets_dropped_, 0);
+    ++num_packets_popped;
+  }
+  producer.join();
+  EXPECT_EQ(num_packets_popped, kNumPackets);
+}
+
+// Closes the stream while another thread adds packets and timestamp bounds.
+// Packets added around the Close() call are dropped without an error.
+TEST_P(InputStreamManagerTest, ConcurrentCloseAndAddPackets) {
+  constexpr int kNumRuns = 200;
+  constexpr int kNumPackets = 1000;
+  for (int run = 0; run < kNumRuns; ++run) {
+    input_stream_manager_->PrepareForRun();
+    std::thread producer([&]() {
+      for (int i = 0; i < kNumPackets; ++i) {
+        bool notify = false;
+        MP_EXPECT_OK(input_stream_manager_->AddPackets(
+            {MakePacket<std::string>("packet").At(Timestamp(2 * i))},
+            &notify));
+        MP_EXPECT_OK(input_stream_manager_->SetNextTimestampBound(
+            Timestamp(2 * i + 2), &notify));
+      }
+    });
+    // Lets the producer run for a varying time before closing.
+    for (int i = 0; i < run * 10; ++i) {
+      std::this_thread::yield();
+    }
+    input_stream_manager_->Close();
+    producer.join();
+    bool notify = false;
+    MP_EXPECT_OK(input_stream_manager_->AddPackets(
+        {MakePacket<std::string>("packet").At(Timestamp(0))}, &notify));
+    EXPECT_FALSE(notify);
+  }
+}
+
+// Measures the cost of passing a packet through an input stream, with and
+// without the lock-free queue.
+void BM_AddAndPopPacket(benchmark::State& state) {
+  PacketType packet_type;
+  packet_type.SetAny();
+  InputStreamManager stream;
+  MEDIAPIPE_CHECK_OK(stream.Initialize(
+      "stream", &packet_type, /*back_edge=*/false,
+      /*single_producer_single_consumer=*/state.range(0)));
+  const Packet payload = MakePacket<int>(0);
+  std::list<Packet> packets;
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    packets.push_back(payload.At(Timestamp(timestamp)));
+    bool notify;
+    MEDIAPIPE_CHECK_OK(stream.MovePackets(&packets, &notify));
+    packets.clear();
+    bool is_empty;
+    stream.MinTimestampOrBound(&is_empty);
+    int num_packets_dropped;
+    bool stream_is_done;
+    benchmark::DoNotOptimize(stream.PopPacketAtTimestamp(
+        Timestamp(timestamp++), &num_packets_dropped, &stream_is_done));
+  }
+}
+BENCHMARK(BM_AddAndPopPacket)->ArgName("spsc")->Arg(0)->Arg(1);
+
 }  // namespace
 }  // namespace mediapipe
@@ -16,6 +16,7 @@
 #define MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_POLLER_H_
 
 #include <memory>
+#include <vector>
 
 #include "mediapipe/framework/graph_output_stream.h"
 
@@ -48,6 +49,22 @@ class OutputStreamPoller {
     return poller->Next(packet);
   }
 
+  // Replaces the contents of "packets" with the next packets, at most
+  // max_packets of them (block until at least one is available or the stream
+  // is done).  Returns true if successful.  This takes the poller lock once
+  // per batch rather than once per packet, and reuses the capacity of
+  // "packets", so a consumer which keeps the vector across calls does not
+  // allocate.
+  ABSL_MUST_USE_RESULT bool NextBatch(std::vector<Packet>* packets,
+                                      int max_packets) {
+    auto poller = internal_poller_impl_.lock();
+    if (!poller) {
+      packets->clear();
+      return false;
+    }
+    return poller->NextBatch(packets, max_packets);
+  }
+
   void SetMaxQueueSize(int queue_size) {
     auto poller = internal_poller_impl_.lock();
     CHECK(poller) << "OutputStreamPollerImpl is already destroyed.";
@@ -14,7 +14,10 @@
 
 #include "mediapipe/framework/packet.h"
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -26,32 +29,101 @@
 namespace mediapipe {
 namespace packet_internal {
 
+namespace {
+
+// The deleter of the std::shared_ptrs returned by GetHolderShared. Each of
+// them holds one reference to the holder.
+struct HolderRef {
+  HolderPtr ref;
+  void operator()(HolderBase* holder) { ref.reset(); }
+};
+
+// Holders that are owned by a std::shared_ptr that was passed to Create(), and
+// that is kept here while Packets refer to the holder.
+absl::Mutex shared_ptr_owners_mutex(absl::kConstInit);
+absl::flat_hash_map<const HolderBase*, std::shared_ptr<HolderBase>>&
+SharedPtrOwners() ABSL_EXCLUSIVE_LOCKS_REQUIRED(shared_ptr_owners_mutex) {
+  static auto* owners =
+      new absl::flat_hash_map<const HolderBase*, std::shared_ptr<HolderBase>>;
+  return *owners;
+}
+
+}  // namespace
+
 HolderBase::~HolderBase() {}
 
+void DestroyHolder(HolderBase* holder) {
+  if (holder->owned_by_shared_ptr_) {
+    std::shared_ptr<HolderBase> owner;
+    absl::MutexLock lock(&shared_ptr_owners_mutex);
+    // A Packet may have been created from the std::shared_ptr again since
+    // the last reference was dropped.
+    if (holder->ref_count_.load(std::memory_order_acquire) == 0) {
+      auto it = SharedPtrOwners().find(holder);
+      if (it != SharedPtrOwners().end()) {
+        owner = std::move(it->second);
+        SharedPtrOwners().erase(it);
+      }
+    }
+    return;
+  }
+  PacketArena* arena = holder->arena_;
+  if (arena == nullptr) {
+    delete holder;
+    return;
+  }
+  const size_t block_size = holder->arena_block_size_;
+  holder->~HolderBase();
+  arena->Deallocate(holder, block_size, PacketArena::kBlockAlignment);
+}
+
 Packet Create(HolderBase* holder) {
   Packet result;
-  result.holder_.reset(holder);
+  result.holder_ = HolderPtr(holder);
   return result;
 }
 
 Packet Create(HolderBase* holder, Timestamp timestamp) {
   Packet result;
-  result.holder_.reset(holder);
+  result.holder_ = HolderPtr(holder);
   result.timestamp_ = timestamp;
   return result;
 }
 
-Packet Create(std::shared_ptr<HolderBase> holder, Timestamp timestamp) {
+Packet Create(HolderPtr holder, Timestamp timestamp) {
   Packet result;
   result.holder_ = std::move(holder);
   result.timestamp_ = timestamp;
   return result;
 }
 
+Packet Create(std::shared_ptr<HolderBase> holder, Timestamp timestamp) {
+  if (holder != nullptr && std::get_deleter<HolderRef>(holder) == nullptr) {
+    // The holder is owned by the std::shared_ptr, which is kept alive for as
+    // long as Packets refer to the holder.
+    absl::MutexLock lock(&shared_ptr_owners_mutex);
+    holder->owned_by_shared_ptr_ = true;
+    SharedPtrOwners().try_emplace(holder.get(), holder);
+    return Create(HolderPtr(holder.get()), timestamp);
+  }
+  return Create(HolderPtr(holder.get()), timestamp);
+}
+
 const HolderBase* GetHolder(const Packet& packet) {
   return packet.holder_.get();
 }
 
+std::shared_ptr<HolderBase> GetHolderShared(const Packet& packet) {
+  return GetHolderShared(Packet(packet));
+}
+
+std::shared_ptr<HolderBase> GetHolderShared(Packet&& packet) {
+  HolderPtr holder = GetHolderPtr(std::move(packet));
+  if (holder == nullptr) return nullptr;
+  HolderBase* ptr = holder.get();
+  return std::shared_ptr<HolderBase>(ptr, HolderRef{std::move(holder)});
+}
+
 absl::StatusOr<Packet> PacketFromDynamicProto(const std::string& type_name,
                                               const std::string& serialized) {
   ASSIGN_OR_RETURN(
@@ -17,8 +17,11 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PACKET_H_
 #define MEDIAPIPE_FRAMEWORK_PACKET_H_
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <new>
 #include <string>
 #include <type_traits>
 
@@ -28,6 +31,7 @@
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/deps/no_destructor.h"
 #include "mediapipe/framework/deps/registration.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
@@ -47,11 +51,65 @@ class Packet;
 namespace packet_internal {
 class HolderBase;
 
+// A reference-counted pointer to a HolderBase. The reference count is stored
+// in the holder itself, so copying a HolderPtr touches a single cache line.
+class HolderPtr {
+ public:
+  HolderPtr() = default;
+  HolderPtr(std::nullptr_t) {}  // NOLINT(runtime/explicit)
+  // Takes a new reference to |holder|, which may be a newly created holder.
+  explicit HolderPtr(HolderBase* holder);
+  HolderPtr(const HolderPtr& other) : HolderPtr(other.holder_) {}
+  HolderPtr(HolderPtr&& other) : holder_(other.holder_) {
+    other.holder_ = nullptr;
+  }
+  HolderPtr& operator=(const HolderPtr& other);
+  HolderPtr& operator=(HolderPtr&& other);
+  ~HolderPtr() { reset(); }
+
+  // Drops the reference, and destroys the holder if it was the last one.
+  void reset();
+
+  HolderBase* get() const { return holder_; }
+  HolderBase* operator->() const { return holder_; }
+  HolderBase& operator*() const { return *holder_; }
+  explicit operator bool() const { return holder_ != nullptr; }
+
+  // Returns true if this is the only reference to the holder.
+  bool unique() const;
+
+  friend bool operator==(const HolderPtr& p, std::nullptr_t) {
+    return p.holder_ == nullptr;
+  }
+  friend bool operator!=(const HolderPtr& p, std::nullptr_t) {
+    return p.holder_ != nullptr;
+  }
+  friend bool operator==(const HolderPtr& p1, const HolderPtr& p2) {
+    return p1.holder_ == p2.holder_;
+  }
+  friend bool operator!=(const HolderPtr& p1, const HolderPtr& p2) {
+    return p1.holder_ != p2.holder_;
+  }
+
+ private:
+  HolderBase* holder_ = nullptr;
+};
+
+template <typename H, typename... Args>
+HolderBase* NewHolder(Args&&... args);
+template <typename T, typename... Args>
+HolderBase* NewPayloadHolder(Args&&... args);
+
 Packet Create(HolderBase* holder);
 Packet Create(HolderBase* holder, Timestamp timestamp);
+Packet Create(HolderPtr holder, Timestamp timestamp);
 Packet Create(std::shared_ptr<HolderBase> holder, Timestamp timestamp);
 const HolderBase* GetHolder(const Packet& packet);
-const std::shared_ptr<HolderBase>& GetHolderShared(const Packet& packet);
+const HolderPtr& GetHolderPtr(const Packet& packet);
+HolderPtr GetHolderPtr(Packet&& packet);
+// Returns a std::shared_ptr that shares the ownership of the packet's holder.
+// Prefer GetHolderPtr, which does not allocate.
+std::shared_ptr<HolderBase> GetHolderShared(const Packet& packet);
 std::shared_ptr<HolderBase> GetHolderShared(Packet&& packet);
 absl::StatusOr<Packet> PacketFromDynamicProto(const std::string& type_name,
                                               const std::string& serialized);
@@ -109,6 +167,8 @@ class Packet {
   // Transfers the ownership of holder's data to a unique pointer
   // of the object if the packet is the sole owner of a non-foreign
   // holder. Otherwise, returns error when the packet can't be consumed.
+  // The data of a packet made by MakePacket may be stored in its holder, see
+  // NewPayloadHolder. It is then moved to a new object, at another address.
   // See ConsumeOrCopy for threading requirements and example usage.
   template <typename T>
   absl::StatusOr<std::unique_ptr<T>> Consume();
@@ -209,20 +269,19 @@ class Packet {
   friend Packet packet_internal::Create(packet_internal::HolderBase* holder);
   friend Packet packet_internal::Create(packet_internal::HolderBase* holder,
                                         class Timestamp timestamp);
-  friend Packet packet_internal::Create(
-      std::shared_ptr<packet_internal::HolderBase> holder,
-      class Timestamp timestamp);
+  friend Packet packet_internal::Create(packet_internal::HolderPtr holder,
+                                        class Timestamp timestamp);
   friend const packet_internal::HolderBase* packet_internal::GetHolder(
       const Packet& packet);
-  friend const std::shared_ptr<packet_internal::HolderBase>&
-  packet_internal::GetHolderShared(const Packet& packet);
-  friend std::shared_ptr<packet_internal::HolderBase>
-  packet_internal::GetHolderShared(Packet&& packet);
+  friend const packet_internal::HolderPtr& packet_internal::GetHolderPtr(
+      const Packet& packet);
+  friend packet_internal::HolderPtr packet_internal::GetHolderPtr(
+      Packet&& packet);
 
   friend class PacketType;
   absl::Status ValidateAsType(TypeId type_id) const;
 
-  std::shared_ptr<packet_internal::HolderBase> holder_;
+  packet_internal::HolderPtr holder_;
   class Timestamp timestamp_;
 };
 
@@ -308,7 +367,8 @@ template <typename T,
           typename std::enable_if<!std::is_array<T>::value>::type* = nullptr,
           typename... Args>
 Packet MakePacket(Args&&... args) {  // NOLINT(build/c++11)
-  return Adopt(new T(std::forward<Args>(args)...));
+  return packet_internal::Create(
+      packet_internal::NewPayloadHolder<T>(std::forward<Args>(args)...));
 }
 
 // Version for arrays. We have to use reinterpret_cast because new T[N]
@@ -393,8 +453,38 @@ class HolderBase {
   GetVectorOfProtoMessageLite() const = 0;
 
   virtual bool HasForeignOwner() const { return false; }
+
+  // Returns true if the payload is stored within the holder, rather than
+  // allocated separately.
+  virtual bool HasInlinePayload() const { return false; }
+
+ private:
+  friend class HolderPtr;
+  template <typename H, typename... Args>
+  friend HolderBase* NewHolder(Args&&... args);
+  friend void DestroyHolder(HolderBase* holder);
+  friend Packet Create(std::shared_ptr<HolderBase> holder, Timestamp timestamp);
+
+  void Ref() const { ref_count_.fetch_add(1, std::memory_order_relaxed); }
+  void Unref() const {
+    if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      DestroyHolder(const_cast<HolderBase*>(this));
+    }
+  }
+
+  // The number of HolderPtrs referring to this holder.
+  mutable std::atomic<int> ref_count_{0};
+  // If the holder was allocated in a PacketArena, the size of its block.
+  uint16_t arena_block_size_ = 0;
+  // True if the holder is owned by a std::shared_ptr passed to Create().
+  bool owned_by_shared_ptr_ = false;
+  // The arena the holder was allocated in, or null.
+  PacketArena* arena_ = nullptr;
 };
 
+// Destroys a holder that has no references left.
+void DestroyHolder(HolderBase* holder);
+
 // Two helper functions to get the proto base pointers.
 template <typename T>
 const proto_ns::MessageLite* ConvertToProtoMessageLite(const T* data,
@@ -519,6 +609,18 @@ class Holder : public HolderBase {
       return InternalError(
           "Foreign holder can't release data ptr without ownership.");
     }
+    if (HasInlinePayload()) {
+      // The payload cannot outlive the holder it is stored in, so it is
+      // moved to a new object. NewPayloadHolder only stores payloads which
+      // are nothrow move-constructible in their holder.
+      if constexpr (std::is_nothrow_move_constructible<U>::value) {
+        return absl::make_unique<T>(std::move(*const_cast<T*>(ptr_)));
+      } else {
+        return absl::InternalError(
+            "Can't release a payload that is stored in its holder and is "
+            "not move-constructible.");
+      }
+    }
     // Casts away constness to make the data mutable after the release.
     std::unique_ptr<T> data_ptr(const_cast<T*>(ptr_));
     ptr_ = nullptr;
@@ -594,6 +696,85 @@ class ForeignHolder : public Holder<T> {
   bool HasForeignOwner() const final { return true; }
 };
 
+// Like Holder, but stores its data within itself, so that the data and the
+// holder are allocated together.
+template <typename T>
+class InlineHolder : public Holder<T> {
+ public:
+  template <typename... Args>
+  explicit InlineHolder(Args&&... args) : Holder<T>(nullptr) {
+    this->ptr_ = new (&storage_) T(std::forward<Args>(args)...);
+  }
+  ~InlineHolder() override {
+    this->ptr_->~T();
+    // Null out ptr_ so it doesn't get deleted by ~Holder.
+    this->ptr_ = nullptr;
+  }
+  bool HasInlinePayload() const final { return true; }
+
+ private:
+  alignas(T) unsigned char storage_[sizeof(T)];
+};
+
+// Returns a new holder of a T constructed from @args. The T is stored in the
+// holder, so that a single allocation holds the payload, the holder and the
+// reference count, if Holder<T>::Release can move it out. Otherwise, it is
+// allocated on its own and the holder points to it.
+template <typename T, typename... Args>
+HolderBase* NewPayloadHolder(Args&&... args) {
+  if constexpr (std::is_nothrow_move_constructible<T>::value) {
+    return NewHolder<InlineHolder<T>>(std::forward<Args>(args)...);
+  } else {
+    return NewHolder<Holder<T>>(new T(std::forward<Args>(args)...));
+  }
+}
+
+// Returns a new holder of type H. The holder is allocated in the current
+// PacketArena, if there is one and the holder fits in its blocks.
+template <typename H, typename... Args>
+HolderBase* NewHolder(Args&&... args) {
+  PacketArena* arena = PacketArena::Current();
+  if (arena == nullptr || sizeof(H) > PacketArena::kMaxBlockSize ||
+      alignof(H) > PacketArena::kBlockAlignment) {
+    return new H(std::forward<Args>(args)...);
+  }
+  void* block = arena->Allocate(sizeof(H), PacketArena::kBlockAlignment);
+  H* holder = new (block) H(std::forward<Args>(args)...);
+  holder->arena_ = arena;
+  holder->arena_block_size_ = sizeof(H);
+  return holder;
+}
+
+inline HolderPtr::HolderPtr(HolderBase* holder) : holder_(holder) {
+  if (holder_ != nullptr) holder_->Ref();
+}
+
+inline HolderPtr& HolderPtr::operator=(const HolderPtr& other) {
+  if (other.holder_ != nullptr) other.holder_->Ref();
+  reset();
+  holder_ = other.holder_;
+  return *this;
+}
+
+inline HolderPtr& HolderPtr::operator=(HolderPtr&& other) {
+  if (this != &other) {
+    reset();
+    holder_ = other.holder_;
+    other.holder_ = nullptr;
+  }
+  return *this;
+}
+
+inline void HolderPtr::reset() {
+  HolderBase* holder = holder_;
+  holder_ = nullptr;
+  if (holder != nullptr) holder->Unref();
+}
+
+inline bool HolderPtr::unique() const {
+  return holder_->ref_count_.load(std::memory_order_acquire) == 1;
+}
+
 template <typename T>
 Holder<T>* HolderBase::As() {
   if (PayloadIsOfType<T>()) {
@@ -763,13 +944,15 @@ inline Timestamp Packet::Timestamp() const { return timestamp_; }
 template <typename T>
 Packet Adopt(const T* ptr) {
   CHECK(ptr != nullptr);
-  return packet_internal::Create(new packet_internal::Holder<T>(ptr));
+  return packet_internal::Create(
+      packet_internal::NewHolder<packet_internal::Holder<T>>(ptr));
 }
 
 template <typename T>
 Packet PointToForeign(const T* ptr) {
   CHECK(ptr != nullptr);
-  return packet_internal::Create(new packet_internal::ForeignHolder<T>(ptr));
+  return packet_internal::Create(
+      packet_internal::NewHolder<packet_internal::ForeignHolder<T>>(ptr));
 }
 
 // Equal Packets refer to the same memory contents, like equal pointers.
@@ -782,12 +965,11 @@ inline bool operator!=(const Packet& p1, const Packet& p2) {
 
 namespace packet_internal {
 
-inline const std::shared_ptr<HolderBase>& GetHolderShared(
-    const Packet& packet) {
+inline const HolderPtr& GetHolderPtr(const Packet& packet) {
   return packet.holder_;
 }
 
-inline std::shared_ptr<HolderBase> GetHolderShared(Packet&& packet) {
+inline HolderPtr GetHolderPtr(Packet&& packet) {
   return std::move(packet.holder_);
 }
 
@@ -0,0 +1,170 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_arena.h"
+
+#include <new>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/base/attributes.h"
+
+namespace mediapipe {
+
+// The free blocks of the current arena that were freed on this thread.
+struct PacketArena::ThreadCache {
+  // The current arena of the thread.
+  PacketArena* arena = nullptr;
+  // Per size class, a list of blocks, its last block and its length.
+  FreeBlock* first[kNumSizeClasses] = {};
+  FreeBlock* last[kNumSizeClasses] = {};
+  int64_t num_blocks[kNumSizeClasses] = {};
+};
+
+// static
+PacketArena::ThreadCache& PacketArena::GetThreadCache() {
+  ABSL_CONST_INIT thread_local ThreadCache cache;
+  return cache;
+}
+
+// static
+std::shared_ptr<PacketArena> PacketArena::Create() {
+  return std::shared_ptr<PacketArena>(
+      new PacketArena(), [](PacketArena* arena) { arena->Unref(1); });
+}
+
+void PacketArena::Unref(int64_t count) {
+  if (num_references_.fetch_sub(count, std::memory_order_acq_rel) == count) {
+    delete this;
+  }
+}
+
+void* PacketArena::Allocate(size_t size, size_t alignment) {
+  if (!UsesSlabs(size, alignment)) {
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      return ::operator new(size, std::align_val_t(alignment));
+    }
+    return ::operator new(size);
+  }
+  const int index = SizeClassIndex(size);
+  ThreadCache& cache = GetThreadCache();
+  if (cache.arena == this && cache.first[index] != nullptr) {
+    FreeBlock* block = cache.first[index];
+    cache.first[index] = block->next;
+    --cache.num_blocks[index];
+    return block;
+  }
+
+  num_references_.fetch_add(1, std::memory_order_relaxed);
+  SizeClass& size_class = size_classes_[index];
+  while (size_class.locked.exchange(true, std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
+  FreeBlock* block = size_class.free_list.load(std::memory_order_acquire);
+  while (block != nullptr &&
+         !size_class.free_list.compare_exchange_weak(
+             block, block->next, std::memory_order_acquire,
+             std::memory_order_acquire)) {
+  }
+  void* result = block;
+  if (block == nullptr) {
+    const size_t block_size = (index + 1) * kBlockAlignment;
+    if (size_class.slab_next == size_class.slab_end) {
+      AddSlab(&size_class, block_size);
+    }
+    result = size_class.slab_next;
+    size_class.slab_next += block_size;
+  }
+  size_class.locked.store(false, std::memory_order_release);
+  return result;
+}
+
+void PacketArena::Deallocate(void* block, size_t size, size_t alignment) {
+  if (!UsesSlabs(size, alignment)) {
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      ::operator delete(block, std::align_val_t(alignment));
+    } else {
+      ::operator delete(block);
+    }
+    return;
+  }
+  const int index = SizeClassIndex(size);
+  FreeBlock* free_block = static_cast<FreeBlock*>(block);
+  ThreadCache& cache = GetThreadCache();
+  if (cache.arena == this) {
+    if (cache.first[index] == nullptr) cache.last[index] = free_block;
+    free_block->next = cache.first[index];
+    cache.first[index] = free_block;
+    ++cache.num_blocks[index];
+    return;
+  }
+  PushBlocks(index, free_block, free_block);
+  Unref(1);
+}
+
+void PacketArena::PushBlocks(int index, FreeBlock* first, FreeBlock* last) {
+  std::atomic<FreeBlock*>& free_list = size_classes_[index].free_list;
+  last->next = free_list.load(std::memory_order_relaxed);
+  while (!free_list.compare_exchange_weak(last->next, first,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+  }
+}
+
+void PacketArena::Flush(ThreadCache* cache) {
+  int64_t num_blocks = 0;
+  for (int index = 0; index < kNumSizeClasses; ++index) {
+    if (cache->first[index] == nullptr) continue;
+    PushBlocks(index, cache->first[index], cache->last[index]);
+    num_blocks += cache->num_blocks[index];
+    cache->first[index] = nullptr;
+    cache->last[index] = nullptr;
+    cache->num_blocks[index] = 0;
+  }
+  if (num_blocks > 0) Unref(num_blocks);
+}
+
+void PacketArena::AddSlab(SizeClass* size_class, size_t block_size) {
+  constexpr size_t kSlabElements = kSlabSize / sizeof(std::max_align_t);
+  std::unique_ptr<std::max_align_t[]> slab(
+      new std::max_align_t[kSlabElements]);
+  char* begin = reinterpret_cast<char*>(slab.get());
+  size_class->slab_next = begin;
+  // Only whole blocks are handed out.
+  size_class->slab_end = begin + (kSlabSize / block_size) * block_size;
+  absl::MutexLock lock(&slabs_mutex_);
+  slabs_.push_back(std::move(slab));
+  num_slabs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// static
+PacketArena* PacketArena::Current() { return GetThreadCache().arena; }
+
+PacketArena::Scope::Scope(PacketArena* arena) {
+  ThreadCache& cache = GetThreadCache();
+  saved_ = cache.arena;
+  if (arena != saved_) {
+    if (saved_ != nullptr) saved_->Flush(&cache);
+    cache.arena = arena;
+  }
+}
+
+PacketArena::Scope::~Scope() {
+  ThreadCache& cache = GetThreadCache();
+  if (cache.arena != saved_) {
+    if (cache.arena != nullptr) cache.arena->Flush(&cache);
+    cache.arena = saved_;
+  }
+}
+
+}  // namespace mediapipe
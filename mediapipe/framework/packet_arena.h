@@ -0,0 +1,156 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace mediapipe {
+
+// A slab allocator for small, short-lived framework objects, in particular the
+// holders of Packets, which also hold their reference counts and, for Packets
+// created with MakePacket, their payloads.
+//
+// Memory is carved out of large slabs, one set of slabs per size class, and
+// freed blocks are kept on per-class free lists for reuse. While an arena is
+// current on a thread (see Scope), the blocks freed on that thread are cached
+// in thread-local free lists, from which allocations on the thread are served
+// without any atomic operation. The cache is returned to the shared free
+// lists when the scope is left. Outside of a scope, blocks can still be
+// allocated and freed from any thread: frees are lock-free, and allocations
+// take a per-class spin lock. Requests that are larger than kMaxBlockSize, or
+// that need a stronger alignment than std::max_align_t, are passed on to
+// operator new.
+//
+// The arena is destroyed, and its slabs released, once the shared_ptr returned
+// by Create() and all blocks allocated from slabs are gone. Packets allocated
+// in the arena can thus safely outlive its owner.
+//
+// A CalculatorGraph with `use_packet_arena: true` owns an arena and makes it
+// current while its calculators run, so that the Packets they create are
+// allocated in it.
+class PacketArena {
+ public:
+  // The largest block served from the slabs, in bytes.
+  static constexpr size_t kMaxBlockSize = 256;
+  // The size and the alignment of blocks are multiples of this.
+  static constexpr size_t kBlockAlignment = alignof(std::max_align_t);
+  // The size of each slab, in bytes.
+  static constexpr size_t kSlabSize = 16 * 1024;
+
+  static std::shared_ptr<PacketArena> Create();
+
+  PacketArena(const PacketArena&) = delete;
+  PacketArena& operator=(const PacketArena&) = delete;
+
+  // Returns a block of at least |size| bytes aligned to |alignment|.
+  void* Allocate(size_t size, size_t alignment);
+
+  // Returns a block obtained from Allocate with the same size and alignment.
+  // This method is thread-safe and lock-free for blocks served from slabs.
+  void Deallocate(void* block, size_t size, size_t alignment);
+
+  // Returns the number of slabs allocated so far.
+  int NumSlabs() const { return num_slabs_.load(std::memory_order_relaxed); }
+
+  // Returns the arena that is current on this thread, or nullptr.
+  static PacketArena* Current();
+
+  // Makes |arena| the current arena of this thread while the scope is alive,
+  // and restores the previous one when it is left. |arena| may be null, in
+  // which case no arena is current within the scope. The owner of |arena|
+  // must keep it alive until the scope is left.
+  class Scope {
+   public:
+    explicit Scope(PacketArena* arena);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    PacketArena* saved_;
+  };
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct ThreadCache;
+
+  // The slabs and the free blocks of one block size.
+  struct SizeClass {
+    // Freed blocks. Blocks are pushed without holding |locked|, and only
+    // popped while holding it, which rules out the ABA problem: a block at
+    // the head of the list cannot be popped and pushed back concurrently.
+    std::atomic<FreeBlock*> free_list{nullptr};
+    // A spin lock, since it is only held for a few instructions, and an
+    // absl::Mutex would cost more than the allocation it replaces.
+    std::atomic<bool> locked{false};
+    // The unused part of the most recent slab. Guarded by |locked|.
+    char* slab_next = nullptr;
+    char* slab_end = nullptr;
+  };
+
+  static constexpr int kNumSizeClasses = kMaxBlockSize / kBlockAlignment;
+
+  PacketArena() = default;
+  ~PacketArena() = default;
+
+  // Returns the cache of the calling thread. Its arena is the current arena.
+  static ThreadCache& GetThreadCache();
+
+  // Returns the blocks in |cache| to the shared free lists.
+  void Flush(ThreadCache* cache);
+
+  // Pushes the chain of blocks from |first| to |last| to a shared free list.
+  void PushBlocks(int index, FreeBlock* first, FreeBlock* last);
+
+  // Drops |count| references, and deletes the arena if they were the last.
+  void Unref(int64_t count);
+
+  // Returns true if a block of |size| and |alignment| is served from slabs.
+  static bool UsesSlabs(size_t size, size_t alignment) {
+    return size <= kMaxBlockSize && alignment <= kBlockAlignment;
+  }
+
+  static int SizeClassIndex(size_t size) {
+    return size == 0 ? 0 : (size - 1) / kBlockAlignment;
+  }
+
+  // Allocates a new slab for |size_class|, whose blocks are |block_size|
+  // bytes long. Must be called while holding the lock of |size_class|.
+  void AddSlab(SizeClass* size_class, size_t block_size);
+
+  // One reference for the owner, plus one per block served from slabs that is
+  // in use or in a thread cache.
+  std::atomic<int64_t> num_references_{1};
+  SizeClass size_classes_[kNumSizeClasses];
+  absl::Mutex slabs_mutex_;
+  std::vector<std::unique_ptr<std::max_align_t[]>> slabs_
+      ABSL_GUARDED_BY(slabs_mutex_);
+  std::atomic<int> num_slabs_{0};
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
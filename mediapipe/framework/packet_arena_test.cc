@@ -0,0 +1,225 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_arena.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
+
+// Counts the heap allocations of the test, for the benchmarks below.
+static std::atomic<int64_t> num_heap_allocations(0);
+
+void* operator new(size_t size) {
+  num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace mediapipe {
+namespace {
+
+TEST(PacketArenaTest, HoldersAreAllocatedInCurrentArena) {
+  auto arena = PacketArena::Create();
+  EXPECT_EQ(PacketArena::Current(), nullptr);
+  {
+    PacketArena::Scope scope(arena.get());
+    ASSERT_NE(PacketArena::Current(), nullptr);
+    EXPECT_EQ(PacketArena::Current(), arena.get());
+    for (int i = 0; i < 10000; ++i) {
+      Packet packet = MakePacket<int>(i).At(Timestamp(i));
+      Packet copy = packet;
+      EXPECT_EQ(copy.Get<int>(), i);
+    }
+  }
+  EXPECT_EQ(PacketArena::Current(), nullptr);
+  // Every holder was returned to the free list before the next was created.
+  EXPECT_EQ(arena->NumSlabs(), 1);
+}
+
+TEST(PacketArenaTest, ScopesNest) {
+  auto arena = PacketArena::Create();
+  PacketArena::Scope scope(arena.get());
+  {
+    PacketArena::Scope no_arena_scope(nullptr);
+    EXPECT_EQ(PacketArena::Current(), nullptr);
+  }
+  EXPECT_EQ(PacketArena::Current(), arena.get());
+}
+
+TEST(PacketArenaTest, PacketsOutliveArenaOwner) {
+  auto arena = PacketArena::Create();
+  Packet packet;
+  Packet foreign_packet;
+  static const int kForeignValue = 7;
+  {
+    PacketArena::Scope scope(arena.get());
+    packet = MakePacket<std::string>("payload");
+    foreign_packet = PointToForeign(&kForeignValue);
+  }
+  arena.reset();
+  EXPECT_EQ(packet.Get<std::string>(), "payload");
+  EXPECT_EQ(foreign_packet.Get<int>(), kForeignValue);
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<std::string> payload,
+                          packet.Consume<std::string>());
+  EXPECT_EQ(*payload, "payload");
+  EXPECT_TRUE(packet.IsEmpty());
+}
+
+TEST(PacketArenaTest, BlocksCanBeFreedOnOtherThreads) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumPackets = 10000;
+  auto arena = PacketArena::Create();
+  std::vector<std::vector<Packet>> packets(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&arena, &packets, t]() {
+      PacketArena::Scope scope(arena.get());
+      for (int i = 0; i < kNumPackets; ++i) {
+        packets[t].push_back(MakePacket<int>(t * kNumPackets + i));
+        // Frees every other block while the other threads allocate, so that
+        // allocations race with frees. The remaining blocks are freed by the
+        // main thread.
+        if (i % 2 == 1) packets[t][i - 1] = Packet();
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (int t = 0; t < kNumThreads; ++t) {
+    for (int i = 1; i < kNumPackets; i += 2) {
+      EXPECT_EQ(packets[t][i].Get<int>(), t * kNumPackets + i);
+    }
+  }
+}
+
+TEST(PacketArenaTest, LargeAndOveralignedBlocksUseOperatorNew) {
+  auto arena = PacketArena::Create();
+  void* large = arena->Allocate(PacketArena::kMaxBlockSize + 1, 8);
+  struct alignas(64) Overaligned {
+    char data[64];
+  };
+  void* overaligned =
+      arena->Allocate(sizeof(Overaligned), alignof(Overaligned));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(overaligned) % alignof(Overaligned),
+            0);
+  EXPECT_EQ(arena->NumSlabs(), 0);
+  arena->Deallocate(large, PacketArena::kMaxBlockSize + 1, 8);
+  arena->Deallocate(overaligned, sizeof(Overaligned), alignof(Overaligned));
+}
+
+// Outputs a new packet for every input, and records whether a packet arena
+// was current while running.
+class ArenaCheckingCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    if (PacketArena::Current() != nullptr) ++num_runs_in_arena;
+    cc->Outputs().Index(0).Add(new int(cc->Inputs().Index(0).Get<int>() + 1),
+                               cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+
+  static std::atomic<int> num_runs_in_arena;
+};
+std::atomic<int> ArenaCheckingCalculator::num_runs_in_arena(0);
+REGISTER_CALCULATOR(ArenaCheckingCalculator);
+
+void RunArenaCheckingGraph(bool use_packet_arena,
+                           std::vector<Packet>* output_packets) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          calculator: "ArenaCheckingCalculator"
+          input_stream: "in"
+          output_stream: "mid"
+        }
+        node {
+          calculator: "ArenaCheckingCalculator"
+          input_stream: "mid"
+          output_stream: "out"
+        }
+      )pb");
+  config.set_use_packet_arena(use_packet_arena);
+  tool::AddVectorSink("out", &config, output_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 100; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+TEST(PacketArenaTest, GraphOptionEnablesArena) {
+  std::vector<Packet> output_packets;
+  ArenaCheckingCalculator::num_runs_in_arena = 0;
+  RunArenaCheckingGraph(/*use_packet_arena=*/false, &output_packets);
+  EXPECT_EQ(ArenaCheckingCalculator::num_runs_in_arena, 0);
+
+  output_packets.clear();
+  RunArenaCheckingGraph(/*use_packet_arena=*/true, &output_packets);
+  EXPECT_EQ(ArenaCheckingCalculator::num_runs_in_arena, 200);
+  // The output packets outlive the graph and its arena.
+  ASSERT_EQ(output_packets.size(), 100);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(output_packets[i].Get<int>(), i + 2);
+  }
+}
+
+// Measures the cost of creating, copying and destroying a packet, with and
+// without an arena. The "allocs" counter is the number of heap allocations per
+// packet, including the one for the payload.
+void BM_MakePacket(benchmark::State& state) {
+  std::shared_ptr<PacketArena> arena;
+  if (state.range(0)) arena = PacketArena::Create();
+  PacketArena::Scope scope(arena.get());
+  const int64_t num_allocations_before = num_heap_allocations.load();
+  int value = 0;
+  for (auto _ : state) {
+    Packet packet = MakePacket<int>(value++).At(Timestamp(value));
+    Packet copy = packet;
+    benchmark::DoNotOptimize(copy);
+  }
+  state.counters["allocs"] = benchmark::Counter(
+      num_heap_allocations.load() - num_allocations_before,
+      benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_MakePacket)->ArgName("arena")->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace mediapipe
@@ -22,6 +22,7 @@
 
 #include "absl/strings/str_cat.h"
 #include "mediapipe/framework/packet_test.pb.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/core_proto_inc.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -517,5 +518,97 @@ TEST(PacketTest, SharedPtrWithPacketOwnership) {
   EXPECT_EQ(exist, false);
 }
 
+TEST(PacketTest, MakePacketStoresPayloadInHolder) {
+  Packet packet = MakePacket<std::string>("payload");
+  const std::string* payload = &packet.Get<std::string>();
+  const void* holder = packet_internal::GetHolder(packet);
+  // The payload is allocated together with its holder.
+  EXPECT_GE(reinterpret_cast<const char*>(payload),
+            reinterpret_cast<const char*>(holder));
+  EXPECT_LT(reinterpret_cast<const char*>(payload),
+            reinterpret_cast<const char*>(holder) + 256);
+}
+
+TEST(PacketTest, ConsumeMovesPayloadOutOfHolder) {
+  Packet packet = MakePacket<std::string>("payload");
+  const std::string* payload = &packet.Get<std::string>();
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<std::string> result,
+                          packet.Consume<std::string>());
+  EXPECT_NE(result.get(), payload);
+  EXPECT_EQ(*result, "payload");
+  EXPECT_TRUE(packet.IsEmpty());
+}
+
+TEST(PacketTest, ConsumeNonMovablePayload) {
+  // A payload which cannot be moved is not stored in its holder, so that it
+  // can still be consumed, at its own address.
+  bool exist;
+  Packet packet = MakePacket<MyClass>(&exist);
+  const MyClass* payload = &packet.Get<MyClass>();
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<MyClass> result,
+                          packet.Consume<MyClass>());
+  EXPECT_EQ(result.get(), payload);
+  EXPECT_TRUE(packet.IsEmpty());
+  EXPECT_EQ(exist, true);
+  result = nullptr;
+  EXPECT_EQ(exist, false);
+}
+
+TEST(PacketTest, GetHolderSharedSharesOwnership) {
+  bool exist;
+  Packet packet = MakePacket<MyClass>(&exist).At(Timestamp(1));
+  std::shared_ptr<packet_internal::HolderBase> holder =
+      packet_internal::GetHolderShared(packet);
+  EXPECT_EQ(holder.get(), packet_internal::GetHolder(packet));
+  packet = {};
+  EXPECT_EQ(exist, true);
+
+  // A packet created from the shared_ptr refers to the same holder.
+  Packet recreated = packet_internal::Create(holder, Timestamp(2));
+  EXPECT_EQ(packet_internal::GetHolder(recreated), holder.get());
+  holder = nullptr;
+  EXPECT_EQ(exist, true);
+  recreated = {};
+  EXPECT_EQ(exist, false);
+}
+
+TEST(PacketTest, CreateFromForeignSharedPtr) {
+  bool exist;
+  auto holder =
+      std::make_shared<packet_internal::Holder<MyClass>>(new MyClass(&exist));
+  Packet packet = packet_internal::Create(holder, Timestamp(1));
+  Packet copy = packet_internal::Create(holder, Timestamp(2));
+  EXPECT_EQ(packet_internal::GetHolder(packet), holder.get());
+  EXPECT_EQ(packet_internal::GetHolderShared(copy), holder);
+  // The holder is kept alive by the shared_ptr or by any of the packets.
+  holder = nullptr;
+  EXPECT_EQ(exist, true);
+  packet = {};
+  EXPECT_EQ(exist, true);
+  copy = {};
+  EXPECT_EQ(exist, false);
+}
+
+// Measures the cost of handing a packet to |fan_out| consumers: copying it
+// once per consumer, and releasing all the copies. Arg 0 of "make_packet"
+// uses Adopt, which allocates the payload separately from its holder.
+void BM_PacketFanOut(benchmark::State& state) {
+  const int fan_out = state.range(0);
+  const bool make_packet = state.range(1);
+  std::vector<Packet> copies(fan_out);
+  int value = 0;
+  for (auto _ : state) {
+    Packet packet = make_packet ? MakePacket<int>(value++)
+                                : Adopt(new int(value++));
+    for (Packet& copy : copies) copy = packet;
+    benchmark::DoNotOptimize(copies.data());
+    for (Packet& copy : copies) copy = Packet();
+  }
+  state.SetItemsProcessed(state.iterations() * fan_out);
+}
+BENCHMARK(BM_PacketFanOut)
+    ->ArgNames({"fan_out", "make_packet"})
+    ->ArgsProduct({{1, 4, 16, 64}, {0, 1}});
+
 }  // namespace
 }  // namespace mediapipe
@@ -0,0 +1,232 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+#include <algorithm>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+
+namespace mediapipe {
+
+namespace {
+
+using EventType = GraphTrace::EventType;
+
+// Device events are shown on tracks numbered after any thread.
+constexpr int32 kDeviceTrackBase = 1 << 20;
+
+// Returns true for events timed on a device rather than on a thread.
+bool IsDeviceEvent(EventType event_type) {
+  return event_type == GraphTrace::GPU_TASK ||
+         event_type == GraphTrace::DSP_TASK ||
+         event_type == GraphTrace::TPU_TASK ||
+         event_type == GraphTrace::GPU_CALIBRATION;
+}
+
+// Returns true for calculator calls that output packets.
+bool IsFlowSource(EventType event_type) {
+  return event_type == GraphTrace::OPEN || event_type == GraphTrace::PROCESS ||
+         event_type == GraphTrace::CLOSE;
+}
+
+// Returns true for calculator calls that consume packets.
+bool IsFlowTarget(EventType event_type) {
+  return event_type == GraphTrace::PROCESS || event_type == GraphTrace::CLOSE;
+}
+
+int32 TrackId(const GraphTrace::CalculatorTrace& calculator_trace) {
+  return IsDeviceEvent(calculator_trace.event_type())
+             ? kDeviceTrackBase + calculator_trace.event_type()
+             : calculator_trace.thread_id();
+}
+
+// Returns a quoted JSON string.
+std::string JsonString(absl::string_view s) {
+  std::string result = "\"";
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(&result, "\\u%04x", static_cast<int>(c));
+        } else {
+          result += c;
+        }
+    }
+  }
+  result += "\"";
+  return result;
+}
+
+}  // namespace
+
+ChromeTraceWriter::ChromeTraceWriter(int64 pid,
+                                     std::vector<std::string> node_names)
+    : pid_(pid), node_names_(std::move(node_names)) {}
+
+void ChromeTraceWriter::StartTrace(std::string* out) {
+  out->append("[\n");
+  first_event_ = true;
+  named_tracks_.clear();
+  AppendEvent(absl::StrFormat(R"({"name":"process_name","ph":"M","pid":%d,)"
+                              R"("args":{"name":"MediaPipe graph %d"}})",
+                              pid_, pid_),
+              out);
+}
+
+void ChromeTraceWriter::AppendTrace(const GraphTrace& trace,
+                                    std::string* out) {
+  const int64 base_time = trace.base_time();
+  const int64 base_ts = trace.base_timestamp();
+  auto stream_name = [&trace](int32 stream_id) {
+    return stream_id < trace.stream_name_size() ? trace.stream_name(stream_id)
+                                                : absl::StrCat(stream_id);
+  };
+
+  // Index the calls that output each packet.
+  previous_flow_sources_ = std::move(flow_sources_);
+  flow_sources_.clear();
+  for (const auto& calculator_trace : trace.calculator_trace()) {
+    if (!IsFlowSource(calculator_trace.event_type()) ||
+        !calculator_trace.has_finish_time()) {
+      continue;
+    }
+    // The flow begins just before the end of the call, so that it is bound
+    // to the call rather than to the one that follows it on the track.
+    int64 time = base_time + calculator_trace.finish_time();
+    if (calculator_trace.has_start_time()) {
+      time = std::max(base_time + calculator_trace.start_time(), time - 1);
+    }
+    for (const auto& output_trace : calculator_trace.output_trace()) {
+      PacketKey key{output_trace.stream_id(),
+                    base_ts + output_trace.packet_timestamp()};
+      flow_sources_[key] = {TrackId(calculator_trace), time};
+    }
+  }
+
+  for (const auto& calculator_trace : trace.calculator_trace()) {
+    const EventType event_type = calculator_trace.event_type();
+    const int32 track_id = TrackId(calculator_trace);
+
+    // Input queue sizes are shown as counters.
+    if (event_type == GraphTrace::PACKET_QUEUED) {
+      for (const auto& input_trace : calculator_trace.input_trace()) {
+        const int64 time = base_time + (input_trace.has_finish_time()
+                                            ? input_trace.finish_time()
+                                            : calculator_trace.start_time());
+        AppendEvent(
+            absl::StrFormat(
+                R"({"name":%s,"ph":"C","pid":%d,"ts":%d,)"
+                R"("args":{"packets":%d}})",
+                JsonString(absl::StrCat(stream_name(input_trace.stream_id()),
+                                        " queue")),
+                pid_, time, input_trace.event_data()),
+            out);
+      }
+      continue;
+    }
+
+    NameTrack(track_id, out);
+    std::string common = absl::StrFormat(
+        R"("name":%s,"cat":"%s","pid":%d,"tid":%d)",
+        JsonString(NodeName(calculator_trace.node_id())),
+        GraphTrace::EventType_Name(event_type), pid_, track_id);
+    std::string args;
+    if (calculator_trace.has_input_timestamp()) {
+      args = absl::StrFormat(R"(,"args":{"input_timestamp":%d})",
+                             base_ts + calculator_trace.input_timestamp());
+    }
+    if (calculator_trace.has_start_time() &&
+        calculator_trace.has_finish_time()) {
+      const int64 duration = std::max<int64>(
+          0, calculator_trace.finish_time() - calculator_trace.start_time());
+      AppendEvent(absl::StrFormat(R"({%s,"ph":"X","ts":%d,"dur":%d%s})",
+                                  common,
+                                  base_time + calculator_trace.start_time(),
+                                  duration, args),
+                  out);
+    } else {
+      const int64 time = calculator_trace.has_start_time()
+                             ? calculator_trace.start_time()
+                             : calculator_trace.finish_time();
+      AppendEvent(absl::StrFormat(R"({%s,"ph":"i","s":"t","ts":%d%s})",
+                                  common, base_time + time, args),
+                  out);
+    }
+
+    // Link each input packet to the call that output it.
+    if (!IsFlowTarget(event_type) || !calculator_trace.has_start_time()) {
+      continue;
+    }
+    const int64 start_time = base_time + calculator_trace.start_time();
+    for (const auto& input_trace : calculator_trace.input_trace()) {
+      PacketKey key{input_trace.stream_id(),
+                    base_ts + input_trace.packet_timestamp()};
+      auto source = flow_sources_.find(key);
+      if (source == flow_sources_.end()) {
+        source = previous_flow_sources_.find(key);
+        if (source == previous_flow_sources_.end()) continue;
+      }
+      const int64 flow_id = next_flow_id_++;
+      std::string name = JsonString(stream_name(input_trace.stream_id()));
+      AppendEvent(absl::StrFormat(R"({"name":%s,"cat":"packet","ph":"s",)"
+                                  R"("id":%d,"pid":%d,"tid":%d,"ts":%d})",
+                                  name, flow_id, pid_, source->second.track_id,
+                                  source->second.time),
+                  out);
+      AppendEvent(absl::StrFormat(R"({"name":%s,"cat":"packet","ph":"f",)"
+                                  R"("bp":"e","id":%d,"pid":%d,"tid":%d,)"
+                                  R"("ts":%d})",
+                                  name, flow_id, pid_, track_id, start_time),
+                  out);
+    }
+  }
+}
+
+void ChromeTraceWriter::AppendEvent(absl::string_view event,
+                                    std::string* out) {
+  absl::StrAppend(out, first_event_ ? "" : ",\n", event);
+  first_event_ = false;
+}
+
+void ChromeTraceWriter::NameTrack(int32 track_id, std::string* out) {
+  if (!named_tracks_.insert(track_id).second) {
+    return;
+  }
+  std::string name =
+      track_id >= kDeviceTrackBase
+          ? GraphTrace::EventType_Name(
+                static_cast<EventType>(track_id - kDeviceTrackBase))
+          : absl::StrCat("Thread ", track_id);
+  AppendEvent(absl::StrFormat(R"({"name":"thread_name","ph":"M","pid":%d,)"
+                              R"("tid":%d,"args":{"name":%s}})",
+                              pid_, track_id, JsonString(name)),
+              out);
+}
+
+std::string ChromeTraceWriter::NodeName(int32 node_id) const {
+  if (node_id >= 0 && node_id < node_names_.size()) {
+    return node_names_[node_id];
+  }
+  return absl::StrCat("node_", node_id);
+}
+
+}  // namespace mediapipe
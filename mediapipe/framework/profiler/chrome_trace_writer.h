@@ -0,0 +1,90 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// Writes GraphTraces as Chrome trace-event JSON, which can be opened in the
+// Perfetto UI or in chrome://tracing.
+//
+// Each calculator call becomes a slice on the track of the thread that ran it.
+// GPU, DSP and TPU task events go on one track per device. Each packet read
+// by a calculator is linked by a flow arrow to the call that output it, and
+// input queue sizes are shown as counters.
+//
+// The trace is written incrementally, one GraphTrace at a time, as returned
+// by GraphTracer::GetTrace or GraphTracer::GetLog. The trace is readable after
+// every GraphTrace, since the closing bracket of the JSON array is optional.
+// Flow arrows are only linked between consecutive GraphTraces, so that memory
+// use stays bounded however long the graph runs.
+//
+// ChromeTraceWriter is not thread-safe.
+class ChromeTraceWriter {
+ public:
+  // The `pid` identifies the graph in the trace, and `node_names` are the
+  // names of the calculator nodes indexed by node_id.
+  ChromeTraceWriter(int64 pid, std::vector<std::string> node_names);
+
+  // Begins a new trace, such as for a new log file.
+  void StartTrace(std::string* out);
+
+  // Appends the events of a GraphTrace to the current trace.
+  void AppendTrace(const GraphTrace& trace, std::string* out);
+
+ private:
+  // The call that output a packet, where its flow arrows begin.
+  struct FlowSource {
+    int32 track_id;
+    int64 time;
+  };
+  // A packet, identified by stream_id and packet timestamp.
+  using PacketKey = std::pair<int32, int64>;
+
+  // Appends one JSON event object.
+  void AppendEvent(absl::string_view event, std::string* out);
+
+  // Appends the metadata naming a track, the first time it is used.
+  void NameTrack(int32 track_id, std::string* out);
+
+  // Returns the name of a calculator node.
+  std::string NodeName(int32 node_id) const;
+
+  const int64 pid_;
+  const std::vector<std::string> node_names_;
+
+  // True until the first event of the current trace is written.
+  bool first_event_ = true;
+  // The tracks named in the current trace.
+  absl::flat_hash_set<int32> named_tracks_;
+  // The output packets of the latest and the previous GraphTrace.
+  absl::flat_hash_map<PacketKey, FlowSource> flow_sources_;
+  absl::flat_hash_map<PacketKey, FlowSource> previous_flow_sources_;
+  int64 next_flow_id_ = 1;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
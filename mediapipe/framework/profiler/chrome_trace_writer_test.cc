@@ -0,0 +1,158 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+#include <string>
+
+#include "absl/strings/match.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+// Returns the number of occurrences of `part` in `s`.
+int CountOf(const std::string& s, const std::string& part) {
+  int count = 0;
+  for (size_t i = s.find(part); i != std::string::npos;
+       i = s.find(part, i + part.size())) {
+    ++count;
+  }
+  return count;
+}
+
+// A source node outputs a packet on thread 1, which node 1 reads on thread 2.
+GraphTrace TwoNodeTrace() {
+  return ParseTextProtoOrDie<GraphTrace>(R"pb(
+    base_time: 1000
+    base_timestamp: 5000
+    stream_name: ""
+    stream_name: "frames"
+    calculator_trace {
+      node_id: 0
+      event_type: PROCESS
+      input_timestamp: 0
+      start_time: 0
+      finish_time: 10
+      thread_id: 1
+      output_trace { stream_id: 1 packet_timestamp: 0 }
+    }
+    calculator_trace {
+      node_id: 1
+      event_type: PACKET_QUEUED
+      input_timestamp: 0
+      input_trace { stream_id: 1 packet_timestamp: 0 event_data: 3 }
+      start_time: 12
+      thread_id: 1
+    }
+    calculator_trace {
+      node_id: 1
+      event_type: PROCESS
+      input_timestamp: 0
+      start_time: 20
+      finish_time: 50
+      thread_id: 2
+      input_trace {
+        stream_id: 1
+        packet_timestamp: 0
+        start_time: 10
+        finish_time: 20
+      }
+    }
+    calculator_trace {
+      node_id: 1
+      event_type: GPU_TASK
+      input_timestamp: 0
+      start_time: 25
+      finish_time: 45
+      thread_id: 2
+    }
+  )pb");
+}
+
+TEST(ChromeTraceWriterTest, WritesCallsFlowsAndCounters) {
+  ChromeTraceWriter writer(7, {"Source", "Sink"});
+  std::string json;
+  writer.StartTrace(&json);
+  writer.AppendTrace(TwoNodeTrace(), &json);
+  EXPECT_EQ(
+      json,
+      R"([
+{"name":"process_name","ph":"M","pid":7,"args":{"name":"MediaPipe graph 7"}},
+{"name":"thread_name","ph":"M","pid":7,"tid":1,"args":{"name":"Thread 1"}},
+{"name":"Source","cat":"PROCESS","pid":7,"tid":1,"ph":"X","ts":1000,"dur":10,"args":{"input_timestamp":5000}},
+{"name":"frames queue","ph":"C","pid":7,"ts":1012,"args":{"packets":3}},
+{"name":"thread_name","ph":"M","pid":7,"tid":2,"args":{"name":"Thread 2"}},
+{"name":"Sink","cat":"PROCESS","pid":7,"tid":2,"ph":"X","ts":1020,"dur":30,"args":{"input_timestamp":5000}},
+{"name":"frames","cat":"packet","ph":"s","id":1,"pid":7,"tid":1,"ts":1009},
+{"name":"frames","cat":"packet","ph":"f","bp":"e","id":1,"pid":7,"tid":2,"ts":1020},
+{"name":"thread_name","ph":"M","pid":7,"tid":1048587,"args":{"name":"GPU_TASK"}},
+{"name":"Sink","cat":"GPU_TASK","pid":7,"tid":1048587,"ph":"X","ts":1025,"dur":20,"args":{"input_timestamp":5000}})");
+}
+
+TEST(ChromeTraceWriterTest, LinksFlowsAcrossConsecutiveTraces) {
+  GraphTrace producer = TwoNodeTrace();
+  producer.mutable_calculator_trace()->DeleteSubrange(1, 3);
+  GraphTrace consumer = TwoNodeTrace();
+  consumer.mutable_calculator_trace()->DeleteSubrange(0, 2);
+
+  ChromeTraceWriter writer(1, {"Source", "Sink"});
+  std::string json;
+  writer.StartTrace(&json);
+  writer.AppendTrace(producer, &json);
+  writer.AppendTrace(consumer, &json);
+  EXPECT_EQ(CountOf(json, R"("ph":"s")"), 1);
+  EXPECT_EQ(CountOf(json, R"("ph":"f")"), 1);
+
+  // Packets are linked only to the previous GraphTrace.
+  json.clear();
+  writer.AppendTrace(producer, &json);
+  writer.AppendTrace(GraphTrace(), &json);
+  writer.AppendTrace(consumer, &json);
+  EXPECT_THAT(json, Not(HasSubstr(R"("ph":"s")")));
+}
+
+TEST(ChromeTraceWriterTest, StartsEachTraceWithTrackNames) {
+  ChromeTraceWriter writer(1, {"Source", "Sink"});
+  std::string json;
+  writer.StartTrace(&json);
+  writer.AppendTrace(TwoNodeTrace(), &json);
+  writer.AppendTrace(TwoNodeTrace(), &json);
+  EXPECT_EQ(CountOf(json, R"("name":"thread_name")"), 3);
+  EXPECT_TRUE(absl::StartsWith(json, "[\n{"));
+
+  json.clear();
+  writer.StartTrace(&json);
+  writer.AppendTrace(TwoNodeTrace(), &json);
+  EXPECT_EQ(CountOf(json, R"("name":"thread_name")"), 3);
+  EXPECT_EQ(CountOf(json, R"("name":"process_name")"), 1);
+}
+
+TEST(ChromeTraceWriterTest, EscapesNames) {
+  ChromeTraceWriter writer(1, {"Say \"hi\"\\\n"});
+  std::string json;
+  writer.StartTrace(&json);
+  writer.AppendTrace(TwoNodeTrace(), &json);
+  EXPECT_THAT(json, HasSubstr(R"("name":"Say \"hi\"\\\u000a")"));
+  EXPECT_THAT(json, HasSubstr(R"("name":"node_1")"));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -142,6 +142,7 @@ class GraphProfiler::GraphProfileBuilder {
 GraphProfiler::GraphProfiler()
     : is_initialized_(false),
       is_profiling_(false),
+      is_recording_latency_(false),
       calculator_profiles_(1000),
       packets_info_(1000),
       is_running_(false),
@@ -192,6 +193,24 @@ void GraphProfiler::Initialize(
     auto iter = calculator_profiles_.insert({node_name, profile});
     CHECK(iter.second) << absl::Substitute(
         "Calculator \"$0\" has already been added.", node_name);
+
+    if (profiler_config_.enable_latency_histograms()) {
+      auto node_latency = std::make_unique<NodeLatency>();
+      node_latency->name = node_name;
+      const CalculatorGraphConfig::Node& node_config =
+          validated_graph_config.Config().node(node_id);
+      std::shared_ptr<tool::TagMap> input_tag_map =
+          TagMap::Create(node_config.input_stream()).value();
+      for (const std::string& input_stream_name : input_tag_map->Names()) {
+        node_latency->input_streams.push_back(
+            std::make_unique<InputStreamLatency>());
+        node_latency->input_streams.back()->name = input_stream_name;
+      }
+      node_latencies_.push_back(std::move(node_latency));
+    }
+  }
+  if (profiler_config_.enable_latency_histograms()) {
+    timestamp_entry_times_ = std::make_unique<TimestampEntryTable>();
   }
   profile_builder_ = std::make_unique<GraphProfileBuilder>(this);
   graph_id_ = ++next_instance_id_;
@@ -212,6 +231,7 @@ const std::shared_ptr<mediapipe::Clock> GraphProfiler::GetClock() const {
 void GraphProfiler::Pause() {
   is_profiling_ = false;
   is_tracing_ = false;
+  is_recording_latency_ = false;
 }
 
 void GraphProfiler::Resume() {
@@ -221,6 +241,7 @@ void GraphProfiler::Resume() {
   // IsProfilerEnabled and IsTracerEnabled.
   is_profiling_ = IsProfilerEnabled(profiler_config_);
   is_tracing_ = IsTracerEnabled(profiler_config_);
+  is_recording_latency_ = profiler_config_.enable_latency_histograms();
 }
 
 void GraphProfiler::Reset() {
@@ -231,11 +252,20 @@ void GraphProfiler::Reset() {
     ResetTimeHistogram(calculator_profile->mutable_process_runtime());
     ResetTimeHistogram(calculator_profile->mutable_process_input_latency());
     ResetTimeHistogram(calculator_profile->mutable_process_output_latency());
+    calculator_profile->set_inline_process_calls(0);
     for (auto& input_stream_profile :
          *(calculator_profile->mutable_input_stream_profiles())) {
       ResetTimeHistogram(input_stream_profile.mutable_latency());
     }
   }
+  for (auto& node_latency : node_latencies_) {
+    node_latency->process_time.Clear();
+    node_latency->queueing_delay.Clear();
+    node_latency->timestamp_latency.Clear();
+    for (auto& input_stream : node_latency->input_streams) {
+      input_stream->queueing_delay.Clear();
+    }
+  }
 }
 
 // Begins profiling for a single graph run.
@@ -300,6 +330,34 @@ void GraphProfiler::LogEvent(const TraceEvent& event) {
   if (event.event_type == GraphTrace::PROCESS && event.node_id == -1) {
     AddPacketInfo(event);
   }
+
+  // Record the times used by the latency histograms.
+  if (is_recording_latency_) {
+    if (event.event_type == GraphTrace::READY_FOR_PROCESS &&
+        event.node_id >= 0 && event.node_id < node_latencies_.size() &&
+        event.packet_ts.IsRangeValue()) {
+      // The event carries the input timestamp as packet_ts.
+      node_latencies_[event.node_id]->ready_times.Record(
+          event.packet_ts.Value(), TimeNowUsec());
+    } else if (event.event_type == GraphTrace::PACKET_QUEUED &&
+               event.node_id >= 0 && event.node_id < node_latencies_.size() &&
+               event.stream_id != nullptr && event.input_ts.IsRangeValue() &&
+               event.packet_ts == event.input_ts) {
+      // The event is logged again for the packet at the head of the queue,
+      // which was queued earlier, so only the newly queued packet is
+      // recorded. Packets queued together before it are not recorded.
+      for (auto& input_stream : node_latencies_[event.node_id]->input_streams) {
+        if (input_stream->name == *event.stream_id) {
+          input_stream->queued_times.Record(event.input_ts.Value(),
+                                            TimeNowUsec());
+          break;
+        }
+      }
+    } else if (event.event_type == GraphTrace::PROCESS &&
+               event.node_id == -1 && event.input_ts.IsRangeValue()) {
+      timestamp_entry_times_->Record(event.input_ts.Value(), TimeNowUsec());
+    }
+  }
 }
 
 void GraphProfiler::AddPacketInfo(const TraceEvent& packet_info) {
@@ -341,6 +399,30 @@ absl::Status GraphProfiler::GetCalculatorProfiles(
   return absl::OkStatus();
 }
 
+absl::Status GraphProfiler::GetLatencyProfiles(
+    std::vector<CalculatorLatencyProfile>* profiles) const {
+  RET_CHECK(is_initialized_)
+      << "GetLatencyProfiles can only be called after Initialize()";
+  for (const auto& node_latency : node_latencies_) {
+    CalculatorLatencyProfile profile;
+    profile.set_name(node_latency->name);
+    *profile.mutable_process_time() = node_latency->process_time.Percentiles();
+    *profile.mutable_queueing_delay() =
+        node_latency->queueing_delay.Percentiles();
+    *profile.mutable_timestamp_latency() =
+        node_latency->timestamp_latency.Percentiles();
+    for (const auto& input_stream : node_latency->input_streams) {
+      StreamLatencyProfile* stream_profile =
+          profile.add_input_stream_queueing_delays();
+      stream_profile->set_name(input_stream->name);
+      *stream_profile->mutable_queueing_delay() =
+          input_stream->queueing_delay.Percentiles();
+    }
+    profiles->push_back(std::move(profile));
+  }
+  return absl::OkStatus();
+}
+
 void GraphProfiler::InitializeTimeHistogram(int64 interval_size_usec,
                                             int64 num_intervals,
                                             TimeHistogram* histogram) {
@@ -497,6 +579,65 @@ void GraphProfiler::AddTimeSample(int64 start_time_usec, int64 end_time_usec,
   histogram->set_count(interval_index, histogram->count(interval_index) + 1);
 }
 
+void GraphProfiler::AddLatencySamples(
+    const CalculatorContext& calculator_context, int64 start_time_usec,
+    int64 end_time_usec) {
+  int node_id = calculator_context.NodeId();
+  if (node_id < 0 || node_id >= node_latencies_.size()) {
+    return;
+  }
+  NodeLatency* node_latency = node_latencies_[node_id].get();
+  node_latency->process_time.AddSample(end_time_usec - start_time_usec);
+
+  Timestamp input_timestamp = calculator_context.InputTimestamp();
+  if (input_timestamp.IsRangeValue()) {
+    int64 ready_time_usec =
+        node_latency->ready_times.Lookup(input_timestamp.Value());
+    if (ready_time_usec >= 0) {
+      node_latency->queueing_delay.AddSample(start_time_usec -
+                                             ready_time_usec);
+    }
+    int input_index = 0;
+    for (CollectionItemId id = calculator_context.Inputs().BeginId();
+         id < calculator_context.Inputs().EndId() &&
+         input_index < node_latency->input_streams.size();
+         ++id, ++input_index) {
+      if (calculator_context.Inputs().Get(id).Value().IsEmpty()) {
+        continue;
+      }
+      InputStreamLatency* input_stream =
+          node_latency->input_streams[input_index].get();
+      int64 queued_time_usec =
+          input_stream->queued_times.Lookup(input_timestamp.Value());
+      if (queued_time_usec >= 0) {
+        input_stream->queueing_delay.AddSample(start_time_usec -
+                                               queued_time_usec);
+      }
+    }
+  }
+
+  // Packet timestamps enter the graph when a source calculator outputs them.
+  if (calculator_context.Inputs().NumEntries() == 0) {
+    for (const OutputStreamShard& output_stream_shard :
+         calculator_context.Outputs()) {
+      for (const Packet& output_packet : *output_stream_shard.OutputQueue()) {
+        if (output_packet.Timestamp().IsRangeValue()) {
+          timestamp_entry_times_->Record(output_packet.Timestamp().Value(),
+                                         start_time_usec);
+        }
+      }
+    }
+  }
+  if (input_timestamp.IsRangeValue()) {
+    int64 entry_time_usec =
+        timestamp_entry_times_->Lookup(input_timestamp.Value());
+    if (entry_time_usec >= 0) {
+      node_latency->timestamp_latency.AddSample(end_time_usec -
+                                                entry_time_usec);
+    }
+  }
+}
+
 int64 GraphProfiler::AddInputStreamTimeSamples(
     const CalculatorContext& calculator_context, int64 start_time_usec,
     CalculatorProfile* calculator_profile) {
@@ -565,6 +706,21 @@ void GraphProfiler::AddProcessSample(
   }
 }
 
+void GraphProfiler::AddInlineProcessCall(
+    const CalculatorContext& calculator_context) {
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  if (!is_profiling_) {
+    return;
+  }
+  auto profile_iter = calculator_profiles_.find(calculator_context.NodeName());
+  CHECK(profile_iter != calculator_profiles_.end()) << absl::Substitute(
+      "Calculator \"$0\" has not been added during initialization.",
+      calculator_context.NodeName());
+  CalculatorProfile* calculator_profile = &profile_iter->second;
+  calculator_profile->set_inline_process_calls(
+      calculator_profile->inline_process_calls() + 1);
+}
+
 std::unique_ptr<GlProfilingHelper> GraphProfiler::CreateGlProfilingHelper() {
   if (!IsTracerEnabled(profiler_config_)) {
     return nullptr;
@@ -716,16 +872,21 @@ absl::Status GraphProfiler::WriteProfile() {
     return absl::OkStatus();
   }
 
-  // Record the CalculatorGraphConfig, once per log file.
   ++previous_log_index_;
   bool is_new_file = (previous_log_index_ % log_interval_count == 0);
+  int log_index = previous_log_index_ / log_interval_count % log_file_count;
+  if (profiler_config_.trace_log_format() == ProfilerConfig::CHROME_JSON) {
+    return WriteChromeTrace(
+        trace, absl::StrCat(trace_log_path, log_index, ".json"), is_new_file);
+  }
+
+  // Record the CalculatorGraphConfig, once per log file.
   if (is_new_file) {
     *profile.mutable_config() = validated_graph_->Config();
     AssignNodeNames(&profile);
   }
 
   // Write the GraphProfile to the trace_log_path.
-  int log_index = previous_log_index_ / log_interval_count % log_file_count;
   std::string log_path = absl::StrCat(trace_log_path, log_index, ".binarypb");
   std::ofstream ofs;
   if (is_new_file) {
@@ -739,4 +900,33 @@ absl::Status GraphProfiler::WriteProfile() {
   return absl::OkStatus();
 }
 
+absl::Status GraphProfiler::WriteChromeTrace(const GraphTrace& trace,
+                                             const std::string& log_path,
+                                             bool is_new_file) {
+  if (!chrome_trace_writer_) {
+    const CalculatorGraphConfig& config = validated_graph_->Config();
+    std::vector<std::string> node_names;
+    node_names.reserve(config.node().size());
+    for (int i = 0; i < config.node().size(); ++i) {
+      node_names.push_back(tool::CanonicalNodeName(config, i));
+    }
+    chrome_trace_writer_ =
+        std::make_unique<ChromeTraceWriter>(graph_id_, std::move(node_names));
+  }
+  std::string json;
+  if (is_new_file) {
+    chrome_trace_writer_->StartTrace(&json);
+  }
+  chrome_trace_writer_->AppendTrace(trace, &json);
+  std::ofstream ofs;
+  if (is_new_file) {
+    ofs.open(log_path, std::ofstream::out | std::ofstream::trunc);
+  } else {
+    ofs.open(log_path, std::ofstream::out | std::ofstream::app);
+  }
+  ofs << json;
+  RET_CHECK(ofs.good()) << "Could not write Chrome trace to: " << log_path;
+  return absl::OkStatus();
+}
+
 }  // namespace mediapipe
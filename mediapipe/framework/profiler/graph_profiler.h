@@ -30,7 +30,9 @@
 #include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
 #include "mediapipe/framework/profiler/graph_tracer.h"
+#include "mediapipe/framework/profiler/latency_histogram.h"
 #include "mediapipe/framework/profiler/sharded_map.h"
 #include "mediapipe/framework/validated_graph_config.h"
 
@@ -96,6 +98,10 @@ enum class PopulateGraphConfig { kNo, kFull };
 // profiler disables itself and returns an empty stub if Initialize() is called
 // more than once.
 //
+// If enable_latency_histograms is true, the profiler also records log-linear
+// latency histograms for each calculator, which can be left on in production
+// and are read through GetLatencyProfiles().
+//
 // The profiler uses the synchronized monotonic clock by default.
 // The client can overwrite this by calling SetClock().
 class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
@@ -140,12 +146,23 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Record a tracing event.
   void LogEvent(const TraceEvent& event);
 
+  // Counts a Process() call that ran inline after the producing calculator,
+  // because CalculatorGraphConfig.fuse_linear_chains is true.
+  void AddInlineProcessCall(const CalculatorContext& calculator_context)
+      ABSL_LOCKS_EXCLUDED(profiler_mutex_);
+
   // Collects the runtime profile for Open(), Process(), and Close() of each
   // calculator in the graph. May be called at any time after the graph has been
   // initialized.
   absl::Status GetCalculatorProfiles(std::vector<CalculatorProfile>*) const
       ABSL_LOCKS_EXCLUDED(profiler_mutex_);
 
+  // Collects the p50, p90, p99 and p999 Process() time, queueing delay, and
+  // timestamp latency of each calculator in the graph, if
+  // enable_latency_histograms is true. May be called at any time after the
+  // graph has been initialized, including while the graph is running.
+  absl::Status GetLatencyProfiles(std::vector<CalculatorLatencyProfile>*) const;
+
   // Records recent profiling and tracing data.  Includes events since the
   // previous call to CaptureProfile.
   //
@@ -192,7 +209,8 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
 
     inline ~Scope() {
       int64 end_time_usec;
-      if (profiler_->is_profiling_ || profiler_->is_tracing_) {
+      if (profiler_->is_profiling_ || profiler_->is_tracing_ ||
+          profiler_->is_recording_latency_) {
         end_time_usec = profiler_->TimeNowUsec();
       }
       if (profiler_->is_profiling_) {
@@ -216,6 +234,11 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
             break;
         }
       }
+      if (profiler_->is_recording_latency_ &&
+          calculator_method_ == GraphTrace::PROCESS) {
+        profiler_->AddLatencySamples(calculator_context_, start_time_usec_,
+                                     end_time_usec);
+      }
       if (profiler_->is_tracing_) {
         absl::Time time_now = absl::FromUnixMicros(end_time_usec);
         profiler_->packet_tracer_->LogOutputEvents(
@@ -305,11 +328,19 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
                         int64 start_time_usec, int64 end_time_usec)
       ABSL_LOCKS_EXCLUDED(profiler_mutex_);
 
+  // Records the latency histogram samples for a Process() call.
+  void AddLatencySamples(const CalculatorContext& calculator_context,
+                         int64 start_time_usec, int64 end_time_usec);
+
   // Helper method to get trace_log_path.  If the trace_log_path is empty and
   // tracing is enabled, this function returns a default platform dependent
   // trace_log_path.
   absl::StatusOr<std::string> GetTraceLogPath();
 
+  // Appends a GraphTrace to a Chrome trace-event JSON log file.
+  absl::Status WriteChromeTrace(const GraphTrace& trace,
+                                const std::string& log_path, bool is_new_file);
+
   // Helper method to get the clock time in microsecond.
   int64 TimeNowUsec() { return ToUnixMicros(clock_->TimeNow()); }
 
@@ -327,6 +358,34 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // If true, the tracer records timing events.
   std::atomic_bool is_tracing_;
 
+  // If true, the profiler records latency histograms.
+  std::atomic_bool is_recording_latency_;
+
+  // The latency histogram for one input stream of a calculator node.
+  struct InputStreamLatency {
+    std::string name;
+    LatencyHistogram queueing_delay;
+    // The times at which the packets of recent timestamps were queued.
+    TimestampEntryTable queued_times;
+  };
+  // The latency histograms for one calculator node.
+  struct NodeLatency {
+    std::string name;
+    LatencyHistogram process_time;
+    LatencyHistogram queueing_delay;
+    LatencyHistogram timestamp_latency;
+    // The times at which the input sets of recent timestamps became ready for
+    // Process(). Keyed by timestamp, since several input sets can be waiting
+    // for Process() at once when max_in_flight is greater than 1.
+    TimestampEntryTable ready_times;
+    // Indexed like the input streams of the node.
+    std::vector<std::unique_ptr<InputStreamLatency>> input_streams;
+  };
+  // The latency histograms indexed by node_id, if enable_latency_histograms.
+  std::vector<std::unique_ptr<NodeLatency>> node_latencies_;
+  // The times at which recent packet timestamps entered the graph.
+  std::unique_ptr<TimestampEntryTable> timestamp_entry_times_;
+
   // Stores all the calculator profiles with the calculator name as the key.
   using CalculatorProfileMap = ShardedMap<std::string, CalculatorProfile>;
   CalculatorProfileMap calculator_profiles_;
@@ -353,6 +412,9 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // The index number of the previous output log.
   int previous_log_index_;
 
+  // Converts trace events for trace_log_format CHROME_JSON.
+  std::unique_ptr<ChromeTraceWriter> chrome_trace_writer_;
+
   // The configuration for the graph being profiled.
   const ValidatedGraphConfig* validated_graph_;
 
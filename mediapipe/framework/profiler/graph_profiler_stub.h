@@ -19,17 +19,20 @@
 #include "mediapipe/framework/timestamp.h"
 
 namespace mediapipe {
+class CalculatorLatencyProfile;
 class CalculatorProfile;
 class GraphTrace;
 class GraphProfile;
 }  // namespace mediapipe
 
 namespace mediapipe {
+using mediapipe::CalculatorLatencyProfile;
 using mediapipe::CalculatorProfile;
 using mediapipe::GraphProfile;
 using mediapipe::GraphTrace;
 
 class ValidatedGraphConfig;
+class CalculatorContext;
 class Executor;
 class Packet;
 class Clock;
@@ -84,10 +87,16 @@ class GraphProfilerStub {
   inline void Initialize(const ValidatedGraphConfig& validated_graph_config) {}
   inline void SetClock(const std::shared_ptr<mediapipe::Clock>& clock) {}
   inline void LogEvent(const TraceEvent& event) {}
+  inline void AddInlineProcessCall(
+      const CalculatorContext& calculator_context) {}
   inline absl::Status GetCalculatorProfiles(
       std::vector<CalculatorProfile>*) const {
     return absl::OkStatus();
   }
+  inline absl::Status GetLatencyProfiles(
+      std::vector<CalculatorLatencyProfile>*) const {
+    return absl::OkStatus();
+  }
   absl::Status CaptureProfile(
       GraphProfile* result,
       PopulateGraphConfig populate_config = PopulateGraphConfig::kNo) {
@@ -1232,6 +1232,144 @@ TEST(GraphProfilerTest, ParallelReads) {
   EXPECT_EQ(1001, out_1_packets.size());
 }
 
+TEST(GraphProfilerTest, LatencyProfiles) {
+  CalculatorGraphConfig config;
+  QCHECK(google::protobuf::TextFormat::ParseFromString(R"(
+    profiler_config {
+     enable_latency_histograms: true
+    }
+    node {
+      calculator: "RangeCalculator"
+      input_side_packet: "range_step"
+      output_stream: "out"
+      output_stream: "sum"
+      output_stream: "mean"
+    }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "out"
+      input_stream: "sum"
+      input_stream: "mean"
+      output_stream: "out_1"
+      output_stream: "sum_1"
+      output_stream: "mean_1"
+    }
+    output_stream: "OUT:0:the_integers"
+    )",
+                                                       &config));
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.Run(
+      {{"range_step", MakePacket<std::pair<uint32, uint32>>(1000, 1)}}));
+  std::vector<CalculatorLatencyProfile> profiles;
+  MP_ASSERT_OK(graph.profiler()->GetLatencyProfiles(&profiles));
+  ASSERT_EQ(2, profiles.size());
+
+  // Latency profiles are ordered by node_id.
+  EXPECT_EQ("RangeCalculator", profiles[0].name());
+  EXPECT_EQ(1000, profiles[0].process_time().count());
+  EXPECT_EQ("PassThroughCalculator", profiles[1].name());
+  EXPECT_EQ(1003, profiles[1].process_time().count());
+  EXPECT_GT(profiles[1].queueing_delay().count(), 0);
+  EXPECT_GT(profiles[1].timestamp_latency().count(), 0);
+
+  // Queueing delays are also recorded per input stream.
+  EXPECT_EQ(0, profiles[0].input_stream_queueing_delays_size());
+  ASSERT_EQ(3, profiles[1].input_stream_queueing_delays_size());
+  EXPECT_EQ("out", profiles[1].input_stream_queueing_delays(0).name());
+  EXPECT_EQ("sum", profiles[1].input_stream_queueing_delays(1).name());
+  EXPECT_EQ("mean", profiles[1].input_stream_queueing_delays(2).name());
+  EXPECT_GT(
+      profiles[1].input_stream_queueing_delays(0).queueing_delay().count(), 0);
+  for (const auto& profile : profiles) {
+    const LatencyPercentiles& process_time = profile.process_time();
+    EXPECT_LE(process_time.p50_usec(), process_time.p99_usec());
+    EXPECT_LE(process_time.p99_usec(), process_time.p999_usec());
+    EXPECT_LE(process_time.p999_usec(), process_time.max_usec());
+  }
+
+  // Latency profiles are not recorded unless enabled.
+  config.mutable_profiler_config()->set_enable_latency_histograms(false);
+  CalculatorGraph disabled_graph;
+  MP_ASSERT_OK(disabled_graph.Initialize(config));
+  profiles.clear();
+  MP_ASSERT_OK(disabled_graph.profiler()->GetLatencyProfiles(&profiles));
+  EXPECT_TRUE(profiles.empty());
+}
+
+TEST(GraphProfilerTest, InlineProcessCalls) {
+  CalculatorGraphConfig config;
+  QCHECK(google::protobuf::TextFormat::ParseFromString(R"(
+    profiler_config {
+     enable_profiler: true
+    }
+    fuse_linear_chains: true
+    input_stream: "in"
+    node {
+      name: "pass_1"
+      calculator: "PassThroughCalculator"
+      input_stream: "in"
+      output_stream: "out_1"
+    }
+    node {
+      name: "pass_2"
+      calculator: "PassThroughCalculator"
+      input_stream: "out_1"
+      output_stream: "out_2"
+    }
+    node {
+      name: "pass_3"
+      calculator: "PassThroughCalculator"
+      input_stream: "out_2"
+      output_stream: "out_3"
+    }
+    )",
+                                                       &config));
+
+  const int kNumPackets = 10;
+  auto count_inline_calls = [&](const CalculatorGraphConfig& config)
+      -> std::map<std::string, int64> {
+    CalculatorGraph graph;
+    MP_EXPECT_OK(graph.Initialize(config));
+    std::vector<Packet> out_packets;
+    MP_EXPECT_OK(graph.ObserveOutputStream("out_3", [&](const Packet& packet) {
+      out_packets.push_back(packet);
+      return absl::OkStatus();
+    }));
+    MP_EXPECT_OK(graph.StartRun({}));
+    // Each packet runs through the whole chain before the next one is added,
+    // so that every fused calculator becomes ready during its producer's run.
+    for (int i = 0; i < kNumPackets; ++i) {
+      MP_EXPECT_OK(graph.AddPacketToInputStream(
+          "in", MakePacket<int>(i).At(Timestamp(i))));
+      MP_EXPECT_OK(graph.WaitUntilIdle());
+    }
+    std::vector<CalculatorProfile> profiles;
+    MP_EXPECT_OK(graph.profiler()->GetCalculatorProfiles(&profiles));
+    MP_EXPECT_OK(graph.CloseAllInputStreams());
+    MP_EXPECT_OK(graph.WaitUntilDone());
+    EXPECT_EQ(kNumPackets, out_packets.size());
+    std::map<std::string, int64> result;
+    for (const CalculatorProfile& profile : profiles) {
+      result[profile.name()] = profile.inline_process_calls();
+    }
+    return result;
+  };
+
+  // The first calculator reads a graph input stream, so it is not fused.
+  std::map<std::string, int64> inline_calls = count_inline_calls(config);
+  EXPECT_EQ(0, inline_calls["pass_1"]);
+  EXPECT_EQ(kNumPackets, inline_calls["pass_2"]);
+  EXPECT_EQ(kNumPackets, inline_calls["pass_3"]);
+
+  // Nothing runs inline unless fuse_linear_chains is set.
+  config.set_fuse_linear_chains(false);
+  inline_calls = count_inline_calls(config);
+  EXPECT_EQ(0, inline_calls["pass_2"]);
+  EXPECT_EQ(0, inline_calls["pass_3"]);
+}
+
 // Returns the set of calculator names in a GraphProfile captured from
 // CalculatorGraph initialized from a certain CalculatorGraphConfig.
 std::set<std::string> GetCalculatorNames(const CalculatorGraphConfig& config) {
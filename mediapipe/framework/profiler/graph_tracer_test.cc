@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "absl/flags/flag.h"
+#include "absl/strings/match.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -57,6 +58,7 @@ class GraphProfilerTestPeer {
 namespace {
 
 using testing::ElementsAre;
+using testing::HasSubstr;
 
 class GraphTracerTest : public ::testing::Test {
  protected:
@@ -1010,6 +1012,24 @@ TEST_F(GraphTracerE2ETest, DemuxGraphLogFile) {
   EXPECT_EQ(113, profile.graph_trace(0).calculator_trace().size());
 }
 
+TEST_F(GraphTracerE2ETest, DemuxGraphChromeTraceFile) {
+  std::string log_path = absl::StrCat(getenv("TEST_TMPDIR"), "/chrome_file_");
+  SetUpDemuxInFlightGraph();
+  graph_config_.mutable_profiler_config()->set_trace_log_path(log_path);
+  graph_config_.mutable_profiler_config()->set_trace_log_interval_usec(-1);
+  graph_config_.mutable_profiler_config()->set_trace_log_format(
+      ProfilerConfig::CHROME_JSON);
+  RunDemuxInFlightGraph();
+  std::string json;
+  MP_ASSERT_OK(file::GetContents(absl::StrCat(log_path, 0, ".json"), &json));
+  EXPECT_TRUE(absl::StartsWith(json, "[\n"));
+  EXPECT_THAT(json, HasSubstr(R"("name":"RoundRobinDemuxCalculator")"));
+  EXPECT_THAT(json, HasSubstr(R"("cat":"PROCESS")"));
+  EXPECT_THAT(json, HasSubstr(R"("ph":"s")"));
+  EXPECT_THAT(json, HasSubstr(R"("ph":"f")"));
+  EXPECT_FALSE(file::Exists(absl::StrCat(log_path, 0, ".binarypb")).ok());
+}
+
 TEST_F(GraphTracerE2ETest, DemuxGraphLogFiles) {
   std::string log_path = absl::StrCat(getenv("TEST_TMPDIR"), "/log_files_");
   SetUpDemuxInFlightGraph();
@@ -0,0 +1,183 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "absl/numeric/bits.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Assigns threads to shards round-robin, in the order they first add samples.
+std::atomic<int> next_thread_shard{0};
+
+// Marks an empty TimestampEntryTable slot.
+constexpr int64 kNoTimestamp = std::numeric_limits<int64>::min();
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram() { Clear(); }
+
+void LatencyHistogram::AddSample(int64 latency_usec) {
+  if (latency_usec < 0) {
+    return;
+  }
+  latency_usec = std::min(latency_usec, kMaxLatencyUsec);
+  Shard& shard = ThreadShard();
+  shard.counts[BucketIndex(latency_usec)].fetch_add(1,
+                                                    std::memory_order_relaxed);
+  int64 max_usec = shard.max_usec.load(std::memory_order_relaxed);
+  while (latency_usec > max_usec &&
+         !shard.max_usec.compare_exchange_weak(max_usec, latency_usec,
+                                               std::memory_order_relaxed)) {
+  }
+}
+
+void LatencyHistogram::Clear() {
+  for (Shard& shard : shards_) {
+    for (auto& count : shard.counts) {
+      count.store(0, std::memory_order_relaxed);
+    }
+    shard.max_usec.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::vector<int64> LatencyHistogram::MergedCounts() const {
+  std::vector<int64> counts(kNumBuckets, 0);
+  for (const Shard& shard : shards_) {
+    for (int i = 0; i < kNumBuckets; ++i) {
+      counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+    }
+  }
+  return counts;
+}
+
+LatencyPercentiles LatencyHistogram::Percentiles() const {
+  std::vector<int64> counts = MergedCounts();
+  int64 max_usec = 0;
+  for (const Shard& shard : shards_) {
+    max_usec =
+        std::max(max_usec, shard.max_usec.load(std::memory_order_relaxed));
+  }
+  int64 total = 0;
+  for (int64 count : counts) {
+    total += count;
+  }
+  LatencyPercentiles result;
+  result.set_count(total);
+  if (total == 0) {
+    return result;
+  }
+  // A bucket upper bound can exceed the largest sample counted in it.
+  auto percentile = [&](double fraction) {
+    return std::min(ValueAtFraction(counts, fraction), max_usec);
+  };
+  result.set_p50_usec(percentile(0.5));
+  result.set_p90_usec(percentile(0.9));
+  result.set_p99_usec(percentile(0.99));
+  result.set_p999_usec(percentile(0.999));
+  result.set_max_usec(max_usec);
+  return result;
+}
+
+int LatencyHistogram::BucketIndex(int64 latency_usec) {
+  if (latency_usec < kSubBuckets) {
+    return static_cast<int>(latency_usec);
+  }
+  int exponent = 63 - absl::countl_zero(static_cast<uint64>(latency_usec));
+  int shift = exponent - kSubBucketBits;
+  int sub_bucket = static_cast<int>(latency_usec >> shift) - kSubBuckets;
+  return (shift + 1) * kSubBuckets + sub_bucket;
+}
+
+int64 LatencyHistogram::BucketUpperBound(int bucket) {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  int shift = bucket / kSubBuckets - 1;
+  int64 lower = int64{kSubBuckets + bucket % kSubBuckets} << shift;
+  return lower + (int64{1} << shift) - 1;
+}
+
+int64 LatencyHistogram::ValueAtFraction(const std::vector<int64>& counts,
+                                        double fraction) {
+  int64 total = 0;
+  for (int64 count : counts) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  fraction = std::clamp(fraction, 0.0, 1.0);
+  int64 rank =
+      std::max<int64>(1, static_cast<int64>(std::ceil(fraction * total)));
+  int64 seen = 0;
+  for (int i = 0; i < counts.size(); ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return BucketUpperBound(i);
+    }
+  }
+  return kMaxLatencyUsec;
+}
+
+LatencyHistogram::Shard& LatencyHistogram::ThreadShard() {
+  static thread_local int shard_index =
+      next_thread_shard.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+  return shards_[shard_index];
+}
+
+TimestampEntryTable::TimestampEntryTable() {
+  for (Slot& slot : slots_) {
+    slot.timestamp.store(kNoTimestamp, std::memory_order_relaxed);
+    slot.time_usec.store(0, std::memory_order_relaxed);
+  }
+}
+
+void TimestampEntryTable::Record(int64 timestamp, int64 time_usec) {
+  Slot& slot = SlotFor(timestamp);
+  if (slot.timestamp.load(std::memory_order_acquire) == timestamp) {
+    return;
+  }
+  slot.timestamp.store(kNoTimestamp, std::memory_order_relaxed);
+  slot.time_usec.store(time_usec, std::memory_order_release);
+  slot.timestamp.store(timestamp, std::memory_order_release);
+}
+
+int64 TimestampEntryTable::Lookup(int64 timestamp) const {
+  Slot& slot = SlotFor(timestamp);
+  if (slot.timestamp.load(std::memory_order_acquire) != timestamp) {
+    return -1;
+  }
+  int64 time_usec = slot.time_usec.load(std::memory_order_acquire);
+  // The slot may have been rewritten for another timestamp meanwhile.
+  if (slot.timestamp.load(std::memory_order_acquire) != timestamp) {
+    return -1;
+  }
+  return time_usec;
+}
+
+TimestampEntryTable::Slot& TimestampEntryTable::SlotFor(
+    int64 timestamp) const {
+  // Mix the bits, since timestamps are often multiples of a frame interval.
+  uint64 hash = static_cast<uint64>(timestamp) * 0x9E3779B97F4A7C15ull;
+  return slots_[hash >> 54];
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,125 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_LATENCY_HISTOGRAM_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_LATENCY_HISTOGRAM_H_
+
+#include <atomic>
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// A log-linear histogram of latencies in microseconds, which is cheap enough
+// to leave enabled while a graph runs in production.
+//
+// Each power-of-two range of latencies is divided into kSubBuckets equal
+// buckets, so that a percentile is reported within 1/kSubBuckets of its
+// true value, from 1 usec up to kMaxLatencyUsec. Samples are counted in one
+// of kNumShards shards chosen by the calling thread, so that threads rarely
+// share a cache line, and the shards are merged when the histogram is read.
+//
+// AddSample is lock-free and thread-safe. Reads are thread-safe, and reflect
+// the samples added before them.
+class LatencyHistogram {
+ public:
+  // The number of buckets per power of two.
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  // Latencies above kMaxLatencyUsec, about 4.6 hours, are counted as it.
+  static constexpr int kMaxLatencyBits = 34;
+  static constexpr int64 kMaxLatencyUsec = (int64{1} << kMaxLatencyBits) - 1;
+  static constexpr int kNumBuckets =
+      (kMaxLatencyBits - kSubBucketBits + 1) * kSubBuckets;
+  static constexpr int kNumShards = 4;
+
+  LatencyHistogram();
+
+  // Not copyable or movable.
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  // Counts one latency. Negative latencies are ignored.
+  void AddSample(int64 latency_usec);
+
+  // Discards all samples.
+  void Clear();
+
+  // Returns the merged count of each bucket.
+  std::vector<int64> MergedCounts() const;
+
+  // Returns the count and the p50, p90, p99, p999 and max latencies.
+  LatencyPercentiles Percentiles() const;
+
+  // Returns the bucket counting a latency.
+  static int BucketIndex(int64 latency_usec);
+  // Returns the highest latency counted in a bucket.
+  static int64 BucketUpperBound(int bucket);
+
+  // Returns the latency at a fraction, in [0, 1], of the merged samples.
+  static int64 ValueAtFraction(const std::vector<int64>& counts,
+                               double fraction);
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<int64> counts[kNumBuckets];
+    std::atomic<int64> max_usec;
+  };
+
+  // Returns the shard of the calling thread.
+  Shard& ThreadShard();
+
+  Shard shards_[kNumShards];
+};
+
+// Remembers when recent packet timestamps entered the graph, in a fixed-size
+// table indexed by timestamp, so that timestamp latency can be measured
+// without locks or allocation. The first entry time recorded for a timestamp
+// is kept until the slot is reused by another timestamp.
+//
+// Record and Lookup are lock-free and thread-safe. Under heavy contention for
+// a slot, Lookup may report no entry time for a recorded timestamp.
+class TimestampEntryTable {
+ public:
+  static constexpr int kNumSlots = 1024;
+
+  TimestampEntryTable();
+
+  // Not copyable or movable.
+  TimestampEntryTable(const TimestampEntryTable&) = delete;
+  TimestampEntryTable& operator=(const TimestampEntryTable&) = delete;
+
+  // Records the entry time for a timestamp, unless one is already recorded.
+  void Record(int64 timestamp, int64 time_usec);
+
+  // Returns the entry time for a timestamp, or -1 if none is recorded.
+  int64 Lookup(int64 timestamp) const;
+
+ private:
+  struct Slot {
+    // The timestamp, or kNoTimestamp while the slot is being written.
+    std::atomic<int64> timestamp;
+    std::atomic<int64> time_usec;
+  };
+
+  Slot& SlotFor(int64 timestamp) const;
+
+  mutable Slot slots_[kNumSlots];
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_LATENCY_HISTOGRAM_H_
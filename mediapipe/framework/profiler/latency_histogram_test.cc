@@ -0,0 +1,91 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/latency_histogram.h"
+
+#include <memory>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(LatencyHistogramTest, BucketsCoverEveryLatency) {
+  for (int64 latency = 0; latency < 1 << 20; ++latency) {
+    int bucket = LatencyHistogram::BucketIndex(latency);
+    ASSERT_LE(latency, LatencyHistogram::BucketUpperBound(bucket));
+    if (bucket > 0) {
+      ASSERT_GT(latency, LatencyHistogram::BucketUpperBound(bucket - 1));
+    }
+  }
+  EXPECT_EQ(LatencyHistogram::kNumBuckets - 1,
+            LatencyHistogram::BucketIndex(LatencyHistogram::kMaxLatencyUsec));
+}
+
+TEST(LatencyHistogramTest, PercentilesAreWithinBucketResolution) {
+  auto histogram = std::make_unique<LatencyHistogram>();
+  for (int64 latency = 1; latency <= 10000; ++latency) {
+    histogram->AddSample(latency);
+  }
+  histogram->AddSample(-5);
+  LatencyPercentiles percentiles = histogram->Percentiles();
+  EXPECT_EQ(10000, percentiles.count());
+  EXPECT_EQ(10000, percentiles.max_usec());
+  auto expect_near = [](int64 expected, int64 actual) {
+    EXPECT_GE(actual, expected);
+    EXPECT_LE(actual, expected + expected / LatencyHistogram::kSubBuckets);
+  };
+  expect_near(5000, percentiles.p50_usec());
+  expect_near(9000, percentiles.p90_usec());
+  expect_near(9900, percentiles.p99_usec());
+  expect_near(9990, percentiles.p999_usec());
+
+  histogram->Clear();
+  percentiles = histogram->Percentiles();
+  EXPECT_EQ(0, percentiles.count());
+  EXPECT_EQ(0, percentiles.p50_usec());
+}
+
+TEST(LatencyHistogramTest, MergesSamplesFromManyThreads) {
+  auto histogram = std::make_unique<LatencyHistogram>();
+  {
+    mediapipe::ThreadPool pool(8);
+    pool.StartWorkers();
+    for (int i = 0; i < 8; ++i) {
+      pool.Schedule([&histogram, i] {
+        for (int j = 0; j < 1000; ++j) {
+          histogram->AddSample(i * 1000 + j);
+        }
+      });
+    }
+  }
+  LatencyPercentiles percentiles = histogram->Percentiles();
+  EXPECT_EQ(8000, percentiles.count());
+  EXPECT_EQ(7999, percentiles.max_usec());
+}
+
+TEST(TimestampEntryTableTest, KeepsFirstEntryTime) {
+  TimestampEntryTable table;
+  EXPECT_EQ(-1, table.Lookup(33333));
+  table.Record(33333, 100);
+  table.Record(33333, 200);
+  EXPECT_EQ(100, table.Lookup(33333));
+  EXPECT_EQ(-1, table.Lookup(66666));
+}
+
+}  // namespace
+}  // namespace mediapipe
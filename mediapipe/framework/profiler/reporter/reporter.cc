@@ -4,8 +4,10 @@
 #include <iterator>
 #include <memory>
 #include <ostream>
+#include <set>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "absl/container/btree_map.h"
@@ -91,6 +93,32 @@ absl::btree_map<std::string,
         {"input_latency_total",
          [](const CalculatorData& d) -> const std::string {
            return ToString(d.input_latency_stat.total());
+         }},
+        {"critical_path_count",
+         [](const CalculatorData& d) -> const std::string {
+           return ToString(d.critical_path_count);
+         }},
+        {"critical_percent",
+         [](const CalculatorData& d) -> const std::string {
+           return ToStringF(d.critical_percent);
+         }},
+        {"critical_time_mean",
+         [](const CalculatorData& d) -> const std::string {
+           return ToStringF(d.critical_time_stat.mean());
+         }},
+        {"critical_time_total",
+         [](const CalculatorData& d) -> const std::string {
+           return ToString(d.critical_time_stat.data_count() == 0
+                               ? 0
+                               : d.critical_time_stat.total());
+         }},
+        {"slack_mean",
+         [](const CalculatorData& d) -> const std::string {
+           return ToStringF(d.slack_stat.mean());
+         }},
+        {"slack_stddev",
+         [](const CalculatorData& d) -> const std::string {
+           return ToStringF(d.slack_stat.stddev());
          }}};
 
 // Holds calculator traces that have an output trace with a provided stream ID
@@ -108,6 +136,28 @@ typedef std::map<std::pair<int64_t, std::pair<int32_t, int32_t>>,
 // Maps node IDs to names.
 typedef std::map<int32_t, std::string> NameLookup;
 
+// Identifies a packet by its timestamp and stream ID.
+typedef std::pair<int64_t, int32_t> PacketKey;
+
+// A Process() call, joined from its start and finish events, as a node of the
+// dependency DAG of one frame. Graph input packets are included as calls with
+// node_id -1 that start and finish when the packet is added.
+struct ProcessCall {
+  int32_t node_id;
+  int64_t start_time;
+  int64_t finish_time;
+  std::vector<PacketKey> inputs;
+  std::vector<PacketKey> outputs;
+  // The calls in the same frame that output this call's inputs, and that
+  // read this call's outputs.
+  std::vector<ProcessCall*> producers;
+  std::vector<ProcessCall*> consumers;
+  int64_t slack = 0;
+};
+
+// Maps each packet timestamp to the Process() calls for that timestamp.
+typedef std::map<int64_t, std::vector<ProcessCall>> FrameLookup;
+
 Reporter::Reporter() { MEDIAPIPE_CHECK_OK(set_columns({"*"})); }
 
 int64_t RecursePacketStartTime(
@@ -192,6 +242,149 @@ void CacheOutputTraceLookup(const mediapipe::GraphProfile& profile,
   }
 }
 
+void AddStreamTraces(
+    int64_t base_timestamp,
+    const proto_ns::RepeatedPtrField<GraphTrace::StreamTrace>& traces,
+    std::vector<PacketKey>* result) {
+  for (const auto& stream_trace : traces) {
+    result->emplace_back(base_timestamp + stream_trace.packet_timestamp(),
+                         stream_trace.stream_id());
+  }
+}
+
+// Groups the Process() calls in a profile by packet timestamp. A call that
+// started before the profile, or had not finished by its end, is omitted.
+void CacheFrameLookup(const mediapipe::GraphProfile& profile,
+                      FrameLookup* frames) {
+  // Unfinished calls by input timestamp, node_id and thread_id.
+  std::map<std::pair<int64_t, std::pair<int32_t, int32_t>>, ProcessCall>
+      started_calls;
+  for (const auto& graph_trace : profile.graph_trace()) {
+    const int64_t base_time = graph_trace.base_time();
+    const int64_t base_timestamp = graph_trace.base_timestamp();
+    for (const auto& calc_trace : graph_trace.calculator_trace()) {
+      if (calc_trace.event_type() != mediapipe::GraphTrace_EventType_PROCESS) {
+        continue;
+      }
+      const int64_t timestamp = base_timestamp + calc_trace.input_timestamp();
+      const auto key = std::make_pair(
+          timestamp,
+          std::make_pair(calc_trace.node_id(), calc_trace.thread_id()));
+      ProcessCall call;
+      if (calc_trace.has_start_time()) {
+        call.node_id = calc_trace.node_id();
+        call.start_time = base_time + calc_trace.start_time();
+      } else if (calc_trace.node_id() == -1) {
+        call.node_id = -1;
+        call.start_time = base_time + calc_trace.finish_time();
+      } else {
+        auto it = started_calls.find(key);
+        if (it == started_calls.end()) {
+          continue;
+        }
+        call = std::move(it->second);
+        started_calls.erase(it);
+      }
+      AddStreamTraces(base_timestamp, calc_trace.input_trace(), &call.inputs);
+      AddStreamTraces(base_timestamp, calc_trace.output_trace(),
+                      &call.outputs);
+      if (!calc_trace.has_finish_time()) {
+        started_calls[key] = std::move(call);
+        continue;
+      }
+      call.finish_time = base_time + calc_trace.finish_time();
+      (*frames)[timestamp].push_back(std::move(call));
+    }
+  }
+}
+
+// Finds the critical path and the slack of each Process() call in each frame,
+// and adds them to the calculator and graph statistics.
+//
+// The critical path runs back from the last call to finish, through the input
+// that arrived last at each call, to a call with no inputs from the frame.
+// The slack of a call is the time it could be delayed before delaying one of
+// its consumers, plus the slack of that consumer.
+void AccumulateCriticalPaths(
+    const NameLookup& name_lookup, FrameLookup* frames,
+    std::map<std::string, CalculatorData>* calculator_data,
+    GraphData* graph_data) {
+  for (auto& frame_entry : *frames) {
+    std::vector<ProcessCall>& calls = frame_entry.second;
+
+    // Link each call to the calls that output its inputs, ignoring back edges
+    // and packets output after the call started.
+    std::map<PacketKey, ProcessCall*> producer_lookup;
+    for (auto& call : calls) {
+      for (const auto& output : call.outputs) {
+        producer_lookup[output] = &call;
+      }
+    }
+    for (auto& call : calls) {
+      for (const auto& input : call.inputs) {
+        auto it = producer_lookup.find(input);
+        if (it == producer_lookup.end() || it->second == &call ||
+            it->second->finish_time > call.start_time) {
+          continue;
+        }
+        call.producers.push_back(it->second);
+        it->second->consumers.push_back(&call);
+      }
+    }
+
+    // Consumers finish after their producers, so visiting calls from the
+    // last to finish computes the slack of each consumer first.
+    std::vector<ProcessCall*> order;
+    for (auto& call : calls) {
+      order.push_back(&call);
+    }
+    std::sort(order.begin(), order.end(),
+              [](const ProcessCall* a, const ProcessCall* b) {
+                return std::make_pair(a->finish_time, a->start_time) >
+                       std::make_pair(b->finish_time, b->start_time);
+              });
+    const int64_t frame_finish_time = order.front()->finish_time;
+    for (ProcessCall* call : order) {
+      call->slack = frame_finish_time - call->finish_time;
+      for (const ProcessCall* consumer : call->consumers) {
+        call->slack =
+            std::min(call->slack, consumer->slack + consumer->start_time -
+                                      call->finish_time);
+      }
+    }
+
+    std::set<const ProcessCall*> critical_path;
+    const ProcessCall* call = order.front();
+    while (call && critical_path.insert(call).second) {
+      const ProcessCall* last_producer = nullptr;
+      for (const ProcessCall* producer : call->producers) {
+        if (!last_producer ||
+            producer->finish_time > last_producer->finish_time) {
+          last_producer = producer;
+        }
+      }
+      if (!last_producer) {
+        graph_data->frame_latency_stat.Push(frame_finish_time -
+                                            call->start_time);
+      }
+      call = last_producer;
+    }
+
+    for (const auto& call : calls) {
+      const auto name_it = name_lookup.find(call.node_id);
+      if (name_it == name_lookup.end()) {
+        continue;
+      }
+      auto& calc_data = (*calculator_data)[name_it->second];
+      calc_data.slack_stat.Push(call.slack);
+      if (critical_path.count(&call)) {
+        ++calc_data.critical_path_count;
+        calc_data.critical_time_stat.Push(call.finish_time - call.start_time);
+      }
+    }
+  }
+}
+
 void CompleteCalculatorData(
     const GraphData& graph_data,
     std::map<std::string, CalculatorData>* calculator_data) {
@@ -211,6 +404,14 @@ void CompleteCalculatorData(
                                     ? 0
                                     : 1.0 / calc_data.time_stat.mean() * 1.0E+6;
     calc_data.thread_count = calc_data.threads.size();
+
+    const auto& frame_latency_stat = graph_data.frame_latency_stat;
+    calc_data.critical_percent =
+        calc_data.critical_time_stat.data_count() == 0 ||
+                frame_latency_stat.data_count() == 0
+            ? 0
+            : 100 * calc_data.critical_time_stat.total() /
+                  frame_latency_stat.total();
   }
 }
 
@@ -295,6 +496,12 @@ void Reporter::Accumulate(const mediapipe::GraphProfile& profile) {
       }
     }
   }
+
+  // Rebuild the dependency DAG of each frame to find its critical path.
+  FrameLookup frames;
+  CacheFrameLookup(profile, &frames);
+  AccumulateCriticalPaths(name_lookup, &frames, &calculator_data_,
+                          &graph_data_);
 }
 
 absl::Status Reporter::set_columns(const std::vector<std::string>& columns) {
@@ -20,6 +20,10 @@ struct GraphData {
   int64_t max_time = std::numeric_limits<int64_t>::min();
 
   int64_t total_time = 0;
+
+  // Records the end-to-end latency of each frame (microseconds), from the
+  // start to the end of its critical path.
+  Statistic frame_latency_stat;
 };
 
 // Holds all of the measured data for a calculator.
@@ -63,6 +67,22 @@ struct CalculatorData {
 
   // The threads on which this calculator ran.
   std::set<int> threads;
+
+  // The number of frames for which this calculator was on the critical path,
+  // the chain of Process() calls that determined when the frame finished.
+  int critical_path_count;
+
+  // Records the time this calculator spent in PROCESS on the critical path of
+  // each frame (microseconds).
+  Statistic critical_time_stat;
+
+  // Percentage of the total end-to-end frame latency spent in this calculator
+  // on the critical path.
+  double critical_percent;
+
+  // Records the slack of each Process() call (microseconds), which is how much
+  // later it could have finished without delaying the end of its frame.
+  Statistic slack_stat;
 };
 
 // A snapshot of statistics generated by Reporter.
@@ -97,7 +97,8 @@ TEST(Reporter, ReportColumnsWithWildcards) {
   auto reporter = loadReporter({"profile_opencv_0.binarypb"});
   MEDIAPIPE_CHECK_OK(reporter->set_columns({"*_m??n", "*l?t*cy*"}));
   EXPECT_THAT(reporter->Report()->headers(),
-              ElementsAre("calculator", "input_latency_mean", "time_mean",
+              ElementsAre("calculator", "critical_time_mean",
+                          "input_latency_mean", "slack_mean", "time_mean",
                           "input_latency_stddev", "input_latency_total"));
 }
 
@@ -228,4 +229,40 @@ TEST(Reporter, LatencyCalculatedCorrectly) {
       testing::DoubleEq(1500));
 }
 
+TEST(Reporter, CriticalPathCalculatedCorrectly) {
+  auto reporter = loadReporter({"profile_critical_path_test.binarypb"});
+  auto report = reporter->Report();
+  const auto& calculator_data = report->calculator_data();
+  EXPECT_EQ(report->graph_data().frame_latency_stat.data_count(), 2);
+  EXPECT_THAT(report->graph_data().frame_latency_stat.total(),
+              testing::DoubleEq(1800));
+
+  // A and D are on the critical path of both frames, B and C of one each.
+  EXPECT_EQ(calculator_data.at("ACalculator").critical_path_count, 2);
+  EXPECT_EQ(calculator_data.at("BCalculator").critical_path_count, 1);
+  EXPECT_EQ(calculator_data.at("CCalculator").critical_path_count, 1);
+  EXPECT_EQ(calculator_data.at("DCalculator").critical_path_count, 2);
+  EXPECT_THAT(calculator_data.at("BCalculator").critical_time_stat.total(),
+              testing::DoubleEq(500));
+  EXPECT_THAT(calculator_data.at("CCalculator").critical_time_stat.total(),
+              testing::DoubleEq(600));
+  EXPECT_THAT(calculator_data.at("ACalculator").critical_percent,
+              testing::DoubleNear(11.11, 0.01));
+  EXPECT_THAT(calculator_data.at("BCalculator").critical_percent,
+              testing::DoubleNear(27.78, 0.01));
+  EXPECT_THAT(calculator_data.at("CCalculator").critical_percent,
+              testing::DoubleNear(33.33, 0.01));
+
+  // Each call can be delayed until its consumer starts, plus the slack of
+  // that consumer.
+  EXPECT_THAT(calculator_data.at("ACalculator").slack_stat.mean(),
+              testing::DoubleEq(50));
+  EXPECT_THAT(calculator_data.at("BCalculator").slack_stat.mean(),
+              testing::DoubleEq(300));
+  EXPECT_THAT(calculator_data.at("CCalculator").slack_stat.mean(),
+              testing::DoubleEq(225));
+  EXPECT_THAT(calculator_data.at("DCalculator").slack_stat.mean(),
+              testing::DoubleEq(0));
+}
+
 }  // namespace mediapipe
@@ -147,6 +147,18 @@ class Scheduler {
 
   void SetHasError(bool error) { shared_.has_error = error; }
 
+  // Sets the arena in which the packets created by nodes are allocated.
+  // Must be called before the scheduler is started.
+  void SetPacketArena(std::shared_ptr<PacketArena> arena) {
+    shared_.packet_arena = std::move(arena);
+  }
+
+  // If true, non-source nodes run in order of their input timestamps rather
+  // than their node ids. Must be called before the scheduler is started.
+  void SetOldestTimestampFirst(bool oldest_timestamp_first) {
+    shared_.oldest_timestamp_first = oldest_timestamp_first;
+  }
+
   // Notifies the scheduler that a packet was added to a graph input stream.
   // The scheduler needs to check whether it is still deadlocked, and
   // unthrottle again if so.
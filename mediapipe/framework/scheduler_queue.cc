@@ -18,9 +18,12 @@
 #include <queue>
 #include <utility>
 
+#include "absl/memory/memory.h"
+#include "absl/numeric/bits.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_node.h"
 #include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/status.h"
@@ -34,6 +37,9 @@
 namespace mediapipe {
 namespace internal {
 
+thread_local SchedulerQueue::InlineTask* SchedulerQueue::current_inline_task_ =
+    nullptr;
+
 SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
     : node_(node), cc_(cc) {
   CHECK(node);
@@ -43,6 +49,8 @@ SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
   if (is_source_) {
     layer_ = node->source_layer();
     source_process_order_ = node->SourceProcessOrder(cc).Value();
+  } else {
+    input_timestamp_ = cc->InputTimestamp().Value();
   }
 }
 
@@ -86,25 +94,114 @@ bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
   }
 }
 
+bool SchedulerQueue::Item::RunsAfterByTimestamp(
+    const SchedulerQueue::Item& that) const {
+  // Newer timestamps run after older timestamps.
+  if (input_timestamp_ != that.input_timestamp_) {
+    return input_timestamp_ > that.input_timestamp_;
+  }
+  // For the same timestamp, higher ids run before lower ids.
+  return id_ < that.id_;
+}
+
+void SchedulerQueue::NodeBuckets::Reserve(int id) {
+  CHECK_GE(id, 0);
+  while (buckets_.size() <= id) {
+    buckets_.push_back(absl::make_unique<Bucket>());
+  }
+  const int num_words = (buckets_.size() + 63) / 64;
+  if (num_words > num_words_) {
+    auto occupied = absl::make_unique<std::atomic<uint64>[]>(num_words);
+    for (int i = 0; i < num_words; ++i) {
+      occupied[i].store(i < num_words_ ? occupied_[i].load() : 0);
+    }
+    occupied_ = std::move(occupied);
+    num_words_ = num_words;
+  }
+}
+
+void SchedulerQueue::NodeBuckets::Push(Item&& item) {
+  const int id = item.Id();
+  DCHECK_LT(id, buckets_.size()) << "Node was not registered.";
+  Bucket& bucket = *buckets_[id];
+  absl::MutexLock lock(&bucket.mutex);
+  if (bucket.items.empty()) {
+    occupied_[id / 64].fetch_or(uint64{1} << (id % 64));
+  }
+  bucket.items.push_back(std::move(item));
+  size_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool SchedulerQueue::NodeBuckets::PopFromBucket(int id,
+                                                absl::optional<Item>* item) {
+  Bucket& bucket = *buckets_[id];
+  absl::MutexLock lock(&bucket.mutex);
+  if (bucket.items.empty()) return false;
+  item->emplace(std::move(bucket.items.front()));
+  bucket.items.pop_front();
+  if (bucket.items.empty()) {
+    occupied_[id / 64].fetch_and(~(uint64{1} << (id % 64)));
+  }
+  size_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool SchedulerQueue::NodeBuckets::Pop(absl::optional<Item>* item) {
+  if (Size() == 0) return false;
+  for (int i = 0; i < num_words_; ++i) {
+    const int word = higher_ids_first_ ? num_words_ - 1 - i : i;
+    uint64 bits = occupied_[word].load();
+    // A bit may be cleared by a concurrent Pop() after it is read here, in
+    // which case PopFromBucket() fails and the next candidate is tried.
+    while (bits != 0) {
+      const int bit = higher_ids_first_ ? 63 - absl::countl_zero(bits)
+                                        : absl::countr_zero(bits);
+      if (PopFromBucket(word * 64 + bit, item)) return true;
+      bits &= ~(uint64{1} << bit);
+    }
+  }
+  return false;
+}
+
+void SchedulerQueue::NodeBuckets::Clear() {
+  for (auto& bucket : buckets_) {
+    absl::MutexLock lock(&bucket->mutex);
+    bucket->items.clear();
+  }
+  for (int i = 0; i < num_words_; ++i) {
+    occupied_[i].store(0);
+  }
+  size_.store(0);
+}
+
 void SchedulerQueue::Reset() {
-  absl::MutexLock lock(&mutex_);
-  num_pending_tasks_ = 0;
+  num_unfinished_items_ = 0;
   num_tasks_to_add_ = 0;
   running_count_ = 0;
 }
 
 void SchedulerQueue::SetExecutor(Executor* executor) { executor_ = executor; }
 
-bool SchedulerQueue::IsIdle() {
-  VLOG(3) << "Scheduler queue empty: " << queue_.empty()
-          << ", # of pending tasks: " << num_pending_tasks_;
-  return queue_.empty() && num_pending_tasks_ == 0;
+void SchedulerQueue::RegisterNode(const CalculatorNode* node) {
+  open_nodes_.Reserve(node->Id());
+  nodes_.Reserve(node->Id());
+}
+
+int SchedulerQueue::QueueSize() const {
+  return open_nodes_.Size() + nodes_.Size() + num_timestamp_nodes_.load() +
+         num_sources_.load();
+}
+
+bool SchedulerQueue::IsIdle() const {
+  VLOG(3) << "Scheduler queue size: " << QueueSize()
+          << ", # of unfinished items: " << num_unfinished_items_.load();
+  return num_unfinished_items_.load() == 0;
 }
 
 void SchedulerQueue::SetRunning(bool running) {
-  absl::MutexLock lock(&mutex_);
-  running_count_ += running ? 1 : -1;
-  DCHECK_LE(running_count_, 1);
+  const int delta = running ? 1 : -1;
+  const int running_count = running_count_.fetch_add(delta) + delta;
+  DCHECK_LE(running_count, 1);
 }
 
 void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
@@ -120,9 +217,29 @@ void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
     CHECK(node->IsSource()) << node->DebugName();
     return;
   }
+  if (TryToRunInline(node, cc)) {
+    return;
+  }
   AddItemToQueue(Item(node, cc));
 }
 
+bool SchedulerQueue::TryToRunInline(CalculatorNode* node,
+                                    CalculatorContext* cc) {
+  InlineTask* task = current_inline_task_;
+  if (node->fused_producer_id() < 0 || task == nullptr || task->queue != this ||
+      task->running_node == nullptr ||
+      task->running_node->Id() != node->fused_producer_id() ||
+      task->next_item.has_value() || running_count_.load() == 0) {
+    return false;
+  }
+  // The running task keeps the queue active, so this cannot make it active.
+  num_unfinished_items_.fetch_add(1);
+  task->next_item.emplace(node, cc);
+  VLOG(4) << node->DebugName() << " will run inline after "
+          << task->running_node->DebugName();
+  return true;
+}
+
 void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
   if (shared_->has_error) {
     return;
@@ -132,18 +249,33 @@ void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
 
 void SchedulerQueue::AddItemToQueue(Item&& item) {
   const CalculatorNode* node = item.Node();
-  bool was_idle;
+  const bool was_idle = num_unfinished_items_.fetch_add(1) == 0;
+  if (item.IsOpenNode()) {
+    open_nodes_.Push(std::move(item));
+  } else if (item.IsSource()) {
+    absl::MutexLock lock(&sources_mutex_);
+    sources_.push(std::move(item));
+    num_sources_.fetch_add(1);
+  } else if (shared_->oldest_timestamp_first) {
+    absl::MutexLock lock(&timestamp_nodes_mutex_);
+    timestamp_nodes_.push(std::move(item));
+    num_timestamp_nodes_.fetch_add(1);
+  } else {
+    nodes_.Push(std::move(item));
+  }
+  num_pushed_items_.fetch_add(1);
+  VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
+
   int tasks_to_add = 0;
-  {
-    absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
-    queue_.push(item);
-    ++num_tasks_to_add_;
-    VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
-
-    // Now grab the tasks to execute while still holding the lock. This will
-    // gather any waiting tasks, in addition to the one we just added.
-    if (running_count_ > 0) {
+  if (running_count_.load() > 0) {
+    // Submit the task for this item ourselves, so that it cannot complete
+    // before idle_callback_(false) below. Also gather any waiting tasks.
+    tasks_to_add = 1 + GetTasksToSubmitToExecutor();
+  } else {
+    num_tasks_to_add_.fetch_add(1);
+    // If the queue started running concurrently, SubmitWaitingTasksToExecutor
+    // may have missed the task added above.
+    if (running_count_.load() > 0) {
       tasks_to_add = GetTasksToSubmitToExecutor();
     }
   }
@@ -162,10 +294,7 @@ void SchedulerQueue::AddItemToQueue(Item&& item) {
 }
 
 int SchedulerQueue::GetTasksToSubmitToExecutor() {
-  int tasks_to_add = num_tasks_to_add_;
-  num_tasks_to_add_ = 0;
-  num_pending_tasks_ += tasks_to_add;
-  return tasks_to_add;
+  return num_tasks_to_add_.exchange(0);
 }
 
 void SchedulerQueue::SubmitWaitingTasksToExecutor() {
@@ -173,11 +302,8 @@ void SchedulerQueue::SubmitWaitingTasksToExecutor() {
   // we do not immediately submit tasks to the executor. Here we check for any
   // such waiting tasks, and submit them.
   int tasks_to_add = 0;
-  {
-    absl::MutexLock lock(&mutex_);
-    if (running_count_ > 0) {
-      tasks_to_add = GetTasksToSubmitToExecutor();
-    }
+  if (running_count_.load() > 0) {
+    tasks_to_add = GetTasksToSubmitToExecutor();
   }
   while (tasks_to_add > 0) {
     executor_->AddTask(this);
@@ -185,24 +311,60 @@ void SchedulerQueue::SubmitWaitingTasksToExecutor() {
   }
 }
 
-void SchedulerQueue::RunNextTask() {
-  CalculatorNode* node;
-  CalculatorContext* calculator_context;
-  bool is_open_node;
-  {
-    absl::MutexLock lock(&mutex_);
-
-    CHECK(!queue_.empty()) << "Called RunNextTask when the queue is empty. "
-                              "This should not happen.";
-
-    node = queue_.top().Node();
-    calculator_context = queue_.top().Context();
-    is_open_node = queue_.top().IsOpenNode();
-    queue_.pop();
+bool SchedulerQueue::PopItem(absl::optional<Item>* item) {
+  if (open_nodes_.Pop(item)) return true;
+  if (nodes_.Pop(item)) return true;
+  if (num_timestamp_nodes_.load() > 0) {
+    absl::MutexLock lock(&timestamp_nodes_mutex_);
+    if (!timestamp_nodes_.empty()) {
+      item->emplace(timestamp_nodes_.top());
+      timestamp_nodes_.pop();
+      num_timestamp_nodes_.fetch_sub(1);
+      return true;
+    }
+  }
+  if (num_sources_.load() > 0) {
+    absl::MutexLock lock(&sources_mutex_);
+    if (!sources_.empty()) {
+      item->emplace(sources_.top());
+      sources_.pop();
+      num_sources_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
 
-    CHECK(!node->Closed())
-        << "Scheduled a node that was closed. This should not happen.";
+void SchedulerQueue::RunNextTask() {
+  CHECK_GT(num_unfinished_items_.load(), 0)
+      << "Called RunNextTask when the queue is empty. This should not happen.";
+  absl::optional<Item> item;
+  // Every task is submitted after the item it stands for was pushed, so the
+  // queue holds at least one item for each task that has not popped one yet.
+  // A scan can only miss all of them if items were pushed behind it while it
+  // ran, in which case num_pushed_items_ has changed and the scan is retried.
+  // Each retry thus means that another thread made progress.
+  while (true) {
+    const int64 num_pushed_items = num_pushed_items_.load();
+    if (PopItem(&item)) break;
+    if (num_pushed_items_.load() == num_pushed_items) {
+      // Not expected. Rather than spin, leave the item to a new task.
+      LOG(DFATAL) << "RunNextTask found no item to run.";
+      executor_->AddTask(this);
+      return;
+    }
   }
+  CalculatorNode* node = item->Node();
+  CalculatorContext* calculator_context = item->Context();
+  bool is_open_node = item->IsOpenNode();
+  CHECK(!node->Closed())
+      << "Scheduled a node that was closed. This should not happen.";
+
+  // Lets AddNode() hand this task the nodes fused with the node it runs.
+  InlineTask inline_task;
+  inline_task.queue = this;
+  InlineTask* const enclosing_task = current_inline_task_;
+  current_inline_task_ = &inline_task;
 
   // On iOS, calculators may rely on the existence of an autorelease pool
   // (either directly, or because system code they call does). We do not
@@ -210,21 +372,32 @@ void SchedulerQueue::RunNextTask() {
   // an executor creating standard pthread will not, by default), so we
   // do it here to ensure all executors are covered.
   AUTORELEASEPOOL {
+    PacketArena::Scope arena_scope(shared_->packet_arena.get());
     if (is_open_node) {
       DCHECK(!calculator_context);
       OpenCalculatorNode(node);
     } else {
+      inline_task.running_node = node;
       RunCalculatorNode(node, calculator_context);
+      // Run the chain of fused nodes that became ready, one after another.
+      while (inline_task.next_item.has_value()) {
+        CalculatorNode* next_node = inline_task.next_item->Node();
+        CalculatorContext* next_context = inline_task.next_item->Context();
+        inline_task.next_item.reset();
+        inline_task.running_node = next_node;
+        ProfilingContext* profiling_context =
+            next_context->GetProfilingContext();
+        if (profiling_context) {
+          profiling_context->AddInlineProcessCall(*next_context);
+        }
+        RunCalculatorNode(next_node, next_context);
+        num_unfinished_items_.fetch_sub(1);
+      }
     }
   }
+  current_inline_task_ = enclosing_task;
 
-  bool is_idle;
-  {
-    absl::MutexLock lock(&mutex_);
-    DCHECK_GT(num_pending_tasks_, 0);
-    --num_pending_tasks_;
-    is_idle = IsIdle();
-  }
+  const bool is_idle = num_unfinished_items_.fetch_sub(1) == 1;
   if (is_idle && idle_callback_) {
     // Became idle.
     idle_callback_(true);
@@ -295,16 +468,28 @@ void SchedulerQueue::OpenCalculatorNode(CalculatorNode* node) {
 }
 
 void SchedulerQueue::CleanupAfterRun() {
-  bool was_idle;
+  const bool was_idle = IsIdle();
+  // No task may be running, so every unfinished item is still queued and
+  // waiting for its task to be added to the executor.
+  CHECK_EQ(num_unfinished_items_.load(), num_tasks_to_add_.load());
+  CHECK_EQ(num_tasks_to_add_.load(), QueueSize());
+  num_tasks_to_add_ = 0;
+  num_unfinished_items_ = 0;
+  open_nodes_.Clear();
+  nodes_.Clear();
+  {
+    absl::MutexLock lock(&timestamp_nodes_mutex_);
+    while (!timestamp_nodes_.empty()) {
+      timestamp_nodes_.pop();
+    }
+    num_timestamp_nodes_ = 0;
+  }
   {
-    absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
-    CHECK_EQ(num_pending_tasks_, 0);
-    CHECK_EQ(num_tasks_to_add_, queue_.size());
-    num_tasks_to_add_ = 0;
-    while (!queue_.empty()) {
-      queue_.pop();
+    absl::MutexLock lock(&sources_mutex_);
+    while (!sources_.empty()) {
+      sources_.pop();
     }
+    num_sources_ = 0;
   }
   if (!was_idle && idle_callback_) {
     // Became idle.
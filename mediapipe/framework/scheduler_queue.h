@@ -16,13 +16,16 @@
 #define MEDIAPIPE_FRAMEWORK_SCHEDULER_QUEUE_H_
 
 #include <atomic>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -35,6 +38,13 @@ class CalculatorNode;
 namespace internal {
 
 // Manages a priority queue of nodes to be run on the associated executor.
+//
+// The queue has no queue-wide lock. Non-source nodes and nodes waiting for
+// OpenNode() are kept in per-node FIFO buckets, each with its own lock, and
+// an atomic occupancy bitmap is scanned to find the highest-priority
+// non-empty bucket. Source nodes, whose priority changes with every
+// timestamp, are kept in a separate priority queue that is only locked when
+// sources are scheduled. The bookkeeping counters are atomics.
 class SchedulerQueue : public TaskQueue {
  public:
   // Callback to be invoked when the queue's idle state changes.
@@ -55,6 +65,10 @@ class SchedulerQueue : public TaskQueue {
 
     bool IsOpenNode() const { return is_open_node_; }
 
+    bool IsSource() const { return is_source_; }
+
+    int Id() const { return id_; }
+
     // This comparison is meant to be used with a std::priority_queue. Since
     // the priority queue returns higher priority items first, this function
     // means "this is lower priority than that", i.e. "this runs after that".
@@ -66,8 +80,14 @@ class SchedulerQueue : public TaskQueue {
     //   are closer to the leaves.
     bool operator<(const Item& that) const;
 
+    // Like operator<, but for non-sources only: older input timestamps run
+    // first, then larger ids.
+    bool RunsAfterByTimestamp(const Item& that) const;
+
    private:
     int64 source_process_order_ = 0;
+    // The input timestamp of a non-source node.
+    int64 input_timestamp_ = 0;
     CalculatorNode* node_;
     CalculatorContext* cc_;
     int id_ = 0;
@@ -76,12 +96,19 @@ class SchedulerQueue : public TaskQueue {
     bool is_open_node_ = false;  // True if the task should run OpenNode().
   };
 
-  explicit SchedulerQueue(SchedulerShared* shared) : shared_(shared) {}
+  explicit SchedulerQueue(SchedulerShared* shared)
+      : open_nodes_(/*higher_ids_first=*/false),
+        nodes_(/*higher_ids_first=*/true),
+        shared_(shared) {}
 
   // Sets the executor that will run the nodes. Must be called before the
   // scheduler is started.
   void SetExecutor(Executor* executor);
 
+  // Makes room for |node| in the queue. Must be called for every node
+  // assigned to this queue before the scheduler is started.
+  void RegisterNode(const CalculatorNode* node);
+
   // Sets the idle callback. It is called exactly once whenever the queue goes
   // from idle to active, or vice versa.
   // Note: if the queue is accessed by multiple threads, it is possible for
@@ -105,45 +132,111 @@ class SchedulerQueue : public TaskQueue {
   // NOTE: After calling SetRunning(true), the caller must call
   // SubmitWaitingTasksToExecutor since tasks may have been added while the
   // queue was not running.
-  void SetRunning(bool running) ABSL_LOCKS_EXCLUDED(mutex_);
+  void SetRunning(bool running);
 
   // Gets the number of tasks that need to be submitted to the executor, and
-  // updates num_pending_tasks_. If this method is called and returns a
-  // non-zero value, the executor's AddTask method *must* be called for each
-  // task returned, but it can be called without holding the lock.
-  int GetTasksToSubmitToExecutor() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // resets it to zero. If this method returns a non-zero value, the
+  // executor's AddTask method *must* be called for each task returned.
+  int GetTasksToSubmitToExecutor();
 
   // Submits tasks that are waiting (e.g. that were added while the queue was
   // not running) if the queue is running. The caller must not hold any mutex.
-  void SubmitWaitingTasksToExecutor() ABSL_LOCKS_EXCLUDED(mutex_);
+  void SubmitWaitingTasksToExecutor();
 
   // Adds a node and a calculator context to the scheduler queue if the node is
   // not already running. Note that if the node was running, then it will be
   // rescheduled upon completion (after checking dependencies), so this call is
-  // not lost.
-  void AddNode(CalculatorNode* node, CalculatorContext* cc)
-      ABSL_LOCKS_EXCLUDED(mutex_);
+  // not lost. A node fused with the node running on the calling thread is not
+  // queued, but run inline once the running node is done.
+  void AddNode(CalculatorNode* node, CalculatorContext* cc);
 
   // Adds a node to the scheduler queue for an OpenNode() call.
-  void AddNodeForOpen(CalculatorNode* node) ABSL_LOCKS_EXCLUDED(mutex_);
+  void AddNodeForOpen(CalculatorNode* node);
 
-  // Adds an Item to queue_.
+  // Adds an Item to the queue.
   void AddItemToQueue(Item&& item);
 
-  void CleanupAfterRun() ABSL_LOCKS_EXCLUDED(mutex_);
+  void CleanupAfterRun();
 
  private:
+  // FIFO buckets of items indexed by node id, with a bitmap of the non-empty
+  // buckets. Each bucket has its own mutex, which is only contended when the
+  // same node is scheduled from several threads at once.
+  class NodeBuckets {
+   public:
+    // If |higher_ids_first| is true, Pop() prefers items with higher node ids,
+    // otherwise items with lower node ids.
+    explicit NodeBuckets(bool higher_ids_first)
+        : higher_ids_first_(higher_ids_first) {}
+
+    // Makes room for node |id|. Must not be called concurrently with any
+    // other method.
+    void Reserve(int id);
+
+    void Push(Item&& item);
+
+    // Pops the first item of the highest-priority non-empty bucket. Returns
+    // false if every bucket was found empty.
+    bool Pop(absl::optional<Item>* item);
+
+    int Size() const { return size_.load(std::memory_order_relaxed); }
+
+    // Must not be called concurrently with any other method.
+    void Clear();
+
+   private:
+    struct Bucket {
+      absl::Mutex mutex;
+      std::deque<Item> items ABSL_GUARDED_BY(mutex);
+    };
+
+    // Pops the first item of bucket |id|, if there is one.
+    bool PopFromBucket(int id, absl::optional<Item>* item);
+
+    const bool higher_ids_first_;
+    std::vector<std::unique_ptr<Bucket>> buckets_;
+    // Bit |id % 64| of word |id / 64| is set iff bucket |id| is non-empty.
+    // A bit is only changed while holding the mutex of its bucket.
+    std::unique_ptr<std::atomic<uint64>[]> occupied_;
+    int num_words_ = 0;
+    std::atomic<int> size_{0};
+  };
+
+  // The task running on a thread. While a node runs, a node fused with it may
+  // be stashed in next_item, to run on the same thread right after it.
+  struct InlineTask {
+    const SchedulerQueue* queue = nullptr;
+    const CalculatorNode* running_node = nullptr;
+    absl::optional<Item> next_item;
+  };
+
+  // Orders a priority queue by SchedulingPolicy OLDEST_TIMESTAMP_FIRST.
+  struct ByTimestamp {
+    bool operator()(const Item& a, const Item& b) const {
+      return a.RunsAfterByTimestamp(b);
+    }
+  };
+
   // Used internally by RunNextTask. Invokes ProcessNode or CloseNode, followed
   // by EndScheduling.
-  void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc)
-      ABSL_LOCKS_EXCLUDED(mutex_);
+  void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc);
 
   // Used internally by RunNextTask. Invokes OpenNode, followed by
   // CheckIfBecameReady.
-  void OpenCalculatorNode(CalculatorNode* node) ABSL_LOCKS_EXCLUDED(mutex_);
+  void OpenCalculatorNode(CalculatorNode* node);
+
+  // Stashes a node fused with the node running on the calling thread, so that
+  // it runs inline after it. Returns false if the node must be queued.
+  bool TryToRunInline(CalculatorNode* node, CalculatorContext* cc);
+
+  // Pops the highest-priority item. Returns false if no item was found.
+  bool PopItem(absl::optional<Item>* item);
+
+  // Returns the number of queued items.
+  int QueueSize() const;
 
   // Checks whether the queue has no queued nodes or pending tasks.
-  bool IsIdle() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool IsIdle() const;
 
   Executor* executor_ = nullptr;
 
@@ -154,20 +247,40 @@ class SchedulerQueue : public TaskQueue {
   // decrements it. The queue is running if running_count_ > 0. A running
   // queue will submit tasks to the executor.
   // Invariant: running_count_ <= 1.
-  int running_count_ ABSL_GUARDED_BY(mutex_) = 0;
-
-  // Number of tasks added to the Executor and not yet complete.
-  int num_pending_tasks_ ABSL_GUARDED_BY(mutex_);
+  std::atomic<int> running_count_{0};
 
   // Number of tasks that need to be added to the Executor.
-  int num_tasks_to_add_ ABSL_GUARDED_BY(mutex_);
-
-  // Queue of nodes that need to be run.
-  std::priority_queue<Item> queue_ ABSL_GUARDED_BY(mutex_);
+  std::atomic<int> num_tasks_to_add_{0};
+
+  // Number of items added to the queue that have not finished running. Every
+  // item is matched by one task that is either waiting to be added to the
+  // Executor or added and not yet complete, so the queue is idle iff this is
+  // zero.
+  std::atomic<int> num_unfinished_items_{0};
+
+  // Number of items pushed to the queue, incremented after each push. Lets
+  // RunNextTask tell a scan that raced with pushes from one that found the
+  // queue empty.
+  std::atomic<int64> num_pushed_items_{0};
+
+  // Nodes that need to be run, in priority order: nodes waiting for
+  // OpenNode(), non-source nodes, and source nodes.
+  NodeBuckets open_nodes_;
+  NodeBuckets nodes_;
+  // Non-source nodes, if SchedulerShared::oldest_timestamp_first. Their
+  // priority depends on the timestamp, as for source nodes.
+  mutable absl::Mutex timestamp_nodes_mutex_;
+  std::priority_queue<Item, std::vector<Item>, ByTimestamp> timestamp_nodes_
+      ABSL_GUARDED_BY(timestamp_nodes_mutex_);
+  std::atomic<int> num_timestamp_nodes_{0};
+  mutable absl::Mutex sources_mutex_;
+  std::priority_queue<Item> sources_ ABSL_GUARDED_BY(sources_mutex_);
+  std::atomic<int> num_sources_{0};
 
   SchedulerShared* const shared_;
 
-  absl::Mutex mutex_;
+  // The innermost task running on this thread, or null.
+  static thread_local InlineTask* current_inline_task_;
 };
 
 }  // namespace internal
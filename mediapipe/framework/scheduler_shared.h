@@ -25,6 +25,7 @@
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/deps/monotonic_clock.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status.h"
 
@@ -108,6 +109,10 @@ struct SchedulerShared {
   std::function<void(const absl::Status& error)> error_callback;
   // Collects timing information for measuring overhead.
   internal::SchedulerTimer timer;
+  // The arena that is current while nodes run, or null.
+  std::shared_ptr<PacketArena> packet_arena;
+  // If true, non-source nodes with older input timestamps run first.
+  bool oldest_timestamp_first = false;
 };
 
 }  // namespace internal
@@ -14,8 +14,13 @@
 
 #include "mediapipe/framework/thread_pool_executor.h"
 
+#include <iterator>
+#include <memory>
+#include <set>
+#include <string>
 #include <utility>
 
+#include "absl/algorithm/container.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/status_builder.h"
@@ -71,21 +76,73 @@ absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
       break;
   }
 #endif
-  return new ThreadPoolExecutor(thread_options, options.num_threads());
+  std::set<int> cpu_set;
+  for (int cpu_id : options.cpu_id()) {
+    if (cpu_id < 0) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "The cpu_id field in ThreadPoolExecutorOptions should be "
+                "non-negative but is "
+             << cpu_id;
+    }
+    cpu_set.insert(cpu_id);
+  }
+  if (options.has_numa_node()) {
+    if (options.numa_node() < 0) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "The numa_node field in ThreadPoolExecutorOptions should be "
+                "non-negative but is "
+             << options.numa_node();
+    }
+    thread_options.set_numa_node(options.numa_node());
+#if defined(__linux__)
+    const std::set<int> node_cpus = GetNumaNodeCpuIds(options.numa_node());
+    if (node_cpus.empty()) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "NUMA node " << options.numa_node()
+             << " specified in ThreadPoolExecutorOptions has no processors.";
+    }
+    if (cpu_set.empty()) {
+      cpu_set = node_cpus;
+    } else {
+      std::set<int> node_cpu_set;
+      absl::c_set_intersection(cpu_set, node_cpus,
+                               std::inserter(node_cpu_set, node_cpu_set.end()));
+      if (node_cpu_set.empty()) {
+        return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+               << "None of the cpu_id values in ThreadPoolExecutorOptions "
+                  "belong to NUMA node "
+               << options.numa_node();
+      }
+      cpu_set = std::move(node_cpu_set);
+    }
+#endif
+  }
+  if (!cpu_set.empty()) {
+    thread_options.set_cpu_set(cpu_set);
+  }
+  return new ThreadPoolExecutor(
+      thread_options, options.num_threads(),
+      options.task_queue_type() == ThreadPoolExecutorOptions::WORK_STEALING);
 }
 
 ThreadPoolExecutor::ThreadPoolExecutor(int num_threads)
-    : thread_pool_("mediapipe", num_threads) {
+    : thread_pool_(
+          std::make_unique<mediapipe::ThreadPool>("mediapipe", num_threads)) {
   Start();
 }
 
 ThreadPoolExecutor::ThreadPoolExecutor(const ThreadOptions& thread_options,
-                                       int num_threads)
-    : thread_pool_(thread_options,
-                   thread_options.name_prefix().empty()
-                       ? "mediapipe"
-                       : thread_options.name_prefix(),
-                   num_threads) {
+                                       int num_threads, bool work_stealing) {
+  const std::string name_prefix = thread_options.name_prefix().empty()
+                                      ? "mediapipe"
+                                      : thread_options.name_prefix();
+  if (work_stealing) {
+    work_stealing_pool_ = std::make_unique<mediapipe::WorkStealingThreadPool>(
+        thread_options, name_prefix, num_threads);
+  } else {
+    thread_pool_ = std::make_unique<mediapipe::ThreadPool>(
+        thread_options, name_prefix, num_threads);
+  }
   Start();
 }
 
@@ -94,14 +151,29 @@ ThreadPoolExecutor::~ThreadPoolExecutor() {
 }
 
 void ThreadPoolExecutor::Schedule(std::function<void()> task) {
-  thread_pool_.Schedule(std::move(task));
+  if (work_stealing_pool_) {
+    work_stealing_pool_->Schedule(std::move(task));
+  } else {
+    thread_pool_->Schedule(std::move(task));
+  }
+}
+
+int ThreadPoolExecutor::num_threads() const {
+  return work_stealing_pool_ ? work_stealing_pool_->num_threads()
+                             : thread_pool_->num_threads();
 }
 
 void ThreadPoolExecutor::Start() {
-  stack_size_ = thread_pool_.thread_options().stack_size();
-  thread_pool_.StartWorkers();
-  VLOG(2) << "Started thread pool with " << thread_pool_.num_threads()
-          << " threads.";
+  if (work_stealing_pool_) {
+    stack_size_ = work_stealing_pool_->thread_options().stack_size();
+    work_stealing_pool_->StartWorkers();
+    VLOG(2) << "Started work-stealing thread pool with " << num_threads()
+            << " threads.";
+  } else {
+    stack_size_ = thread_pool_->thread_options().stack_size();
+    thread_pool_->StartWorkers();
+    VLOG(2) << "Started thread pool with " << num_threads() << " threads.";
+  }
 }
 
 REGISTER_EXECUTOR(ThreadPoolExecutor);
@@ -15,7 +15,10 @@
 #ifndef MEDIAPIPE_FRAMEWORK_THREAD_POOL_EXECUTOR_H_
 #define MEDIAPIPE_FRAMEWORK_THREAD_POOL_EXECUTOR_H_
 
+#include <memory>
+
 #include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/statusor.h"
 #include "mediapipe/framework/port/threadpool.h"
@@ -33,20 +36,24 @@ class ThreadPoolExecutor : public Executor {
   void Schedule(std::function<void()> task) override;
 
   // For testing.
-  int num_threads() const { return thread_pool_.num_threads(); }
+  int num_threads() const;
   // Returns the thread stack size (in bytes).
   size_t stack_size() const { return stack_size_; }
 
  private:
-  ThreadPoolExecutor(const ThreadOptions& thread_options, int num_threads);
+  ThreadPoolExecutor(const ThreadOptions& thread_options, int num_threads,
+                     bool work_stealing);
 
   // Saves the value of the stack size option and starts the thread pool.
   void Start();
 
-  mediapipe::ThreadPool thread_pool_;
+  // Exactly one of the two pools is created, depending on
+  // ThreadPoolExecutorOptions::task_queue_type.
+  std::unique_ptr<mediapipe::ThreadPool> thread_pool_;
+  std::unique_ptr<mediapipe::WorkStealingThreadPool> work_stealing_pool_;
 
   // Records the stack size in ThreadOptions right before we call
-  // thread_pool_.StartWorkers().
+  // StartWorkers().
   //
   // The actual stack size passed to pthread_attr_setstacksize() for the
   // worker threads differs from the stack size we specified. It includes the
@@ -46,6 +46,7 @@
 #include "mediapipe/framework/tool/subgraph_expansion.h"
 #include "mediapipe/framework/tool/validate.h"
 #include "mediapipe/framework/tool/validate_name.h"
+#include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
@@ -397,6 +398,8 @@ absl::Status ValidatedGraphConfig::Initialize(
   MP_RETURN_IF_ERROR(ValidateStreamTypes());
 
   MP_RETURN_IF_ERROR(ComputeSourceDependence());
+  MP_RETURN_IF_ERROR(IdentifySingleProducerSingleConsumerStreams());
+  MP_RETURN_IF_ERROR(IdentifyFusedLinearChains());
 
   MP_RETURN_IF_ERROR(ValidateExecutors());
 
@@ -1131,6 +1134,93 @@ absl::Status ValidatedGraphConfig::ComputeSourceDependence() {
   return absl::OkStatus();
 }
 
+absl::Status
+ValidatedGraphConfig::IdentifySingleProducerSingleConsumerStreams() {
+  // The InputStreamHandlers which only access their input streams from the
+  // scheduling loop of their node.
+  static const auto* kSerialInputStreamHandlers =
+      new absl::flat_hash_set<std::string>{"DefaultInputStreamHandler",
+                                           "ImmediateInputStreamHandler"};
+  for (EdgeInfo& input_edge_info : input_streams_) {
+    input_edge_info.single_producer_single_consumer = false;
+    if (input_edge_info.upstream < 0) {
+      continue;
+    }
+    const EdgeInfo& output_edge_info =
+        output_streams_[input_edge_info.upstream];
+    if (!NodeRunsSerially(input_edge_info.parent_node) ||
+        !NodeRunsSerially(output_edge_info.parent_node)) {
+      continue;
+    }
+    // Same precedence as in CalculatorNode: the graph specified
+    // InputStreamHandler, then the calculator specified one, then the default.
+    const CalculatorGraphConfig::Node& node_config =
+        config_.node(input_edge_info.parent_node.index);
+    const NodeTypeInfo& node_type_info =
+        calculators_[input_edge_info.parent_node.index];
+    std::string input_stream_handler =
+        node_config.input_stream_handler().input_stream_handler();
+    if (!node_config.input_stream_handler().has_input_stream_handler() &&
+        !node_type_info.GetInputStreamHandler().empty()) {
+      input_stream_handler = node_type_info.GetInputStreamHandler();
+    }
+    input_edge_info.single_producer_single_consumer =
+        kSerialInputStreamHandlers->contains(input_stream_handler);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ValidatedGraphConfig::IdentifyFusedLinearChains() {
+  fused_producers_.assign(calculators_.size(), -1);
+  if (!config_.fuse_linear_chains()) {
+    return absl::OkStatus();
+  }
+  for (const NodeTypeInfo& node_type_info : calculators_) {
+    if (node_type_info.InputStreamTypes().NumEntries() != 1) {
+      continue;
+    }
+    // A single-producer single-consumer stream connects two calculators that
+    // each run one Process() call at a time.
+    const EdgeInfo& input_edge_info =
+        input_streams_[node_type_info.InputStreamBaseIndex()];
+    if (input_edge_info.back_edge ||
+        !input_edge_info.single_producer_single_consumer) {
+      continue;
+    }
+    const int producer =
+        output_streams_[input_edge_info.upstream].parent_node.index;
+    if (calculators_[producer].OutputStreamTypes().NumEntries() != 1 ||
+        OutputStreamToConsumers(input_edge_info.upstream).size() != 1) {
+      continue;
+    }
+    const int consumer = node_type_info.Node().index;
+    if (config_.node(consumer).executor() !=
+        config_.node(producer).executor()) {
+      continue;
+    }
+    fused_producers_[consumer] = producer;
+  }
+  return absl::OkStatus();
+}
+
+int ValidatedGraphConfig::MaxInFlight(
+    const CalculatorGraphConfig::Node& node_config,
+    const NodeTypeInfo& node_type_info) const {
+  int max_in_flight = node_config.max_in_flight();
+  if (max_in_flight == 0 && config_.throughput_mode() &&
+      node_type_info.Contract().GetProcessReentrant() &&
+      node_type_info.InputStreamTypes().NumEntries() > 0) {
+    max_in_flight = mediapipe::NumCPUCores();
+  }
+  return max_in_flight ? max_in_flight : 1;
+}
+
+bool ValidatedGraphConfig::NodeRunsSerially(
+    const NodeTypeInfo::NodeRef& node) const {
+  return node.type == NodeTypeInfo::NodeType::CALCULATOR &&
+         MaxInFlight(config_.node(node.index), calculators_[node.index]) == 1;
+}
+
 absl::StatusOr<std::string> ValidatedGraphConfig::RegisteredSidePacketTypeName(
     const std::string& name) {
   auto iter = side_packet_to_producer_.find(name);
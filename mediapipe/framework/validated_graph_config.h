@@ -186,6 +186,13 @@ struct EdgeInfo {
   std::string name;
   PacketType* packet_type = nullptr;
   bool back_edge = false;  // Only applicable to input streams.
+  // True if the stream is written by only one thread at a time and read by
+  // only one thread at a time, in which case its packets can be queued
+  // without taking a lock. Only applicable to input streams. This holds when
+  // the producing and the consuming calculators both have a max_in_flight of
+  // 1, and the consuming calculator uses an InputStreamHandler that only
+  // reads the stream while scheduling the calculator.
+  bool single_producer_single_consumer = false;
 };
 
 // This class is used to validate and canonicalize a CalculatorGraphConfig.
@@ -309,6 +316,26 @@ class ValidatedGraphConfig {
     return required_side_packets_.count(name) > 0;
   }
 
+  // Returns the number of Process() calls a node may run at a time: the
+  // max_in_flight of its config if set, one per CPU core for a reentrant
+  // calculator with inputs in throughput_mode, and 1 otherwise.
+  // CalculatorNode and NodeRunsSerially both use it, so that they cannot
+  // disagree.
+  int MaxInFlight(const CalculatorGraphConfig::Node& node_config,
+                  const NodeTypeInfo& node_type_info) const;
+
+  // Returns true if the node is a calculator which runs at most one Process()
+  // call at a time, so that its streams are only written by one thread at a
+  // time.
+  bool NodeRunsSerially(const NodeTypeInfo::NodeRef& node) const;
+
+  // Returns the index of the calculator after which calculator |node_index|
+  // runs inline, or -1 if it is scheduled on its own. Calculators are only
+  // fused if CalculatorGraphConfig.fuse_linear_chains is true.
+  int FusedProducer(int node_index) const {
+    return fused_producers_[node_index];
+  }
+
  private:
   // Perform transforms such as converting legacy features, expanding
   // subgraphs, and popluting input stream handler.
@@ -394,6 +421,13 @@ class ValidatedGraphConfig {
   // Compute the dependence of nodes on sources.
   absl::Status ComputeSourceDependence();
 
+  // Sets the single_producer_single_consumer field of all input streams.
+  absl::Status IdentifySingleProducerSingleConsumerStreams();
+
+  // Fills fused_producers_, fusing each calculator with its producer when
+  // they form a link of a linear chain.
+  absl::Status IdentifyFusedLinearChains();
+
   // Infer the type of types set to "Any" by what they are connected to.
   absl::Status ResolveAnyTypes(std::vector<EdgeInfo>* input_edges,
                                std::vector<EdgeInfo>* output_edges);
@@ -430,6 +464,9 @@ class ValidatedGraphConfig {
   // Mapping from output streams to consumer node ids. Used for profiling.
   std::map<int, std::vector<int>> output_streams_to_consumer_nodes_;
 
+  // The calculator after which each calculator runs inline, or -1.
+  std::vector<int> fused_producers_;
+
   // Mapping from side packet name to the output_side_packets_ index
   // which produces it.
   std::map<std::string, int> side_packet_to_producer_;
@@ -12,7 +12,9 @@
 #include "mediapipe/framework/graph_service.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
@@ -34,6 +36,24 @@ MEDIAPIPE_REGISTER_NODE(CalculatorB);
 using CalculatorC = NoOp;
 MEDIAPIPE_REGISTER_NODE(CalculatorC);
 
+class ReentrantNoOp : public mediapipe::api2::Node {
+ public:
+  static constexpr mediapipe::api2::Input<int>::Optional kInputNotNeeded{"NN"};
+  static constexpr mediapipe::api2::Output<int>::Optional kOutputNotNeeded{
+      "NN"};
+  MEDIAPIPE_NODE_CONTRACT(kInputNotNeeded, kOutputNotNeeded);
+  static absl::Status UpdateContract(CalculatorContract* cc) {
+    cc->SetProcessReentrant(true);
+    return absl::OkStatus();
+  }
+  absl::Status Process(CalculatorContext* cc) override {
+    return absl::OkStatus();
+  }
+};
+
+using ReentrantCalculator = ReentrantNoOp;
+MEDIAPIPE_REGISTER_NODE(ReentrantCalculator);
+
 CalculatorGraphConfig ExpectedConfig(const std::string& node_name) {
   CalculatorGraphConfig config;
   config.add_node()->set_calculator(node_name);
@@ -163,4 +183,189 @@ TEST(ValidatedGraphConfigTest, InitializeSubgraphWithServiceCalculatorB) {
   }
 }
 
+
+TEST(ValidatedGraphConfigTest, IdentifiesSingleProducerSingleConsumerStreams) {
+  CalculatorGraphConfig graph = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    node {
+      calculator: "CalculatorA"
+      input_stream: "NN:in"
+      output_stream: "NN:a"
+    }
+    node {
+      calculator: "CalculatorB"
+      input_stream: "NN:a"
+      output_stream: "NN:b"
+    }
+    node {
+      calculator: "CalculatorC"
+      input_stream: "NN:b"
+      output_stream: "NN:c"
+      max_in_flight: 2
+    }
+    node {
+      calculator: "CalculatorA"
+      input_stream: "NN:c"
+    }
+    node {
+      calculator: "CalculatorB"
+      input_stream: "NN:a"
+      input_stream_handler {
+        input_stream_handler: "FixedSizeInputStreamHandler"
+      }
+    }
+    node {
+      calculator: "CalculatorC"
+      input_stream: "NN:a"
+      input_stream_handler {
+        input_stream_handler: "ImmediateInputStreamHandler"
+      }
+    }
+  )pb");
+  ValidatedGraphConfig config;
+  MP_ASSERT_OK(config.Initialize(graph));
+  std::vector<bool> single_producer_single_consumer;
+  for (const EdgeInfo& edge_info : config.InputStreamInfos()) {
+    single_producer_single_consumer.push_back(
+        edge_info.single_producer_single_consumer);
+  }
+  EXPECT_THAT(single_producer_single_consumer,
+              testing::ElementsAre(
+                  // Written by a graph input stream.
+                  false,
+                  // Written and read by serial calculators.
+                  true,
+                  // Read by a parallel calculator.
+                  false,
+                  // Written by a parallel calculator.
+                  false,
+                  // Read by an unsupported InputStreamHandler.
+                  false,
+                  // Read by a supported InputStreamHandler.
+                  true));
+}
+
+TEST(ValidatedGraphConfigTest, ReentrantCalculatorsRunSeriallyByDefault) {
+  CalculatorGraphConfig graph = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    node {
+      calculator: "CalculatorA"
+      output_stream: "NN:a"
+    }
+    node {
+      calculator: "ReentrantCalculator"
+      input_stream: "NN:a"
+      output_stream: "NN:b"
+    }
+    node {
+      calculator: "ReentrantCalculator"
+      input_stream: "NN:b"
+      output_stream: "NN:c"
+      max_in_flight: 2
+    }
+    node {
+      calculator: "CalculatorB"
+      input_stream: "NN:c"
+    }
+  )pb");
+  ValidatedGraphConfig config;
+  MP_ASSERT_OK(config.Initialize(graph));
+  auto calculator = [](int index) {
+    return NodeTypeInfo::NodeRef(NodeTypeInfo::NodeType::CALCULATOR, index);
+  };
+  EXPECT_TRUE(config.NodeRunsSerially(calculator(0)));
+  EXPECT_TRUE(config.NodeRunsSerially(calculator(1)));
+  EXPECT_FALSE(config.NodeRunsSerially(calculator(2)));
+  std::vector<bool> single_producer_single_consumer;
+  for (const EdgeInfo& edge_info : config.InputStreamInfos()) {
+    single_producer_single_consumer.push_back(
+        edge_info.single_producer_single_consumer);
+  }
+  EXPECT_THAT(single_producer_single_consumer,
+              testing::ElementsAre(
+                  // Read by a reentrant calculator without max_in_flight.
+                  true,
+                  // Read by a reentrant calculator with max_in_flight 2.
+                  false,
+                  // Written by a reentrant calculator with max_in_flight 2.
+                  false));
+}
+
+TEST(ValidatedGraphConfigTest, ReentrantCalculatorsRunInParallelForThroughput) {
+  CalculatorGraphConfig graph = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    throughput_mode: true
+    node {
+      calculator: "CalculatorA"
+      output_stream: "NN:a"
+    }
+    node {
+      calculator: "ReentrantCalculator"
+      input_stream: "NN:a"
+      output_stream: "NN:b"
+    }
+    node {
+      calculator: "ReentrantCalculator"
+      input_stream: "NN:b"
+      output_stream: "NN:c"
+      max_in_flight: 1
+    }
+  )pb");
+  ValidatedGraphConfig config;
+  MP_ASSERT_OK(config.Initialize(graph));
+  auto calculator = [](int index) {
+    return NodeTypeInfo::NodeRef(NodeTypeInfo::NodeType::CALCULATOR, index);
+  };
+  EXPECT_EQ(1, config.MaxInFlight(config.Config().node(0),
+                                  config.CalculatorInfos()[0]));
+  EXPECT_EQ(NumCPUCores(), config.MaxInFlight(config.Config().node(1),
+                                              config.CalculatorInfos()[1]));
+  EXPECT_EQ(1, config.MaxInFlight(config.Config().node(2),
+                                  config.CalculatorInfos()[2]));
+  EXPECT_TRUE(config.NodeRunsSerially(calculator(0)));
+  EXPECT_EQ(NumCPUCores() == 1, config.NodeRunsSerially(calculator(1)));
+  EXPECT_TRUE(config.NodeRunsSerially(calculator(2)));
+}
+
+TEST(ValidatedGraphConfigTest, FusesLinearChains) {
+  CalculatorGraphConfig graph = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    fuse_linear_chains: true
+    node {
+      calculator: "CalculatorA"
+      output_stream: "NN:a"
+    }
+    node {
+      calculator: "CalculatorB"
+      input_stream: "NN:a"
+      output_stream: "NN:b"
+    }
+    node {
+      calculator: "CalculatorC"
+      input_stream: "NN:b"
+      output_stream: "NN:c"
+    }
+    node {
+      calculator: "CalculatorB"
+      input_stream: "NN:b"
+    }
+    node {
+      calculator: "CalculatorC"
+      input_stream: "NN:c"
+    }
+  )pb");
+  ValidatedGraphConfig config;
+  MP_ASSERT_OK(config.Initialize(graph));
+  EXPECT_EQ(-1, config.FusedProducer(0));
+  EXPECT_EQ(0, config.FusedProducer(1));
+  // Stream "b" has two consumers.
+  EXPECT_EQ(-1, config.FusedProducer(2));
+  EXPECT_EQ(-1, config.FusedProducer(3));
+  EXPECT_EQ(2, config.FusedProducer(4));
+
+  graph.set_fuse_linear_chains(false);
+  ValidatedGraphConfig unfused_config;
+  MP_ASSERT_OK(unfused_config.Initialize(graph));
+  for (int i = 0; i < graph.node_size(); ++i) {
+    EXPECT_EQ(-1, unfused_config.FusedProducer(i));
+  }
+}
+
 }  // namespace mediapipe
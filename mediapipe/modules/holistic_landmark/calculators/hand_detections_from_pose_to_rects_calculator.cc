@@ -4,6 +4,7 @@
 #include "mediapipe/calculators/util/detections_to_rects_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_options.pb.h"
+#include "mediapipe/framework/formats/compact_detection.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
@@ -48,6 +49,17 @@ class HandDetectionsFromPoseToRectsCalculator
   absl::Status ComputeRotation(const Detection& detection,
                                const DetectionSpec& detection_spec,
                                float* rotation) override;
+  absl::Status DetectionToNormalizedRect(const CompactDetection& detection,
+                                         const DetectionSpec& detection_spec,
+                                         NormalizedRect* rect) override {
+    return DetectionToNormalizedRect(ToDetection(detection), detection_spec,
+                                     rect);
+  }
+  absl::Status ComputeRotation(const CompactDetection& detection,
+                               const DetectionSpec& detection_spec,
+                               float* rotation) override {
+    return ComputeRotation(ToDetection(detection), detection_spec, rotation);
+  }
 };
 REGISTER_CALCULATOR(HandDetectionsFromPoseToRectsCalculator);
 
@@ -30,6 +30,7 @@
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -39,6 +40,10 @@ ABSL_FLAG(std::string, system_cpu_max_freq_file,
           "/sys/devices/system/cpu/cpu$0/cpufreq/cpuinfo_max_freq",
           "The file pattern for CPU max frequencies, where $0 will be replaced "
           "with the CPU id.");
+ABSL_FLAG(std::string, system_numa_node_cpulist_file,
+          "/sys/devices/system/node/node$0/cpulist",
+          "The file pattern for the CPU list of NUMA nodes, where $0 will be "
+          "replaced with the node id.");
 
 namespace mediapipe {
 namespace {
@@ -78,6 +83,30 @@ absl::StatusOr<uint64> GetCpuMaxFrequency(int cpu) {
   }
 }
 
+// Parses a kernel CPU list such as "0-3,8,10-11".
+absl::StatusOr<std::set<int>> ParseCpuList(absl::string_view cpu_list) {
+  std::set<int> cpus;
+  for (absl::string_view range :
+       absl::StrSplit(cpu_list, ',', absl::SkipWhitespace())) {
+    std::pair<absl::string_view, absl::string_view> bounds =
+        absl::StrSplit(range, absl::MaxSplits('-', 1));
+    int first, last;
+    if (!absl::SimpleAtoi(bounds.first, &first)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid CPU list: ", cpu_list));
+    }
+    last = first;
+    if (!bounds.second.empty() && !absl::SimpleAtoi(bounds.second, &last)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid CPU list: ", cpu_list));
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.insert(cpu);
+    }
+  }
+  return cpus;
+}
+
 std::set<int> InferLowerOrHigherCoreIds(bool lower) {
   std::vector<std::pair<int, uint64>> cpu_freq_pairs;
   for (int cpu = 0; cpu < NumCPUCores(); ++cpu) {
@@ -136,4 +165,22 @@ std::set<int> InferHigherCoreIds() {
   return InferLowerOrHigherCoreIds(/* lower= */ false);
 }
 
+std::set<int> GetNumaNodeCpuIds(int numa_node) {
+  const std::string pattern =
+      absl::GetFlag(FLAGS_system_numa_node_cpulist_file);
+  if (numa_node < 0 || !absl::StrContains(pattern, "$0")) {
+    return {};
+  }
+  std::ifstream file(absl::Substitute(pattern, numa_node));
+  std::string cpu_list;
+  if (!file.is_open() || !std::getline(file, cpu_list)) {
+    return {};
+  }
+  auto cpus_or_status = ParseCpuList(cpu_list);
+  if (!cpus_or_status.ok()) {
+    return {};
+  }
+  return cpus_or_status.value();
+}
+
 }  // namespace mediapipe.
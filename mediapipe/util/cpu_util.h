@@ -24,6 +24,9 @@ int NumCPUCores();
 std::set<int> InferLowerCoreIds();
 // Returns a set of inferred CPU ids of higher cores.
 std::set<int> InferHigherCoreIds();
+// Returns the set of CPU ids that belong to the given NUMA node, or an empty
+// set if the node does not exist or the topology is unavailable.
+std::set<int> GetNumaNodeCpuIds(int numa_node);
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_UTIL_CPU_UTIL_H_
@@ -64,6 +64,23 @@ class ResourceCache {
     return entry->value;
   }
 
+  // Returns the value cached for `key`, or an unset value. Unlike Lookup, this
+  // does not count as a request.
+  Value Find(const Key& key) const {
+    auto map_it = map_.find(key);
+    if (map_it == map_.end()) return Value();
+    return map_it->second->value;
+  }
+
+  // Calls `fn` on the cached values, from the least requested to the most
+  // requested, until it returns false.
+  void ForEachLeastRequestedFirst(absl::FunctionRef<bool(Value& value)> fn) {
+    for (Entry* entry = entry_list_.tail(); entry != nullptr;
+         entry = entry->prev) {
+      if (entry->value && !fn(entry->value)) return;
+    }
+  }
+
   std::vector<Value> Evict(int max_count, int request_count_scrub_interval) {
     std::vector<Value> evicted;
 
@@ -146,5 +146,59 @@ TEST(ResourceCacheTest, EvictWithScrub) {
   EXPECT_EQ(1, *evicted[0]);
 }
 
+TEST(ResourceCacheTest, FindDoesNotCountRequests) {
+  IntCache cache;
+  MockCreate create;
+
+  EXPECT_CALL(create, Call(_, _))
+      .WillRepeatedly([](int key, int request_count) {
+        return std::make_shared<int>(key);
+      });
+
+  EXPECT_EQ(nullptr, cache.Find(1));
+  auto value = cache.Lookup(1, create.AsStdFunction());
+  EXPECT_EQ(value, cache.Find(1));
+  EXPECT_NE(nullptr, cache.Lookup(2, create.AsStdFunction()));
+  EXPECT_EQ(nullptr, cache.Find(3));
+
+  // Find did not count as a request, so both entries have one request and
+  // are in insertion order.
+  std::vector<int> order;
+  cache.ForEachLeastRequestedFirst([&order](std::shared_ptr<int>& value) {
+    order.push_back(*value);
+    return true;
+  });
+  EXPECT_THAT(order, testing::ElementsAre(2, 1));
+}
+
+TEST(ResourceCacheTest, ForEachLeastRequestedFirst) {
+  IntCache cache;
+  MockCreate create;
+
+  EXPECT_CALL(create, Call(_, _))
+      .WillRepeatedly([](int key, int request_count) {
+        return std::make_shared<int>(key);
+      });
+
+  for (int key : {1, 2, 3, 3, 3, 2}) {
+    EXPECT_NE(nullptr, cache.Lookup(key, create.AsStdFunction()));
+  }
+
+  std::vector<int> order;
+  cache.ForEachLeastRequestedFirst([&order](std::shared_ptr<int>& value) {
+    order.push_back(*value);
+    return true;
+  });
+  EXPECT_THAT(order, testing::ElementsAre(1, 2, 3));
+
+  // Stops when the function returns false.
+  order.clear();
+  cache.ForEachLeastRequestedFirst([&order](std::shared_ptr<int>& value) {
+    order.push_back(*value);
+    return order.size() < 2;
+  });
+  EXPECT_THAT(order, testing::ElementsAre(1, 2));
+}
+
 }  // namespace
 }  // namespace mediapipe